@@ -0,0 +1,89 @@
+/*
+ * Implementação do alocador por região (arena)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/* ========== Funções auxiliares ========== */
+
+static size_t alinhar(size_t tam) {
+    return (tam + ARENA_ALINHAMENTO - 1) & ~(size_t)(ARENA_ALINHAMENTO - 1);
+}
+
+static BlocoArena *novo_bloco(Arena *a, size_t minimo) {
+    size_t tam = minimo > ARENA_BLOCO_TAM ? minimo : ARENA_BLOCO_TAM;
+    size_t cabecalho = alinhar(sizeof(BlocoArena));
+    BlocoArena *b = (BlocoArena *)malloc(cabecalho + tam);
+    if (b == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a arena\n");
+        exit(1);
+    }
+    b->dados = (char *)b + cabecalho;
+    b->prox = NULL;
+    b->tamanho = tam;
+    b->usado = 0;
+    a->bytes_reservados += tam;
+    a->num_blocos++;
+    return b;
+}
+
+/* ========== Alocação ========== */
+
+void *arena_alocar(Arena *a, size_t tam) {
+    tam = alinhar(tam);
+
+    if (a->atual == NULL) {
+        a->primeiro = a->atual = novo_bloco(a, tam);
+    } else if (a->atual->usado + tam > a->atual->tamanho) {
+        /* Reaproveita o próximo bloco (após um reinício) se ele couber */
+        BlocoArena *prox = a->atual->prox;
+        if (prox != NULL && prox->tamanho >= tam) {
+            prox->usado = 0;
+        } else {
+            BlocoArena *b = novo_bloco(a, tam);
+            b->prox = prox;
+            a->atual->prox = b;
+            prox = b;
+        }
+        a->atual = prox;
+    }
+
+    void *p = a->atual->dados + a->atual->usado;
+    a->atual->usado += tam;
+    a->bytes_usados += tam;
+    if (a->bytes_usados > a->pico) {
+        a->pico = a->bytes_usados;
+    }
+    return p;
+}
+
+char *arena_strndup(Arena *a, const char *s, size_t n) {
+    char *copia = (char *)arena_alocar(a, n + 1);
+    memcpy(copia, s, n);
+    copia[n] = '\0';
+    return copia;
+}
+
+/* ========== Liberação ========== */
+
+void arena_reiniciar(Arena *a) {
+    a->atual = a->primeiro;
+    if (a->atual != NULL) {
+        a->atual->usado = 0;
+    }
+    a->bytes_usados = 0;
+}
+
+void arena_liberar(Arena *a) {
+    BlocoArena *b = a->primeiro;
+    while (b != NULL) {
+        BlocoArena *prox = b->prox;
+        free(b);
+        b = prox;
+    }
+    memset(a, 0, sizeof(Arena));
+}
@@ -0,0 +1,50 @@
+/*
+ * Alocador por região (arena) para os nós da AST de X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Tamanho padrão de cada bloco da arena */
+#define ARENA_BLOCO_TAM (64 * 1024)
+
+/* Alinhamento garantido para toda alocação */
+#define ARENA_ALINHAMENTO 16
+
+/* Bloco de memória da arena (encadeado) */
+typedef struct BlocoArena {
+    struct BlocoArena *prox;
+    size_t tamanho;         /* Capacidade de 'dados' em bytes */
+    size_t usado;
+    char *dados;            /* Área útil, logo após o cabeçalho */
+} BlocoArena;
+
+/*
+ * Arena: aloca sequencialmente dentro de blocos grandes e libera tudo de
+ * uma vez. Uma Arena zerada já está pronta para uso.
+ */
+typedef struct Arena {
+    BlocoArena *primeiro;
+    BlocoArena *atual;
+    size_t bytes_usados;    /* Bytes entregues desde o último reinício */
+    size_t bytes_reservados;/* Soma das capacidades dos blocos */
+    size_t pico;            /* Maior valor de bytes_usados já observado */
+    int num_blocos;
+} Arena;
+
+/* Aloca 'tam' bytes alinhados; nunca retorna NULL (aborta sem memória) */
+void *arena_alocar(Arena *a, size_t tam);
+
+/* Copia 'n' bytes de 's' para a arena, terminando com '\0' */
+char *arena_strndup(Arena *a, const char *s, size_t n);
+
+/* Descarta todas as alocações em O(1), mantendo os blocos para reuso */
+void arena_reiniciar(Arena *a);
+
+/* Devolve todos os blocos ao sistema */
+void arena_liberar(Arena *a);
+
+#endif /* ARENA_H */
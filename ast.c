@@ -5,18 +5,38 @@
 
 #define _GNU_SOURCE
 #include "ast.h"
+#include "contexto.h"
 
-/* A variável programa_raiz é definida em parser.y */
+/* ========== Identificadores ========== */
+
+ChaveId chave_id(const char *texto, size_t tam) {
+    ChaveId chave = 0;
+    if (tam > ID_MAX_CHARS) tam = ID_MAX_CHARS;
+    for (size_t i = 0; i < tam; i++) {
+        chave |= (ChaveId)(unsigned char)texto[i] << (8 * i);
+    }
+    return chave;
+}
+
+const char *texto_id(ChaveId chave, char *buf) {
+    int i = 0;
+    while (chave != 0 && i < ID_MAX_CHARS) {
+        buf[i++] = (char)(chave & 0xFF);
+        chave >>= 8;
+    }
+    buf[i] = '\0';
+    return buf;
+}
 
 /* ========== Funções auxiliares ========== */
 
-static void imprimir_indent(int nivel) {
+static void imprimir_indent(FILE *saida, int nivel) {
     for (int i = 0; i < nivel; i++) {
-        printf("  ");
+        fputs("  ", saida);
     }
 }
 
-static const char *tipo_para_string(TipoDado tipo) {
+const char *tipo_para_string(TipoDado tipo) {
     switch (tipo) {
         case TIPO_INTEIRO: return "INTEIRO";
         case TIPO_REAL: return "REAL";
@@ -60,549 +80,561 @@ static const char *op_log_para_string(OpLogico op) {
 
 /* ========== Criação de nós - Programa ========== */
 
-NoPrograma *criar_programa(char *nome, NoDecl *decl, NoCmd *algo) {
-    NoPrograma *prog = (NoPrograma *)malloc(sizeof(NoPrograma));
+NoPrograma *criar_programa(ContextoCompilacao *ctx, char *nome, NoDecl *decl, NoCmd *algo) {
+    NoPrograma *prog = (NoPrograma *)arena_alocar(&ctx->arena, sizeof(NoPrograma));
     prog->nome = nome;
     prog->declaracoes = decl;
     prog->algoritmo = algo;
+    prog->tamanho_quadro = 0;
     return prog;
 }
 
 /* ========== Criação de nós - Declarações ========== */
 
-NoDecl *criar_declaracao(TipoDado tipo, char *nome, int tamanho) {
-    NoDecl *decl = (NoDecl *)malloc(sizeof(NoDecl));
+NoDecl *criar_declaracao(ContextoCompilacao *ctx, TipoDado tipo, ChaveId chave, int tamanho) {
+    NoDecl *decl = (NoDecl *)arena_alocar(&ctx->arena, sizeof(NoDecl));
     decl->tipo = tipo;
-    decl->nome = nome;
+    decl->chave = chave;
     decl->tamanho_array = tamanho;
-    decl->linha = linha;
-    decl->coluna = coluna;
+    /* O lookahead já pode estar na linha seguinte: a posição é a do nome */
+    decl->linha = ctx->linha_id;
+    decl->coluna = ctx->coluna_id;
     decl->prox = NULL;
+    decl->ultimo = decl;
     return decl;
 }
 
 NoDecl *concat_declaracoes(NoDecl *lista, NoDecl *nova) {
     if (lista == NULL) return nova;
-    NoDecl *atual = lista;
-    while (atual->prox != NULL) {
-        atual = atual->prox;
-    }
-    atual->prox = nova;
+    if (nova == NULL) return lista;
+    lista->ultimo->prox = nova;
+    lista->ultimo = nova->ultimo;
     return lista;
 }
 
 /* ========== Criação de nós - Variáveis ========== */
 
-NoVar *criar_var_simples(char *nome) {
-    NoVar *var = (NoVar *)malloc(sizeof(NoVar));
-    var->nome = nome;
+NoVar *criar_var_simples(ContextoCompilacao *ctx, ChaveId chave) {
+    NoVar *var = (NoVar *)arena_alocar(&ctx->arena, sizeof(NoVar));
+    var->chave = chave;
     var->indice = NULL;
-    var->linha = linha;
-    var->coluna = coluna;
+    var->simbolo = NULL;
+    var->limite = LIMITE_DESCONHECIDO;
+    /* Criado antes do lookahead (ver nome_variavel em parser.y) */
+    var->linha = ctx->linha_id;
+    var->coluna = ctx->coluna_id;
     return var;
 }
 
-NoVar *criar_var_array(char *nome, NoExpr *indice) {
-    NoVar *var = (NoVar *)malloc(sizeof(NoVar));
-    var->nome = nome;
-    var->indice = indice;
-    var->linha = linha;
-    var->coluna = coluna;
-    return var;
-}
-
-ListaVar *criar_lista_var(NoVar *var) {
-    ListaVar *lista = (ListaVar *)malloc(sizeof(ListaVar));
+ListaVar *criar_lista_var(ContextoCompilacao *ctx, NoVar *var) {
+    ListaVar *lista = (ListaVar *)arena_alocar(&ctx->arena, sizeof(ListaVar));
     lista->var = var;
     lista->prox = NULL;
+    lista->ultimo = lista;
     return lista;
 }
 
-ListaVar *concat_lista_var(ListaVar *lista, NoVar *var) {
-    ListaVar *novo = criar_lista_var(var);
+ListaVar *concat_lista_var(ContextoCompilacao *ctx, ListaVar *lista, NoVar *var) {
+    ListaVar *novo = criar_lista_var(ctx, var);
     if (lista == NULL) return novo;
-    ListaVar *atual = lista;
-    while (atual->prox != NULL) {
-        atual = atual->prox;
-    }
-    atual->prox = novo;
+    lista->ultimo->prox = novo;
+    lista->ultimo = novo;
     return lista;
 }
 
 /* ========== Criação de nós - Expressões ========== */
 
-NoExpr *criar_expr_const_int(int valor) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_const_int(ContextoCompilacao *ctx, int valor) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     expr->tipo = EXPR_CONST_INT;
     expr->tipo_dado = TIPO_INTEIRO;
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.const_int = valor;
     return expr;
 }
 
-NoExpr *criar_expr_const_real(double valor) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_const_real(ContextoCompilacao *ctx, double valor) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     expr->tipo = EXPR_CONST_REAL;
     expr->tipo_dado = TIPO_REAL;
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.const_real = valor;
     return expr;
 }
 
-NoExpr *criar_expr_var(NoVar *var) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_var(ContextoCompilacao *ctx, NoVar *var) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     if (var->indice != NULL) {
         expr->tipo = EXPR_VAR_ARRAY;
     } else {
         expr->tipo = EXPR_VAR;
     }
     expr->tipo_dado = TIPO_INDEFINIDO;  /* Será definido na análise semântica */
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.var = var;
     return expr;
 }
 
-NoExpr *criar_expr_aritmetica(OpAritmetico op, NoExpr *esq, NoExpr *dir) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_aritmetica(ContextoCompilacao *ctx, OpAritmetico op, NoExpr *esq, NoExpr *dir) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     expr->tipo = EXPR_ARITMETICA;
     expr->tipo_dado = TIPO_INDEFINIDO;  /* Será definido na análise semântica */
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.aritmetica.op = op;
     expr->dado.aritmetica.esq = esq;
     expr->dado.aritmetica.dir = dir;
     return expr;
 }
 
-NoExpr *criar_expr_relacional(OpRelacional op, NoExpr *esq, NoExpr *dir) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_relacional(ContextoCompilacao *ctx, OpRelacional op, NoExpr *esq, NoExpr *dir) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     expr->tipo = EXPR_RELACIONAL;
     expr->tipo_dado = TIPO_INTEIRO;  /* Resultado booleano (0 ou 1) */
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.relacional.op = op;
     expr->dado.relacional.esq = esq;
     expr->dado.relacional.dir = dir;
     return expr;
 }
 
-NoExpr *criar_expr_logica(OpLogico op, NoExpr *esq, NoExpr *dir) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_logica(ContextoCompilacao *ctx, OpLogico op, NoExpr *esq, NoExpr *dir) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     expr->tipo = EXPR_LOGICA;
     expr->tipo_dado = TIPO_INTEIRO;  /* Resultado booleano (0 ou 1) */
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.logica.op = op;
     expr->dado.logica.esq = esq;
     expr->dado.logica.dir = dir;
     return expr;
 }
 
-NoExpr *criar_expr_nao(NoExpr *expr_interna) {
-    NoExpr *expr = (NoExpr *)malloc(sizeof(NoExpr));
+NoExpr *criar_expr_nao(ContextoCompilacao *ctx, NoExpr *expr_interna) {
+    NoExpr *expr = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
     expr->tipo = EXPR_NAO;
     expr->tipo_dado = TIPO_INTEIRO;  /* Resultado booleano (0 ou 1) */
-    expr->linha = linha;
-    expr->coluna = coluna;
+    expr->linha = ctx->linha;
+    expr->coluna = ctx->coluna;
     expr->dado.negacao = expr_interna;
     return expr;
 }
 
 /* ========== Criação de nós - Comandos ========== */
 
-NoCmd *criar_cmd_atrib(NoVar *var, NoExpr *expr) {
-    NoCmd *cmd = (NoCmd *)malloc(sizeof(NoCmd));
+NoCmd *criar_cmd_atrib(ContextoCompilacao *ctx, NoVar *var, NoExpr *expr) {
+    NoCmd *cmd = (NoCmd *)arena_alocar(&ctx->arena, sizeof(NoCmd));
     cmd->tipo = CMD_ATRIB;
-    cmd->linha = linha;
-    cmd->coluna = coluna;
+    cmd->linha = ctx->linha;
+    cmd->coluna = ctx->coluna;
     cmd->dado.atrib.var = var;
     cmd->dado.atrib.expr = expr;
     cmd->prox = NULL;
+    cmd->ultimo = cmd;
     return cmd;
 }
 
-NoCmd *criar_cmd_leia(ListaVar *vars) {
-    NoCmd *cmd = (NoCmd *)malloc(sizeof(NoCmd));
+NoCmd *criar_cmd_leia(ContextoCompilacao *ctx, ListaVar *vars) {
+    NoCmd *cmd = (NoCmd *)arena_alocar(&ctx->arena, sizeof(NoCmd));
     cmd->tipo = CMD_LEIA;
-    cmd->linha = linha;
-    cmd->coluna = coluna;
+    cmd->linha = ctx->linha;
+    cmd->coluna = ctx->coluna;
     cmd->dado.leia = vars;
     cmd->prox = NULL;
+    cmd->ultimo = cmd;
     return cmd;
 }
 
-NoCmd *criar_cmd_escreva(ListaEscreva *itens) {
-    NoCmd *cmd = (NoCmd *)malloc(sizeof(NoCmd));
+NoCmd *criar_cmd_escreva(ContextoCompilacao *ctx, ListaEscreva *itens) {
+    NoCmd *cmd = (NoCmd *)arena_alocar(&ctx->arena, sizeof(NoCmd));
     cmd->tipo = CMD_ESCREVA;
-    cmd->linha = linha;
-    cmd->coluna = coluna;
+    cmd->linha = ctx->linha;
+    cmd->coluna = ctx->coluna;
     cmd->dado.escreva = itens;
     cmd->prox = NULL;
+    cmd->ultimo = cmd;
     return cmd;
 }
 
-NoCmd *criar_cmd_se(NoExpr *cond, NoCmd *entao, NoCmd *senao) {
-    NoCmd *cmd = (NoCmd *)malloc(sizeof(NoCmd));
+NoCmd *criar_cmd_se(ContextoCompilacao *ctx, NoExpr *cond, NoCmd *entao, NoCmd *senao) {
+    NoCmd *cmd = (NoCmd *)arena_alocar(&ctx->arena, sizeof(NoCmd));
     cmd->tipo = CMD_SE;
-    cmd->linha = linha;
-    cmd->coluna = coluna;
+    cmd->linha = ctx->linha;
+    cmd->coluna = ctx->coluna;
     cmd->dado.se.condicao = cond;
     cmd->dado.se.entao = entao;
     cmd->dado.se.senao = senao;
     cmd->prox = NULL;
+    cmd->ultimo = cmd;
     return cmd;
 }
 
-NoCmd *criar_cmd_enquanto(NoExpr *cond, NoCmd *corpo) {
-    NoCmd *cmd = (NoCmd *)malloc(sizeof(NoCmd));
+NoCmd *criar_cmd_enquanto(ContextoCompilacao *ctx, NoExpr *cond, NoCmd *corpo) {
+    NoCmd *cmd = (NoCmd *)arena_alocar(&ctx->arena, sizeof(NoCmd));
     cmd->tipo = CMD_ENQUANTO;
-    cmd->linha = linha;
-    cmd->coluna = coluna;
+    cmd->linha = ctx->linha;
+    cmd->coluna = ctx->coluna;
     cmd->dado.enquanto.condicao = cond;
     cmd->dado.enquanto.corpo = corpo;
     cmd->prox = NULL;
+    cmd->ultimo = cmd;
     return cmd;
 }
 
 NoCmd *concat_comandos(NoCmd *lista, NoCmd *novo) {
     if (lista == NULL) return novo;
-    NoCmd *atual = lista;
-    while (atual->prox != NULL) {
-        atual = atual->prox;
-    }
-    atual->prox = novo;
+    if (novo == NULL) return lista;
+    lista->ultimo->prox = novo;
+    lista->ultimo = novo->ultimo;
     return lista;
 }
 
 /* ========== Lista para ESCREVA ========== */
 
-ListaEscreva *criar_item_cadeia(char *cadeia) {
-    ListaEscreva *item = (ListaEscreva *)malloc(sizeof(ListaEscreva));
+ListaEscreva *criar_item_cadeia(ContextoCompilacao *ctx, char *cadeia) {
+    ListaEscreva *item = (ListaEscreva *)arena_alocar(&ctx->arena, sizeof(ListaEscreva));
     item->is_cadeia = 1;
     item->item.cadeia = cadeia;
     item->prox = NULL;
+    item->ultimo = item;
     return item;
 }
 
-ListaEscreva *criar_item_expr(NoExpr *expr) {
-    ListaEscreva *item = (ListaEscreva *)malloc(sizeof(ListaEscreva));
+ListaEscreva *criar_item_expr(ContextoCompilacao *ctx, NoExpr *expr) {
+    ListaEscreva *item = (ListaEscreva *)arena_alocar(&ctx->arena, sizeof(ListaEscreva));
     item->is_cadeia = 0;
     item->item.expr = expr;
     item->prox = NULL;
+    item->ultimo = item;
     return item;
 }
 
 ListaEscreva *concat_lista_escreva(ListaEscreva *lista, ListaEscreva *item) {
     if (lista == NULL) return item;
-    ListaEscreva *atual = lista;
-    while (atual->prox != NULL) {
-        atual = atual->prox;
-    }
-    atual->prox = item;
+    if (item == NULL) return lista;
+    lista->ultimo->prox = item;
+    lista->ultimo = item->ultimo;
     return lista;
 }
 
-/* ========== Impressão da AST ========== */
+/* ========== Percurso de comandos ========== */
 
-void imprimir_expressao(NoExpr *expr) {
-    if (expr == NULL) {
-        printf("NULL");
-        return;
+/* Guarda uma sequência para depois do bloco aninhado atual */
+static void adiar(PercursoComandos *p, NoCmd *cmd) {
+    if (cmd != NULL) {
+        *(NoCmd **)pilha_empilhar(&p->pendentes) = cmd;
+    }
+}
+
+void iniciar_percurso(PercursoComandos *p, NoCmd *cmd) {
+    p->proximo = cmd;
+    pilha_iniciar(&p->pendentes, sizeof(NoCmd *));
+}
+
+NoCmd *proximo_comando(PercursoComandos *p) {
+    NoCmd *cmd = p->proximo;
+    
+    if (cmd == NULL) {
+        NoCmd **topo = (NoCmd **)pilha_topo(&p->pendentes);
+        if (topo == NULL) return NULL;
+        cmd = *topo;
+        pilha_desempilhar(&p->pendentes);
     }
     
-    switch (expr->tipo) {
-        case EXPR_CONST_INT:
-            printf("%d", expr->dado.const_int);
-            break;
-            
-        case EXPR_CONST_REAL:
-            printf("%.2f", expr->dado.const_real);
-            break;
-            
-        case EXPR_VAR:
-            printf("%s", expr->dado.var->nome);
-            break;
-            
-        case EXPR_VAR_ARRAY:
-            printf("%s[", expr->dado.var->nome);
-            imprimir_expressao(expr->dado.var->indice);
-            printf("]");
-            break;
-            
-        case EXPR_ARITMETICA:
-            printf("(");
-            imprimir_expressao(expr->dado.aritmetica.esq);
-            printf(" %s ", op_arit_para_string(expr->dado.aritmetica.op));
-            imprimir_expressao(expr->dado.aritmetica.dir);
-            printf(")");
-            break;
-            
-        case EXPR_RELACIONAL:
-            printf("(");
-            imprimir_expressao(expr->dado.relacional.esq);
-            printf(" %s ", op_rel_para_string(expr->dado.relacional.op));
-            imprimir_expressao(expr->dado.relacional.dir);
-            printf(")");
+    p->proximo = cmd->prox;
+    switch (cmd->tipo) {
+        case CMD_SE:
+            adiar(p, p->proximo);
+            adiar(p, cmd->dado.se.senao);
+            p->proximo = cmd->dado.se.entao;
             break;
-            
-        case EXPR_LOGICA:
-            printf("(");
-            imprimir_expressao(expr->dado.logica.esq);
-            printf(" %s ", op_log_para_string(expr->dado.logica.op));
-            imprimir_expressao(expr->dado.logica.dir);
-            printf(")");
+        case CMD_ENQUANTO:
+            adiar(p, p->proximo);
+            p->proximo = cmd->dado.enquanto.corpo;
             break;
-            
-        case EXPR_NAO:
-            printf(".NAO. (");
-            imprimir_expressao(expr->dado.negacao);
-            printf(")");
+        default:
             break;
     }
+    return cmd;
+}
+
+void terminar_percurso(PercursoComandos *p) {
+    pilha_liberar(&p->pendentes);
+}
+
+/* ========== Impressão da AST ========== */
+
+/*
+ * As impressões usam pilhas explícitas (pilha.h) em vez de recursão, de
+ * modo que a profundidade da AST não é limitada pela pilha de chamadas.
+ */
+
+/* Expressão em impressão e quantas partes dela já foram escritas */
+typedef struct {
+    NoExpr *expr;
+    int etapa;
+} QuadroImpressao;
+
+static void empilhar_impressao(Pilha *pilha, NoExpr *expr) {
+    QuadroImpressao *q = (QuadroImpressao *)pilha_empilhar(pilha);
+    q->expr = expr;
+    q->etapa = 0;
+}
+
+/* Escreve "(esq op dir)": etapa 0 abre e desce à esquerda, 1 desce à direita, 2 fecha */
+static NoExpr *imprimir_binaria(FILE *saida, int etapa, const char *op, NoExpr *esq, NoExpr *dir) {
+    switch (etapa) {
+        case 0:
+            fprintf(saida, "(");
+            return esq;
+        case 1:
+            fprintf(saida, " %s ", op);
+            return dir;
+        default:
+            fprintf(saida, ")");
+            return NULL;
+    }
 }
 
-void imprimir_declaracoes(NoDecl *decl, int nivel) {
+void imprimir_expressao(NoExpr *raiz, FILE *saida) {
+    char nome[ID_MAX_CHARS + 1];
+    Pilha pilha;
+    QuadroImpressao *q;
+    
+    pilha_iniciar(&pilha, sizeof(QuadroImpressao));
+    empilhar_impressao(&pilha, raiz);
+    
+    while ((q = (QuadroImpressao *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = q->expr;
+        int etapa = q->etapa++;
+        NoExpr *operando = NULL;    /* Escrito antes da próxima etapa deste nó */
+        int desce = 0;
+        
+        if (expr == NULL) {
+            fprintf(saida, "NULL");
+            pilha_desempilhar(&pilha);
+            continue;
+        }
+        
+        switch (expr->tipo) {
+            case EXPR_CONST_INT:
+                fprintf(saida, "%d", expr->dado.const_int);
+                break;
+                
+            case EXPR_CONST_REAL:
+                fprintf(saida, "%.2f", expr->dado.const_real);
+                break;
+                
+            case EXPR_VAR:
+                fprintf(saida, "%s", texto_id(expr->dado.var->chave, nome));
+                break;
+                
+            case EXPR_VAR_ARRAY:
+                if (etapa == 0) {
+                    fprintf(saida, "%s[", texto_id(expr->dado.var->chave, nome));
+                    operando = expr->dado.var->indice;
+                    desce = 1;
+                } else {
+                    fprintf(saida, "]");
+                }
+                break;
+                
+            case EXPR_ARITMETICA:
+                operando = imprimir_binaria(saida, etapa, op_arit_para_string(expr->dado.aritmetica.op),
+                                            expr->dado.aritmetica.esq, expr->dado.aritmetica.dir);
+                desce = etapa < 2;
+                break;
+                
+            case EXPR_RELACIONAL:
+                operando = imprimir_binaria(saida, etapa, op_rel_para_string(expr->dado.relacional.op),
+                                            expr->dado.relacional.esq, expr->dado.relacional.dir);
+                desce = etapa < 2;
+                break;
+                
+            case EXPR_LOGICA:
+                operando = imprimir_binaria(saida, etapa, op_log_para_string(expr->dado.logica.op),
+                                            expr->dado.logica.esq, expr->dado.logica.dir);
+                desce = etapa < 2;
+                break;
+                
+            case EXPR_NAO:
+            case EXPR_NEG:
+                if (etapa == 0) {
+                    fputs(expr->tipo == EXPR_NAO ? ".NAO. (" : "-(", saida);
+                    operando = expr->dado.negacao;
+                    desce = 1;
+                } else {
+                    fprintf(saida, ")");
+                }
+                break;
+        }
+        
+        if (desce) {
+            empilhar_impressao(&pilha, operando);
+        } else {
+            pilha_desempilhar(&pilha);
+        }
+    }
+    
+    pilha_liberar(&pilha);
+}
+
+void imprimir_declaracoes(NoDecl *decl, int nivel, FILE *saida) {
+    char nome[ID_MAX_CHARS + 1];
+    
     while (decl != NULL) {
-        imprimir_indent(nivel);
-        printf("%s %s", tipo_para_string(decl->tipo), decl->nome);
+        imprimir_indent(saida, nivel);
+        fprintf(saida, "%s %s", tipo_para_string(decl->tipo), texto_id(decl->chave, nome));
         if (decl->tamanho_array > 0) {
-            printf("[%d]", decl->tamanho_array);
+            fprintf(saida, "[%d]", decl->tamanho_array);
         }
-        printf("\n");
+        fprintf(saida, "\n");
         decl = decl->prox;
     }
 }
 
-void imprimir_comandos(NoCmd *cmd, int nivel) {
-    while (cmd != NULL) {
-        imprimir_indent(nivel);
+/*
+ * Sequência a retomar depois de um bloco aninhado, precedida da linha
+ * que fecha (ou separa) o bloco: "FIMSE", "FIMENQ" ou "SENAO".
+ */
+typedef struct {
+    const char *linha;
+    int nivel_linha;
+    NoCmd *cmd;
+    int nivel;
+} QuadroComandos;
+
+static void adiar_impressao(Pilha *pendentes, const char *linha, int nivel_linha,
+                            NoCmd *cmd, int nivel) {
+    QuadroComandos *q = (QuadroComandos *)pilha_empilhar(pendentes);
+    q->linha = linha;
+    q->nivel_linha = nivel_linha;
+    q->cmd = cmd;
+    q->nivel = nivel;
+}
+
+void imprimir_comandos(NoCmd *cmd, int nivel, FILE *saida) {
+    char nome[ID_MAX_CHARS + 1];
+    Pilha pendentes;
+    
+    pilha_iniciar(&pendentes, sizeof(QuadroComandos));
+    
+    for (;;) {
+        if (cmd == NULL) {
+            QuadroComandos *q = (QuadroComandos *)pilha_topo(&pendentes);
+            if (q == NULL) break;
+            if (q->linha != NULL) {
+                imprimir_indent(saida, q->nivel_linha);
+                fprintf(saida, "%s\n", q->linha);
+            }
+            cmd = q->cmd;
+            nivel = q->nivel;
+            pilha_desempilhar(&pendentes);
+            continue;
+        }
+        
+        NoCmd *prox = cmd->prox;
+        imprimir_indent(saida, nivel);
         
         switch (cmd->tipo) {
             case CMD_ATRIB:
                 if (cmd->dado.atrib.var->indice != NULL) {
-                    printf("%s[", cmd->dado.atrib.var->nome);
-                    imprimir_expressao(cmd->dado.atrib.var->indice);
-                    printf("]");
+                    fprintf(saida, "%s[", texto_id(cmd->dado.atrib.var->chave, nome));
+                    imprimir_expressao(cmd->dado.atrib.var->indice, saida);
+                    fprintf(saida, "]");
                 } else {
-                    printf("%s", cmd->dado.atrib.var->nome);
+                    fprintf(saida, "%s", texto_id(cmd->dado.atrib.var->chave, nome));
                 }
-                printf(" := ");
-                imprimir_expressao(cmd->dado.atrib.expr);
-                printf("\n");
+                fprintf(saida, " := ");
+                imprimir_expressao(cmd->dado.atrib.expr, saida);
+                fprintf(saida, "\n");
                 break;
                 
             case CMD_LEIA:
-                printf("LEIA ");
+                fprintf(saida, "LEIA ");
                 {
                     ListaVar *v = cmd->dado.leia;
                     while (v != NULL) {
                         if (v->var->indice != NULL) {
-                            printf("%s[", v->var->nome);
-                            imprimir_expressao(v->var->indice);
-                            printf("]");
+                            fprintf(saida, "%s[", texto_id(v->var->chave, nome));
+                            imprimir_expressao(v->var->indice, saida);
+                            fprintf(saida, "]");
                         } else {
-                            printf("%s", v->var->nome);
+                            fprintf(saida, "%s", texto_id(v->var->chave, nome));
                         }
-                        if (v->prox != NULL) printf(", ");
+                        if (v->prox != NULL) fprintf(saida, ", ");
                         v = v->prox;
                     }
                 }
-                printf("\n");
+                fprintf(saida, "\n");
                 break;
                 
             case CMD_ESCREVA:
-                printf("ESCREVA ");
+                fprintf(saida, "ESCREVA ");
                 {
                     ListaEscreva *e = cmd->dado.escreva;
                     while (e != NULL) {
                         if (e->is_cadeia) {
-                            printf("'%s'", e->item.cadeia);
+                            fprintf(saida, "'%s'", e->item.cadeia);
                         } else {
-                            imprimir_expressao(e->item.expr);
+                            imprimir_expressao(e->item.expr, saida);
                         }
-                        if (e->prox != NULL) printf(", ");
+                        if (e->prox != NULL) fprintf(saida, ", ");
                         e = e->prox;
                     }
                 }
-                printf("\n");
+                fprintf(saida, "\n");
                 break;
                 
             case CMD_SE:
-                printf("SE ");
-                imprimir_expressao(cmd->dado.se.condicao);
-                printf("\n");
-                imprimir_indent(nivel);
-                printf("ENTAO\n");
-                imprimir_comandos(cmd->dado.se.entao, nivel + 1);
+                fprintf(saida, "SE ");
+                imprimir_expressao(cmd->dado.se.condicao, saida);
+                fprintf(saida, "\n");
+                imprimir_indent(saida, nivel);
+                fprintf(saida, "ENTAO\n");
+                adiar_impressao(&pendentes, "FIMSE", nivel, prox, nivel);
                 if (cmd->dado.se.senao != NULL) {
-                    imprimir_indent(nivel);
-                    printf("SENAO\n");
-                    imprimir_comandos(cmd->dado.se.senao, nivel + 1);
+                    adiar_impressao(&pendentes, "SENAO", nivel, cmd->dado.se.senao, nivel + 1);
                 }
-                imprimir_indent(nivel);
-                printf("FIMSE\n");
+                prox = cmd->dado.se.entao;
+                nivel++;
                 break;
                 
             case CMD_ENQUANTO:
-                printf("ENQUANTO ");
-                imprimir_expressao(cmd->dado.enquanto.condicao);
-                printf(" FACA\n");
-                imprimir_comandos(cmd->dado.enquanto.corpo, nivel + 1);
-                imprimir_indent(nivel);
-                printf("FIMENQ\n");
-                break;
-                
-            case CMD_BLOCO:
-                imprimir_comandos(cmd->dado.bloco.cmd, nivel);
+                fprintf(saida, "ENQUANTO ");
+                imprimir_expressao(cmd->dado.enquanto.condicao, saida);
+                fprintf(saida, " FACA\n");
+                adiar_impressao(&pendentes, "FIMENQ", nivel, prox, nivel);
+                prox = cmd->dado.enquanto.corpo;
+                nivel++;
                 break;
         }
         
-        cmd = cmd->prox;
+        cmd = prox;
     }
+    
+    pilha_liberar(&pendentes);
 }
 
-void imprimir_ast(NoPrograma *prog) {
+void imprimir_ast(NoPrograma *prog, FILE *saida) {
     if (prog == NULL) {
-        printf("Programa vazio!\n");
+        fprintf(saida, "Programa vazio!\n");
         return;
     }
     
-    printf("=== ARVORE SINTATICA ABSTRATA ===\n\n");
-    printf("PROGRAMA %s\n\n", prog->nome ? prog->nome : "(sem nome)");
+    fprintf(saida, "=== ARVORE SINTATICA ABSTRATA ===\n\n");
+    fprintf(saida, "PROGRAMA %s\n\n", prog->nome ? prog->nome : "(sem nome)");
     
-    printf("DECLARACOES:\n");
-    imprimir_declaracoes(prog->declaracoes, 1);
-    printf("\n");
-    
-    printf("ALGORITMO:\n");
-    imprimir_comandos(prog->algoritmo, 1);
-    
-    printf("\n=================================\n");
-}
-
-/* ========== Liberação de memória ========== */
-
-void liberar_var(NoVar *var) {
-    if (var == NULL) return;
-    free(var->nome);
-    liberar_expressao(var->indice);
-    free(var);
-}
-
-void liberar_lista_var(ListaVar *lista) {
-    while (lista != NULL) {
-        ListaVar *prox = lista->prox;
-        liberar_var(lista->var);
-        free(lista);
-        lista = prox;
-    }
-}
-
-void liberar_expressao(NoExpr *expr) {
-    if (expr == NULL) return;
+    fprintf(saida, "DECLARACOES:\n");
+    imprimir_declaracoes(prog->declaracoes, 1, saida);
+    fprintf(saida, "\n");
     
-    switch (expr->tipo) {
-        case EXPR_CONST_INT:
-        case EXPR_CONST_REAL:
-            break;
-            
-        case EXPR_VAR:
-        case EXPR_VAR_ARRAY:
-            liberar_var(expr->dado.var);
-            break;
-            
-        case EXPR_ARITMETICA:
-            liberar_expressao(expr->dado.aritmetica.esq);
-            liberar_expressao(expr->dado.aritmetica.dir);
-            break;
-            
-        case EXPR_RELACIONAL:
-            liberar_expressao(expr->dado.relacional.esq);
-            liberar_expressao(expr->dado.relacional.dir);
-            break;
-            
-        case EXPR_LOGICA:
-            liberar_expressao(expr->dado.logica.esq);
-            liberar_expressao(expr->dado.logica.dir);
-            break;
-            
-        case EXPR_NAO:
-            liberar_expressao(expr->dado.negacao);
-            break;
-    }
+    fprintf(saida, "ALGORITMO:\n");
+    imprimir_comandos(prog->algoritmo, 1, saida);
     
-    free(expr);
+    fprintf(saida, "\n=================================\n");
 }
-
-void liberar_lista_escreva(ListaEscreva *lista) {
-    while (lista != NULL) {
-        ListaEscreva *prox = lista->prox;
-        if (lista->is_cadeia) {
-            free(lista->item.cadeia);
-        } else {
-            liberar_expressao(lista->item.expr);
-        }
-        free(lista);
-        lista = prox;
-    }
-}
-
-void liberar_comandos(NoCmd *cmd) {
-    while (cmd != NULL) {
-        NoCmd *prox = cmd->prox;
-        
-        switch (cmd->tipo) {
-            case CMD_ATRIB:
-                liberar_var(cmd->dado.atrib.var);
-                liberar_expressao(cmd->dado.atrib.expr);
-                break;
-                
-            case CMD_LEIA:
-                liberar_lista_var(cmd->dado.leia);
-                break;
-                
-            case CMD_ESCREVA:
-                liberar_lista_escreva(cmd->dado.escreva);
-                break;
-                
-            case CMD_SE:
-                liberar_expressao(cmd->dado.se.condicao);
-                liberar_comandos(cmd->dado.se.entao);
-                liberar_comandos(cmd->dado.se.senao);
-                break;
-                
-            case CMD_ENQUANTO:
-                liberar_expressao(cmd->dado.enquanto.condicao);
-                liberar_comandos(cmd->dado.enquanto.corpo);
-                break;
-                
-            case CMD_BLOCO:
-                liberar_comandos(cmd->dado.bloco.cmd);
-                break;
-        }
-        
-        free(cmd);
-        cmd = prox;
-    }
-}
-
-void liberar_declaracoes(NoDecl *decl) {
-    while (decl != NULL) {
-        NoDecl *prox = decl->prox;
-        free(decl->nome);
-        free(decl);
-        decl = prox;
-    }
-}
-
-void liberar_programa(NoPrograma *prog) {
-    if (prog == NULL) return;
-    free(prog->nome);
-    liberar_declaracoes(prog->declaracoes);
-    liberar_comandos(prog->algoritmo);
-    free(prog);
-}
-
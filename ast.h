@@ -9,6 +9,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include "arena.h"
+#include "pilha.h"
+
+/* ========== Identificadores ========== */
+
+/*
+ * Identificadores de X25b têm no máximo 8 caracteres (letras e dígitos),
+ * então cabem empacotados em um inteiro de 64 bits: o caractere i ocupa
+ * o byte i e os bytes restantes ficam zerados. Igualdade e hash de nomes
+ * viram operações sobre um único inteiro, sem alocação.
+ */
+#define ID_MAX_CHARS 8
+
+typedef uint64_t ChaveId;
+
+/* Empacota os 'tam' primeiros caracteres de 'texto' (no máximo 8) */
+ChaveId chave_id(const char *texto, size_t tam);
+
+/* Desempacota em 'buf' (ID_MAX_CHARS + 1 bytes) e retorna 'buf' */
+const char *texto_id(ChaveId chave, char *buf);
 
 /* ========== Tipos de Nós da AST ========== */
 
@@ -56,7 +77,8 @@ typedef enum {
     EXPR_ARITMETICA,
     EXPR_RELACIONAL,
     EXPR_LOGICA,
-    EXPR_NAO
+    EXPR_NAO,
+    EXPR_NEG        /* Menos unário (criado pela otimização a partir de 0 - x) */
 } TipoExpr;
 
 /* Tipos de nós de comando */
@@ -65,8 +87,7 @@ typedef enum {
     CMD_LEIA,
     CMD_ESCREVA,
     CMD_SE,
-    CMD_ENQUANTO,
-    CMD_BLOCO
+    CMD_ENQUANTO
 } TipoCmd;
 
 /* ========== Estruturas da AST ========== */
@@ -77,19 +98,33 @@ struct NoCmd;
 struct NoDecl;
 struct NoVar;
 struct NoPrograma;
+struct EntradaSimbolo;
+
+/*
+ * O que a análise de intervalos (intervalos.h) provou sobre o índice de
+ * um acesso a lista; os executores só verificam os desconhecidos.
+ */
+typedef enum {
+    LIMITE_DESCONHECIDO,    /* Verificado na execução */
+    LIMITE_SEGURO,          /* Sempre entre 1 e o tamanho */
+    LIMITE_FORA             /* Sempre fora (erro de compilação) */
+} VerificacaoLimite;
 
 /* Nó de variável (para referência) */
 typedef struct NoVar {
-    char *nome;
+    ChaveId chave;
     struct NoExpr *indice;  /* NULL para variáveis simples, expressão para arrays */
+    struct EntradaSimbolo *simbolo;  /* Ligado uma única vez na análise semântica */
     int linha;
     int coluna;
+    VerificacaoLimite limite;  /* Só com índice */
 } NoVar;
 
 /* Lista de variáveis (para LEIA) */
 typedef struct ListaVar {
     NoVar *var;
     struct ListaVar *prox;
+    struct ListaVar *ultimo;  /* Cauda da lista (válido apenas na cabeça) */
 } ListaVar;
 
 /* Nó de expressão */
@@ -130,7 +165,7 @@ typedef struct NoExpr {
             struct NoExpr *dir;
         } logica;
         
-        /* Negação lógica */
+        /* Operando de .NAO. (negação lógica) e de EXPR_NEG (aritmética) */
         struct NoExpr *negacao;
     } dado;
 } NoExpr;
@@ -143,6 +178,7 @@ typedef struct ListaEscreva {
         NoExpr *expr;
     } item;
     struct ListaEscreva *prox;
+    struct ListaEscreva *ultimo;  /* Cauda da lista (válido apenas na cabeça) */
 } ListaEscreva;
 
 /* Nó de comando */
@@ -176,25 +212,21 @@ typedef struct NoCmd {
             NoExpr *condicao;
             struct NoCmd *corpo;
         } enquanto;
-        
-        /* Bloco de comandos */
-        struct {
-            struct NoCmd *cmd;
-            struct NoCmd *prox;
-        } bloco;
     } dado;
     
-    struct NoCmd *prox;  /* Próximo comando na sequência */
+    struct NoCmd *prox;    /* Próximo comando na sequência */
+    struct NoCmd *ultimo;  /* Cauda da sequência (válido apenas na cabeça) */
 } NoCmd;
 
 /* Nó de declaração */
 typedef struct NoDecl {
     TipoDado tipo;
-    char *nome;
+    ChaveId chave;
     int tamanho_array;  /* 0 para variáveis simples */
     int linha;
     int coluna;
     struct NoDecl *prox;
+    struct NoDecl *ultimo;  /* Cauda da lista (válido apenas na cabeça) */
 } NoDecl;
 
 /* Nó raiz do programa */
@@ -202,63 +234,89 @@ typedef struct NoPrograma {
     char *nome;
     NoDecl *declaracoes;
     NoCmd *algoritmo;
+    int tamanho_quadro;  /* Posições do quadro (definido na análise semântica) */
 } NoPrograma;
 
 /* ========== Funções de criação de nós ========== */
 
+/*
+ * Os nós são alocados na arena do contexto de compilação e recebem a
+ * posição corrente do seu analisador léxico (ver contexto.h).
+ */
+typedef struct ContextoCompilacao ContextoCompilacao;
+
+/*
+ * As funções concat_* anexam em O(1): a cabeça de cada lista guarda em
+ * 'ultimo' o seu nó final, de modo que as regras recursivas à esquerda
+ * do parser constroem sequências em tempo linear.
+ */
+
 /* Programa */
-NoPrograma *criar_programa(char *nome, NoDecl *decl, NoCmd *algo);
+NoPrograma *criar_programa(ContextoCompilacao *ctx, char *nome, NoDecl *decl, NoCmd *algo);
 
 /* Declarações */
-NoDecl *criar_declaracao(TipoDado tipo, char *nome, int tamanho);
+NoDecl *criar_declaracao(ContextoCompilacao *ctx, TipoDado tipo, ChaveId chave, int tamanho);
 NoDecl *concat_declaracoes(NoDecl *lista, NoDecl *nova);
 
-/* Variáveis */
-NoVar *criar_var_simples(char *nome);
-NoVar *criar_var_array(char *nome, NoExpr *indice);
-ListaVar *criar_lista_var(NoVar *var);
-ListaVar *concat_lista_var(ListaVar *lista, NoVar *var);
+/* Variáveis (um elemento de array recebe o 'indice' depois, no parser) */
+NoVar *criar_var_simples(ContextoCompilacao *ctx, ChaveId chave);
+ListaVar *criar_lista_var(ContextoCompilacao *ctx, NoVar *var);
+ListaVar *concat_lista_var(ContextoCompilacao *ctx, ListaVar *lista, NoVar *var);
 
 /* Expressões */
-NoExpr *criar_expr_const_int(int valor);
-NoExpr *criar_expr_const_real(double valor);
-NoExpr *criar_expr_var(NoVar *var);
-NoExpr *criar_expr_aritmetica(OpAritmetico op, NoExpr *esq, NoExpr *dir);
-NoExpr *criar_expr_relacional(OpRelacional op, NoExpr *esq, NoExpr *dir);
-NoExpr *criar_expr_logica(OpLogico op, NoExpr *esq, NoExpr *dir);
-NoExpr *criar_expr_nao(NoExpr *expr);
+NoExpr *criar_expr_const_int(ContextoCompilacao *ctx, int valor);
+NoExpr *criar_expr_const_real(ContextoCompilacao *ctx, double valor);
+NoExpr *criar_expr_var(ContextoCompilacao *ctx, NoVar *var);
+NoExpr *criar_expr_aritmetica(ContextoCompilacao *ctx, OpAritmetico op, NoExpr *esq, NoExpr *dir);
+NoExpr *criar_expr_relacional(ContextoCompilacao *ctx, OpRelacional op, NoExpr *esq, NoExpr *dir);
+NoExpr *criar_expr_logica(ContextoCompilacao *ctx, OpLogico op, NoExpr *esq, NoExpr *dir);
+NoExpr *criar_expr_nao(ContextoCompilacao *ctx, NoExpr *expr);
 
 /* Comandos */
-NoCmd *criar_cmd_atrib(NoVar *var, NoExpr *expr);
-NoCmd *criar_cmd_leia(ListaVar *vars);
-NoCmd *criar_cmd_escreva(ListaEscreva *itens);
-NoCmd *criar_cmd_se(NoExpr *cond, NoCmd *entao, NoCmd *senao);
-NoCmd *criar_cmd_enquanto(NoExpr *cond, NoCmd *corpo);
+NoCmd *criar_cmd_atrib(ContextoCompilacao *ctx, NoVar *var, NoExpr *expr);
+NoCmd *criar_cmd_leia(ContextoCompilacao *ctx, ListaVar *vars);
+NoCmd *criar_cmd_escreva(ContextoCompilacao *ctx, ListaEscreva *itens);
+NoCmd *criar_cmd_se(ContextoCompilacao *ctx, NoExpr *cond, NoCmd *entao, NoCmd *senao);
+NoCmd *criar_cmd_enquanto(ContextoCompilacao *ctx, NoExpr *cond, NoCmd *corpo);
 NoCmd *concat_comandos(NoCmd *lista, NoCmd *novo);
 
 /* Lista de itens para ESCREVA */
-ListaEscreva *criar_item_cadeia(char *cadeia);
-ListaEscreva *criar_item_expr(NoExpr *expr);
+ListaEscreva *criar_item_cadeia(ContextoCompilacao *ctx, char *cadeia);
+ListaEscreva *criar_item_expr(ContextoCompilacao *ctx, NoExpr *expr);
 ListaEscreva *concat_lista_escreva(ListaEscreva *lista, ListaEscreva *item);
 
+/* ========== Percurso de comandos ========== */
+
+/*
+ * Visita os comandos de uma sequência e, sem recursão, os dos blocos
+ * aninhados: cada SE vem antes do seu ENTAO, que vem antes do SENAO e
+ * do restante da sequência (a ordem de um percurso recursivo). A pilha
+ * de sequências pendentes cresce no heap, então a profundidade de
+ * aninhamento é limitada só pela memória.
+ *
+ *     PercursoComandos p;
+ *     iniciar_percurso(&p, prog->algoritmo);
+ *     while ((cmd = proximo_comando(&p)) != NULL) { ... }
+ *     terminar_percurso(&p);
+ */
+typedef struct PercursoComandos {
+    NoCmd *proximo;
+    Pilha pendentes;
+} PercursoComandos;
+
+void iniciar_percurso(PercursoComandos *p, NoCmd *cmd);
+NoCmd *proximo_comando(PercursoComandos *p);
+void terminar_percurso(PercursoComandos *p);
+
 /* ========== Funções de impressão da AST ========== */
-void imprimir_ast(NoPrograma *prog);
-void imprimir_declaracoes(NoDecl *decl, int nivel);
-void imprimir_comandos(NoCmd *cmd, int nivel);
-void imprimir_expressao(NoExpr *expr);
-
-/* ========== Funções de liberação de memória ========== */
-void liberar_programa(NoPrograma *prog);
-void liberar_declaracoes(NoDecl *decl);
-void liberar_comandos(NoCmd *cmd);
-void liberar_expressao(NoExpr *expr);
-void liberar_var(NoVar *var);
-void liberar_lista_var(ListaVar *lista);
-void liberar_lista_escreva(ListaEscreva *lista);
-
-/* ========== Variáveis globais ========== */
-extern int linha;
-extern int coluna;
+
+/* Nome do tipo como na fonte ("INTEIRO", "LISTAREAL", ...) */
+const char *tipo_para_string(TipoDado tipo);
+
+void imprimir_ast(NoPrograma *prog, FILE *saida);
+void imprimir_declaracoes(NoDecl *decl, int nivel, FILE *saida);
+void imprimir_comandos(NoCmd *cmd, int nivel, FILE *saida);
+void imprimir_expressao(NoExpr *expr, FILE *saida);
 
 #endif /* AST_H */
 
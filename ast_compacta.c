@@ -0,0 +1,507 @@
+/*
+ * Implementação da AST compacta
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ast_compacta.h"
+#include "contexto.h"
+#include "pilha.h"
+
+/* Bytes de um nó da AST de ponteiros, como a arena o aloca */
+#define NA_ARENA(tipo) ((sizeof(tipo) + ARENA_ALINHAMENTO - 1) & ~(size_t)(ARENA_ALINHAMENTO - 1))
+
+/* ========== Resumo pela AST de ponteiros ========== */
+
+typedef struct {
+    NoExpr *expr;
+    int profundidade;
+} QuadroResumo;
+
+static void empilhar_resumo(Pilha *pilha, NoExpr *expr, int profundidade) {
+    if (expr != NULL) {
+        QuadroResumo *q = (QuadroResumo *)pilha_empilhar(pilha);
+        q->expr = expr;
+        q->profundidade = profundidade;
+    }
+}
+
+static void resumir_expr(ResumoAst *r, Pilha *pilha, NoExpr *raiz) {
+    QuadroResumo *q;
+
+    empilhar_resumo(pilha, raiz, 1);
+    while ((q = (QuadroResumo *)pilha_topo(pilha)) != NULL) {
+        NoExpr *expr = q->expr;
+        int p = q->profundidade;
+        pilha_desempilhar(pilha);
+
+        r->nos_expr[expr->tipo]++;
+        if (p > r->maior_profundidade) {
+            r->maior_profundidade = p;
+        }
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                r->vars++;
+                empilhar_resumo(pilha, expr->dado.var->indice, p + 1);
+                break;
+            case EXPR_ARITMETICA:
+            case EXPR_RELACIONAL:
+            case EXPR_LOGICA:
+                /* Os três membros da união têm o mesmo layout (op, esq, dir) */
+                empilhar_resumo(pilha, expr->dado.aritmetica.dir, p + 1);
+                empilhar_resumo(pilha, expr->dado.aritmetica.esq, p + 1);
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_resumo(pilha, expr->dado.negacao, p + 1);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void resumir_var(ResumoAst *r, Pilha *pilha, NoVar *var) {
+    r->vars++;
+    resumir_expr(r, pilha, var->indice);
+}
+
+void resumir_ast(NoPrograma *prog, ResumoAst *r) {
+    PercursoComandos percurso;
+    Pilha pilha;
+    NoCmd *cmd;
+
+    memset(r, 0, sizeof(*r));
+    r->sequencias = 1;
+    pilha_iniciar(&pilha, sizeof(QuadroResumo));
+    iniciar_percurso(&percurso, prog->algoritmo);
+
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        r->nos_cmd[cmd->tipo]++;
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                resumir_var(r, &pilha, cmd->dado.atrib.var);
+                resumir_expr(r, &pilha, cmd->dado.atrib.expr);
+                break;
+            case CMD_LEIA:
+                for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                    resumir_var(r, &pilha, l->var);
+                    r->bytes += NA_ARENA(ListaVar);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *l = cmd->dado.escreva; l != NULL; l = l->prox) {
+                    r->itens++;
+                    r->bytes += NA_ARENA(ListaEscreva);
+                    if (l->is_cadeia) {
+                        r->cadeias++;
+                    } else {
+                        resumir_expr(r, &pilha, l->item.expr);
+                    }
+                }
+                break;
+            case CMD_SE:
+                resumir_expr(r, &pilha, cmd->dado.se.condicao);
+                r->sequencias += (cmd->dado.se.entao != NULL) + (cmd->dado.se.senao != NULL);
+                break;
+            case CMD_ENQUANTO:
+                resumir_expr(r, &pilha, cmd->dado.enquanto.condicao);
+                r->sequencias += (cmd->dado.enquanto.corpo != NULL);
+                break;
+        }
+    }
+
+    terminar_percurso(&percurso);
+    pilha_liberar(&pilha);
+
+    for (int i = 0; i <= EXPR_NEG; i++) r->bytes += r->nos_expr[i] * NA_ARENA(NoExpr);
+    for (int i = 0; i <= CMD_ENQUANTO; i++) r->bytes += r->nos_cmd[i] * NA_ARENA(NoCmd);
+    r->bytes += r->vars * NA_ARENA(NoVar);
+}
+
+/* ========== Construção ========== */
+
+typedef struct {
+    ContextoCompilacao *ctx;
+    AstCompacta *ac;
+    Pilha quadros;              /* QuadroCompactacao */
+    Pilha resultados;           /* IdNo dos operandos já compactados */
+    Pilha sequencias;           /* SequenciaPendente */
+    int sem_memoria;
+} Compactador;
+
+typedef struct {
+    NoExpr *expr;
+    int operandos_empilhados;
+} QuadroCompactacao;
+
+/* Sequência já numerada cujos comandos ainda não foram copiados */
+typedef struct {
+    NoCmd *primeiro;
+    IdNo seq;
+} SequenciaPendente;
+
+static void *vetor(Compactador *c, uint32_t n, size_t tam) {
+    void *v = calloc((size_t)n + 1, tam);   /* + a posição 0, não usada */
+    if (v == NULL) {
+        c->sem_memoria = 1;
+    }
+    c->ac->bytes += ((size_t)n + 1) * tam;
+    return v;
+}
+
+static PosicaoFonte posicao(int linha, int coluna) {
+    PosicaoFonte p;
+    p.linha = linha;
+    p.coluna = coluna;
+    return p;
+}
+
+static void empilhar_compactacao(Compactador *c, NoExpr *expr) {
+    QuadroCompactacao *q = (QuadroCompactacao *)pilha_empilhar(&c->quadros);
+    q->expr = expr;
+    q->operandos_empilhados = 0;
+}
+
+static IdNo resultado(Compactador *c) {
+    IdNo id = *(IdNo *)pilha_topo(&c->resultados);
+    pilha_desempilhar(&c->resultados);
+    return id;
+}
+
+static void preencher_var(Compactador *c, IdNo id, NoVar *var, IdNo indice) {
+    VarsCompactas *v = &c->ac->vars;
+    v->chave[id] = var->chave;
+    v->simbolo[id] = var->simbolo != NULL ? (int32_t)(var->simbolo - c->ctx->tabela.simbolos) : -1;
+    v->indice[id] = indice;
+    v->posicao[id] = posicao(var->linha, var->coluna);
+}
+
+/*
+ * Copia a expressão em pós-ordem, sem recursão: um nó só recebe índice
+ * depois dos seus operandos, cujos índices ficam em 'resultados'.
+ */
+static IdNo compactar_expr(Compactador *c, NoExpr *raiz) {
+    AstCompacta *ac = c->ac;
+    ExprsCompactas *e = &ac->expr;
+    QuadroCompactacao *q;
+
+    if (raiz == NULL) return NENHUM;
+
+    empilhar_compactacao(c, raiz);
+    while ((q = (QuadroCompactacao *)pilha_topo(&c->quadros)) != NULL) {
+        NoExpr *expr = q->expr;
+
+        if (!q->operandos_empilhados) {
+            /* O esquerdo é empilhado por último: recebe índice primeiro */
+            q->operandos_empilhados = 1;
+            switch (expr->tipo) {
+                case EXPR_VAR:
+                case EXPR_VAR_ARRAY:
+                    if (expr->dado.var->indice != NULL) {
+                        empilhar_compactacao(c, expr->dado.var->indice);
+                    }
+                    break;
+                case EXPR_ARITMETICA:
+                case EXPR_RELACIONAL:
+                case EXPR_LOGICA:
+                    empilhar_compactacao(c, expr->dado.aritmetica.dir);
+                    empilhar_compactacao(c, expr->dado.aritmetica.esq);
+                    break;
+                case EXPR_NAO:
+                case EXPR_NEG:
+                    empilhar_compactacao(c, expr->dado.negacao);
+                    break;
+                default:
+                    break;
+            }
+            continue;
+        }
+
+        pilha_desempilhar(&c->quadros);
+        IdNo id = e->num++;
+        IdNo a = NENHUM, b = NENHUM;
+        uint8_t op = 0;
+
+        switch (expr->tipo) {
+            case EXPR_CONST_INT:
+                a = (IdNo)expr->dado.const_int;
+                break;
+            case EXPR_CONST_REAL:
+                a = ac->num_reais++;
+                ac->reais[a] = expr->dado.const_real;
+                break;
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                {
+                    NoVar *var = expr->dado.var;
+                    IdNo indice = var->indice != NULL ? resultado(c) : NENHUM;
+                    a = ac->vars.num++;
+                    preencher_var(c, a, var, indice);
+                }
+                break;
+            case EXPR_ARITMETICA:
+            case EXPR_RELACIONAL:
+            case EXPR_LOGICA:
+                b = resultado(c);
+                a = resultado(c);
+                op = (uint8_t)expr->dado.aritmetica.op;
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                a = resultado(c);
+                break;
+        }
+
+        e->tipo[id] = (uint8_t)expr->tipo;
+        e->tipo_dado[id] = (uint8_t)expr->tipo_dado;
+        e->op[id] = op;
+        e->a[id] = a;
+        e->b[id] = b;
+        e->posicao[id] = posicao(expr->linha, expr->coluna);
+        *(IdNo *)pilha_empilhar(&c->resultados) = id;
+    }
+    return resultado(c);
+}
+
+static IdNo compactar_var(Compactador *c, IdNo id, NoVar *var) {
+    preencher_var(c, id, var, compactar_expr(c, var->indice));
+    return id;
+}
+
+/* Numera uma sequência de comandos, copiada depois por compactar_sequencia */
+static IdNo nova_sequencia(Compactador *c, NoCmd *primeiro) {
+    SequenciaPendente *s;
+
+    if (primeiro == NULL) return NENHUM;
+    s = (SequenciaPendente *)pilha_empilhar(&c->sequencias);
+    s->primeiro = primeiro;
+    s->seq = c->ac->num_seqs++;
+    return s->seq;
+}
+
+/*
+ * Copia os comandos de uma sequência para posições contíguas. Os corpos
+ * de SE/ENQUANTO viram novas sequências pendentes (sem recursão).
+ */
+static void compactar_sequencia(Compactador *c, NoCmd *primeiro, IdNo seq) {
+    AstCompacta *ac = c->ac;
+    CmdsCompactos *k = &ac->cmds;
+    uint32_t n = 0;
+
+    for (NoCmd *cmd = primeiro; cmd != NULL; cmd = cmd->prox) n++;
+    ac->inicio_seq[seq] = k->num;
+    ac->quantidade_seq[seq] = n;
+
+    IdNo id = k->num;
+    k->num += n;
+    for (NoCmd *cmd = primeiro; cmd != NULL; cmd = cmd->prox, id++) {
+        IdNo a = NENHUM, b = NENHUM, d = NENHUM;
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                a = compactar_var(c, ac->vars.num++, cmd->dado.atrib.var);
+                b = compactar_expr(c, cmd->dado.atrib.expr);
+                break;
+
+            case CMD_LEIA:
+                {
+                    /* Reserva as variáveis juntas; os índices vêm depois */
+                    ListaVar *l;
+                    for (l = cmd->dado.leia; l != NULL; l = l->prox) b++;
+                    a = ac->vars.num;
+                    ac->vars.num += b;
+                    IdNo v = a;
+                    for (l = cmd->dado.leia; l != NULL; l = l->prox) {
+                        compactar_var(c, v++, l->var);
+                    }
+                }
+                break;
+
+            case CMD_ESCREVA:
+                {
+                    ListaEscreva *l;
+                    for (l = cmd->dado.escreva; l != NULL; l = l->prox) b++;
+                    a = ac->num_itens;
+                    ac->num_itens += b;
+                    IdNo i = a;
+                    for (l = cmd->dado.escreva; l != NULL; l = l->prox, i++) {
+                        ac->item_cadeia[i] = (uint8_t)l->is_cadeia;
+                        if (l->is_cadeia) {
+                            ac->item[i] = ac->num_cadeias;
+                            ac->cadeias[ac->num_cadeias++] = l->item.cadeia;
+                        } else {
+                            ac->item[i] = compactar_expr(c, l->item.expr);
+                        }
+                    }
+                }
+                break;
+
+            case CMD_SE:
+                a = compactar_expr(c, cmd->dado.se.condicao);
+                b = nova_sequencia(c, cmd->dado.se.entao);
+                d = nova_sequencia(c, cmd->dado.se.senao);
+                break;
+
+            case CMD_ENQUANTO:
+                a = compactar_expr(c, cmd->dado.enquanto.condicao);
+                b = nova_sequencia(c, cmd->dado.enquanto.corpo);
+                break;
+        }
+
+        k->tipo[id] = (uint8_t)cmd->tipo;
+        k->a[id] = a;
+        k->b[id] = b;
+        k->c[id] = d;
+        k->posicao[id] = posicao(cmd->linha, cmd->coluna);
+    }
+}
+
+int compactar_programa(ContextoCompilacao *ctx, NoPrograma *prog, AstCompacta *ac) {
+    Compactador c;
+    ResumoAst r;
+    uint32_t exprs = 0, cmds = 0;
+
+    memset(ac, 0, sizeof(*ac));
+    memset(&c, 0, sizeof(c));
+    c.ctx = ctx;
+    c.ac = ac;
+
+    /* Uma contagem antes: cada vetor é alocado uma vez, do tamanho exato */
+    resumir_ast(prog, &r);
+    for (int i = 0; i <= EXPR_NEG; i++) exprs += (uint32_t)r.nos_expr[i];
+    for (int i = 0; i <= CMD_ENQUANTO; i++) cmds += (uint32_t)r.nos_cmd[i];
+
+    ac->expr.tipo = vetor(&c, exprs, sizeof(uint8_t));
+    ac->expr.tipo_dado = vetor(&c, exprs, sizeof(uint8_t));
+    ac->expr.op = vetor(&c, exprs, sizeof(uint8_t));
+    ac->expr.a = vetor(&c, exprs, sizeof(IdNo));
+    ac->expr.b = vetor(&c, exprs, sizeof(IdNo));
+    ac->expr.posicao = vetor(&c, exprs, sizeof(PosicaoFonte));
+    ac->vars.chave = vetor(&c, (uint32_t)r.vars, sizeof(ChaveId));
+    ac->vars.simbolo = vetor(&c, (uint32_t)r.vars, sizeof(int32_t));
+    ac->vars.indice = vetor(&c, (uint32_t)r.vars, sizeof(IdNo));
+    ac->vars.posicao = vetor(&c, (uint32_t)r.vars, sizeof(PosicaoFonte));
+    ac->cmds.tipo = vetor(&c, cmds, sizeof(uint8_t));
+    ac->cmds.a = vetor(&c, cmds, sizeof(IdNo));
+    ac->cmds.b = vetor(&c, cmds, sizeof(IdNo));
+    ac->cmds.c = vetor(&c, cmds, sizeof(IdNo));
+    ac->cmds.posicao = vetor(&c, cmds, sizeof(PosicaoFonte));
+    ac->inicio_seq = vetor(&c, (uint32_t)r.sequencias, sizeof(IdNo));
+    ac->quantidade_seq = vetor(&c, (uint32_t)r.sequencias, sizeof(uint32_t));
+    ac->item_cadeia = vetor(&c, (uint32_t)r.itens, sizeof(uint8_t));
+    ac->item = vetor(&c, (uint32_t)r.itens, sizeof(IdNo));
+    ac->reais = vetor(&c, (uint32_t)r.nos_expr[EXPR_CONST_REAL], sizeof(double));
+    ac->cadeias = vetor(&c, (uint32_t)r.cadeias, sizeof(const char *));
+    if (c.sem_memoria) {
+        liberar_ast_compacta(ac);
+        return 0;
+    }
+
+    ac->expr.num = ac->vars.num = ac->cmds.num = 1;
+    ac->num_seqs = ac->num_itens = ac->num_reais = ac->num_cadeias = 1;
+    ac->nome = prog->nome;
+    ac->tamanho_quadro = prog->tamanho_quadro;
+
+    pilha_iniciar(&c.quadros, sizeof(QuadroCompactacao));
+    pilha_iniciar(&c.resultados, sizeof(IdNo));
+    pilha_iniciar(&c.sequencias, sizeof(SequenciaPendente));
+
+    /* O algoritmo é sempre uma sequência, mesmo vazio */
+    ac->algoritmo = ac->num_seqs++;
+    compactar_sequencia(&c, prog->algoritmo, ac->algoritmo);
+
+    SequenciaPendente *s;
+    while ((s = (SequenciaPendente *)pilha_topo(&c.sequencias)) != NULL) {
+        SequenciaPendente pendente = *s;
+        pilha_desempilhar(&c.sequencias);
+        compactar_sequencia(&c, pendente.primeiro, pendente.seq);
+    }
+
+    pilha_liberar(&c.quadros);
+    pilha_liberar(&c.resultados);
+    pilha_liberar(&c.sequencias);
+    return 1;
+}
+
+void liberar_ast_compacta(AstCompacta *ac) {
+    free(ac->expr.tipo);
+    free(ac->expr.tipo_dado);
+    free(ac->expr.op);
+    free(ac->expr.a);
+    free(ac->expr.b);
+    free(ac->expr.posicao);
+    free(ac->vars.chave);
+    free(ac->vars.simbolo);
+    free(ac->vars.indice);
+    free(ac->vars.posicao);
+    free(ac->cmds.tipo);
+    free(ac->cmds.a);
+    free(ac->cmds.b);
+    free(ac->cmds.c);
+    free(ac->cmds.posicao);
+    free(ac->inicio_seq);
+    free(ac->quantidade_seq);
+    free(ac->item_cadeia);
+    free(ac->item);
+    free(ac->reais);
+    free((void *)ac->cadeias);
+    memset(ac, 0, sizeof(*ac));
+}
+
+/* ========== Resumo pela AST compacta ========== */
+
+/*
+ * Como os operandos vêm antes dos nós, a altura de cada expressão sai de
+ * uma única varredura crescente; os comandos são outra varredura.
+ */
+void resumir_ast_compacta(const AstCompacta *ac, ResumoAst *r) {
+    const ExprsCompactas *e = &ac->expr;
+    uint32_t *altura = (uint32_t *)malloc(((size_t)e->num + 1) * sizeof(uint32_t));
+
+    memset(r, 0, sizeof(*r));
+    if (altura == NULL) {
+        return;
+    }
+    altura[NENHUM] = 0;
+
+    for (IdNo i = 1; i < e->num; i++) {
+        uint32_t h = 0;
+        r->nos_expr[e->tipo[i]]++;
+        switch (e->tipo[i]) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                h = altura[ac->vars.indice[e->a[i]]];
+                break;
+            case EXPR_ARITMETICA:
+            case EXPR_RELACIONAL:
+            case EXPR_LOGICA:
+                h = altura[e->a[i]] > altura[e->b[i]] ? altura[e->a[i]] : altura[e->b[i]];
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                h = altura[e->a[i]];
+                break;
+            default:
+                break;
+        }
+        altura[i] = h + 1;
+        if ((int)altura[i] > r->maior_profundidade) {
+            r->maior_profundidade = (int)altura[i];
+        }
+    }
+
+    for (IdNo i = 1; i < ac->cmds.num; i++) {
+        r->nos_cmd[ac->cmds.tipo[i]]++;
+    }
+    r->vars = ac->vars.num - 1;
+    r->itens = ac->num_itens - 1;
+    r->cadeias = ac->num_cadeias - 1;
+    r->sequencias = ac->num_seqs - 1;
+    r->bytes = ac->bytes;
+
+    free(altura);
+}
@@ -0,0 +1,134 @@
+/*
+ * AST compacta: nós em vetores por tipo, filhos como índices de 32 bits
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef AST_COMPACTA_H
+#define AST_COMPACTA_H
+
+#include <stdint.h>
+#include "ast.h"
+
+/* Índice de um nó no seu vetor; a posição 0 de cada vetor não é usada */
+typedef uint32_t IdNo;
+#define NENHUM 0
+
+/* Posição no fonte, guardada fora dos nós (só os diagnósticos a leem) */
+typedef struct PosicaoFonte {
+    int linha;
+    int coluna;
+} PosicaoFonte;
+
+/*
+ * Expressões, em pós-ordem: os operandos de um nó têm sempre índices
+ * menores que o dele, então um laço de 1 a num - 1 visita a árvore de
+ * baixo para cima, sem pilha.
+ *
+ *   tipo                      a                          b
+ *   EXPR_CONST_INT            valor (bits do int)        -
+ *   EXPR_CONST_REAL           índice em 'reais'          -
+ *   EXPR_VAR, EXPR_VAR_ARRAY  índice em 'vars'           -
+ *   binárias                  esq                        dir
+ *   EXPR_NAO, EXPR_NEG        operando                   -
+ */
+typedef struct ExprsCompactas {
+    uint8_t *tipo;              /* TipoExpr */
+    uint8_t *tipo_dado;         /* TipoDado */
+    uint8_t *op;                /* OpAritmetico, OpRelacional ou OpLogico */
+    IdNo *a;
+    IdNo *b;
+    PosicaoFonte *posicao;
+    uint32_t num;
+} ExprsCompactas;
+
+/* Referências a variáveis (indice: expressão, ou NENHUM) */
+typedef struct VarsCompactas {
+    ChaveId *chave;
+    int32_t *simbolo;           /* Entrada em ctx->tabela.simbolos, ou -1 */
+    IdNo *indice;
+    PosicaoFonte *posicao;
+    uint32_t num;
+} VarsCompactas;
+
+/*
+ * Comandos. Os de uma mesma sequência ficam contíguos, então não há
+ * 'prox': uma sequência é um intervalo [inicio, inicio + quantidade).
+ *
+ *   tipo          a                    b                      c
+ *   CMD_ATRIB     var                  expressão              -
+ *   CMD_LEIA      primeira var         quantidade             -
+ *   CMD_ESCREVA   primeiro item        quantidade             -
+ *   CMD_SE        condição             sequência ENTAO        sequência SENAO
+ *   CMD_ENQUANTO  condição             sequência do corpo     -
+ */
+typedef struct CmdsCompactos {
+    uint8_t *tipo;              /* TipoCmd */
+    IdNo *a;
+    IdNo *b;
+    IdNo *c;
+    PosicaoFonte *posicao;
+    uint32_t num;
+} CmdsCompactos;
+
+typedef struct AstCompacta {
+    ExprsCompactas expr;
+    VarsCompactas vars;
+    CmdsCompactos cmds;
+
+    /* Sequências de comandos: o algoritmo é a sequência 'algoritmo' */
+    IdNo *inicio_seq;
+    uint32_t *quantidade_seq;
+    uint32_t num_seqs;
+    IdNo algoritmo;
+
+    /* Itens de ESCREVA: cadeia (índice em 'cadeias') ou expressão */
+    uint8_t *item_cadeia;
+    IdNo *item;
+    uint32_t num_itens;
+
+    double *reais;
+    uint32_t num_reais;
+
+    /* Apontam para as cadeias da AST original (arena ou fonte mapeada) */
+    const char **cadeias;
+    uint32_t num_cadeias;
+
+    const char *nome;
+    int tamanho_quadro;
+
+    size_t bytes;               /* Soma dos vetores acima */
+} AstCompacta;
+
+/*
+ * Resumo de uma AST, calculado nas duas representações para comparar o
+ * custo de percorrê-las: nós por tipo, maior profundidade de expressão e
+ * bytes ocupados pelos nós.
+ */
+typedef struct ResumoAst {
+    long nos_expr[EXPR_NEG + 1];
+    long nos_cmd[CMD_ENQUANTO + 1];
+    long vars;                  /* Referências a variáveis */
+    long itens;                 /* Itens de ESCREVA */
+    long cadeias;
+    long sequencias;            /* Algoritmo e corpos não vazios de SE/ENQUANTO */
+    int maior_profundidade;
+    size_t bytes;
+} ResumoAst;
+
+/*
+ * Achata 'prog' (já analisado: NoVar->simbolo ligado) em 'ac'. Cada
+ * vetor é alocado uma única vez, do tamanho exato, após uma contagem.
+ * A AST original continua válida e deve viver enquanto 'ac' for usada
+ * (as cadeias são compartilhadas). Retorna 0 sem memória.
+ */
+int compactar_programa(ContextoCompilacao *ctx, NoPrograma *prog, AstCompacta *ac);
+
+void liberar_ast_compacta(AstCompacta *ac);
+
+/* Resumo percorrendo os ponteiros (pilha explícita) */
+void resumir_ast(NoPrograma *prog, ResumoAst *r);
+
+/* O mesmo resumo em varreduras lineares dos vetores */
+void resumir_ast_compacta(const AstCompacta *ac, ResumoAst *r);
+
+#endif /* AST_COMPACTA_H */
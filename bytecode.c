@@ -0,0 +1,450 @@
+/*
+ * Compilação da AST de X25b para bytecode
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+#include "semantic.h"
+
+/* Estado da compilação */
+typedef struct Compilador {
+    Bytecode *bc;
+    int profundidade;       /* Profundidade corrente da pilha de operandos */
+} Compilador;
+
+/* Nome e número de operandos de cada instrução */
+static const struct {
+    const char *nome;
+    int operandos;
+} info_opcodes[NUM_OPCODES] = {
+    [OP_CONST_I]     = { "CONST_I", 1 },
+    [OP_CONST_R]     = { "CONST_R", 1 },
+    [OP_CARREGA]     = { "CARREGA", 1 },
+    [OP_CARREGA_ARR] = { "CARREGA_ARR", 3 },
+    [OP_GUARDA]      = { "GUARDA", 1 },
+    [OP_GUARDA_ARR]  = { "GUARDA_ARR", 3 },
+    [OP_CARREGA_ELEM] = { "CARREGA_ELEM", 1 },
+    [OP_GUARDA_ELEM] = { "GUARDA_ELEM", 1 },
+    [OP_I2R]         = { "I2R", 0 },
+    [OP_R2I]         = { "R2I", 0 },
+    [OP_SOMA_I]      = { "SOMA_I", 0 },
+    [OP_SUB_I]       = { "SUB_I", 0 },
+    [OP_MULT_I]      = { "MULT_I", 0 },
+    [OP_DIV_I]       = { "DIV_I", 1 },
+    [OP_SOMA_R]      = { "SOMA_R", 0 },
+    [OP_SUB_R]       = { "SUB_R", 0 },
+    [OP_MULT_R]      = { "MULT_R", 0 },
+    [OP_DIV_R]       = { "DIV_R", 0 },
+    [OP_MAQ_I]       = { "MAQ_I", 0 },
+    [OP_MAI_I]       = { "MAI_I", 0 },
+    [OP_MEQ_I]       = { "MEQ_I", 0 },
+    [OP_MEI_I]       = { "MEI_I", 0 },
+    [OP_IGU_I]       = { "IGU_I", 0 },
+    [OP_DIF_I]       = { "DIF_I", 0 },
+    [OP_MAQ_R]       = { "MAQ_R", 0 },
+    [OP_MAI_R]       = { "MAI_R", 0 },
+    [OP_MEQ_R]       = { "MEQ_R", 0 },
+    [OP_MEI_R]       = { "MEI_R", 0 },
+    [OP_IGU_R]       = { "IGU_R", 0 },
+    [OP_DIF_R]       = { "DIF_R", 0 },
+    [OP_NEG_I]       = { "NEG_I", 0 },
+    [OP_NEG_R]       = { "NEG_R", 0 },
+    [OP_NAO]         = { "NAO", 0 },
+    [OP_DESVIA]      = { "DESVIA", 1 },
+    [OP_DESVIA_F]    = { "DESVIA_F", 1 },
+    [OP_DESVIA_V]    = { "DESVIA_V", 1 },
+    [OP_LEIA_I]      = { "LEIA_I", 1 },
+    [OP_LEIA_R]      = { "LEIA_R", 1 },
+    [OP_ESCREVA_I]   = { "ESCREVA_I", 0 },
+    [OP_ESCREVA_R]   = { "ESCREVA_R", 0 },
+    [OP_ESCREVA_S]   = { "ESCREVA_S", 1 },
+    [OP_FIM_LINHA]   = { "FIM_LINHA", 0 },
+    [OP_PARA]        = { "PARA", 0 },
+};
+
+/* ========== Emissão ========== */
+
+static void *crescer(void *vetor, int *capacidade, size_t elem) {
+    *capacidade = *capacidade ? *capacidade * 2 : 64;
+    void *novo = realloc(vetor, (size_t)*capacidade * elem);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para o bytecode\n");
+        exit(1);
+    }
+    return novo;
+}
+
+static int emitir_palavra(Compilador *c, int32_t palavra) {
+    Bytecode *bc = c->bc;
+    if (bc->tamanho == bc->capacidade) {
+        bc->codigo = crescer(bc->codigo, &bc->capacidade, sizeof(int32_t));
+    }
+    bc->codigo[bc->tamanho] = palavra;
+    return bc->tamanho++;
+}
+
+/* Ajusta a profundidade da pilha após uma instrução */
+static void pilha(Compilador *c, int delta) {
+    c->profundidade += delta;
+    if (c->profundidade > c->bc->pilha_max) {
+        c->bc->pilha_max = c->profundidade;
+    }
+}
+
+static void emitir(Compilador *c, OpCode op, int delta) {
+    emitir_palavra(c, op);
+    pilha(c, delta);
+}
+
+static void emitir1(Compilador *c, OpCode op, int32_t a, int delta) {
+    emitir_palavra(c, op);
+    emitir_palavra(c, a);
+    pilha(c, delta);
+}
+
+static void emitir3(Compilador *c, OpCode op, int32_t a, int32_t b, int32_t d, int delta) {
+    emitir_palavra(c, op);
+    emitir_palavra(c, a);
+    emitir_palavra(c, b);
+    emitir_palavra(c, d);
+    pilha(c, delta);
+}
+
+/* Emite um desvio com alvo a definir; retorna a posição do operando */
+static int emitir_desvio(Compilador *c, OpCode op) {
+    emitir_palavra(c, op);
+    int pos = emitir_palavra(c, -1);
+    pilha(c, op == OP_DESVIA ? 0 : -1);
+    return pos;
+}
+
+static void corrigir_desvio(Compilador *c, int pos, int alvo) {
+    c->bc->codigo[pos] = alvo;
+}
+
+static int adicionar_real(Compilador *c, double valor) {
+    Bytecode *bc = c->bc;
+    if (bc->num_reais == bc->cap_reais) {
+        bc->reais = crescer(bc->reais, &bc->cap_reais, sizeof(double));
+    }
+    bc->reais[bc->num_reais] = valor;
+    return bc->num_reais++;
+}
+
+static int adicionar_cadeia(Compilador *c, const char *cadeia) {
+    Bytecode *bc = c->bc;
+    if (bc->num_cadeias == bc->cap_cadeias) {
+        bc->cadeias = crescer(bc->cadeias, &bc->cap_cadeias, sizeof(char *));
+    }
+    bc->cadeias[bc->num_cadeias] = cadeia;
+    return bc->num_cadeias++;
+}
+
+/* ========== Expressões ========== */
+
+static void compilar_expressao(Compilador *c, NoExpr *expr, TipoDado alvo);
+
+static int elemento_real(EntradaSimbolo *s) {
+    return s->tipo == TIPO_REAL || s->tipo == TIPO_LISTAREAL;
+}
+
+/* Empilha o índice (se houver) da variável referenciada */
+static void compilar_indice(Compilador *c, NoVar *var) {
+    if (var->indice != NULL) {
+        compilar_expressao(c, var->indice, TIPO_INTEIRO);
+    }
+}
+
+static void compilar_carga(Compilador *c, NoVar *var) {
+    EntradaSimbolo *s = var->simbolo;
+    c->bc->nomes_slot[s->slot] = var->chave;
+    if (var->indice == NULL) {
+        emitir1(c, OP_CARREGA, s->slot, +1);
+    } else if (var->limite == LIMITE_SEGURO) {
+        compilar_indice(c, var);
+        emitir1(c, OP_CARREGA_ELEM, s->slot - 1, 0);
+    } else {
+        compilar_indice(c, var);
+        emitir3(c, OP_CARREGA_ARR, s->slot, s->tamanho_array, var->linha, 0);
+    }
+}
+
+/* Grava o topo da pilha na variável (o índice, se houver, está abaixo) */
+static void compilar_guarda(Compilador *c, NoVar *var) {
+    EntradaSimbolo *s = var->simbolo;
+    c->bc->nomes_slot[s->slot] = var->chave;
+    if (var->indice == NULL) {
+        emitir1(c, OP_GUARDA, s->slot, -1);
+    } else if (var->limite == LIMITE_SEGURO) {
+        emitir1(c, OP_GUARDA_ELEM, s->slot - 1, -2);
+    } else {
+        emitir3(c, OP_GUARDA_ARR, s->slot, s->tamanho_array, var->linha, -2);
+    }
+}
+
+static void compilar_aritmetica(Compilador *c, NoExpr *expr, TipoDado tipo) {
+    compilar_expressao(c, expr->dado.aritmetica.esq, tipo);
+    compilar_expressao(c, expr->dado.aritmetica.dir, tipo);
+
+    if (tipo == TIPO_REAL) {
+        static const OpCode ops[] = { OP_SOMA_R, OP_SUB_R, OP_MULT_R, OP_DIV_R };
+        emitir(c, ops[expr->dado.aritmetica.op], -1);
+    } else if (expr->dado.aritmetica.op == ARIT_DIV) {
+        emitir1(c, OP_DIV_I, expr->linha, -1);
+    } else {
+        static const OpCode ops[] = { OP_SOMA_I, OP_SUB_I, OP_MULT_I };
+        emitir(c, ops[expr->dado.aritmetica.op], -1);
+    }
+}
+
+static void compilar_relacional(Compilador *c, NoExpr *expr) {
+    static const OpCode ops_i[] = { OP_MAQ_I, OP_MAI_I, OP_MEQ_I, OP_MEI_I, OP_IGU_I, OP_DIF_I };
+    static const OpCode ops_r[] = { OP_MAQ_R, OP_MAI_R, OP_MEQ_R, OP_MEI_R, OP_IGU_R, OP_DIF_R };
+    NoExpr *esq = expr->dado.relacional.esq;
+    NoExpr *dir = expr->dado.relacional.dir;
+    TipoDado tipo = (esq->tipo_dado == TIPO_REAL || dir->tipo_dado == TIPO_REAL)
+                    ? TIPO_REAL : TIPO_INTEIRO;
+
+    compilar_expressao(c, esq, tipo);
+    compilar_expressao(c, dir, tipo);
+    emitir(c, tipo == TIPO_REAL ? ops_r[expr->dado.relacional.op]
+                                : ops_i[expr->dado.relacional.op], -1);
+}
+
+/*
+ * .E. e .OU. em curto-circuito, como nos demais modos de execução: o
+ * operando direito só é avaliado se o esquerdo não decidir o resultado
+ * (e pode depender disso, como em "d .DIF. 0 .E. x / d .MAI. 1").
+ * Empilha 0 ou 1.
+ */
+static void compilar_logica(Compilador *c, NoExpr *expr) {
+    int e = expr->dado.logica.op == LOG_E;
+    OpCode decide = e ? OP_DESVIA_F : OP_DESVIA_V;
+
+    compilar_expressao(c, expr->dado.logica.esq, TIPO_INTEIRO);
+    int curto1 = emitir_desvio(c, decide);
+    compilar_expressao(c, expr->dado.logica.dir, TIPO_INTEIRO);
+    int curto2 = emitir_desvio(c, decide);
+    emitir1(c, OP_CONST_I, e ? 1 : 0, +1);
+    int para_fim = emitir_desvio(c, OP_DESVIA);
+    pilha(c, -1);           /* O outro caminho empilha o seu próprio resultado */
+    corrigir_desvio(c, curto1, c->bc->tamanho);
+    corrigir_desvio(c, curto2, c->bc->tamanho);
+    emitir1(c, OP_CONST_I, e ? 0 : 1, +1);
+    corrigir_desvio(c, para_fim, c->bc->tamanho);
+}
+
+/* Compila 'expr' deixando no topo da pilha um valor do tipo 'alvo' */
+static void compilar_expressao(Compilador *c, NoExpr *expr, TipoDado alvo) {
+    TipoDado tipo = expr->tipo_dado == TIPO_REAL ? TIPO_REAL : TIPO_INTEIRO;
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+            if (alvo == TIPO_REAL) {
+                emitir1(c, OP_CONST_R, adicionar_real(c, expr->dado.const_int), +1);
+                return;
+            }
+            emitir1(c, OP_CONST_I, expr->dado.const_int, +1);
+            break;
+
+        case EXPR_CONST_REAL:
+            emitir1(c, OP_CONST_R, adicionar_real(c, expr->dado.const_real), +1);
+            break;
+
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            compilar_carga(c, expr->dado.var);
+            break;
+
+        case EXPR_ARITMETICA:
+            compilar_aritmetica(c, expr, tipo);
+            break;
+
+        case EXPR_RELACIONAL:
+            compilar_relacional(c, expr);
+            break;
+
+        case EXPR_LOGICA:
+            compilar_logica(c, expr);
+            break;
+
+        case EXPR_NAO:
+            compilar_expressao(c, expr->dado.negacao, TIPO_INTEIRO);
+            emitir(c, OP_NAO, 0);
+            break;
+
+        case EXPR_NEG:
+            compilar_expressao(c, expr->dado.negacao, tipo);
+            emitir(c, tipo == TIPO_REAL ? OP_NEG_R : OP_NEG_I, 0);
+            break;
+    }
+
+    /* Conversões implícitas entre INTEIRO e REAL */
+    if (tipo == TIPO_INTEIRO && alvo == TIPO_REAL) {
+        emitir(c, OP_I2R, 0);
+    } else if (tipo == TIPO_REAL && alvo == TIPO_INTEIRO) {
+        emitir(c, OP_R2I, 0);
+    }
+}
+
+/* ========== Comandos ========== */
+
+static void compilar_comandos(Compilador *c, NoCmd *cmd) {
+    while (cmd != NULL) {
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                {
+                    NoVar *var = cmd->dado.atrib.var;
+                    compilar_indice(c, var);
+                    compilar_expressao(c, cmd->dado.atrib.expr,
+                                       elemento_real(var->simbolo) ? TIPO_REAL : TIPO_INTEIRO);
+                    compilar_guarda(c, var);
+                }
+                break;
+
+            case CMD_LEIA:
+                {
+                    ListaVar *v = cmd->dado.leia;
+                    while (v != NULL) {
+                        compilar_indice(c, v->var);
+                        emitir1(c, elemento_real(v->var->simbolo) ? OP_LEIA_R : OP_LEIA_I,
+                                cmd->linha, +1);
+                        compilar_guarda(c, v->var);
+                        v = v->prox;
+                    }
+                }
+                break;
+
+            case CMD_ESCREVA:
+                {
+                    ListaEscreva *e = cmd->dado.escreva;
+                    while (e != NULL) {
+                        if (e->is_cadeia) {
+                            emitir1(c, OP_ESCREVA_S, adicionar_cadeia(c, e->item.cadeia), 0);
+                        } else if (e->item.expr->tipo_dado == TIPO_REAL) {
+                            compilar_expressao(c, e->item.expr, TIPO_REAL);
+                            emitir(c, OP_ESCREVA_R, -1);
+                        } else {
+                            compilar_expressao(c, e->item.expr, TIPO_INTEIRO);
+                            emitir(c, OP_ESCREVA_I, -1);
+                        }
+                        e = e->prox;
+                    }
+                    emitir(c, OP_FIM_LINHA, 0);
+                }
+                break;
+
+            case CMD_SE:
+                {
+                    compilar_expressao(c, cmd->dado.se.condicao, TIPO_INTEIRO);
+                    int para_senao = emitir_desvio(c, OP_DESVIA_F);
+                    compilar_comandos(c, cmd->dado.se.entao);
+                    if (cmd->dado.se.senao != NULL) {
+                        int para_fim = emitir_desvio(c, OP_DESVIA);
+                        corrigir_desvio(c, para_senao, c->bc->tamanho);
+                        compilar_comandos(c, cmd->dado.se.senao);
+                        corrigir_desvio(c, para_fim, c->bc->tamanho);
+                    } else {
+                        corrigir_desvio(c, para_senao, c->bc->tamanho);
+                    }
+                }
+                break;
+
+            case CMD_ENQUANTO:
+                {
+                    /* Laço invertido: a condição fica no fim e é testada
+                       com um único desvio por iteração */
+                    int para_teste = emitir_desvio(c, OP_DESVIA);
+                    int corpo = c->bc->tamanho;
+                    compilar_comandos(c, cmd->dado.enquanto.corpo);
+                    corrigir_desvio(c, para_teste, c->bc->tamanho);
+                    compilar_expressao(c, cmd->dado.enquanto.condicao, TIPO_INTEIRO);
+                    int volta = emitir_desvio(c, OP_DESVIA_V);
+                    corrigir_desvio(c, volta, corpo);
+                }
+                break;
+        }
+
+        cmd = cmd->prox;
+    }
+}
+
+/* ========== Interface ========== */
+
+Bytecode *compilar_bytecode(NoPrograma *prog) {
+    Compilador c;
+    Bytecode *bc = (Bytecode *)calloc(1, sizeof(Bytecode));
+
+    bc->tamanho_quadro = prog->tamanho_quadro;
+    bc->nomes_slot = (ChaveId *)calloc(bc->tamanho_quadro > 0 ? bc->tamanho_quadro : 1,
+                                       sizeof(ChaveId));
+    c.bc = bc;
+    c.profundidade = 0;
+
+    compilar_comandos(&c, prog->algoritmo);
+    emitir(&c, OP_PARA, 0);
+    return bc;
+}
+
+void imprimir_bytecode(const Bytecode *bc, FILE *saida) {
+    char nome[ID_MAX_CHARS + 1];
+
+    fprintf(saida, "\n=== BYTECODE ===\n");
+    fprintf(saida, "%d palavras, pilha maxima %d, quadro %d, %d real(is), %d cadeia(s)\n\n",
+            bc->tamanho, bc->pilha_max, bc->tamanho_quadro, bc->num_reais, bc->num_cadeias);
+
+    int pc = 0;
+    while (pc < bc->tamanho) {
+        OpCode op = (OpCode)bc->codigo[pc];
+        const int32_t *a = &bc->codigo[pc + 1];
+
+        fprintf(saida, "%6d  %-12s", pc, info_opcodes[op].nome);
+        switch (op) {
+            case OP_CONST_R:
+                fprintf(saida, "%g", bc->reais[a[0]]);
+                break;
+            case OP_CARREGA:
+            case OP_GUARDA:
+                fprintf(saida, "%-6d ; %s", a[0], texto_id(bc->nomes_slot[a[0]], nome));
+                break;
+            case OP_CARREGA_ARR:
+            case OP_GUARDA_ARR:
+                fprintf(saida, "%-6d ; %s[1..%d]", a[0],
+                        texto_id(bc->nomes_slot[a[0]], nome), a[1]);
+                break;
+            case OP_CARREGA_ELEM:
+            case OP_GUARDA_ELEM:
+                fprintf(saida, "%-6d ; %s[i], sem verificacao", a[0] + 1,
+                        texto_id(bc->nomes_slot[a[0] + 1], nome));
+                break;
+            case OP_ESCREVA_S:
+                fprintf(saida, "'%s'", bc->cadeias[a[0]]);
+                break;
+            case OP_DIV_I:
+            case OP_LEIA_I:
+            case OP_LEIA_R:
+                fprintf(saida, "; linha %d", a[0]);
+                break;
+            default:
+                if (info_opcodes[op].operandos > 0) {
+                    fprintf(saida, "%d", a[0]);
+                }
+                break;
+        }
+        fprintf(saida, "\n");
+        pc += 1 + info_opcodes[op].operandos;
+    }
+    fprintf(saida, "================\n\n");
+}
+
+void liberar_bytecode(Bytecode *bc) {
+    if (bc == NULL) return;
+    free(bc->codigo);
+    free(bc->reais);
+    free(bc->cadeias);
+    free(bc->nomes_slot);
+    free(bc);
+}
@@ -0,0 +1,76 @@
+/*
+ * Bytecode linear e tipado para programas X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+#include "ast.h"
+
+/*
+ * Máquina de pilha: cada instrução ocupa uma palavra de 32 bits com o
+ * código da operação, seguida de seus operandos (também de 32 bits).
+ * Aritmética e comparações inteiras e reais têm códigos distintos,
+ * escolhidos a partir do tipo_dado anotado na análise semântica.
+ */
+typedef enum {
+    OP_CONST_I,     /* k            : empilha o inteiro k */
+    OP_CONST_R,     /* idx          : empilha reais[idx] */
+    OP_CARREGA,     /* slot         : empilha quadro[slot] */
+    OP_CARREGA_ARR, /* slot tam lin : desempilha i, empilha quadro[slot+i-1] */
+    OP_GUARDA,      /* slot         : desempilha em quadro[slot] */
+    OP_GUARDA_ARR,  /* slot tam lin : desempilha v e i, quadro[slot+i-1] = v */
+    OP_CARREGA_ELEM,/* base         : desempilha i, empilha quadro[base+i] (índice provado) */
+    OP_GUARDA_ELEM, /* base         : desempilha v e i, quadro[base+i] = v (índice provado) */
+    OP_I2R,         /*              : converte o topo de inteiro para real */
+    OP_R2I,         /*              : converte o topo de real para inteiro */
+    OP_SOMA_I, OP_SUB_I, OP_MULT_I,
+    OP_DIV_I,       /* lin          : divisão inteira (verifica zero e INT_MIN / -1) */
+    OP_SOMA_R, OP_SUB_R, OP_MULT_R, OP_DIV_R,
+    OP_MAQ_I, OP_MAI_I, OP_MEQ_I, OP_MEI_I, OP_IGU_I, OP_DIF_I,
+    OP_MAQ_R, OP_MAI_R, OP_MEQ_R, OP_MEI_R, OP_IGU_R, OP_DIF_R,
+    OP_NEG_I, OP_NEG_R,
+    OP_NAO,         /*              : negação lógica (.E. e .OU. viram desvios) */
+    OP_DESVIA,      /* alvo         : pc = alvo */
+    OP_DESVIA_F,    /* alvo         : desempilha; se zero, pc = alvo */
+    OP_DESVIA_V,    /* alvo         : desempilha; se não zero, pc = alvo */
+    OP_LEIA_I,      /* lin          : lê um inteiro e empilha */
+    OP_LEIA_R,      /* lin          : lê um real e empilha */
+    OP_ESCREVA_I, OP_ESCREVA_R,
+    OP_ESCREVA_S,   /* idx          : escreve cadeias[idx] */
+    OP_FIM_LINHA,
+    OP_PARA,
+    NUM_OPCODES
+} OpCode;
+
+/* Programa compilado */
+typedef struct Bytecode {
+    int32_t *codigo;
+    int tamanho;
+    int capacidade;
+
+    double *reais;          /* Constantes reais */
+    int num_reais;
+    int cap_reais;
+
+    const char **cadeias;   /* Cadeias de ESCREVA (apontam para a AST) */
+    int num_cadeias;
+    int cap_cadeias;
+
+    int pilha_max;          /* Profundidade máxima da pilha de operandos */
+    int tamanho_quadro;     /* Posições do quadro de variáveis */
+    ChaveId *nomes_slot;    /* Nome de cada slot (para a listagem) */
+} Bytecode;
+
+/* Traduz um programa verificado para bytecode */
+Bytecode *compilar_bytecode(NoPrograma *prog);
+
+/* Lista o bytecode em formato legível */
+void imprimir_bytecode(const Bytecode *bc, FILE *saida);
+
+/* Libera o bytecode */
+void liberar_bytecode(Bytecode *bc);
+
+#endif /* BYTECODE_H */
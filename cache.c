@@ -0,0 +1,521 @@
+/*
+ * Implementação do cache em disco de ASTs verificadas
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "semantic.h"
+#include "pilha.h"
+
+/*
+ * Formato da imagem (um arquivo por fonte, <dir>/<chave>.ast):
+ *
+ *   CabecalhoCache | nós da AST e cadeias | EntradaSimbolo[num_simbolos]
+ *                  | relocações | relocações de símbolos
+ *
+ * Os nós são cópias byte a byte das estruturas de ast.h, alinhadas como
+ * na arena. Cada ponteiro interno guarda o deslocamento do alvo desde o
+ * início do arquivo, e cada NoVar->simbolo guarda o índice da entrada;
+ * as listas de relocações dizem onde estão esses campos. Carregar é
+ * mapear o arquivo e somar a base a cada campo listado: nenhum nó é
+ * interpretado.
+ */
+
+#define CACHE_MAGICA  "X25BAST"
+#define CACHE_FORMATO 1
+#define CACHE_ALINHAMENTO 16
+
+typedef struct CabecalhoCache {
+    char magica[8];
+    uint32_t formato;
+    uint32_t layout;                /* Tamanhos das estruturas da AST */
+    uint64_t tamanho_fonte;
+    uint64_t verificacao;           /* Segundo hash da fonte */
+    uint64_t tamanho;               /* Tamanho total do arquivo */
+    uint64_t raiz;                  /* NoPrograma */
+    uint64_t simbolos;
+    uint64_t num_simbolos;
+    uint64_t relocacoes;
+    uint64_t num_relocacoes;
+    uint64_t relocacoes_simbolos;
+    uint64_t num_relocacoes_simbolos;
+} CabecalhoCache;
+
+/* ========== Chave ========== */
+
+static uint64_t fnv1a(uint64_t h, const void *dados, size_t n) {
+    const unsigned char *p = (const unsigned char *)dados;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/* Hash independente do FNV, guardado no cabeçalho para descartar colisões */
+static uint64_t verificacao(const unsigned char *p, size_t n) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ n;
+    for (size_t i = 0; i < n; i++) {
+        h = (h + p[i] + 1) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+static uint32_t assinatura_layout(void) {
+    const size_t medidas[] = {
+        sizeof(void *), sizeof(NoPrograma), sizeof(NoDecl), sizeof(NoCmd),
+        sizeof(NoExpr), sizeof(NoVar), sizeof(ListaVar), sizeof(ListaEscreva),
+        sizeof(EntradaSimbolo)
+    };
+    return (uint32_t)fnv1a(0xCBF29CE484222325ULL, medidas, sizeof(medidas));
+}
+
+static void caminho_cache(char *destino, size_t tam, const char *dir, uint64_t chave) {
+    snprintf(destino, tam, "%s/%016llx.ast", dir, (unsigned long long)chave);
+}
+
+/* Calcula a chave uma única vez, enquanto a fonte mapeada está intacta */
+static int calcular_chave(ContextoCompilacao *ctx) {
+    if (ctx->chave_cache_valida) {
+        return 1;
+    }
+    if (ctx->mapa == NULL) {
+        return 0;
+    }
+    uint64_t h = fnv1a(0xCBF29CE484222325ULL, X25B_VERSAO, sizeof(X25B_VERSAO));
+    ctx->chave_cache = fnv1a(h, ctx->mapa, ctx->tamanho_fonte);
+    ctx->verificacao_cache = verificacao((const unsigned char *)ctx->mapa, ctx->tamanho_fonte);
+    ctx->chave_cache_valida = 1;
+    return 1;
+}
+
+/* ========== Serialização ========== */
+
+typedef struct Serializador {
+    char *dados;
+    size_t tamanho;
+    size_t capacidade;
+
+    /* Endereço original -> deslocamento na imagem (endereçamento aberto) */
+    uintptr_t *origens;
+    uint64_t *destinos;
+    size_t num_mapa;
+    size_t cap_mapa;
+
+    /* Campos da imagem que ainda guardam o ponteiro original */
+    uint64_t *pendentes;
+    size_t num_pendentes;
+    size_t cap_pendentes;
+    uint64_t *pendentes_simbolos;
+    size_t num_pendentes_simbolos;
+    size_t cap_pendentes_simbolos;
+} Serializador;
+
+static void reservar(Serializador *s, size_t n) {
+    if (s->tamanho + n > s->capacidade) {
+        while (s->tamanho + n > s->capacidade) {
+            s->capacidade = s->capacidade ? s->capacidade * 2 : 64 * 1024;
+        }
+        s->dados = (char *)realloc(s->dados, s->capacidade);
+    }
+}
+
+static void empilhar(uint64_t **v, size_t *n, size_t *cap, uint64_t valor) {
+    if (*n == *cap) {
+        *cap = *cap ? *cap * 2 : 256;
+        *v = (uint64_t *)realloc(*v, *cap * sizeof(uint64_t));
+    }
+    (*v)[(*n)++] = valor;
+}
+
+static size_t posicao_mapa(const Serializador *s, uintptr_t origem) {
+    size_t i = (size_t)((origem * 0x9E3779B97F4A7C15ULL) >> 20) & (s->cap_mapa - 1);
+    while (s->origens[i] != 0 && s->origens[i] != origem) {
+        i = (i + 1) & (s->cap_mapa - 1);
+    }
+    return i;
+}
+
+static void mapear(Serializador *s, const void *origem, uint64_t destino) {
+    if (2 * (s->num_mapa + 1) > s->cap_mapa) {
+        uintptr_t *origens = s->origens;
+        uint64_t *destinos = s->destinos;
+        size_t cap = s->cap_mapa;
+        s->cap_mapa = cap ? cap * 2 : 1024;
+        s->origens = (uintptr_t *)calloc(s->cap_mapa, sizeof(uintptr_t));
+        s->destinos = (uint64_t *)malloc(s->cap_mapa * sizeof(uint64_t));
+        for (size_t i = 0; i < cap; i++) {
+            if (origens[i] != 0) {
+                size_t j = posicao_mapa(s, origens[i]);
+                s->origens[j] = origens[i];
+                s->destinos[j] = destinos[i];
+            }
+        }
+        free(origens);
+        free(destinos);
+    }
+    size_t i = posicao_mapa(s, (uintptr_t)origem);
+    s->origens[i] = (uintptr_t)origem;
+    s->destinos[i] = destino;
+    s->num_mapa++;
+}
+
+/* Copia 'tam' bytes de 'no' para a imagem e registra o endereço */
+static uint64_t copiar(Serializador *s, const void *no, size_t tam) {
+    size_t inicio = (s->tamanho + CACHE_ALINHAMENTO - 1) & ~(size_t)(CACHE_ALINHAMENTO - 1);
+    reservar(s, inicio - s->tamanho + tam);
+    memset(s->dados + s->tamanho, 0, inicio - s->tamanho);
+    memcpy(s->dados + inicio, no, tam);
+    s->tamanho = inicio + tam;
+    mapear(s, no, inicio);
+    return inicio;
+}
+
+/* Marca o campo em 'no + campo' (se não for NULL) para relocação */
+static void ponteiro(Serializador *s, uint64_t no, size_t campo) {
+    void *valor;
+    memcpy(&valor, s->dados + no + campo, sizeof(valor));
+    if (valor != NULL) {
+        empilhar(&s->pendentes, &s->num_pendentes, &s->cap_pendentes, no + campo);
+    }
+}
+
+#define PONTEIRO(s, no, Tipo, campo) ponteiro((s), (no), offsetof(Tipo, campo))
+
+/* Copia um NoVar; o índice, se houver, fica a cargo de quem chama */
+static void copiar_var(Serializador *s, NoVar *var) {
+    uint64_t no = copiar(s, var, sizeof(NoVar));
+    PONTEIRO(s, no, NoVar, indice);
+    if (var->simbolo != NULL) {
+        empilhar(&s->pendentes_simbolos, &s->num_pendentes_simbolos,
+                 &s->cap_pendentes_simbolos, no + offsetof(NoVar, simbolo));
+    }
+}
+
+/* Pré-ordem com pilha explícita: cadeias de milhões de termos não estouram a pilha de C */
+static void serializar_expr(Serializador *s, NoExpr *raiz) {
+    Pilha pilha;
+    NoExpr **topo;
+
+    pilha_iniciar(&pilha, sizeof(NoExpr *));
+    *(NoExpr **)pilha_empilhar(&pilha) = raiz;
+    while ((topo = (NoExpr **)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = *topo;
+        pilha_desempilhar(&pilha);
+
+        uint64_t no = copiar(s, expr, sizeof(NoExpr));
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                PONTEIRO(s, no, NoExpr, dado.var);
+                copiar_var(s, expr->dado.var);
+                if (expr->dado.var->indice != NULL) {
+                    *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.var->indice;
+                }
+                break;
+            case EXPR_ARITMETICA:
+            case EXPR_RELACIONAL:
+            case EXPR_LOGICA:
+                /* Os três membros da união têm o mesmo layout (op, esq, dir) */
+                PONTEIRO(s, no, NoExpr, dado.aritmetica.esq);
+                PONTEIRO(s, no, NoExpr, dado.aritmetica.dir);
+                *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.aritmetica.dir;
+                *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.aritmetica.esq;
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                PONTEIRO(s, no, NoExpr, dado.negacao);
+                *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.negacao;
+                break;
+            default:
+                break;
+        }
+    }
+    pilha_liberar(&pilha);
+}
+
+static void serializar_var(Serializador *s, NoVar *var) {
+    copiar_var(s, var);
+    if (var->indice != NULL) {
+        serializar_expr(s, var->indice);
+    }
+}
+
+static uint64_t serializar_cadeia(Serializador *s, const char *cadeia) {
+    return copiar(s, cadeia, strlen(cadeia) + 1);
+}
+
+/* Todos os comandos, inclusive os dos blocos aninhados, sem recursão */
+static void serializar_cmds(Serializador *s, NoCmd *cmds) {
+    PercursoComandos percurso;
+    NoCmd *cmd;
+
+    iniciar_percurso(&percurso, cmds);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        uint64_t no = copiar(s, cmd, sizeof(NoCmd));
+        PONTEIRO(s, no, NoCmd, prox);
+        PONTEIRO(s, no, NoCmd, ultimo);
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                PONTEIRO(s, no, NoCmd, dado.atrib.var);
+                PONTEIRO(s, no, NoCmd, dado.atrib.expr);
+                serializar_var(s, cmd->dado.atrib.var);
+                serializar_expr(s, cmd->dado.atrib.expr);
+                break;
+            case CMD_LEIA:
+                PONTEIRO(s, no, NoCmd, dado.leia);
+                for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                    uint64_t item = copiar(s, l, sizeof(ListaVar));
+                    PONTEIRO(s, item, ListaVar, var);
+                    PONTEIRO(s, item, ListaVar, prox);
+                    PONTEIRO(s, item, ListaVar, ultimo);
+                    serializar_var(s, l->var);
+                }
+                break;
+            case CMD_ESCREVA:
+                PONTEIRO(s, no, NoCmd, dado.escreva);
+                for (ListaEscreva *l = cmd->dado.escreva; l != NULL; l = l->prox) {
+                    uint64_t item = copiar(s, l, sizeof(ListaEscreva));
+                    PONTEIRO(s, item, ListaEscreva, prox);
+                    PONTEIRO(s, item, ListaEscreva, ultimo);
+                    if (l->is_cadeia) {
+                        PONTEIRO(s, item, ListaEscreva, item.cadeia);
+                        serializar_cadeia(s, l->item.cadeia);
+                    } else {
+                        PONTEIRO(s, item, ListaEscreva, item.expr);
+                        serializar_expr(s, l->item.expr);
+                    }
+                }
+                break;
+            case CMD_SE:
+                /* ENTAO e SENAO vêm do próprio percurso */
+                PONTEIRO(s, no, NoCmd, dado.se.condicao);
+                PONTEIRO(s, no, NoCmd, dado.se.entao);
+                PONTEIRO(s, no, NoCmd, dado.se.senao);
+                serializar_expr(s, cmd->dado.se.condicao);
+                break;
+            case CMD_ENQUANTO:
+                PONTEIRO(s, no, NoCmd, dado.enquanto.condicao);
+                PONTEIRO(s, no, NoCmd, dado.enquanto.corpo);
+                serializar_expr(s, cmd->dado.enquanto.condicao);
+                break;
+        }
+    }
+    terminar_percurso(&percurso);
+}
+
+static uint64_t serializar_programa(Serializador *s, NoPrograma *prog) {
+    uint64_t raiz = copiar(s, prog, sizeof(NoPrograma));
+    PONTEIRO(s, raiz, NoPrograma, nome);
+    PONTEIRO(s, raiz, NoPrograma, declaracoes);
+    PONTEIRO(s, raiz, NoPrograma, algoritmo);
+
+    if (prog->nome != NULL) {
+        serializar_cadeia(s, prog->nome);
+    }
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox) {
+        uint64_t no = copiar(s, d, sizeof(NoDecl));
+        PONTEIRO(s, no, NoDecl, prox);
+        PONTEIRO(s, no, NoDecl, ultimo);
+    }
+    serializar_cmds(s, prog->algoritmo);
+    return raiz;
+}
+
+/*
+ * Troca os ponteiros originais pelos deslocamentos dos alvos. Um alvo
+ * fora da AST (só possível em 'ultimo' de nós internos de listas, que
+ * não é usado após a análise sintática) vira NULL.
+ */
+static void resolver(Serializador *s, uint64_t *relocacoes, size_t *num_relocacoes) {
+    *num_relocacoes = 0;
+    for (size_t i = 0; i < s->num_pendentes; i++) {
+        uintptr_t origem;
+        uintptr_t destino = 0;
+        memcpy(&origem, s->dados + s->pendentes[i], sizeof(origem));
+
+        size_t j = posicao_mapa(s, origem);
+        if (s->origens[j] == origem) {
+            destino = (uintptr_t)s->destinos[j];
+            relocacoes[(*num_relocacoes)++] = s->pendentes[i];
+        }
+        memcpy(s->dados + s->pendentes[i], &destino, sizeof(destino));
+    }
+}
+
+static void liberar_serializador(Serializador *s) {
+    free(s->dados);
+    free(s->origens);
+    free(s->destinos);
+    free(s->pendentes);
+    free(s->pendentes_simbolos);
+}
+
+void salvar_ast_cache(ContextoCompilacao *ctx, const char *dir) {
+    if (ctx->programa == NULL || !calcular_chave(ctx) ||
+        ctx->erros_lexicos > 0 || ctx->erros_sintaticos > 0 ||
+        ctx->erros_semanticos > 0 || ctx->avisos > 0) {
+        return;
+    }
+
+    Serializador s;
+    memset(&s, 0, sizeof(s));
+
+    CabecalhoCache cab;
+    memset(&cab, 0, sizeof(cab));
+    reservar(&s, sizeof(cab));
+    s.tamanho = sizeof(cab);
+
+    cab.raiz = serializar_programa(&s, ctx->programa);
+
+    /* Tabela de símbolos; NoVar->simbolo vira índice */
+    TabelaSimbolos *t = &ctx->tabela;
+    for (size_t i = 0; i < s.num_pendentes_simbolos; i++) {
+        EntradaSimbolo *e;
+        memcpy(&e, s.dados + s.pendentes_simbolos[i], sizeof(e));
+        uintptr_t indice = (uintptr_t)(e - t->simbolos);
+        memcpy(s.dados + s.pendentes_simbolos[i], &indice, sizeof(indice));
+    }
+    cab.num_simbolos = (uint64_t)t->num_simbolos;
+    if (t->num_simbolos > 0) {
+        cab.simbolos = copiar(&s, t->simbolos, (size_t)t->num_simbolos * sizeof(EntradaSimbolo));
+    }
+
+    /* Relocações (resolvidas depois de todos os nós terem destino) */
+    uint64_t *relocacoes = (uint64_t *)malloc((s.num_pendentes + 1) * sizeof(uint64_t));
+    size_t num_relocacoes;
+    resolver(&s, relocacoes, &num_relocacoes);
+    cab.num_relocacoes = num_relocacoes;
+    cab.relocacoes = copiar(&s, relocacoes, (num_relocacoes + 1) * sizeof(uint64_t));
+    cab.num_relocacoes_simbolos = s.num_pendentes_simbolos;
+    cab.relocacoes_simbolos = copiar(&s, s.pendentes_simbolos,
+                                     (s.num_pendentes_simbolos + 1) * sizeof(uint64_t));
+    free(relocacoes);
+
+    memcpy(cab.magica, CACHE_MAGICA, sizeof(cab.magica));
+    cab.formato = CACHE_FORMATO;
+    cab.layout = assinatura_layout();
+    cab.tamanho_fonte = ctx->tamanho_fonte;
+    cab.verificacao = ctx->verificacao_cache;
+    cab.tamanho = s.tamanho;
+    memcpy(s.dados, &cab, sizeof(cab));
+
+    /* Grava num temporário e renomeia: leitores nunca veem meio arquivo */
+    char caminho[4096], temporario[4096];
+    caminho_cache(caminho, sizeof(caminho), dir, ctx->chave_cache);
+    snprintf(temporario, sizeof(temporario), "%s/.tmp-XXXXXX", dir);
+
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        liberar_serializador(&s);
+        return;
+    }
+    int fd = mkstemp(temporario);
+    if (fd >= 0) {
+        fchmod(fd, 0644);
+        size_t escrito = 0;
+        while (escrito < s.tamanho) {
+            ssize_t n = write(fd, s.dados + escrito, s.tamanho - escrito);
+            if (n <= 0) break;
+            escrito += (size_t)n;
+        }
+        close(fd);
+        if (escrito != s.tamanho || rename(temporario, caminho) != 0) {
+            unlink(temporario);
+        }
+    }
+    liberar_serializador(&s);
+}
+
+/* ========== Carga ========== */
+
+/* Confere que [inicio, inicio + n * tam) cabe no arquivo */
+static int dentro(const CabecalhoCache *cab, uint64_t inicio, uint64_t n, uint64_t tam) {
+    return inicio <= cab->tamanho && n <= (cab->tamanho - inicio) / tam;
+}
+
+int carregar_ast_cache(ContextoCompilacao *ctx, const char *dir) {
+    char caminho[4096];
+    struct stat st;
+
+    if (!calcular_chave(ctx)) {
+        return 0;
+    }
+    caminho_cache(caminho, sizeof(caminho), dir, ctx->chave_cache);
+
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) {
+        ctx->cache_falhas++;
+        return 0;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CabecalhoCache)) {
+        close(fd);
+        ctx->cache_falhas++;
+        return 0;
+    }
+
+    /* Privado e gravável: a relocação e a otimização escrevem nos nós */
+    size_t tamanho = (size_t)st.st_size;
+    char *base = mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        ctx->cache_falhas++;
+        return 0;
+    }
+
+    const CabecalhoCache *cab = (const CabecalhoCache *)base;
+    int valido = memcmp(cab->magica, CACHE_MAGICA, sizeof(cab->magica)) == 0 &&
+                 cab->formato == CACHE_FORMATO &&
+                 cab->layout == assinatura_layout() &&
+                 cab->tamanho == tamanho &&
+                 cab->tamanho_fonte == ctx->tamanho_fonte &&
+                 cab->verificacao == ctx->verificacao_cache &&
+                 dentro(cab, cab->raiz, 1, sizeof(NoPrograma)) &&
+                 dentro(cab, cab->simbolos, cab->num_simbolos, sizeof(EntradaSimbolo)) &&
+                 dentro(cab, cab->relocacoes, cab->num_relocacoes, sizeof(uint64_t)) &&
+                 dentro(cab, cab->relocacoes_simbolos, cab->num_relocacoes_simbolos, sizeof(uint64_t));
+
+    const uint64_t *relocacoes = (const uint64_t *)(base + cab->relocacoes);
+    const uint64_t *relocacoes_simbolos = (const uint64_t *)(base + cab->relocacoes_simbolos);
+    for (uint64_t i = 0; valido && i < cab->num_relocacoes; i++) {
+        valido = relocacoes[i] <= tamanho - sizeof(uintptr_t) &&
+                 *(const uintptr_t *)(base + relocacoes[i]) < tamanho;
+    }
+    for (uint64_t i = 0; valido && i < cab->num_relocacoes_simbolos; i++) {
+        valido = relocacoes_simbolos[i] <= tamanho - sizeof(uintptr_t) &&
+                 *(const uintptr_t *)(base + relocacoes_simbolos[i]) < cab->num_simbolos;
+    }
+    if (!valido) {
+        munmap(base, tamanho);
+        ctx->cache_falhas++;
+        return 0;
+    }
+
+    restaurar_tabela(ctx, (const EntradaSimbolo *)(base + cab->simbolos), (int)cab->num_simbolos);
+
+    /* Relocação: base + deslocamento, ou a entrada na tabela restaurada */
+    for (uint64_t i = 0; i < cab->num_relocacoes; i++) {
+        uintptr_t *campo = (uintptr_t *)(base + relocacoes[i]);
+        *campo = (uintptr_t)(base + *campo);
+    }
+    for (uint64_t i = 0; i < cab->num_relocacoes_simbolos; i++) {
+        uintptr_t *campo = (uintptr_t *)(base + relocacoes_simbolos[i]);
+        *campo = (uintptr_t)&ctx->tabela.simbolos[*campo];
+    }
+
+    ctx->programa = (NoPrograma *)(base + cab->raiz);
+    ctx->mapa_cache = base;
+    ctx->tamanho_mapa_cache = tamanho;
+    ctx->cache_acertos++;
+    return 1;
+}
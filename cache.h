@@ -0,0 +1,38 @@
+/*
+ * Cache em disco de ASTs já verificadas (opção --cache)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "contexto.h"
+
+/* Diretório usado por --cache sem argumento */
+#define CACHE_DIR_PADRAO ".x25b-cache"
+
+/*
+ * Versão do compilador, parte da chave do cache: deve mudar sempre que
+ * a AST, a análise semântica ou o formato da imagem mudarem.
+ */
+#define X25B_VERSAO "x25b-2025.23"
+
+/*
+ * Procura em 'dir' a AST verificada da fonte mapeada de ctx (a chave é
+ * um hash dos bytes da fonte e de X25B_VERSAO, calculado antes de a
+ * fonte ser analisada). Num acerto, a imagem é mapeada, seus ponteiros
+ * são relocados num único passo, a tabela de símbolos é restaurada e
+ * ctx->programa passa a apontar para a AST. Retorna 1 num acerto.
+ * Fontes lidas em fluxo nunca estão no cache.
+ */
+int carregar_ast_cache(ContextoCompilacao *ctx, const char *dir);
+
+/*
+ * Grava em 'dir' a AST de ctx, recém-analisada (antes da otimização).
+ * Só programas sem erros nem avisos são gravados; a gravação é atômica
+ * (arquivo temporário + rename), então várias threads ou processos
+ * podem compartilhar o diretório.
+ */
+void salvar_ast_cache(ContextoCompilacao *ctx, const char *dir);
+
+#endif /* CACHE_H */
@@ -0,0 +1,581 @@
+/*
+ * Implementação da eliminação de código morto
+ * Avaliação Parcial 2 - Compiladores
+ *
+ * Cada rodada marca as atribuições mortas e depois varre as sequências
+ * de comandos, removendo as marcadas e podando os desvios. Uma remoção
+ * leva junto as leituras do comando, e a rodada seguinte pode achar
+ * mais: "a := 1; SE c ENTAO b := a FIMSE; b := 2" perde b := a na
+ * primeira e a := 1 na segunda.
+ *
+ * Duas análises decidem que uma atribuição a v é morta:
+ *   - vivacidade (fluxo.h): nenhum caminho a partir dela lê v antes de
+ *     outra atribuição;
+ *   - variáveis úteis: uma leitura num ESCREVA, numa condição, num
+ *     índice de LEIA ou numa atribuição que pode falhar torna a variável
+ *     útil, e uma variável útil torna úteis as que as suas atribuições
+ *     leem. As demais só se alimentam entre si (um contador "x := x + 1"
+ *     que nunca é escrito), o que a vivacidade não vê: a leitura do
+ *     próprio laço mantém x viva.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codigo_morto.h"
+#include "fluxo.h"
+#include "semantic.h"
+#include "contexto.h"
+
+/* Rodadas de marcação e varredura; cadeias mais longas entre blocos são raras */
+#define MAX_RODADAS 8
+
+static void *realocar(void *p, size_t tam) {
+    void *novo = realloc(p, tam > 0 ? tam : 1);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a eliminacao de codigo morto\n");
+        exit(1);
+    }
+    return novo;
+}
+
+/* ========== Estado ========== */
+
+/* A atribuição a 'alvo' lê 'lida' */
+typedef struct Dependencia {
+    int alvo;
+    int lida;
+} Dependencia;
+
+typedef struct EstadoMorto {
+    ContextoCompilacao *ctx;
+    FILE *registro;
+    int num_variaveis;
+    Pilha pilha;            /* NoExpr*, nos percursos de expressões */
+
+    /* Símbolos lidos pela última expressão (ou atribuição) visitada */
+    int *lidas;
+    int num_lidas;
+    int capacidade_lidas;
+
+    /* Variáveis úteis */
+    unsigned char *util;
+    Dependencia *dependencias;
+    int num_dependencias;
+    int capacidade_dependencias;
+    int *inicio;            /* Dependências de v em lidas_por_alvo[inicio[v], inicio[v + 1]) */
+    int *lidas_por_alvo;
+    int *fila;
+
+    /* Atribuições mortas da rodada, ordenadas por endereço antes da varredura */
+    NoCmd **mortas;
+    int num_mortas;
+    int capacidade_mortas;
+
+    long *removidas;        /* Atribuições removidas por variável */
+    int *linha_removida;    /* Linha da primeira delas */
+
+    long atribuicoes;
+    long desvios;
+    long comandos;
+} EstadoMorto;
+
+static int indice_simbolo(const EstadoMorto *e, const NoVar *var) {
+    return (int)(var->simbolo - e->ctx->tabela.simbolos);
+}
+
+/* ========== Leituras ========== */
+
+/* O próprio nó pode interromper a execução */
+static int falha_propria(const NoExpr *expr) {
+    if (expr->tipo == EXPR_VAR_ARRAY) {
+        return expr->dado.var->limite != LIMITE_SEGURO;
+    }
+    if (expr->tipo == EXPR_ARITMETICA && expr->dado.aritmetica.op == ARIT_DIV &&
+        expr->tipo_dado != TIPO_REAL) {
+        NoExpr *dir = expr->dado.aritmetica.dir;
+        return !(dir->tipo == EXPR_CONST_INT && dir->dado.const_int != 0 && dir->dado.const_int != -1);
+    }
+    return 0;
+}
+
+static void anotar_leitura(EstadoMorto *e, const NoVar *var) {
+    if (e->num_lidas == e->capacidade_lidas) {
+        e->capacidade_lidas = e->capacidade_lidas > 0 ? 2 * e->capacidade_lidas : 64;
+        e->lidas = (int *)realocar(e->lidas, (size_t)e->capacidade_lidas * sizeof(int));
+    }
+    e->lidas[e->num_lidas++] = indice_simbolo(e, var);
+}
+
+static void empilhar_no(Pilha *pilha, NoExpr *expr) {
+    if (expr != NULL) {
+        *(NoExpr **)pilha_empilhar(pilha) = expr;
+    }
+}
+
+/* Acrescenta a e->lidas as variáveis lidas por 'raiz'; 1 se ela pode falhar (sem recursão) */
+static int ler_expressao(EstadoMorto *e, NoExpr *raiz) {
+    NoExpr **topo;
+    int falha = 0;
+
+    empilhar_no(&e->pilha, raiz);
+    while ((topo = (NoExpr **)pilha_topo(&e->pilha)) != NULL) {
+        NoExpr *expr = *topo;
+        pilha_desempilhar(&e->pilha);
+        falha |= falha_propria(expr);
+
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                anotar_leitura(e, expr->dado.var);
+                empilhar_no(&e->pilha, expr->dado.var->indice);
+                break;
+            case EXPR_ARITMETICA:
+                empilhar_no(&e->pilha, expr->dado.aritmetica.esq);
+                empilhar_no(&e->pilha, expr->dado.aritmetica.dir);
+                break;
+            case EXPR_RELACIONAL:
+                empilhar_no(&e->pilha, expr->dado.relacional.esq);
+                empilhar_no(&e->pilha, expr->dado.relacional.dir);
+                break;
+            case EXPR_LOGICA:
+                empilhar_no(&e->pilha, expr->dado.logica.esq);
+                empilhar_no(&e->pilha, expr->dado.logica.dir);
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_no(&e->pilha, expr->dado.negacao);
+                break;
+            default:
+                break;
+        }
+    }
+    return falha;
+}
+
+/* Leituras de uma atribuição (expressão e índice do alvo) em e->lidas; 1 se ela pode falhar */
+static int ler_atribuicao(EstadoMorto *e, NoCmd *cmd) {
+    NoVar *alvo = cmd->dado.atrib.var;
+    int falha;
+
+    e->num_lidas = 0;
+    falha = ler_expressao(e, cmd->dado.atrib.expr);
+    if (alvo->indice != NULL) {
+        falha |= ler_expressao(e, alvo->indice);
+        falha |= alvo->limite != LIMITE_SEGURO;
+    }
+    return falha;
+}
+
+/* ========== Variáveis úteis ========== */
+
+static void marcar_util(EstadoMorto *e, int v, int *fim_fila) {
+    if (!e->util[v]) {
+        e->util[v] = 1;
+        e->fila[(*fim_fila)++] = v;
+    }
+}
+
+static void anotar_dependencia(EstadoMorto *e, int alvo, int lida) {
+    if (e->num_dependencias == e->capacidade_dependencias) {
+        e->capacidade_dependencias = e->capacidade_dependencias > 0 ? 2 * e->capacidade_dependencias : 256;
+        e->dependencias = (Dependencia *)realocar(e->dependencias,
+                                                  (size_t)e->capacidade_dependencias * sizeof(Dependencia));
+    }
+    e->dependencias[e->num_dependencias].alvo = alvo;
+    e->dependencias[e->num_dependencias].lida = lida;
+    e->num_dependencias++;
+}
+
+/*
+ * As leituras fora de atribuições (e nas que podem falhar) são as raízes;
+ * a partir delas, uma busca em largura segue as dependências, agrupadas
+ * por alvo com uma contagem.
+ */
+static void calcular_uteis(EstadoMorto *e, NoPrograma *prog) {
+    PercursoComandos percurso;
+    NoCmd *cmd;
+    int fim_fila = 0;
+
+    memset(e->util, 0, (size_t)e->num_variaveis);
+    e->num_dependencias = 0;
+
+    iniciar_percurso(&percurso, prog->algoritmo);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        e->num_lidas = 0;
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                if (!ler_atribuicao(e, cmd)) {
+                    int alvo = indice_simbolo(e, cmd->dado.atrib.var);
+                    for (int i = 0; i < e->num_lidas; i++) {
+                        anotar_dependencia(e, alvo, e->lidas[i]);
+                    }
+                    e->num_lidas = 0;
+                }
+                break;
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    ler_expressao(e, v->var->indice);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        ler_expressao(e, item->item.expr);
+                    }
+                }
+                break;
+            case CMD_SE:
+                ler_expressao(e, cmd->dado.se.condicao);
+                break;
+            case CMD_ENQUANTO:
+                ler_expressao(e, cmd->dado.enquanto.condicao);
+                break;
+        }
+        for (int i = 0; i < e->num_lidas; i++) {
+            marcar_util(e, e->lidas[i], &fim_fila);
+        }
+    }
+    terminar_percurso(&percurso);
+
+    /* Contagem por alvo; preenchendo do fim, inicio[v] volta ao começo das de v */
+    memset(e->inicio, 0, (size_t)(e->num_variaveis + 1) * sizeof(int));
+    for (int d = 0; d < e->num_dependencias; d++) {
+        e->inicio[e->dependencias[d].alvo]++;
+    }
+    for (int v = 1; v < e->num_variaveis; v++) {
+        e->inicio[v] += e->inicio[v - 1];
+    }
+    e->inicio[e->num_variaveis] = e->num_dependencias;
+    e->lidas_por_alvo = (int *)realocar(e->lidas_por_alvo, (size_t)e->num_dependencias * sizeof(int));
+    for (int d = e->num_dependencias - 1; d >= 0; d--) {
+        e->lidas_por_alvo[--e->inicio[e->dependencias[d].alvo]] = e->dependencias[d].lida;
+    }
+
+    for (int k = 0; k < fim_fila; k++) {
+        int v = e->fila[k];
+        for (int d = e->inicio[v]; d < e->inicio[v + 1]; d++) {
+            marcar_util(e, e->lidas_por_alvo[d], &fim_fila);
+        }
+    }
+}
+
+/* ========== Atribuições mortas ========== */
+
+static void marcar_morta(EstadoMorto *e, NoCmd *cmd, int alvo) {
+    if (e->num_mortas == e->capacidade_mortas) {
+        e->capacidade_mortas = e->capacidade_mortas > 0 ? 2 * e->capacidade_mortas : 64;
+        e->mortas = (NoCmd **)realocar(e->mortas, (size_t)e->capacidade_mortas * sizeof(NoCmd *));
+    }
+    e->mortas[e->num_mortas++] = cmd;
+    if (e->removidas[alvo]++ == 0 || cmd->linha < e->linha_removida[alvo]) {
+        e->linha_removida[alvo] = cmd->linha;
+    }
+}
+
+static void ligar_lidas(EstadoMorto *e, PalavraBits *viva) {
+    for (int i = 0; i < e->num_lidas; i++) {
+        ligar_bit(viva, e->lidas[i]);
+    }
+}
+
+/*
+ * Percorre cada bloco do fim para o início, a partir das variáveis vivas
+ * na saída dele: uma atribuição que não pode falhar, a uma variável que
+ * não está viva ali ou não é útil, é morta e não acrescenta leituras.
+ */
+static int marcar_mortas(EstadoMorto *e, NoPrograma *prog) {
+    GrafoFluxo g;
+    ProblemaFluxo vivacidade;
+
+    calcular_uteis(e, prog);
+    construir_grafo(&g, prog->algoritmo);
+    calcular_vivacidade(e->ctx, &g, &vivacidade);
+
+    PalavraBits *viva = (PalavraBits *)realocar(NULL, (size_t)vivacidade.palavras * sizeof(PalavraBits));
+    for (int b = 0; b < g.num_blocos; b++) {
+        const BlocoBasico *bloco = &g.blocos[b];
+
+        memcpy(viva, vetor_bloco(&vivacidade, vivacidade.saida, b),
+               (size_t)vivacidade.palavras * sizeof(PalavraBits));
+        if (bloco->desvio != NULL) {
+            e->num_lidas = 0;
+            ler_expressao(e, bloco->desvio->tipo == CMD_SE ? bloco->desvio->dado.se.condicao
+                                                           : bloco->desvio->dado.enquanto.condicao);
+            ligar_lidas(e, viva);
+        }
+
+        for (int i = bloco->num_comandos - 1; i >= 0; i--) {
+            NoCmd *cmd = g.comandos[bloco->primeiro + i];
+            e->num_lidas = 0;
+            switch (cmd->tipo) {
+                case CMD_ATRIB: {
+                    NoVar *alvo = cmd->dado.atrib.var;
+                    int v = indice_simbolo(e, alvo);
+                    if (!ler_atribuicao(e, cmd) && (!e->util[v] || !bit_ligado(viva, v))) {
+                        marcar_morta(e, cmd, v);
+                        continue;
+                    }
+                    if (alvo->indice == NULL) {
+                        desligar_bit(viva, v);
+                    }
+                    break;
+                }
+                case CMD_LEIA:
+                    /* Alvos antes dos índices: "LEIA a, v[a]" mantém a viva antes do comando */
+                    for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                        if (l->var->indice == NULL) {
+                            desligar_bit(viva, indice_simbolo(e, l->var));
+                        }
+                    }
+                    for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                        ler_expressao(e, l->var->indice);
+                    }
+                    break;
+                case CMD_ESCREVA:
+                    for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                        if (!item->is_cadeia) {
+                            ler_expressao(e, item->item.expr);
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+            ligar_lidas(e, viva);
+        }
+    }
+
+    free(viva);
+    liberar_problema(&vivacidade);
+    liberar_grafo(&g);
+    return e->num_mortas;
+}
+
+/* ========== Varredura ========== */
+
+static int comparar_comandos(const void *a, const void *b) {
+    const NoCmd *x = *(NoCmd *const *)a;
+    const NoCmd *y = *(NoCmd *const *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int morta(const EstadoMorto *e, NoCmd *cmd) {
+    return e->num_mortas > 0 &&
+           bsearch(&cmd, e->mortas, (size_t)e->num_mortas, sizeof(NoCmd *), comparar_comandos) != NULL;
+}
+
+/* Valor de uma condição constante (como avaliar_inteiro no interpretador) */
+static int condicao_constante(const NoExpr *condicao, int *valor) {
+    if (condicao->tipo == EXPR_CONST_INT) {
+        *valor = condicao->dado.const_int != 0;
+        return 1;
+    }
+    if (condicao->tipo == EXPR_CONST_REAL) {
+        *valor = (int)condicao->dado.const_real != 0;
+        return 1;
+    }
+    return 0;
+}
+
+/* Comandos da sequência 'cmd', inclusive os aninhados */
+static long contar_sequencia(NoCmd *cmd) {
+    PercursoComandos percurso;
+    long total = 0;
+
+    iniciar_percurso(&percurso, cmd);
+    while (proximo_comando(&percurso) != NULL) {
+        total++;
+    }
+    terminar_percurso(&percurso);
+    return total;
+}
+
+/* Comandos de um SE ou ENQUANTO, inclusive ele, sem os que o seguem */
+static long contar_comando(NoCmd *cmd) {
+    if (cmd->tipo == CMD_SE) {
+        return 1 + contar_sequencia(cmd->dado.se.entao) + contar_sequencia(cmd->dado.se.senao);
+    }
+    if (cmd->tipo == CMD_ENQUANTO) {
+        return 1 + contar_sequencia(cmd->dado.enquanto.corpo);
+    }
+    return 1;
+}
+
+/*
+ * Remove as atribuições marcadas e poda os desvios, sequência por
+ * sequência (sem recursão), refazendo 'ultimo' na cabeça de cada uma.
+ * Retorna o número de comandos removidos.
+ */
+static long varrer(EstadoMorto *e, NoPrograma *prog) {
+    Pilha sequencias;
+    NoCmd ***topo;
+    long removidos = 0;
+
+    if (e->num_mortas > 0) {
+        qsort(e->mortas, (size_t)e->num_mortas, sizeof(NoCmd *), comparar_comandos);
+    }
+
+    pilha_iniciar(&sequencias, sizeof(NoCmd **));
+    *(NoCmd ***)pilha_empilhar(&sequencias) = &prog->algoritmo;
+
+    while ((topo = (NoCmd ***)pilha_topo(&sequencias)) != NULL) {
+        NoCmd **inicio = *topo;
+        NoCmd **lugar = inicio;
+        NoCmd *ultimo = NULL;
+        NoCmd *cmd;
+        pilha_desempilhar(&sequencias);
+
+        while ((cmd = *lugar) != NULL) {
+            int valor;
+
+            if (cmd->tipo == CMD_ATRIB && morta(e, cmd)) {
+                *lugar = cmd->prox;
+                removidos++;
+                e->atribuicoes++;
+                continue;
+            }
+
+            if (cmd->tipo == CMD_SE && condicao_constante(cmd->dado.se.condicao, &valor)) {
+                /* O ramo tomado ocupa o lugar do SE e é visitado em seguida */
+                NoCmd *ramo = valor ? cmd->dado.se.entao : cmd->dado.se.senao;
+                long podados = 1 + contar_sequencia(valor ? cmd->dado.se.senao : cmd->dado.se.entao);
+                if (e->registro != NULL) {
+                    fprintf(e->registro, ">>> Codigo morto na linha %d: SE com condicao sempre %s, "
+                                         "%ld comando(s) removido(s)\n",
+                            cmd->dado.se.condicao->linha, valor ? "verdadeira" : "falsa", podados);
+                }
+                if (ramo != NULL) {
+                    NoCmd *fim = ramo;
+                    while (fim->prox != NULL) {
+                        fim = fim->prox;
+                    }
+                    fim->prox = cmd->prox;
+                    *lugar = ramo;
+                } else {
+                    *lugar = cmd->prox;
+                }
+                removidos += podados;
+                e->desvios++;
+                continue;
+            }
+
+            if (cmd->tipo == CMD_SE && cmd->dado.se.entao == NULL && cmd->dado.se.senao == NULL) {
+                e->num_lidas = 0;
+                if (!ler_expressao(e, cmd->dado.se.condicao)) {
+                    if (e->registro != NULL) {
+                        fprintf(e->registro, ">>> Codigo morto na linha %d: SE sem comandos\n",
+                                cmd->dado.se.condicao->linha);
+                    }
+                    *lugar = cmd->prox;
+                    removidos++;
+                    e->desvios++;
+                    continue;
+                }
+            }
+
+            if (cmd->tipo == CMD_ENQUANTO && condicao_constante(cmd->dado.enquanto.condicao, &valor)) {
+                if (!valor) {
+                    long podados = contar_comando(cmd);
+                    if (e->registro != NULL) {
+                        fprintf(e->registro, ">>> Codigo morto na linha %d: ENQUANTO com condicao sempre "
+                                             "falsa, %ld comando(s) removido(s)\n",
+                                cmd->dado.enquanto.condicao->linha, podados);
+                    }
+                    *lugar = cmd->prox;
+                    removidos += podados;
+                    e->desvios++;
+                    continue;
+                }
+                if (cmd->prox != NULL) {
+                    /* Laço que só termina por um erro de execução */
+                    long podados = contar_sequencia(cmd->prox);
+                    if (e->registro != NULL) {
+                        fprintf(e->registro, ">>> Codigo morto na linha %d: %ld comando(s) apos um "
+                                             "ENQUANTO que nunca termina\n",
+                                cmd->dado.enquanto.condicao->linha, podados);
+                    }
+                    cmd->prox = NULL;
+                    removidos += podados;
+                }
+            }
+
+            if (cmd->tipo == CMD_SE) {
+                *(NoCmd ***)pilha_empilhar(&sequencias) = &cmd->dado.se.senao;
+                *(NoCmd ***)pilha_empilhar(&sequencias) = &cmd->dado.se.entao;
+            } else if (cmd->tipo == CMD_ENQUANTO) {
+                *(NoCmd ***)pilha_empilhar(&sequencias) = &cmd->dado.enquanto.corpo;
+            }
+            ultimo = cmd;
+            lugar = &cmd->prox;
+        }
+
+        if (*inicio != NULL) {
+            (*inicio)->ultimo = ultimo;
+        }
+    }
+
+    pilha_liberar(&sequencias);
+    e->num_mortas = 0;
+    e->comandos += removidos;
+    return removidos;
+}
+
+/* ========== Passo completo ========== */
+
+long eliminar_codigo_morto(ContextoCompilacao *ctx, NoPrograma *prog, FILE *registro) {
+    EstadoMorto e;
+    size_t n;
+
+    memset(&e, 0, sizeof(e));
+    e.ctx = ctx;
+    e.registro = registro;
+    e.num_variaveis = ctx->tabela.num_simbolos;
+    n = (size_t)e.num_variaveis + 1;
+    e.util = (unsigned char *)realocar(NULL, n);
+    e.inicio = (int *)realocar(NULL, n * sizeof(int));
+    e.fila = (int *)realocar(NULL, n * sizeof(int));
+    e.removidas = (long *)calloc(n, sizeof(long));
+    e.linha_removida = (int *)calloc(n, sizeof(int));
+    if (e.removidas == NULL || e.linha_removida == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a eliminacao de codigo morto\n");
+        exit(1);
+    }
+    pilha_iniciar(&e.pilha, sizeof(NoExpr *));
+
+    /* Primeiro os desvios constantes deixados pelo dobramento */
+    long removidos = varrer(&e, prog);
+    for (int rodada = 0; rodada < MAX_RODADAS && prog->algoritmo != NULL; rodada++) {
+        /* Uma varredura sem atribuições marcadas ainda tira os SE que ficaram vazios */
+        if (marcar_mortas(&e, prog) == 0 && removidos == 0) {
+            break;
+        }
+        removidos = varrer(&e, prog);
+    }
+
+    if (registro != NULL) {
+        char nome[ID_MAX_CHARS + 1];
+        for (int v = 0; v < e.num_variaveis; v++) {
+            if (e.removidas[v] > 0) {
+                fprintf(registro, ">>> Atribuicoes sem leitura a '%s': %ld removida(s), a primeira na linha %d\n",
+                        texto_id(ctx->tabela.simbolos[v].chave, nome), e.removidas[v], e.linha_removida[v]);
+            }
+        }
+    }
+
+    ctx->atribuicoes_mortas = e.atribuicoes;
+    ctx->desvios_constantes = e.desvios;
+    ctx->comandos_removidos = e.comandos;
+
+    pilha_liberar(&e.pilha);
+    free(e.lidas);
+    free(e.util);
+    free(e.dependencias);
+    free(e.inicio);
+    free(e.lidas_por_alvo);
+    free(e.fila);
+    free(e.mortas);
+    free(e.removidas);
+    free(e.linha_removida);
+    return e.comandos;
+}
@@ -0,0 +1,35 @@
+/*
+ * Eliminação de código morto: desvios constantes e atribuições sem leitura
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef CODIGO_MORTO_H
+#define CODIGO_MORTO_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/*
+ * Remove do ALGORITMO:
+ *   - o ramo de um SE cuja condição o dobramento tornou constante (o
+ *     outro ramo toma o lugar do SE), um SE com os dois ramos vazios e
+ *     um ENQUANTO cuja condição é sempre falsa;
+ *   - os comandos que seguem, na mesma sequência, um ENQUANTO cuja
+ *     condição é sempre verdadeira (nunca são alcançados);
+ *   - as atribuições cujo valor nunca é lido: a variável não está viva
+ *     depois delas (vivacidade, fluxo.h) ou só alimenta atribuições a
+ *     variáveis que nunca chegam a um ESCREVA, a uma condição ou a um
+ *     índice.
+ * LEIA e ESCREVA ficam sempre, e uma atribuição que pode interromper a
+ * execução (divisão inteira por uma variável ou por -1, acesso a lista
+ * não provado seguro) também fica, para que o erro aconteça.
+ *
+ * Deve ser chamada após o dobramento de constantes, numa AST sem erros
+ * semânticos (otimizar_programa o faz em OTIMIZAR_LACOS, -O2). Com 'registro' não nulo, escreve ali uma linha por desvio
+ * podado e por variável com atribuições removidas. Retorna o número de
+ * comandos removidos (também em ctx->comandos_removidos; as atribuições
+ * e os desvios ficam em ctx->atribuicoes_mortas e ctx->desvios_constantes).
+ */
+long eliminar_codigo_morto(ContextoCompilacao *ctx, NoPrograma *prog, FILE *registro);
+
+#endif /* CODIGO_MORTO_H */
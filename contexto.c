@@ -0,0 +1,214 @@
+/*
+ * Implementação do contexto de compilação
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#define _DEFAULT_SOURCE     /* MAP_ANONYMOUS */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "contexto.h"
+
+int inicializar_contexto(ContextoCompilacao *ctx, const char *arquivo, DestinoDiagnosticos destino) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->arquivo = arquivo;
+    ctx->linha = 1;
+    ctx->coluna = 1;
+    ctx->relatorio = 1;
+    ctx->mostrar_tabela = 1;
+    ctx->destino = destino;
+
+    if (destino == DESTINO_MEMORIA) {
+        ctx->diagnosticos = open_memstream(&ctx->texto_diagnosticos,
+                                           &ctx->tamanho_diagnosticos);
+        if (ctx->diagnosticos == NULL) {
+            return 0;
+        }
+    } else {
+        ctx->diagnosticos = stderr;
+    }
+    return 1;
+}
+
+static void fechar_fonte(ContextoCompilacao *ctx) {
+    if (ctx->fonte != NULL && ctx->fonte != stdin) {
+        fclose(ctx->fonte);
+    }
+    ctx->fonte = NULL;
+}
+
+void liberar_contexto(ContextoCompilacao *ctx) {
+    liberar_tabela_simbolos(ctx);
+    arena_liberar(&ctx->arena);
+    ctx->programa = NULL;
+
+    /* As cadeias da AST apontam para os mapas: só agora eles podem sair */
+    fechar_fonte(ctx);
+    if (ctx->mapa != NULL && ctx->tamanho_mapa > 0) {
+        munmap(ctx->mapa, ctx->tamanho_mapa);
+    }
+    ctx->mapa = NULL;
+    if (ctx->mapa_cache != NULL) {
+        munmap(ctx->mapa_cache, ctx->tamanho_mapa_cache);
+        ctx->mapa_cache = NULL;
+    }
+
+    if (ctx->diagnosticos != NULL && ctx->diagnosticos != stderr) {
+        fclose(ctx->diagnosticos);
+        free(ctx->texto_diagnosticos);
+        ctx->texto_diagnosticos = NULL;
+    }
+    ctx->diagnosticos = NULL;
+    liberar_diagnosticos(&ctx->coletados);
+}
+
+int reiniciar_contexto(ContextoCompilacao *ctx, const char *arquivo, DestinoDiagnosticos destino) {
+    Arena arena = ctx->arena;
+
+    /* Tudo da compilação anterior sai, menos os blocos da arena */
+    memset(&ctx->arena, 0, sizeof(ctx->arena));
+    liberar_contexto(ctx);
+    arena_reiniciar(&arena);
+
+    int ok = inicializar_contexto(ctx, arquivo, destino);
+    ctx->arena = arena;
+    return ok;
+}
+
+/* ========== Leitura da fonte ========== */
+
+/*
+ * Mapeia 'tamanho' bytes de 'fd' seguidos de dois '\0', exigidos pelo
+ * yy_scan_buffer do FLEX. Reserva primeiro uma região anônima (zerada)
+ * um pouco maior e sobrepõe o arquivo ao seu início: o resto da última
+ * página do arquivo já vem zerado, e se o arquivo ocupar páginas
+ * inteiras, os zeros vêm da página anônima seguinte.
+ *
+ * O mapeamento é privado e gravável porque o FLEX termina cada yytext
+ * com '\0' no próprio buffer; só as páginas tocadas são copiadas.
+ */
+static int mapear_fonte(ContextoCompilacao *ctx, int fd, size_t tamanho) {
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    size_t total = (tamanho + 2 + pagina - 1) / pagina * pagina;
+
+    char *base = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return 0;
+    }
+    if (mmap(base, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, total);
+        return 0;
+    }
+    posix_madvise(base, tamanho, POSIX_MADV_SEQUENTIAL);
+
+    ctx->mapa = base;
+    ctx->tamanho_mapa = total;
+    ctx->tamanho_fonte = tamanho;
+    return 1;
+}
+
+int abrir_fonte(ContextoCompilacao *ctx, const char *caminho) {
+    if (strcmp(caminho, "-") == 0) {
+        ctx->fonte = stdin;
+        return 1;
+    }
+
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    /* Arquivos regulares não vazios são mapeados; o resto vai em fluxo */
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        mapear_fonte(ctx, fd, (size_t)st.st_size)) {
+        close(fd);
+        return 1;
+    }
+
+    ctx->fonte = fdopen(fd, "r");
+    if (ctx->fonte == NULL) {
+        close(fd);
+        return 0;
+    }
+    return 1;
+}
+
+void usar_fonte_memoria(ContextoCompilacao *ctx, char *texto, size_t tamanho) {
+    ctx->mapa = texto;
+    ctx->tamanho_mapa = 0;      /* Emprestado: liberar_contexto não o desfaz */
+    ctx->tamanho_fonte = tamanho;
+}
+
+int analisar_sintaxe(ContextoCompilacao *ctx) {
+    int resultado;
+
+    if (ctx->mapa != NULL) {
+        resultado = analisar_memoria(ctx, ctx->mapa, ctx->tamanho_fonte);
+    } else if (ctx->fonte != NULL) {
+        resultado = analisar_fluxo(ctx, ctx->fonte);
+        fechar_fonte(ctx);
+    } else {
+        diagnosticar(ctx, SEVERIDADE_ERRO, ORIGEM_COMPILADOR, "CMP001", 0, 0,
+                     "nenhuma fonte aberta para '%s'", ctx->arquivo);
+        return 0;
+    }
+    return resultado == 0 && ctx->erros_sintaticos == 0;
+}
+
+/* ========== Marcas de comandos ========== */
+
+void marcar_comando(ContextoCompilacao *ctx, const char *texto, int tamanho) {
+    MarcasComandos *m = ctx->marcas;
+
+    if (m->num == m->capacidade) {
+        int nova = m->capacidade > 0 ? 2 * m->capacidade : 64;
+        MarcaComando *itens = (MarcaComando *)realloc(m->itens, nova * sizeof(MarcaComando));
+        if (itens == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para as marcas de comandos\n");
+            exit(1);
+        }
+        m->itens = itens;
+        m->capacidade = nova;
+    }
+
+    /* O lookahead já foi lido: a coluna corrente está no fim dele */
+    MarcaComando *marca = &m->itens[m->num++];
+    marca->texto = texto;
+    marca->linha = ctx->linha;
+    marca->coluna = ctx->coluna - tamanho;
+    marca->comandos = NULL;
+    marca->num_comandos = 0;
+}
+
+void ligar_comando(ContextoCompilacao *ctx, NoCmd *cmd) {
+    MarcasComandos *m = ctx->marcas;
+
+    if (m->num == 0) return;
+    MarcaComando *marca = &m->itens[m->num - 1];
+    if (marca->comandos == NULL) {
+        marca->comandos = cmd;
+    }
+    marca->num_comandos++;
+}
+
+void marcar_fim_algoritmo(ContextoCompilacao *ctx, const char *texto, int tamanho) {
+    MarcasComandos *m = ctx->marcas;
+
+    m->fim = texto;
+    m->linha_fim = ctx->linha;
+    m->coluna_fim = ctx->coluna - tamanho;
+    m->tamanho_fim = tamanho;
+}
+
+const char *diagnosticos_contexto(ContextoCompilacao *ctx) {
+    if (ctx->diagnosticos == NULL || ctx->diagnosticos == stderr) {
+        return "";
+    }
+    fflush(ctx->diagnosticos);
+    return ctx->texto_diagnosticos != NULL ? ctx->texto_diagnosticos : "";
+}
@@ -0,0 +1,215 @@
+/*
+ * Contexto de compilação de um arquivo X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef CONTEXTO_H
+#define CONTEXTO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ast.h"
+#include "arena.h"
+#include "semantic.h"
+#include "diagnosticos.h"
+
+/* Para onde vão os diagnósticos de um contexto (inicializar_contexto) */
+typedef enum {
+    DESTINO_STDERR,             /* Texto, escrito à medida que surgem */
+    DESTINO_MEMORIA,            /* Texto num buffer (diagnosticos_contexto) */
+    DESTINO_LISTA               /* Guardados em 'coletados', para JSON */
+} DestinoDiagnosticos;
+
+/*
+ * Onde começa cada comando do nível externo de ALGORITMO numa análise
+ * (a posição no buffer analisado e a linha e coluna do primeiro token),
+ * com os comandos que o parser montou a partir dali: normalmente um só;
+ * nenhum se houve erro de sintaxe, e mais de um quando comandos vindos
+ * logo após um erro ficam com ele. O servidor LSP (lsp.h) reanalisa
+ * apenas os trechos entre marcas atingidos por uma edição.
+ */
+typedef struct MarcaComando {
+    const char *texto;
+    int linha;
+    int coluna;
+    NoCmd *comandos;
+    int num_comandos;
+} MarcaComando;
+
+typedef struct MarcasComandos {
+    MarcaComando *itens;
+    int num;
+    int capacidade;
+    const char *fim;            /* Token após o último comando (FIMPROG) */
+    int linha_fim;
+    int coluna_fim;
+    int tamanho_fim;
+} MarcasComandos;
+
+/*
+ * Todo o estado de uma compilação: o analisador léxico (reentrante), o
+ * parser (puro) e a análise semântica só acessam o que está aqui, então
+ * cada thread pode compilar um arquivo diferente com o seu contexto.
+ */
+struct ContextoCompilacao {
+    const char *arquivo;
+
+    /*
+     * Fonte: um arquivo regular é mapeado em memória ('mapa', com dois
+     * '\0' após os 'tamanho_fonte' bytes) e analisado no lugar; cadeias
+     * literais apontam para dentro do mapa, que vive até liberar_contexto.
+     * Pipes e a entrada padrão são lidos em fluxo por 'fonte'. Com
+     * 'tamanho_mapa' 0, o buffer é emprestado (usar_fonte_memoria).
+     */
+    char *mapa;
+    size_t tamanho_mapa;
+    size_t tamanho_fonte;
+    FILE *fonte;
+
+    /* Posição corrente do analisador léxico */
+    int linha;
+    int coluna;
+    long tokens;                /* Tokens entregues ao parser */
+    int linha_id;               /* Início do último identificador lido */
+    int coluna_id;
+    int erros_lexicos;
+
+    /* Resultado da análise sintática */
+    NoPrograma *programa;
+    int erros_sintaticos;
+
+    /*
+     * Análise incremental (lsp.h): com 'trecho', a fonte é uma sequência
+     * de comandos de ALGORITMO, sem cabeçalho nem FIMPROG, e o resultado
+     * é ctx->programa->algoritmo; com 'marcas' não nulo, os inícios dos
+     * comandos são registrados ali.
+     */
+    int trecho;
+    MarcasComandos *marcas;
+
+    /* Análise semântica */
+    TabelaSimbolos tabela;
+    int erros_semanticos;
+    int avisos;
+    int relatorio;              /* Imprime progresso (padrão: 1) */
+    int mostrar_tabela;         /* Imprime a tabela de símbolos (padrão: 1) */
+    long buscas_tabela;
+    long sondagens_tabela;      /* Baldes visitados nessas buscas */
+    int maior_sondagem_busca;
+    long declaracoes_analisadas;
+    long referencias_variaveis;
+
+    /* Fluxo de dados (fluxo.h): tamanho do grafo e trabalho do solver */
+    int blocos_fluxo;
+    int lacos_fluxo;
+    long visitas_fluxo;
+    double ms_fluxo;
+
+    /* Limites de listas (intervalos.h): acessos provados dentro e fora */
+    long acessos_lista;
+    long acessos_seguros;
+    long acessos_fora;
+    double ms_limites;
+
+    /* Otimização (nós de expressão antes e depois, invariantes de laços movidos) */
+    long nos_antes_otimizacao;
+    long nos_depois_otimizacao;
+    long invariantes_movidos;
+
+    /*
+     * Código morto (codigo_morto.h): atribuições sem leitura, desvios
+     * com condição constante e o total de comandos removidos
+     */
+    long atribuicoes_mortas;
+    long desvios_constantes;
+    long comandos_removidos;
+
+    /*
+     * Subexpressões comuns (subexpressoes.h): ocorrências trocadas por
+     * temporários, nós de expressão a menos no programa e nós fundidos
+     * pelo compartilhamento
+     */
+    long subexpressoes_comuns;
+    long temporarios_comuns;
+    long avaliacoes_removidas;
+    long nos_compartilhados;
+    long nos_unicos;
+    long bytes_compartilhados;
+
+    /* Dona de todos os nós da AST e das cadeias literais */
+    Arena arena;
+
+    /*
+     * Cache de ASTs verificadas (cache.h): chave da fonte e, num acerto,
+     * a imagem mapeada que passa a conter a AST (vive até liberar_contexto)
+     */
+    uint64_t chave_cache;
+    uint64_t verificacao_cache;
+    int chave_cache_valida;
+    int cache_acertos;
+    int cache_falhas;
+    char *mapa_cache;
+    size_t tamanho_mapa_cache;
+
+    /*
+     * Destino dos erros e avisos: stderr, um buffer em memória
+     * (open_memstream) quando as mensagens precisam sair de uma vez (de
+     * vários arquivos compilados em paralelo, ou com --quiet), ou a
+     * lista estruturada 'coletados' (--diagnostics=json).
+     */
+    DestinoDiagnosticos destino;
+    FILE *diagnosticos;
+    char *texto_diagnosticos;
+    size_t tamanho_diagnosticos;
+    ListaDiagnosticos coletados;
+};
+
+/* Prepara um contexto vazio, com os diagnósticos indo para 'destino' */
+int inicializar_contexto(ContextoCompilacao *ctx, const char *arquivo, DestinoDiagnosticos destino);
+
+/* Libera a AST, a tabela de símbolos e os diagnósticos */
+void liberar_contexto(ContextoCompilacao *ctx);
+
+/*
+ * Libera o que a compilação anterior deixou em ctx e o prepara para
+ * outra, como inicializar_contexto, mas mantendo os blocos da arena:
+ * uma sequência de compilações pequenas não volta ao malloc.
+ */
+int reiniciar_contexto(ContextoCompilacao *ctx, const char *arquivo, DestinoDiagnosticos destino);
+
+/* Abre 'caminho' ("-" = entrada padrão); retorna 0 se não foi possível */
+int abrir_fonte(ContextoCompilacao *ctx, const char *caminho);
+
+/*
+ * Usa como fonte 'tamanho' bytes de 'texto', seguidos de dois '\0' e
+ * graváveis (o FLEX os analisa no lugar). O buffer continua do chamador
+ * e deve viver enquanto a AST de ctx for usada.
+ */
+void usar_fonte_memoria(ContextoCompilacao *ctx, char *texto, size_t tamanho);
+
+/* Análise léxica e sintática da fonte aberta; retorna 1 se não houve erros */
+int analisar_sintaxe(ContextoCompilacao *ctx);
+
+/* Texto dos diagnósticos acumulados em memória ("" se nenhum) */
+const char *diagnosticos_contexto(ContextoCompilacao *ctx);
+
+/* ========== Marcas de comandos (parser.y) ========== */
+
+/* Registra o início de um comando no token 'texto' de 'tamanho' bytes */
+void marcar_comando(ContextoCompilacao *ctx, const char *texto, int tamanho);
+
+/* Associa 'cmd' à última marca registrada */
+void ligar_comando(ContextoCompilacao *ctx, NoCmd *cmd);
+
+/* Registra o token que encerra a área ALGORITMO */
+void marcar_fim_algoritmo(ContextoCompilacao *ctx, const char *texto, int tamanho);
+
+/* ========== Interface do analisador léxico (lexer.l) ========== */
+
+/* Executa o parser lendo 'entrada' em fluxo; retorna o valor de yyparse */
+int analisar_fluxo(ContextoCompilacao *ctx, FILE *entrada);
+
+/* Executa o parser sobre 'base' no lugar (seguido de dois '\0') */
+int analisar_memoria(ContextoCompilacao *ctx, char *base, size_t tamanho);
+
+#endif /* CONTEXTO_H */
@@ -0,0 +1,164 @@
+/*
+ * Implementação dos diagnósticos
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "diagnosticos.h"
+#include "contexto.h"
+
+/* ========== Texto ========== */
+
+static void escrever_prefixo(FILE *saida, Severidade severidade, OrigemDiagnostico origem,
+                             int linha, int coluna) {
+    if (origem == ORIGEM_COMPILADOR) {
+        fputs("Erro: ", saida);
+    } else if (severidade == SEVERIDADE_AVISO) {
+        fprintf(saida, "AVISO na linha %d: ", linha);
+    } else if (origem == ORIGEM_SEMANTICA) {
+        fprintf(saida, "ERRO SEMANTICO na linha %d: ", linha);
+    } else {
+        fprintf(saida, "ERRO %s na linha %d, coluna %d: ",
+                origem == ORIGEM_LEXICA ? "LEXICO" : "SINTATICO", linha, coluna);
+    }
+}
+
+void escrever_diagnostico(const Diagnostico *d, FILE *saida) {
+    escrever_prefixo(saida, d->severidade, d->origem, d->linha, d->coluna);
+    fprintf(saida, "%s\n", d->mensagem);
+}
+
+/* ========== Coleta ========== */
+
+static int guardar(ListaDiagnosticos *lista, Diagnostico *d, const char *formato, va_list args) {
+    va_list copia;
+
+    va_copy(copia, args);
+    int tam = vsnprintf(NULL, 0, formato, copia);
+    va_end(copia);
+
+    if (tam < 0) return 0;
+    d->mensagem = (char *)malloc((size_t)tam + 1);
+    if (d->mensagem == NULL) return 0;
+    vsnprintf(d->mensagem, (size_t)tam + 1, formato, args);
+
+    if (lista->num == lista->capacidade) {
+        int nova = lista->capacidade > 0 ? 2 * lista->capacidade : 16;
+        Diagnostico *itens = (Diagnostico *)realloc(lista->itens, nova * sizeof(Diagnostico));
+        if (itens == NULL) {
+            free(d->mensagem);
+            return 0;
+        }
+        lista->itens = itens;
+        lista->capacidade = nova;
+    }
+    lista->itens[lista->num++] = *d;
+    return 1;
+}
+
+void vdiagnosticar(ContextoCompilacao *ctx, Severidade severidade, OrigemDiagnostico origem,
+                   const char *codigo, int linha, int coluna, const char *formato, va_list args) {
+    if (ctx->destino == DESTINO_LISTA) {
+        Diagnostico d;
+        d.severidade = severidade;
+        d.origem = origem;
+        d.codigo = codigo;
+        d.linha = linha;
+        d.coluna = coluna;
+
+        va_list copia;
+        va_copy(copia, args);
+        int guardado = guardar(&ctx->coletados, &d, formato, copia);
+        va_end(copia);
+        if (guardado) {
+            return;
+        }
+        /* Sem memória para guardar: ao menos não perde a mensagem */
+    }
+
+    FILE *saida = ctx->diagnosticos != NULL ? ctx->diagnosticos : stderr;
+    escrever_prefixo(saida, severidade, origem, linha, coluna);
+    vfprintf(saida, formato, args);
+    fputc('\n', saida);
+}
+
+void diagnosticar(ContextoCompilacao *ctx, Severidade severidade, OrigemDiagnostico origem,
+                  const char *codigo, int linha, int coluna, const char *formato, ...) {
+    va_list args;
+    va_start(args, formato);
+    vdiagnosticar(ctx, severidade, origem, codigo, linha, coluna, formato, args);
+    va_end(args);
+}
+
+void liberar_diagnosticos(ListaDiagnosticos *lista) {
+    for (int i = 0; i < lista->num; i++) {
+        free(lista->itens[i].mensagem);
+    }
+    free(lista->itens);
+    memset(lista, 0, sizeof(*lista));
+}
+
+/* ========== JSON ========== */
+
+void escrever_cadeia_json(FILE *saida, const char *s) {
+    fputc('"', saida);
+    for (; s != NULL && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(saida, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(saida, "\\u%04x", c);
+        } else if (c < 0x80) {
+            fputc(c, saida);
+        } else {
+            /* Sequências UTF-8 passam; um byte solto (fonte em Latin-1) vira \u00XX */
+            int n = c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+            int k = 1;
+            while (k < n && ((unsigned char)s[k] & 0xC0) == 0x80) k++;
+            if (n > 0 && k == n) {
+                fwrite(s, 1, (size_t)n, saida);
+                s += n - 1;
+            } else {
+                fprintf(saida, "\\u%04x", c);
+            }
+        }
+    }
+    fputc('"', saida);
+}
+
+static const char *nome_origem(OrigemDiagnostico origem) {
+    switch (origem) {
+        case ORIGEM_LEXICA:     return "lexica";
+        case ORIGEM_SINTATICA:  return "sintatica";
+        case ORIGEM_SEMANTICA:  return "semantica";
+        default:                return "compilador";
+    }
+}
+
+void escrever_diagnosticos_json(ContextoCompilacao *ctx, FILE *saida) {
+    const ListaDiagnosticos *lista = &ctx->coletados;
+    int erros = 0;
+
+    for (int i = 0; i < lista->num; i++) {
+        erros += lista->itens[i].severidade == SEVERIDADE_ERRO;
+    }
+
+    fputs("{\"arquivo\": ", saida);
+    escrever_cadeia_json(saida, ctx->arquivo);
+    fprintf(saida, ", \"erros\": %d, \"avisos\": %d, \"diagnosticos\": [",
+            erros, lista->num - erros);
+    for (int i = 0; i < lista->num; i++) {
+        const Diagnostico *d = &lista->itens[i];
+        fprintf(saida, "%s{\"linha\": %d, \"coluna\": %d, \"severidade\": \"%s\", "
+                       "\"codigo\": \"%s\", \"origem\": \"%s\", \"mensagem\": ",
+                i > 0 ? ", " : "", d->linha, d->coluna,
+                d->severidade == SEVERIDADE_ERRO ? "erro" : "aviso",
+                d->codigo, nome_origem(d->origem));
+        escrever_cadeia_json(saida, d->mensagem);
+        fputc('}', saida);
+    }
+    fputs("]}\n", saida);
+}
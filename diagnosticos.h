@@ -0,0 +1,102 @@
+/*
+ * Diagnósticos (erros e avisos) do compilador X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef DIAGNOSTICOS_H
+#define DIAGNOSTICOS_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include "ast.h"
+
+typedef enum {
+    SEVERIDADE_ERRO,
+    SEVERIDADE_AVISO
+} Severidade;
+
+/* Fase que emitiu o diagnóstico (define o texto "ERRO LEXICO", ...) */
+typedef enum {
+    ORIGEM_LEXICA,
+    ORIGEM_SINTATICA,
+    ORIGEM_SEMANTICA,
+    ORIGEM_COMPILADOR           /* Arquivo inacessível, falta de memória */
+} OrigemDiagnostico;
+
+/*
+ * Códigos estáveis, para ferramentas que filtram diagnósticos:
+ *
+ *   LEX001  identificador com mais de 8 caracteres
+ *   LEX002  caractere inválido
+ *   SIN001  erro de sintaxe (mensagem do Bison)
+ *   SIN002  array declarado sem LISTAINT/LISTAREAL
+ *   SEM001  variável já declarada
+ *   SEM002  tamanho de array fora de 10..40
+ *   SEM003  tipo que não pode ser array
+ *   SEM004  variável não declarada
+ *   SEM005  variável usada como array sem ser um
+ *   SEM006  array sem índice
+ *   SEM007  índice não inteiro
+ *   SEM008  tipos incompatíveis em operação aritmética
+ *   SEM009  tipos incompatíveis em comparação
+ *   SEM010  tipo incompatível na atribuição
+ *   SEM011  índice de lista sempre fora dos limites
+ *   AVI001  possível divisão por zero
+ *   AVI002  divisão por zero em expressão constante
+ *   AVI003  variável lida que pode não ter sido inicializada
+ *   AVI004  variável lida sem que nenhuma atribuição a alcance
+ *   AVI005  variável declarada e nunca usada
+ *   AVI006  variável atribuída (ou lida por LEIA) e nunca lida
+ *   CMP001  arquivo não pôde ser aberto
+ *   CMP002  falha ao iniciar o analisador léxico
+ *   CMP003  programa vazio
+ */
+typedef struct Diagnostico {
+    Severidade severidade;
+    OrigemDiagnostico origem;
+    const char *codigo;         /* Literal: um dos códigos acima */
+    int linha;                  /* 0 quando não se refere a um ponto da fonte */
+    int coluna;
+    char *mensagem;
+} Diagnostico;
+
+typedef struct ListaDiagnosticos {
+    Diagnostico *itens;
+    int num;
+    int capacidade;
+} ListaDiagnosticos;
+
+/* Formato de --diagnostics */
+typedef enum {
+    DIAGNOSTICOS_TEXTO,
+    DIAGNOSTICOS_JSON
+} FormatoDiagnosticos;
+
+/*
+ * Emite um diagnóstico de ctx. Em texto, vai direto para ctx->diagnosticos
+ * (stderr ou o buffer em memória); com o destino DESTINO_LISTA (ver
+ * contexto.h), é guardado em ctx->coletados para ser escrito no final.
+ * Não altera os contadores de erros do contexto.
+ */
+void diagnosticar(ContextoCompilacao *ctx, Severidade severidade, OrigemDiagnostico origem,
+                  const char *codigo, int linha, int coluna, const char *formato, ...);
+
+void vdiagnosticar(ContextoCompilacao *ctx, Severidade severidade, OrigemDiagnostico origem,
+                   const char *codigo, int linha, int coluna, const char *formato, va_list args);
+
+/* O mesmo texto que diagnosticar escreveria, de um diagnóstico guardado */
+void escrever_diagnostico(const Diagnostico *d, FILE *saida);
+
+/*
+ * Escreve os diagnósticos guardados de ctx como um objeto JSON numa
+ * única linha (um objeto por arquivo, no formato JSON Lines):
+ *   {"arquivo": ..., "erros": N, "avisos": N, "diagnosticos": [...]}
+ */
+void escrever_diagnosticos_json(ContextoCompilacao *ctx, FILE *saida);
+
+/* Cadeia entre aspas, com os escapes do JSON (sempre UTF-8 válido) */
+void escrever_cadeia_json(FILE *saida, const char *s);
+
+void liberar_diagnosticos(ListaDiagnosticos *lista);
+
+#endif /* DIAGNOSTICOS_H */
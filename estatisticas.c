@@ -0,0 +1,335 @@
+/*
+ * Implementação das estatísticas por fase (--stats)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "estatisticas.h"
+#include "contexto.h"
+
+static const char *nomes_expr[EXPR_NEG + 1] = {
+    [EXPR_CONST_INT]  = "EXPR_CONST_INT",
+    [EXPR_CONST_REAL] = "EXPR_CONST_REAL",
+    [EXPR_VAR]        = "EXPR_VAR",
+    [EXPR_VAR_ARRAY]  = "EXPR_VAR_ARRAY",
+    [EXPR_ARITMETICA] = "EXPR_ARITMETICA",
+    [EXPR_RELACIONAL] = "EXPR_RELACIONAL",
+    [EXPR_LOGICA]     = "EXPR_LOGICA",
+    [EXPR_NAO]        = "EXPR_NAO",
+    [EXPR_NEG]        = "EXPR_NEG"
+};
+
+static const char *nomes_cmd[CMD_ENQUANTO + 1] = {
+    [CMD_ATRIB]    = "CMD_ATRIB",
+    [CMD_LEIA]     = "CMD_LEIA",
+    [CMD_ESCREVA]  = "CMD_ESCREVA",
+    [CMD_SE]       = "CMD_SE",
+    [CMD_ENQUANTO] = "CMD_ENQUANTO"
+};
+
+/* ========== Tempo por fase ========== */
+
+static double ms_entre(struct timespec ini, struct timespec fim) {
+    return (fim.tv_sec - ini.tv_sec) * 1e3 + (fim.tv_nsec - ini.tv_nsec) / 1e6;
+}
+
+void marcar_instante(Instante *t) {
+    clock_gettime(CLOCK_MONOTONIC, &t->parede);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t->cpu);
+}
+
+double registrar_fase(Estatisticas *e, const char *nome, const Instante *ini) {
+    Instante fim;
+    marcar_instante(&fim);
+
+    double parede = ms_entre(ini->parede, fim.parede);
+    if (e->num_fases < MAX_FASES) {
+        Fase *f = &e->fases[e->num_fases++];
+        f->nome = nome;
+        f->parede_ms = parede;
+        f->cpu_ms = ms_entre(ini->cpu, fim.cpu);
+    }
+    return parede;
+}
+
+/* ========== Contagem de nós ========== */
+
+/* Sem recursão: a profundidade da AST é limitada só pela memória */
+
+static void empilhar_no(Pilha *pilha, NoExpr *expr) {
+    if (expr != NULL) {
+        *(NoExpr **)pilha_empilhar(pilha) = expr;
+    }
+}
+
+static void contar_expr(Estatisticas *e, NoExpr *raiz) {
+    Pilha pilha;
+    NoExpr **topo;
+
+    pilha_iniciar(&pilha, sizeof(NoExpr *));
+    empilhar_no(&pilha, raiz);
+
+    while ((topo = (NoExpr **)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = *topo;
+        pilha_desempilhar(&pilha);
+
+        e->nos_expr[expr->tipo]++;
+        switch (expr->tipo) {
+            case EXPR_VAR_ARRAY:
+                empilhar_no(&pilha, expr->dado.var->indice);
+                break;
+            case EXPR_ARITMETICA:
+                empilhar_no(&pilha, expr->dado.aritmetica.esq);
+                empilhar_no(&pilha, expr->dado.aritmetica.dir);
+                break;
+            case EXPR_RELACIONAL:
+                empilhar_no(&pilha, expr->dado.relacional.esq);
+                empilhar_no(&pilha, expr->dado.relacional.dir);
+                break;
+            case EXPR_LOGICA:
+                empilhar_no(&pilha, expr->dado.logica.esq);
+                empilhar_no(&pilha, expr->dado.logica.dir);
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_no(&pilha, expr->dado.negacao);
+                break;
+            default:
+                break;
+        }
+    }
+
+    pilha_liberar(&pilha);
+}
+
+static void contar_cmds(Estatisticas *e, NoCmd *cmd) {
+    PercursoComandos percurso;
+
+    iniciar_percurso(&percurso, cmd);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        e->nos_cmd[cmd->tipo]++;
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                contar_expr(e, cmd->dado.atrib.var->indice);
+                contar_expr(e, cmd->dado.atrib.expr);
+                break;
+            case CMD_LEIA:
+                for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                    contar_expr(e, l->var->indice);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *l = cmd->dado.escreva; l != NULL; l = l->prox) {
+                    if (!l->is_cadeia) {
+                        contar_expr(e, l->item.expr);
+                    }
+                }
+                break;
+            case CMD_SE:
+                contar_expr(e, cmd->dado.se.condicao);
+                break;
+            case CMD_ENQUANTO:
+                contar_expr(e, cmd->dado.enquanto.condicao);
+                break;
+        }
+    }
+    terminar_percurso(&percurso);
+}
+
+void contar_nos(Estatisticas *e, NoPrograma *prog) {
+    if (prog == NULL) return;
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox) {
+        e->nos_decl++;
+    }
+    contar_cmds(e, prog->algoritmo);
+}
+
+void coletar_contexto(Estatisticas *e, ContextoCompilacao *ctx) {
+    e->arquivo = ctx->arquivo;
+    e->tokens = ctx->tokens;
+    e->bytes_fonte = ctx->tamanho_fonte;
+    e->fonte_mapeada = ctx->mapa != NULL;
+    e->cache_acertos = ctx->cache_acertos;
+    e->cache_falhas = ctx->cache_falhas;
+    e->arena_pico = ctx->arena.pico;
+    e->arena_reservados = ctx->arena.bytes_reservados;
+    e->arena_blocos = ctx->arena.num_blocos;
+    e->buscas_tabela = ctx->buscas_tabela;
+    e->sondagens_tabela = ctx->sondagens_tabela;
+    e->maior_sondagem_busca = ctx->maior_sondagem_busca;
+    e->blocos_fluxo = ctx->blocos_fluxo;
+    e->lacos_fluxo = ctx->lacos_fluxo;
+    e->visitas_fluxo = ctx->visitas_fluxo;
+    e->ms_fluxo = ctx->ms_fluxo;
+    e->acessos_lista = ctx->acessos_lista;
+    e->acessos_seguros = ctx->acessos_seguros;
+    e->acessos_fora = ctx->acessos_fora;
+    e->ms_limites = ctx->ms_limites;
+    e->nos_antes_otimizacao = ctx->nos_antes_otimizacao;
+    e->nos_depois_otimizacao = ctx->nos_depois_otimizacao;
+    e->comandos_removidos = ctx->comandos_removidos;
+    e->atribuicoes_mortas = ctx->atribuicoes_mortas;
+    e->invariantes_movidos = ctx->invariantes_movidos;
+    e->subexpressoes_comuns = ctx->subexpressoes_comuns;
+    e->avaliacoes_removidas = ctx->avaliacoes_removidas;
+    e->nos_compartilhados = ctx->nos_compartilhados;
+    e->bytes_compartilhados = ctx->bytes_compartilhados;
+    ocupacao_tabela(ctx, &e->tabela);
+}
+
+/* ========== Saída ========== */
+
+static long total_nos(const Estatisticas *e) {
+    long total = e->nos_decl;
+    for (int i = 0; i <= EXPR_NEG; i++) total += e->nos_expr[i];
+    for (int i = 0; i <= CMD_ENQUANTO; i++) total += e->nos_cmd[i];
+    return total;
+}
+
+/* Tokens por segundo na fase léxica e sintática (as duas são intercaladas) */
+static double tokens_por_segundo(const Estatisticas *e) {
+    for (int i = 0; i < e->num_fases; i++) {
+        if (strcmp(e->fases[i].nome, "lexico_sintatico") == 0) {
+            double ms = e->fases[i].parede_ms;
+            return ms > 0 ? e->tokens / (ms / 1e3) : 0.0;
+        }
+    }
+    return 0.0;
+}
+
+static double sondagens_por_busca(const Estatisticas *e) {
+    return e->buscas_tabela > 0 ? (double)e->sondagens_tabela / e->buscas_tabela : 0.0;
+}
+
+static void imprimir_json(const Estatisticas *e, FILE *saida) {
+    fprintf(saida, "{\n  \"arquivo\": ");
+    escrever_cadeia_json(saida, e->arquivo);
+
+    fprintf(saida, ",\n  \"fases\": [");
+    for (int i = 0; i < e->num_fases; i++) {
+        fprintf(saida, "%s\n    {\"nome\": \"%s\", \"parede_ms\": %.3f, \"cpu_ms\": %.3f}",
+                i > 0 ? "," : "", e->fases[i].nome, e->fases[i].parede_ms, e->fases[i].cpu_ms);
+    }
+    fprintf(saida, "\n  ],\n");
+
+    fprintf(saida, "  \"fonte\": {\"bytes\": %zu, \"mapeada\": %s},\n",
+            e->bytes_fonte, e->fonte_mapeada ? "true" : "false");
+    fprintf(saida, "  \"cache\": {\"acertos\": %d, \"falhas\": %d},\n",
+            e->cache_acertos, e->cache_falhas);
+    fprintf(saida, "  \"tokens\": %ld,\n  \"tokens_por_segundo\": %.0f,\n",
+            e->tokens, tokens_por_segundo(e));
+
+    fprintf(saida, "  \"nos\": {\n    \"total\": %ld,\n    \"declaracoes\": %ld,\n",
+            total_nos(e), e->nos_decl);
+    fprintf(saida, "    \"expressoes\": {");
+    for (int i = 0; i <= EXPR_NEG; i++) {
+        fprintf(saida, "%s\"%s\": %ld", i > 0 ? ", " : "", nomes_expr[i], e->nos_expr[i]);
+    }
+    fprintf(saida, "},\n    \"comandos\": {");
+    for (int i = 0; i <= CMD_ENQUANTO; i++) {
+        fprintf(saida, "%s\"%s\": %ld", i > 0 ? ", " : "", nomes_cmd[i], e->nos_cmd[i]);
+    }
+    fprintf(saida, "}\n  },\n");
+
+    fprintf(saida, "  \"memoria\": {\"arena_pico_bytes\": %zu, \"arena_reservados_bytes\": %zu, "
+                   "\"arena_blocos\": %d, \"tabela_bytes\": %zu},\n",
+            e->arena_pico, e->arena_reservados, e->arena_blocos, e->tabela.bytes);
+
+    fprintf(saida, "  \"tabela_simbolos\": {\"simbolos\": %d, \"baldes\": %d, \"fator_carga\": %.3f, "
+                   "\"sondagem_media\": %.3f, \"maior_sondagem\": %d, \"buscas\": %ld, "
+                   "\"sondagens_por_busca\": %.3f, \"maior_sondagem_busca\": %d},\n",
+            e->tabela.simbolos, e->tabela.baldes, e->tabela.fator_carga,
+            e->tabela.sondagem_media, e->tabela.maior_sondagem, e->buscas_tabela,
+            sondagens_por_busca(e), e->maior_sondagem_busca);
+
+    fprintf(saida, "  \"fluxo\": {\"blocos\": %d, \"lacos\": %d, \"visitas\": %ld, \"ms\": %.3f},\n",
+            e->blocos_fluxo, e->lacos_fluxo, e->visitas_fluxo, e->ms_fluxo);
+
+    fprintf(saida, "  \"limites\": {\"acessos\": %ld, \"seguros\": %ld, \"fora\": %ld, \"ms\": %.3f},\n",
+            e->acessos_lista, e->acessos_seguros, e->acessos_fora, e->ms_limites);
+
+    fprintf(saida, "  \"otimizacao\": {\"nos_antes\": %ld, \"nos_depois\": %ld, \"comandos_removidos\": %ld, "
+                   "\"atribuicoes_mortas\": %ld, \"invariantes\": %ld, \"subexpressoes\": %ld, "
+                   "\"nos_a_menos\": %ld, \"compartilhados\": %ld, \"bytes_compartilhados\": %ld}\n}\n",
+            e->nos_antes_otimizacao, e->nos_depois_otimizacao, e->comandos_removidos,
+            e->atribuicoes_mortas, e->invariantes_movidos, e->subexpressoes_comuns,
+            e->avaliacoes_removidas, e->nos_compartilhados, e->bytes_compartilhados);
+}
+
+static void imprimir_texto(const Estatisticas *e, FILE *saida) {
+    fprintf(saida, "\n=== ESTATISTICAS: %s ===\n", e->arquivo);
+
+    fprintf(saida, "%-20s %12s %12s\n", "Fase", "Parede (ms)", "CPU (ms)");
+    for (int i = 0; i < e->num_fases; i++) {
+        fprintf(saida, "%-20s %12.3f %12.3f\n",
+                e->fases[i].nome, e->fases[i].parede_ms, e->fases[i].cpu_ms);
+    }
+
+    if (e->fonte_mapeada) {
+        fprintf(saida, "\nFonte: %zu bytes, mapeada em memoria\n", e->bytes_fonte);
+    } else {
+        fprintf(saida, "\nFonte: lida em fluxo\n");
+    }
+    if (e->cache_acertos + e->cache_falhas > 0) {
+        fprintf(saida, "Cache de ASTs: %s\n", e->cache_acertos > 0 ? "acerto" : "falha");
+    }
+    fprintf(saida, "Tokens: %ld (%.0f tokens/s)\n", e->tokens, tokens_por_segundo(e));
+
+    fprintf(saida, "\nNos da AST: %ld (%ld declaracoes)\n", total_nos(e), e->nos_decl);
+    for (int i = 0; i <= EXPR_NEG; i++) {
+        if (e->nos_expr[i] > 0) {
+            fprintf(saida, "  %-20s %10ld\n", nomes_expr[i], e->nos_expr[i]);
+        }
+    }
+    for (int i = 0; i <= CMD_ENQUANTO; i++) {
+        if (e->nos_cmd[i] > 0) {
+            fprintf(saida, "  %-20s %10ld\n", nomes_cmd[i], e->nos_cmd[i]);
+        }
+    }
+    if (e->nos_antes_otimizacao > 0) {
+        fprintf(saida, "  Otimizacao: %ld -> %ld nos de expressao\n",
+                e->nos_antes_otimizacao, e->nos_depois_otimizacao);
+    }
+    if (e->comandos_removidos > 0) {
+        fprintf(saida, "  Codigo morto: %ld comando(s) removido(s) (%ld atribuicao(oes) sem leitura)\n",
+                e->comandos_removidos, e->atribuicoes_mortas);
+    }
+    if (e->invariantes_movidos > 0) {
+        fprintf(saida, "  Invariantes de laco movidos: %ld\n", e->invariantes_movidos);
+    }
+    if (e->subexpressoes_comuns > 0 || e->nos_compartilhados > 0) {
+        fprintf(saida, "  Subexpressoes comuns: %ld (%ld nos a menos), %ld nos compartilhados (%ld bytes)\n",
+                e->subexpressoes_comuns, e->avaliacoes_removidas, e->nos_compartilhados,
+                e->bytes_compartilhados);
+    }
+
+    fprintf(saida, "\nMemoria: arena com pico de %zu bytes (%zu reservados em %d bloco(s)), "
+                   "tabela %zu bytes\n",
+            e->arena_pico, e->arena_reservados, e->arena_blocos, e->tabela.bytes);
+
+    fprintf(saida, "Tabela de simbolos: %d simbolo(s) em %d baldes (carga %.2f), "
+                   "sondagem media %.2f (maior %d)\n",
+            e->tabela.simbolos, e->tabela.baldes, e->tabela.fator_carga,
+            e->tabela.sondagem_media, e->tabela.maior_sondagem);
+    fprintf(saida, "Buscas: %ld, %.2f sondagens por busca (maior %d)\n",
+            e->buscas_tabela, sondagens_por_busca(e), e->maior_sondagem_busca);
+    if (e->blocos_fluxo > 0) {
+        fprintf(saida, "Fluxo de dados: %d bloco(s), %d laco(s), %ld visita(s) em %.3f ms\n",
+                e->blocos_fluxo, e->lacos_fluxo, e->visitas_fluxo, e->ms_fluxo);
+    }
+    if (e->acessos_lista > 0) {
+        fprintf(saida, "Limites de listas: %ld acesso(s), %ld provados seguros (%.1f%%), %ld fora\n",
+                e->acessos_lista, e->acessos_seguros,
+                100.0 * e->acessos_seguros / e->acessos_lista, e->acessos_fora);
+    }
+    fprintf(saida, "==========================\n");
+}
+
+void imprimir_estatisticas(const Estatisticas *e, FILE *saida, int json) {
+    if (json) {
+        imprimir_json(e, saida);
+    } else {
+        imprimir_texto(e, saida);
+    }
+}
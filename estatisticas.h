@@ -0,0 +1,98 @@
+/*
+ * Estatísticas por fase da compilação (opção --stats)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef ESTATISTICAS_H
+#define ESTATISTICAS_H
+
+#include <stdio.h>
+#include <time.h>
+#include "ast.h"
+#include "semantic.h"
+
+#define MAX_FASES 12
+
+/* Instante de início de uma fase: relógio de parede e tempo de CPU */
+typedef struct Instante {
+    struct timespec parede;
+    struct timespec cpu;
+} Instante;
+
+typedef struct Fase {
+    const char *nome;
+    double parede_ms;
+    double cpu_ms;
+} Fase;
+
+typedef struct Estatisticas {
+    const char *arquivo;
+
+    Fase fases[MAX_FASES];
+    int num_fases;
+
+    /* Análise léxica */
+    long tokens;
+    size_t bytes_fonte;         /* 0 quando lida em fluxo */
+    int fonte_mapeada;
+
+    /* Cache de ASTs (--cache) */
+    int cache_acertos;
+    int cache_falhas;
+
+    /* Nós da AST logo após a análise sintática */
+    long nos_expr[EXPR_NEG + 1];
+    long nos_cmd[CMD_ENQUANTO + 1];
+    long nos_decl;
+
+    /* Memória */
+    size_t arena_pico;
+    size_t arena_reservados;
+    int arena_blocos;
+
+    /* Tabela de símbolos */
+    OcupacaoTabela tabela;
+    long buscas_tabela;
+    long sondagens_tabela;
+    int maior_sondagem_busca;
+
+    /* Fluxo de dados */
+    int blocos_fluxo;
+    int lacos_fluxo;
+    long visitas_fluxo;
+    double ms_fluxo;
+
+    /* Limites de listas (acessos, provados seguros, provados fora) */
+    long acessos_lista;
+    long acessos_seguros;
+    long acessos_fora;
+    double ms_limites;
+
+    /* Otimização (nós de expressão, código morto, invariantes de laços movidos, subexpressões comuns) */
+    long nos_antes_otimizacao;
+    long nos_depois_otimizacao;
+    long comandos_removidos;
+    long atribuicoes_mortas;
+    long invariantes_movidos;
+    long subexpressoes_comuns;
+    long avaliacoes_removidas;
+    long nos_compartilhados;
+    long bytes_compartilhados;
+} Estatisticas;
+
+/* Marca o início de uma fase */
+void marcar_instante(Instante *t);
+
+/* Registra a fase 'nome' iniciada em 'ini' e retorna seu tempo de parede (ms) */
+double registrar_fase(Estatisticas *e, const char *nome, const Instante *ini);
+
+/* Conta os nós de 'prog' por TipoExpr e TipoCmd */
+void contar_nos(Estatisticas *e, NoPrograma *prog);
+
+/* Copia do contexto os contadores, a arena e a ocupação da tabela */
+void coletar_contexto(Estatisticas *e, ContextoCompilacao *ctx);
+
+/* Imprime em texto ou, com 'json', como um único objeto JSON */
+void imprimir_estatisticas(const Estatisticas *e, FILE *saida, int json);
+
+#endif /* ESTATISTICAS_H */
@@ -0,0 +1,875 @@
+/*
+ * Implementação do grafo de fluxo de controle e das análises de fluxo de dados
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fluxo.h"
+#include "pilha.h"
+#include "semantic.h"
+#include "contexto.h"
+
+static void *realocar(void *p, size_t tam) {
+    void *novo = realloc(p, tam > 0 ? tam : 1);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a analise de fluxo\n");
+        exit(1);
+    }
+    return novo;
+}
+
+static void *zerado(size_t n, size_t tam) {
+    void *p = calloc(n > 0 ? n : 1, tam);
+    if (p == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a analise de fluxo\n");
+        exit(1);
+    }
+    return p;
+}
+
+/* ========== Construção do grafo ========== */
+
+static int novo_bloco(GrafoFluxo *g, int laco, int profundidade) {
+    if (g->num_blocos == g->capacidade_blocos) {
+        g->capacidade_blocos = g->capacidade_blocos > 0 ? 2 * g->capacidade_blocos : 16;
+        g->blocos = (BlocoBasico *)realocar(g->blocos, g->capacidade_blocos * sizeof(BlocoBasico));
+    }
+    BlocoBasico *b = &g->blocos[g->num_blocos];
+    memset(b, 0, sizeof(*b));
+    b->primeiro = g->num_comandos;
+    b->sucessores[0] = b->sucessores[1] = -1;
+    b->idom = -1;
+    b->ordem = -1;
+    b->laco = laco;
+    b->profundidade = profundidade;
+    return g->num_blocos++;
+}
+
+static void anexar_comando(GrafoFluxo *g, int bloco, NoCmd *cmd) {
+    if (g->num_comandos == g->capacidade_comandos) {
+        g->capacidade_comandos = g->capacidade_comandos > 0 ? 2 * g->capacidade_comandos : 64;
+        g->comandos = (NoCmd **)realocar(g->comandos, g->capacidade_comandos * sizeof(NoCmd *));
+    }
+    g->comandos[g->num_comandos++] = cmd;
+    g->blocos[bloco].num_comandos++;
+}
+
+/* A ordem das ligações define qual sucessor é o da condição verdadeira */
+static void ligar(GrafoFluxo *g, int de, int para) {
+    BlocoBasico *b = &g->blocos[de];
+    b->sucessores[b->sucessores[0] < 0 ? 0 : 1] = para;
+}
+
+/* SE ou ENQUANTO cujos blocos internos estão sendo construídos */
+typedef struct {
+    NoCmd *cmd;
+    NoCmd *continuacao;     /* Próximo comando da sequência de fora */
+    int bloco;              /* SE: bloco da condição; ENQUANTO: cabeçalho */
+    int fim_entao;          /* SE: último bloco do ENTAO (-1 enquanto é construído) */
+    int laco;               /* Aninhamento de fora do comando */
+    int profundidade;
+} QuadroGrafo;
+
+static void criar_blocos(GrafoFluxo *g, NoCmd *cmd) {
+    Pilha pilha;
+    QuadroGrafo *q;
+    int laco = -1, profundidade = 0;
+    int atual = novo_bloco(g, laco, profundidade);
+
+    g->entrada = atual;
+    pilha_iniciar(&pilha, sizeof(QuadroGrafo));
+
+    for (;;) {
+        if (cmd != NULL) {
+            if (cmd->tipo == CMD_SE) {
+                g->blocos[atual].desvio = cmd;
+                q = (QuadroGrafo *)pilha_empilhar(&pilha);
+                q->cmd = cmd;
+                q->continuacao = cmd->prox;
+                q->bloco = atual;
+                q->fim_entao = -1;
+                q->laco = laco;
+                q->profundidade = profundidade;
+                atual = novo_bloco(g, laco, profundidade);
+                ligar(g, q->bloco, atual);
+                cmd = cmd->dado.se.entao;
+            } else if (cmd->tipo == CMD_ENQUANTO) {
+                int cabecalho = novo_bloco(g, -1, profundidade + 1);
+                g->blocos[cabecalho].laco = cabecalho;
+                g->blocos[cabecalho].desvio = cmd;
+                g->num_lacos++;
+                ligar(g, atual, cabecalho);
+                q = (QuadroGrafo *)pilha_empilhar(&pilha);
+                q->cmd = cmd;
+                q->continuacao = cmd->prox;
+                q->bloco = cabecalho;
+                q->fim_entao = -1;
+                q->laco = laco;
+                q->profundidade = profundidade;
+                laco = cabecalho;
+                profundidade++;
+                atual = novo_bloco(g, laco, profundidade);
+                ligar(g, cabecalho, atual);
+                cmd = cmd->dado.enquanto.corpo;
+            } else {
+                anexar_comando(g, atual, cmd);
+                cmd = cmd->prox;
+            }
+            continue;
+        }
+
+        /* Fim de uma sequência: fecha o SE ou o ENQUANTO de fora */
+        q = (QuadroGrafo *)pilha_topo(&pilha);
+        if (q == NULL) break;
+
+        if (q->cmd->tipo == CMD_SE && q->fim_entao < 0 && q->cmd->dado.se.senao != NULL) {
+            q->fim_entao = atual;
+            atual = novo_bloco(g, laco, profundidade);
+            ligar(g, q->bloco, atual);
+            cmd = q->cmd->dado.se.senao;
+            continue;
+        }
+
+        laco = q->laco;
+        profundidade = q->profundidade;
+        int juncao = novo_bloco(g, laco, profundidade);
+        if (q->cmd->tipo == CMD_SE) {
+            if (q->fim_entao < 0) {
+                /* Sem SENAO: a condição falsa vai direto à junção */
+                ligar(g, atual, juncao);
+                ligar(g, q->bloco, juncao);
+            } else {
+                ligar(g, q->fim_entao, juncao);
+                ligar(g, atual, juncao);
+            }
+        } else {
+            ligar(g, atual, q->bloco);
+            ligar(g, q->bloco, juncao);
+        }
+        cmd = q->continuacao;
+        atual = juncao;
+        pilha_desempilhar(&pilha);
+    }
+
+    g->saida = atual;
+    pilha_liberar(&pilha);
+}
+
+static void calcular_predecessores(GrafoFluxo *g) {
+    int total = 0;
+
+    for (int b = 0; b < g->num_blocos; b++) {
+        for (int k = 0; k < 2; k++) {
+            int s = g->blocos[b].sucessores[k];
+            if (s >= 0) {
+                g->blocos[s].num_pred++;
+                total++;
+            }
+        }
+    }
+    g->predecessores = (int *)zerado((size_t)total, sizeof(int));
+    total = 0;
+    for (int b = 0; b < g->num_blocos; b++) {
+        g->blocos[b].primeiro_pred = total;
+        total += g->blocos[b].num_pred;
+        g->blocos[b].num_pred = 0;
+    }
+    for (int b = 0; b < g->num_blocos; b++) {
+        for (int k = 0; k < 2; k++) {
+            int s = g->blocos[b].sucessores[k];
+            if (s >= 0) {
+                BlocoBasico *bs = &g->blocos[s];
+                g->predecessores[bs->primeiro_pred + bs->num_pred++] = b;
+            }
+        }
+    }
+}
+
+/* Busca em profundidade a partir da entrada, com pilha explícita */
+static void calcular_rpo(GrafoFluxo *g) {
+    typedef struct { int bloco; int proximo; } QuadroBusca;
+    Pilha pilha;
+    QuadroBusca *q;
+    char *visitado = (char *)zerado((size_t)g->num_blocos, 1);
+    int n = 0;
+
+    g->rpo = (int *)zerado((size_t)g->num_blocos, sizeof(int));
+    pilha_iniciar(&pilha, sizeof(QuadroBusca));
+    q = (QuadroBusca *)pilha_empilhar(&pilha);
+    q->bloco = g->entrada;
+    q->proximo = 0;
+    visitado[g->entrada] = 1;
+
+    /* Pós-ordem preenchida do fim para o começo: já sai invertida */
+    int pos = g->num_blocos;
+    while ((q = (QuadroBusca *)pilha_topo(&pilha)) != NULL) {
+        if (q->proximo < 2) {
+            int s = g->blocos[q->bloco].sucessores[q->proximo++];
+            if (s >= 0 && !visitado[s]) {
+                visitado[s] = 1;
+                q = (QuadroBusca *)pilha_empilhar(&pilha);
+                q->bloco = s;
+                q->proximo = 0;
+            }
+        } else {
+            g->rpo[--pos] = q->bloco;
+            n++;
+            pilha_desempilhar(&pilha);
+        }
+    }
+    memmove(g->rpo, g->rpo + pos, (size_t)n * sizeof(int));
+    g->num_alcancaveis = n;
+    for (int i = 0; i < n; i++) {
+        g->blocos[g->rpo[i]].ordem = i;
+    }
+
+    pilha_liberar(&pilha);
+    free(visitado);
+}
+
+/*
+ * Dominadores pelo algoritmo iterativo de Cooper, Harvey e Kennedy: na
+ * pós-ordem reversa, o dominador imediato de um bloco é o ancestral
+ * comum dos seus predecessores já processados. Em grafos redutíveis
+ * converge em duas passadas.
+ */
+static int intersecao_dominadores(const GrafoFluxo *g, int a, int b) {
+    while (a != b) {
+        while (g->blocos[a].ordem > g->blocos[b].ordem) a = g->blocos[a].idom;
+        while (g->blocos[b].ordem > g->blocos[a].ordem) b = g->blocos[b].idom;
+    }
+    return a;
+}
+
+static void calcular_dominadores(GrafoFluxo *g) {
+    int mudou = 1;
+
+    g->blocos[g->entrada].idom = g->entrada;
+    while (mudou) {
+        mudou = 0;
+        for (int i = 1; i < g->num_alcancaveis; i++) {
+            BlocoBasico *b = &g->blocos[g->rpo[i]];
+            int novo = -1;
+            for (int k = 0; k < b->num_pred; k++) {
+                int p = g->predecessores[b->primeiro_pred + k];
+                if (g->blocos[p].idom < 0) continue;
+                novo = novo < 0 ? p : intersecao_dominadores(g, p, novo);
+            }
+            if (novo != b->idom) {
+                b->idom = novo;
+                mudou = 1;
+            }
+        }
+    }
+    g->blocos[g->entrada].idom = -1;
+}
+
+void construir_grafo(GrafoFluxo *g, NoCmd *cmd) {
+    memset(g, 0, sizeof(*g));
+    criar_blocos(g, cmd);
+    calcular_predecessores(g);
+    calcular_rpo(g);
+    calcular_dominadores(g);
+}
+
+void liberar_grafo(GrafoFluxo *g) {
+    free(g->blocos);
+    free(g->comandos);
+    free(g->predecessores);
+    free(g->rpo);
+    memset(g, 0, sizeof(*g));
+}
+
+int domina(const GrafoFluxo *g, int a, int b) {
+    if (g->blocos[a].ordem < 0 || g->blocos[b].ordem < 0) return 0;
+    while (b >= 0 && g->blocos[b].ordem >= g->blocos[a].ordem) {
+        if (b == a) return 1;
+        b = g->blocos[b].idom;
+    }
+    return 0;
+}
+
+/* ========== Vetores de bits ========== */
+
+int bit_ligado(const PalavraBits *v, int i) {
+    return (int)((v[i / BITS_POR_PALAVRA] >> (i % BITS_POR_PALAVRA)) & 1u);
+}
+
+void ligar_bit(PalavraBits *v, int i) {
+    v[i / BITS_POR_PALAVRA] |= (PalavraBits)1 << (i % BITS_POR_PALAVRA);
+}
+
+void desligar_bit(PalavraBits *v, int i) {
+    v[i / BITS_POR_PALAVRA] &= ~((PalavraBits)1 << (i % BITS_POR_PALAVRA));
+}
+
+/* Liga (ou desliga) os bits [a, b) palavra a palavra */
+static void preencher_intervalo(PalavraBits *v, int a, int b, int ligar_bits) {
+    while (a < b) {
+        int palavra = a / BITS_POR_PALAVRA, deslocamento = a % BITS_POR_PALAVRA;
+        int n = BITS_POR_PALAVRA - deslocamento;
+        if (n > b - a) n = b - a;
+        PalavraBits mascara = (n == BITS_POR_PALAVRA ? ~(PalavraBits)0
+                                                     : (((PalavraBits)1 << n) - 1)) << deslocamento;
+        if (ligar_bits) {
+            v[palavra] |= mascara;
+        } else {
+            v[palavra] &= ~mascara;
+        }
+        a += n;
+    }
+}
+
+PalavraBits *vetor_bloco(const ProblemaFluxo *p, PalavraBits *base, int bloco) {
+    return base + (size_t)bloco * p->palavras;
+}
+
+/* ========== Resolução ========== */
+
+void iniciar_lista_trabalho(ListaTrabalho *l, int num_blocos) {
+    l->prioridades = (int *)zerado((size_t)num_blocos, sizeof(int));
+    l->blocos = (int *)zerado((size_t)num_blocos, sizeof(int));
+    l->presente = (char *)zerado((size_t)num_blocos, 1);
+    l->num = 0;
+}
+
+void liberar_lista_trabalho(ListaTrabalho *l) {
+    free(l->prioridades);
+    free(l->blocos);
+    free(l->presente);
+}
+
+static void trocar_lista(ListaTrabalho *l, int i, int j) {
+    int p = l->prioridades[i], b = l->blocos[i];
+    l->prioridades[i] = l->prioridades[j];
+    l->blocos[i] = l->blocos[j];
+    l->prioridades[j] = p;
+    l->blocos[j] = b;
+}
+
+void inserir_lista_trabalho(ListaTrabalho *l, int prioridade, int bloco) {
+    if (l->presente[bloco]) return;
+    l->presente[bloco] = 1;
+    int i = l->num++;
+    l->prioridades[i] = prioridade;
+    l->blocos[i] = bloco;
+    while (i > 0 && l->prioridades[(i - 1) / 2] > l->prioridades[i]) {
+        trocar_lista(l, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+int retirar_lista_trabalho(ListaTrabalho *l) {
+    int bloco = l->blocos[0];
+    l->presente[bloco] = 0;
+    l->num--;
+    l->prioridades[0] = l->prioridades[l->num];
+    l->blocos[0] = l->blocos[l->num];
+    for (int i = 0;;) {
+        int menor = i, e = 2 * i + 1, d = 2 * i + 2;
+        if (e < l->num && l->prioridades[e] < l->prioridades[menor]) menor = e;
+        if (d < l->num && l->prioridades[d] < l->prioridades[menor]) menor = d;
+        if (menor == i) break;
+        trocar_lista(l, i, menor);
+        i = menor;
+    }
+    return bloco;
+}
+
+void iniciar_problema(ProblemaFluxo *p, const GrafoFluxo *g, int bits,
+                      DirecaoFluxo direcao, EncontroFluxo encontro, int com_kill) {
+    size_t total;
+
+    memset(p, 0, sizeof(*p));
+    p->direcao = direcao;
+    p->encontro = encontro;
+    p->bits = bits;
+    p->palavras = (bits + BITS_POR_PALAVRA - 1) / BITS_POR_PALAVRA;
+    p->num_blocos = g->num_blocos;
+    total = (size_t)g->num_blocos * p->palavras;
+    p->gen = (PalavraBits *)zerado(total, sizeof(PalavraBits));
+    p->kill = com_kill ? (PalavraBits *)zerado(total, sizeof(PalavraBits)) : NULL;
+}
+
+void liberar_problema(ProblemaFluxo *p) {
+    free(p->gen);
+    free(p->kill);
+    free(p->entrada);
+    free(p->saida);
+    memset(p, 0, sizeof(*p));
+}
+
+/*
+ * Na visão "para a frente": 'antes' é o lado que recebe o encontro dos
+ * vizinhos (entrada; saída quando para trás) e 'depois', o lado que a
+ * transferência produz.
+ */
+void resolver_problema(ProblemaFluxo *p, const GrafoFluxo *g) {
+    size_t total = (size_t)g->num_blocos * p->palavras;
+    int frente = p->direcao == FLUXO_PARA_FRENTE;
+    int n = g->num_alcancaveis;
+    PalavraBits ultima = p->bits % BITS_POR_PALAVRA == 0
+                             ? ~(PalavraBits)0
+                             : ((PalavraBits)1 << (p->bits % BITS_POR_PALAVRA)) - 1;
+
+    p->entrada = (PalavraBits *)zerado(total, sizeof(PalavraBits));
+    p->saida = (PalavraBits *)zerado(total, sizeof(PalavraBits));
+    PalavraBits *antes = frente ? p->entrada : p->saida;
+    PalavraBits *depois = frente ? p->saida : p->entrada;
+
+    /* Interseção parte do conjunto cheio; união, do vazio */
+    if (p->encontro == ENCONTRO_INTERSECAO && p->palavras > 0) {
+        for (int b = 0; b < g->num_blocos; b++) {
+            PalavraBits *d = vetor_bloco(p, depois, b);
+            memset(d, 0xFF, (size_t)p->palavras * sizeof(PalavraBits));
+            d[p->palavras - 1] &= ultima;
+        }
+    }
+
+    /*
+     * Lista de trabalho ordenada pela posição na pós-ordem reversa (no
+     * seu avesso, para trás): um laço converge antes que os blocos
+     * seguintes sejam revisitados, em vez de cada volta do laço
+     * propagar uma onda pelo resto do programa.
+     */
+    ListaTrabalho lista;
+    iniciar_lista_trabalho(&lista, g->num_blocos);
+    for (int i = 0; i < n; i++) {
+        inserir_lista_trabalho(&lista, i, g->rpo[frente ? i : n - 1 - i]);
+    }
+
+    while (lista.num > 0) {
+        int b = retirar_lista_trabalho(&lista);
+        p->visitas++;
+
+        const BlocoBasico *bloco = &g->blocos[b];
+        PalavraBits *a = vetor_bloco(p, antes, b);
+        PalavraBits *d = vetor_bloco(p, depois, b);
+        const PalavraBits *gen = vetor_bloco(p, p->gen, b);
+        const PalavraBits *kill = p->kill != NULL ? vetor_bloco(p, p->kill, b) : NULL;
+
+        /* Encontro dos vizinhos (o contorno é vazio) */
+        int vizinhos = frente ? bloco->num_pred : (bloco->sucessores[0] >= 0) + (bloco->sucessores[1] >= 0);
+        int contorno = frente ? b == g->entrada : vizinhos == 0;
+        int primeiro = 1;
+        memset(a, 0, (size_t)p->palavras * sizeof(PalavraBits));
+        for (int k = 0; k < (frente ? bloco->num_pred : 2) && !contorno; k++) {
+            int v = frente ? g->predecessores[bloco->primeiro_pred + k] : bloco->sucessores[k];
+            if (v < 0 || g->blocos[v].ordem < 0) continue;
+            const PalavraBits *dv = vetor_bloco(p, depois, v);
+            for (int w = 0; w < p->palavras; w++) {
+                if (primeiro) {
+                    a[w] = dv[w];
+                } else if (p->encontro == ENCONTRO_UNIAO) {
+                    a[w] |= dv[w];
+                } else {
+                    a[w] &= dv[w];
+                }
+            }
+            primeiro = 0;
+        }
+
+        /* Transferência; os vizinhos do outro lado voltam à fila se mudou */
+        int mudou = 0;
+        for (int w = 0; w < p->palavras; w++) {
+            PalavraBits novo = gen[w] | (a[w] & (kill != NULL ? ~kill[w] : ~(PalavraBits)0));
+            if (novo != d[w]) {
+                d[w] = novo;
+                mudou = 1;
+            }
+        }
+        if (!mudou) continue;
+
+        int num = frente ? 2 : bloco->num_pred;
+        for (int k = 0; k < num; k++) {
+            int v = frente ? bloco->sucessores[k] : g->predecessores[bloco->primeiro_pred + k];
+            if (v < 0 || g->blocos[v].ordem < 0) continue;
+            inserir_lista_trabalho(&lista, frente ? g->blocos[v].ordem : n - 1 - g->blocos[v].ordem, v);
+        }
+    }
+
+    liberar_lista_trabalho(&lista);
+}
+
+/* ========== Leituras e definições dos comandos ========== */
+
+/*
+ * Visita, na ordem em que acontecem, as variáveis lidas e atribuídas por
+ * um bloco: numa atribuição, a expressão e o índice do destino são lidos
+ * antes da atribuição; num LEIA, cada variável é lida e atribuída antes
+ * da próxima; a condição do desvio é lida por último.
+ */
+typedef struct VisitaFluxo {
+    ContextoCompilacao *ctx;
+    void (*ler)(struct VisitaFluxo *v, NoVar *var);
+    void (*definir)(struct VisitaFluxo *v, NoCmd *cmd, NoVar *var);
+    void *dados;
+    Pilha pilha;
+} VisitaFluxo;
+
+static int indice_variavel(const ContextoCompilacao *ctx, const NoVar *var) {
+    return (int)(var->simbolo - ctx->tabela.simbolos);
+}
+
+static void empilhar_no(Pilha *pilha, NoExpr *expr) {
+    if (expr != NULL) {
+        *(NoExpr **)pilha_empilhar(pilha) = expr;
+    }
+}
+
+static void visitar_leituras(VisitaFluxo *v, NoExpr *raiz) {
+    NoExpr **topo;
+
+    empilhar_no(&v->pilha, raiz);
+    while ((topo = (NoExpr **)pilha_topo(&v->pilha)) != NULL) {
+        NoExpr *expr = *topo;
+        pilha_desempilhar(&v->pilha);
+
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                v->ler(v, expr->dado.var);
+                empilhar_no(&v->pilha, expr->dado.var->indice);
+                break;
+            case EXPR_ARITMETICA:
+                empilhar_no(&v->pilha, expr->dado.aritmetica.esq);
+                empilhar_no(&v->pilha, expr->dado.aritmetica.dir);
+                break;
+            case EXPR_RELACIONAL:
+                empilhar_no(&v->pilha, expr->dado.relacional.esq);
+                empilhar_no(&v->pilha, expr->dado.relacional.dir);
+                break;
+            case EXPR_LOGICA:
+                empilhar_no(&v->pilha, expr->dado.logica.esq);
+                empilhar_no(&v->pilha, expr->dado.logica.dir);
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_no(&v->pilha, expr->dado.negacao);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void visitar_bloco(VisitaFluxo *v, const GrafoFluxo *g, int b) {
+    const BlocoBasico *bloco = &g->blocos[b];
+
+    for (int i = 0; i < bloco->num_comandos; i++) {
+        NoCmd *cmd = g->comandos[bloco->primeiro + i];
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                visitar_leituras(v, cmd->dado.atrib.expr);
+                visitar_leituras(v, cmd->dado.atrib.var->indice);
+                v->definir(v, cmd, cmd->dado.atrib.var);
+                break;
+            case CMD_LEIA:
+                for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                    visitar_leituras(v, l->var->indice);
+                    v->definir(v, cmd, l->var);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *e = cmd->dado.escreva; e != NULL; e = e->prox) {
+                    if (!e->is_cadeia) {
+                        visitar_leituras(v, e->item.expr);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (bloco->desvio != NULL) {
+        visitar_leituras(v, bloco->desvio->tipo == CMD_SE ? bloco->desvio->dado.se.condicao
+                                                          : bloco->desvio->dado.enquanto.condicao);
+    }
+}
+
+static void iniciar_visita(VisitaFluxo *v, ContextoCompilacao *ctx) {
+    memset(v, 0, sizeof(*v));
+    v->ctx = ctx;
+    pilha_iniciar(&v->pilha, sizeof(NoExpr *));
+}
+
+/* ========== Análises ========== */
+
+/* Estado de uma análise durante a visita de um bloco */
+typedef struct {
+    PalavraBits *gen;
+    PalavraBits *kill;
+    const DefinicoesFluxo *defs;
+    int *proxima;           /* Próxima definição de cada variável a numerar */
+    int bloco;
+} EstadoBloco;
+
+/* Atribuição: gen = variáveis atribuídas no bloco */
+static void ler_nada(VisitaFluxo *v, NoVar *var) {
+    (void)v;
+    (void)var;
+}
+
+static void definir_atribuida(VisitaFluxo *v, NoCmd *cmd, NoVar *var) {
+    EstadoBloco *e = (EstadoBloco *)v->dados;
+    (void)cmd;
+    ligar_bit(e->gen, indice_variavel(v->ctx, var));
+}
+
+void calcular_atribuicao(ContextoCompilacao *ctx, const GrafoFluxo *g, ProblemaFluxo *p,
+                         EncontroFluxo encontro) {
+    VisitaFluxo v;
+    EstadoBloco e;
+
+    iniciar_problema(p, g, ctx->tabela.num_simbolos, FLUXO_PARA_FRENTE, encontro, 0);
+    iniciar_visita(&v, ctx);
+    v.ler = ler_nada;
+    v.definir = definir_atribuida;
+    v.dados = &e;
+    for (int b = 0; b < g->num_blocos; b++) {
+        e.gen = vetor_bloco(p, p->gen, b);
+        visitar_bloco(&v, g, b);
+    }
+    pilha_liberar(&v.pilha);
+    resolver_problema(p, g);
+}
+
+/* Vivacidade: gen = lidas antes de atribuídas no bloco, kill = atribuídas */
+static void ler_viva(VisitaFluxo *v, NoVar *var) {
+    EstadoBloco *e = (EstadoBloco *)v->dados;
+    int i = indice_variavel(v->ctx, var);
+    if (!bit_ligado(e->kill, i)) {
+        ligar_bit(e->gen, i);
+    }
+}
+
+static void definir_morta(VisitaFluxo *v, NoCmd *cmd, NoVar *var) {
+    EstadoBloco *e = (EstadoBloco *)v->dados;
+    (void)cmd;
+    if (var->indice == NULL) {
+        ligar_bit(e->kill, indice_variavel(v->ctx, var));
+    }
+}
+
+void calcular_vivacidade(ContextoCompilacao *ctx, const GrafoFluxo *g, ProblemaFluxo *p) {
+    VisitaFluxo v;
+    EstadoBloco e;
+
+    iniciar_problema(p, g, ctx->tabela.num_simbolos, FLUXO_PARA_TRAS, ENCONTRO_UNIAO, 1);
+    iniciar_visita(&v, ctx);
+    v.ler = ler_viva;
+    v.definir = definir_morta;
+    v.dados = &e;
+    for (int b = 0; b < g->num_blocos; b++) {
+        e.gen = vetor_bloco(p, p->gen, b);
+        e.kill = vetor_bloco(p, p->kill, b);
+        visitar_bloco(&v, g, b);
+    }
+    pilha_liberar(&v.pilha);
+    resolver_problema(p, g);
+}
+
+/*
+ * Definições alcançantes. Uma passada conta as definições de cada
+ * variável (para os intervalos 'inicio'); a segunda as numera e monta
+ * gen e kill: uma atribuição simples a v mata todo o intervalo de v e
+ * deixa em gen só ela mesma.
+ */
+static void contar_definicao(VisitaFluxo *v, NoCmd *cmd, NoVar *var) {
+    DefinicoesFluxo *defs = (DefinicoesFluxo *)v->dados;
+    (void)cmd;
+    defs->inicio[indice_variavel(v->ctx, var) + 1]++;
+}
+
+static void numerar_definicao(VisitaFluxo *v, NoCmd *cmd, NoVar *var) {
+    EstadoBloco *e = (EstadoBloco *)v->dados;
+    int i = indice_variavel(v->ctx, var);
+    int d = e->proxima[i]++;
+    Definicao *def = &e->defs->itens[d];
+
+    def->cmd = cmd;
+    def->var = var;
+    def->bloco = e->bloco;
+    if (var->indice == NULL) {
+        preencher_intervalo(e->gen, e->defs->inicio[i], e->defs->inicio[i + 1], 0);
+        preencher_intervalo(e->kill, e->defs->inicio[i], e->defs->inicio[i + 1], 1);
+    }
+    ligar_bit(e->gen, d);
+}
+
+void calcular_definicoes_alcancantes(ContextoCompilacao *ctx, const GrafoFluxo *g,
+                                     DefinicoesFluxo *defs, ProblemaFluxo *p) {
+    int variaveis = ctx->tabela.num_simbolos;
+    VisitaFluxo v;
+    EstadoBloco e;
+
+    memset(defs, 0, sizeof(*defs));
+    defs->inicio = (int *)zerado((size_t)variaveis + 1, sizeof(int));
+    iniciar_visita(&v, ctx);
+    v.ler = ler_nada;
+    v.definir = contar_definicao;
+    v.dados = defs;
+    for (int b = 0; b < g->num_blocos; b++) {
+        visitar_bloco(&v, g, b);
+    }
+    for (int i = 0; i < variaveis; i++) {
+        defs->inicio[i + 1] += defs->inicio[i];
+    }
+    defs->num = defs->inicio[variaveis];
+    defs->itens = (Definicao *)zerado((size_t)defs->num, sizeof(Definicao));
+
+    iniciar_problema(p, g, defs->num, FLUXO_PARA_FRENTE, ENCONTRO_UNIAO, 1);
+    e.defs = defs;
+    e.proxima = (int *)zerado((size_t)variaveis + 1, sizeof(int));
+    memcpy(e.proxima, defs->inicio, (size_t)variaveis * sizeof(int));
+    v.definir = numerar_definicao;
+    v.dados = &e;
+    for (int b = 0; b < g->num_blocos; b++) {
+        e.gen = vetor_bloco(p, p->gen, b);
+        e.kill = vetor_bloco(p, p->kill, b);
+        e.bloco = b;
+        visitar_bloco(&v, g, b);
+    }
+    free(e.proxima);
+    pilha_liberar(&v.pilha);
+    resolver_problema(p, g);
+}
+
+void liberar_definicoes(DefinicoesFluxo *defs) {
+    free(defs->itens);
+    free(defs->inicio);
+    memset(defs, 0, sizeof(*defs));
+}
+
+/* ========== Leituras sem inicialização ========== */
+
+/* Leitura suspeita: a variável não foi atribuída em todos os caminhos */
+typedef struct {
+    NoVar *var;
+    int bloco;
+} LeituraSuspeita;
+
+typedef struct {
+    PalavraBits *atribuidas;    /* Atribuídas em todos os caminhos até aqui */
+    PalavraBits *avisadas;      /* Uma leitura suspeita já registrada */
+    PalavraBits *lidas;         /* Lidas em algum comando alcançável */
+    PalavraBits *escritas;      /* Atribuídas ou lidas por LEIA */
+    Pilha *suspeitas;
+    int bloco;
+} EstadoInicializacao;
+
+static void ler_inicializada(VisitaFluxo *v, NoVar *var) {
+    EstadoInicializacao *e = (EstadoInicializacao *)v->dados;
+    int i = indice_variavel(v->ctx, var);
+
+    ligar_bit(e->lidas, i);
+    if (!bit_ligado(e->atribuidas, i) && !bit_ligado(e->avisadas, i)) {
+        LeituraSuspeita *s = (LeituraSuspeita *)pilha_empilhar(e->suspeitas);
+        s->var = var;
+        s->bloco = e->bloco;
+        ligar_bit(e->avisadas, i);
+    }
+}
+
+static void definir_inicializada(VisitaFluxo *v, NoCmd *cmd, NoVar *var) {
+    EstadoInicializacao *e = (EstadoInicializacao *)v->dados;
+    (void)cmd;
+    ligar_bit(e->atribuidas, indice_variavel(v->ctx, var));
+    ligar_bit(e->escritas, indice_variavel(v->ctx, var));
+}
+
+static double ms_desde(const struct timespec *ini) {
+    struct timespec fim;
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    return (fim.tv_sec - ini->tv_sec) * 1e3 + (fim.tv_nsec - ini->tv_nsec) / 1e6;
+}
+
+/*
+ * A atribuição definida encontra as leituras suspeitas; só se houver
+ * alguma, a atribuição possível diz se alguma atribuição chega até ela
+ * (AVI003) ou nenhuma (AVI004). Programas sem suspeitas, o caso comum,
+ * resolvem um único problema. A mesma visita anota as variáveis lidas e
+ * as escritas, para as declarações sem uso (AVI005, AVI006).
+ */
+void verificar_inicializacao(ContextoCompilacao *ctx, NoPrograma *prog) {
+    struct timespec ini;
+    GrafoFluxo g;
+    ProblemaFluxo atribuicao;
+    VisitaFluxo v;
+    EstadoInicializacao e;
+    Pilha suspeitas;
+
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+    construir_grafo(&g, prog->algoritmo);
+    calcular_atribuicao(ctx, &g, &atribuicao, ENCONTRO_INTERSECAO);
+
+    e.atribuidas = (PalavraBits *)zerado((size_t)atribuicao.palavras, sizeof(PalavraBits));
+    e.avisadas = (PalavraBits *)zerado((size_t)atribuicao.palavras, sizeof(PalavraBits));
+    e.lidas = (PalavraBits *)zerado((size_t)atribuicao.palavras, sizeof(PalavraBits));
+    e.escritas = (PalavraBits *)zerado((size_t)atribuicao.palavras, sizeof(PalavraBits));
+    e.suspeitas = &suspeitas;
+    pilha_iniciar(&suspeitas, sizeof(LeituraSuspeita));
+    iniciar_visita(&v, ctx);
+    v.ler = ler_inicializada;
+    v.definir = definir_inicializada;
+    v.dados = &e;
+    for (int b = 0; b < g.num_blocos; b++) {
+        if (g.blocos[b].ordem < 0) continue;
+        memcpy(e.atribuidas, vetor_bloco(&atribuicao, atribuicao.entrada, b),
+               (size_t)atribuicao.palavras * sizeof(PalavraBits));
+        e.bloco = b;
+        visitar_bloco(&v, &g, b);
+    }
+    pilha_liberar(&v.pilha);
+
+    ctx->blocos_fluxo = g.num_blocos;
+    ctx->lacos_fluxo = g.num_lacos;
+    ctx->visitas_fluxo = atribuicao.visitas;
+
+    if (suspeitas.num > 0) {
+        ProblemaFluxo possivel;
+        char nome[ID_MAX_CHARS + 1];
+
+        calcular_atribuicao(ctx, &g, &possivel, ENCONTRO_UNIAO);
+        for (size_t k = 0; k < suspeitas.num; k++) {
+            LeituraSuspeita *s = (LeituraSuspeita *)(suspeitas.itens + k * sizeof(LeituraSuspeita));
+            if (bit_ligado(vetor_bloco(&possivel, possivel.entrada, s->bloco), indice_variavel(ctx, s->var))) {
+                aviso_semantico(ctx, s->var->linha, s->var->coluna, "AVI003",
+                                "Variavel '%s' pode nao ter sido inicializada",
+                                texto_id(s->var->chave, nome));
+            } else {
+                aviso_semantico(ctx, s->var->linha, s->var->coluna, "AVI004",
+                                "Variavel '%s' e lida sem ter sido inicializada",
+                                texto_id(s->var->chave, nome));
+            }
+        }
+        ctx->visitas_fluxo += possivel.visitas;
+        liberar_problema(&possivel);
+    }
+
+    /* Sem erros semânticos, o símbolo i é a i-ésima declaração */
+    int i = 0;
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox, i++) {
+        char nome[ID_MAX_CHARS + 1];
+        if (bit_ligado(e.lidas, i)) continue;
+        if (!bit_ligado(e.escritas, i)) {
+            aviso_semantico(ctx, d->linha, d->coluna, "AVI005",
+                            "Variavel '%s' declarada e nunca usada", texto_id(d->chave, nome));
+        } else {
+            aviso_semantico(ctx, d->linha, d->coluna, "AVI006",
+                            "Variavel '%s' recebe valores que nunca sao lidos", texto_id(d->chave, nome));
+        }
+    }
+
+    pilha_liberar(&suspeitas);
+    free(e.atribuidas);
+    free(e.avisadas);
+    free(e.lidas);
+    free(e.escritas);
+    liberar_problema(&atribuicao);
+    liberar_grafo(&g);
+    ctx->ms_fluxo = ms_desde(&ini);
+}
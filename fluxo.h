@@ -0,0 +1,203 @@
+/*
+ * Grafo de fluxo de controle e análise de fluxo de dados
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef FLUXO_H
+#define FLUXO_H
+
+#include <stdint.h>
+#include "ast.h"
+
+/* ========== Grafo de fluxo de controle ========== */
+
+/*
+ * Bloco básico: uma sequência de ATRIB, LEIA e ESCREVA sem desvios,
+ * terminada opcionalmente pela condição de um SE ou de um ENQUANTO
+ * ('desvio'). A condição é avaliada no fim do bloco; o bloco de um
+ * ENQUANTO (o cabeçalho do laço) contém só ela.
+ */
+typedef struct BlocoBasico {
+    int primeiro;           /* Índice do primeiro comando em GrafoFluxo.comandos */
+    int num_comandos;
+    NoCmd *desvio;          /* SE ou ENQUANTO que termina o bloco, ou NULL */
+    int sucessores[2];      /* Com desvio: [0] condição verdadeira, [1] falsa; -1 = nenhum */
+    int primeiro_pred;      /* Predecessores em GrafoFluxo.predecessores */
+    int num_pred;
+    int idom;               /* Dominador imediato (-1 na entrada e nos inalcançáveis) */
+    int ordem;              /* Posição em pós-ordem reversa (-1 se inalcançável) */
+
+    /*
+     * Aninhamento de laços: 'laco' é o cabeçalho do ENQUANTO mais interno
+     * que contém o bloco (o cabeçalho contém a si mesmo; -1 fora de
+     * laços). O laço que contém o de cabeçalho h é o de blocos[h].idom.
+     */
+    int laco;
+    int profundidade;
+} BlocoBasico;
+
+/*
+ * Os blocos são numerados na ordem da fonte: a entrada é o bloco 0 e a
+ * saída, o último criado. Como X25b só tem SE e ENQUANTO, o grafo é
+ * redutível e os laços naturais são exatamente os corpos de ENQUANTO.
+ */
+typedef struct GrafoFluxo {
+    BlocoBasico *blocos;
+    int num_blocos;
+    int capacidade_blocos;
+    NoCmd **comandos;       /* Comandos de todos os blocos, bloco após bloco */
+    int num_comandos;
+    int capacidade_comandos;
+    int *predecessores;
+    int *rpo;               /* Blocos alcançáveis em pós-ordem reversa */
+    int num_alcancaveis;
+    int entrada;
+    int saida;
+    int num_lacos;
+} GrafoFluxo;
+
+/* Constrói o grafo de 'cmd' (sem recursão), com dominadores e laços */
+void construir_grafo(GrafoFluxo *g, NoCmd *cmd);
+
+void liberar_grafo(GrafoFluxo *g);
+
+/* 1 se o bloco 'a' domina o bloco 'b' */
+int domina(const GrafoFluxo *g, int a, int b);
+
+/* ========== Fluxo de dados em vetores de bits ========== */
+
+typedef uint64_t PalavraBits;
+
+#define BITS_POR_PALAVRA 64
+
+int bit_ligado(const PalavraBits *v, int i);
+void ligar_bit(PalavraBits *v, int i);
+void desligar_bit(PalavraBits *v, int i);
+
+typedef enum {
+    FLUXO_PARA_FRENTE,
+    FLUXO_PARA_TRAS
+} DirecaoFluxo;
+
+typedef enum {
+    ENCONTRO_UNIAO,         /* "Em algum caminho" */
+    ENCONTRO_INTERSECAO     /* "Em todos os caminhos" */
+} EncontroFluxo;
+
+/*
+ * Problema de fluxo de dados com função de transferência
+ *
+ *     saida(B) = gen(B) | (entrada(B) & ~kill(B))
+ *
+ * (para trás, 'entrada' e 'saida' trocam de papel: o valor flui do fim
+ * do bloco para o início). Os vetores de cada bloco têm 'palavras'
+ * palavras e ficam em sequência: o de B começa em B * palavras. O
+ * contorno (início do grafo, ou o fim quando para trás) é o conjunto
+ * vazio.
+ */
+typedef struct ProblemaFluxo {
+    DirecaoFluxo direcao;
+    EncontroFluxo encontro;
+    int bits;
+    int palavras;
+    int num_blocos;
+    PalavraBits *gen;
+    PalavraBits *kill;      /* NULL se nenhum bloco remove fatos */
+    PalavraBits *entrada;   /* Resultado: no início de cada bloco */
+    PalavraBits *saida;     /* Resultado: no fim de cada bloco */
+    long visitas;           /* Blocos processados até o ponto fixo */
+} ProblemaFluxo;
+
+/* Aloca gen (zerado) e, com 'com_kill', kill (zerado) para o grafo */
+void iniciar_problema(ProblemaFluxo *p, const GrafoFluxo *g, int bits,
+                      DirecaoFluxo direcao, EncontroFluxo encontro, int com_kill);
+
+/*
+ * Lista de trabalho: heap mínimo de blocos pela prioridade (a posição na
+ * pós-ordem reversa, ou no seu avesso), cada bloco no máximo uma vez.
+ */
+typedef struct ListaTrabalho {
+    int *prioridades;
+    int *blocos;
+    char *presente;
+    int num;
+} ListaTrabalho;
+
+void iniciar_lista_trabalho(ListaTrabalho *l, int num_blocos);
+void liberar_lista_trabalho(ListaTrabalho *l);
+
+/* Insere 'bloco', se ainda não estiver na lista */
+void inserir_lista_trabalho(ListaTrabalho *l, int prioridade, int bloco);
+
+/* Retira o bloco de menor prioridade (a lista não pode estar vazia) */
+int retirar_lista_trabalho(ListaTrabalho *l);
+
+/*
+ * Resolve por lista de trabalho ordenada pela pós-ordem reversa (ou pelo
+ * seu avesso, para trás): cada bloco é revisitado só quando um vizinho
+ * mudou, e sempre o mais cedo na ordem primeiro. Em grafos redutíveis,
+ * as visitas por bloco ficam limitadas pelo aninhamento de laços, não
+ * pelo tamanho do programa.
+ */
+void resolver_problema(ProblemaFluxo *p, const GrafoFluxo *g);
+
+void liberar_problema(ProblemaFluxo *p);
+
+/* Vetor do bloco 'bloco' em 'base' (p->gen, p->entrada, ...) */
+PalavraBits *vetor_bloco(const ProblemaFluxo *p, PalavraBits *base, int bloco);
+
+/* ========== Análises ========== */
+
+/*
+ * Variáveis são numeradas pela posição do símbolo na tabela (ordem de
+ * declaração); o programa deve ter passado pela análise semântica sem
+ * erros (NoVar->simbolo ligado). Uma atribuição a um elemento conta
+ * como definição do array inteiro nas análises "deve" (atribuição
+ * definida), mas não remove definições anteriores nem mata a variável.
+ */
+
+/* Uma definição: o comando e a variável atribuída (LEIA pode ter várias) */
+typedef struct Definicao {
+    NoCmd *cmd;
+    NoVar *var;
+    int bloco;
+} Definicao;
+
+/*
+ * As definições são numeradas agrupadas por variável: as da variável v
+ * são [inicio[v], inicio[v + 1]), e matar todas é preencher um intervalo.
+ */
+typedef struct DefinicoesFluxo {
+    Definicao *itens;
+    int num;
+    int *inicio;            /* num_variaveis + 1 posições */
+} DefinicoesFluxo;
+
+/* Definições alcançantes: bits = definições, para frente, união */
+void calcular_definicoes_alcancantes(ContextoCompilacao *ctx, const GrafoFluxo *g,
+                                     DefinicoesFluxo *defs, ProblemaFluxo *p);
+void liberar_definicoes(DefinicoesFluxo *defs);
+
+/* Variáveis vivas: bits = variáveis, para trás, união */
+void calcular_vivacidade(ContextoCompilacao *ctx, const GrafoFluxo *g, ProblemaFluxo *p);
+
+/*
+ * Variáveis atribuídas: bits = variáveis, para frente. Com interseção,
+ * atribuídas em todos os caminhos (atribuição definida); com união, em
+ * algum (o mesmo que "alguma definição da variável alcança o ponto",
+ * sem um bit por definição).
+ */
+void calcular_atribuicao(ContextoCompilacao *ctx, const GrafoFluxo *g, ProblemaFluxo *p,
+                         EncontroFluxo encontro);
+
+/*
+ * Avisa leituras de variáveis que podem não ter sido atribuídas (AVI003)
+ * ou que nenhuma atribuição alcança (AVI004), uma vez por variável, e
+ * variáveis declaradas que nunca são usadas (AVI005) ou só recebem
+ * valores (AVI006).
+ * Chamada pela análise semântica quando não houve erros; os tamanhos e
+ * o tempo ficam em ctx (blocos_fluxo, ...).
+ */
+void verificar_inicializacao(ContextoCompilacao *ctx, NoPrograma *prog);
+
+#endif /* FLUXO_H */
@@ -0,0 +1,1252 @@
+/*
+ * Implementação do gerador de assembly x86-64
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include "gerador_asm.h"
+#include "semantic.h"
+
+/*
+ * Runtime embutido em cada programa gerado (espelha runtime.c). Só
+ * chama funções da libc, sem usar variáveis dela (stdout, stderr), para
+ * ligar tanto com ld quanto com um compilador C, com ou sem PIE. Os
+ * erros saem por dprintf no descritor 2 depois de descarregar stdout.
+ */
+static const char *runtime_asm =
+    "\n# ========== Runtime de X25b (LEIA, ESCREVA e erros) ==========\n"
+    "\n"
+    "x25b_escreva_inteiro:\t\t# edi = valor\n"
+    "\tsubq\t$8, %rsp\n"
+    "\tmovl\t%edi, %esi\n"
+    "\tleaq\t.Lx25b_fmt_inteiro(%rip), %rdi\n"
+    "\txorl\t%eax, %eax\n"
+    "\tcall\tprintf@PLT\n"
+    "\taddq\t$8, %rsp\n"
+    "\tret\n"
+    "\n"
+    "x25b_escreva_cadeia:\t\t# rdi = cadeia\n"
+    "\tsubq\t$8, %rsp\n"
+    "\tmovq\t%rdi, %rsi\n"
+    "\tleaq\t.Lx25b_fmt_cadeia(%rip), %rdi\n"
+    "\txorl\t%eax, %eax\n"
+    "\tcall\tprintf@PLT\n"
+    "\taddq\t$8, %rsp\n"
+    "\tret\n"
+    "\n"
+    "x25b_escreva_real:\t\t# xmm0 = valor, com virgula decimal\n"
+    "\tsubq\t$72, %rsp\n"
+    "\tmovq\t%rsp, %rdi\n"
+    "\tmovl\t$64, %esi\n"
+    "\tleaq\t.Lx25b_fmt_real(%rip), %rdx\n"
+    "\tmovl\t$1, %eax\n"
+    "\tcall\tsnprintf@PLT\n"
+    "\tmovq\t%rsp, %rdi\n"
+    "\tmovl\t$46, %esi\n"
+    "\tcall\tstrchr@PLT\n"
+    "\ttestq\t%rax, %rax\n"
+    "\tje\t1f\n"
+    "\tmovb\t$44, (%rax)\n"
+    "1:\tmovq\t%rsp, %rdi\n"
+    "\tcall\tx25b_escreva_cadeia\n"
+    "\taddq\t$72, %rsp\n"
+    "\tret\n"
+    "\n"
+    "x25b_fim_linha:\n"
+    "\tmovl\t$10, %edi\n"
+    "\tjmp\tputchar@PLT\n"
+    "\n"
+    "x25b_palavra:\t\t\t# rdi = buffer de 64 bytes; eax = 0 no fim da entrada\n"
+    "\tpushq\t%rbx\n"
+    "\tpushq\t%r12\n"
+    "\tsubq\t$8, %rsp\n"
+    "\tmovq\t%rdi, %rbx\n"
+    "\txorl\t%r12d, %r12d\n"
+    "1:\tcall\tgetchar@PLT\n"
+    "\tcmpl\t$32, %eax\n"
+    "\tje\t1b\n"
+    "\tcmpl\t$9, %eax\n"
+    "\tje\t1b\n"
+    "\tcmpl\t$10, %eax\n"
+    "\tje\t1b\n"
+    "\tcmpl\t$13, %eax\n"
+    "\tje\t1b\n"
+    "2:\tcmpl\t$-1, %eax\n"
+    "\tje\t3f\n"
+    "\tcmpl\t$32, %eax\n"
+    "\tje\t3f\n"
+    "\tcmpl\t$9, %eax\n"
+    "\tje\t3f\n"
+    "\tcmpl\t$10, %eax\n"
+    "\tje\t3f\n"
+    "\tcmpl\t$13, %eax\n"
+    "\tje\t3f\n"
+    "\tcmpl\t$63, %r12d\n"
+    "\tjae\t4f\n"
+    "\tmovb\t%al, (%rbx,%r12)\n"
+    "\tincl\t%r12d\n"
+    "4:\tcall\tgetchar@PLT\n"
+    "\tjmp\t2b\n"
+    "3:\tmovb\t$0, (%rbx,%r12)\n"
+    "\txorl\t%eax, %eax\n"
+    "\ttestl\t%r12d, %r12d\n"
+    "\tsetne\t%al\n"
+    "\taddq\t$8, %rsp\n"
+    "\tpopq\t%r12\n"
+    "\tpopq\t%rbx\n"
+    "\tret\n"
+    "\n"
+    "x25b_leia_inteiro:\t\t# edi = linha; eax = valor\n"
+    "\tpushq\t%rbx\n"
+    "\tsubq\t$80, %rsp\n"
+    "\tmovl\t%edi, %ebx\n"
+    "\txorl\t%edi, %edi\n"
+    "\tcall\tfflush@PLT\n"
+    "\tmovq\t%rsp, %rdi\n"
+    "\tcall\tx25b_palavra\n"
+    "\ttestl\t%eax, %eax\n"
+    "\tjne\t1f\n"
+    "\tmovl\t%ebx, %edi\n"
+    "\tleaq\t.Lx25b_erro_fim(%rip), %rsi\n"
+    "\tjmp\tx25b_erro\n"
+    "1:\tmovq\t%rsp, %rdi\n"
+    "\tleaq\t64(%rsp), %rsi\n"
+    "\tmovl\t$10, %edx\n"
+    "\tcall\tstrtol@PLT\n"
+    "\tmovq\t64(%rsp), %rcx\n"
+    "\tcmpb\t$0, (%rcx)\n"
+    "\tje\t2f\n"
+    "\tmovl\t%ebx, %edi\n"
+    "\tleaq\t.Lx25b_erro_inteiro(%rip), %rsi\n"
+    "\tmovq\t%rsp, %rdx\n"
+    "\tjmp\tx25b_erro\n"
+    "2:\taddq\t$80, %rsp\n"
+    "\tpopq\t%rbx\n"
+    "\tret\n"
+    "\n"
+    "x25b_leia_real:\t\t\t# edi = linha; xmm0 = valor (virgula ou ponto)\n"
+    "\tpushq\t%rbx\n"
+    "\tsubq\t$80, %rsp\n"
+    "\tmovl\t%edi, %ebx\n"
+    "\txorl\t%edi, %edi\n"
+    "\tcall\tfflush@PLT\n"
+    "\tmovq\t%rsp, %rdi\n"
+    "\tcall\tx25b_palavra\n"
+    "\ttestl\t%eax, %eax\n"
+    "\tjne\t1f\n"
+    "\tmovl\t%ebx, %edi\n"
+    "\tleaq\t.Lx25b_erro_fim(%rip), %rsi\n"
+    "\tjmp\tx25b_erro\n"
+    "1:\tmovq\t%rsp, %rdi\n"
+    "\tmovl\t$44, %esi\n"
+    "\tcall\tstrchr@PLT\n"
+    "\ttestq\t%rax, %rax\n"
+    "\tje\t2f\n"
+    "\tmovb\t$46, (%rax)\n"
+    "2:\tmovq\t%rsp, %rdi\n"
+    "\tleaq\t64(%rsp), %rsi\n"
+    "\tcall\tstrtod@PLT\n"
+    "\tmovq\t64(%rsp), %rcx\n"
+    "\tcmpb\t$0, (%rcx)\n"
+    "\tje\t3f\n"
+    "\tmovl\t%ebx, %edi\n"
+    "\tleaq\t.Lx25b_erro_real(%rip), %rsi\n"
+    "\tmovq\t%rsp, %rdx\n"
+    "\tjmp\tx25b_erro\n"
+    "3:\taddq\t$80, %rsp\n"
+    "\tpopq\t%rbx\n"
+    "\tret\n"
+    "\n"
+    "x25b_erro:\t\t\t# edi = linha, rsi = formato, rdx/rcx/r8 = argumentos; nao retorna\n"
+    "\tandq\t$-16, %rsp\n"
+    "\tmovl\t%edi, %ebx\n"
+    "\tmovq\t%rsi, %r12\n"
+    "\tmovq\t%rdx, %r13\n"
+    "\tmovq\t%rcx, %r14\n"
+    "\tmovq\t%r8, %r15\n"
+    "\txorl\t%edi, %edi\n"
+    "\tcall\tfflush@PLT\n"
+    "\tmovl\t$2, %edi\n"
+    "\tmovq\t%r12, %rsi\n"
+    "\tmovl\t%ebx, %edx\n"
+    "\tmovq\t%r13, %rcx\n"
+    "\tmovq\t%r14, %r8\n"
+    "\tmovq\t%r15, %r9\n"
+    "\txorl\t%eax, %eax\n"
+    "\tcall\tdprintf@PLT\n"
+    "\tmovl\t$2, %edi\n"
+    "\tcall\texit@PLT\n"
+    "\n"
+    "\t.section\t.rodata\n"
+    ".Lx25b_fmt_inteiro:\t.string\t\"%d\"\n"
+    ".Lx25b_fmt_real:\t.string\t\"%.2f\"\n"
+    ".Lx25b_fmt_cadeia:\t.string\t\"%s\"\n"
+    ".Lx25b_erro_fim:\t.string\t\"ERRO DE EXECUCAO na linha %d: Fim da entrada durante LEIA\\n\"\n"
+    ".Lx25b_erro_inteiro:\t.string\t\"ERRO DE EXECUCAO na linha %d: Valor inteiro invalido na entrada: '%s'\\n\"\n"
+    ".Lx25b_erro_real:\t.string\t\"ERRO DE EXECUCAO na linha %d: Valor real invalido na entrada: '%s'\\n\"\n"
+    ".Lx25b_erro_indice:\t.string\t\"ERRO DE EXECUCAO na linha %d: Indice %d fora dos limites de '%s' (1..%d)\\n\"\n"
+    ".Lx25b_erro_divisao:\t.string\t\"ERRO DE EXECUCAO na linha %d: Divisao inteira por zero\\n\"\n"
+    ".Lx25b_erro_estouro:\t.string\t\"ERRO DE EXECUCAO na linha %d: Estouro na divisao inteira\\n\"\n"
+    "\t.balign\t16\n"
+    ".Lx25b_sinal:\t.quad\t0x8000000000000000, 0\n";
+
+/* ========== Registradores ========== */
+
+/*
+ * Temporários inteiros: os registradores de uso geral menos %rsp e os
+ * auxiliares %rax e %rdx (divisão, endereços de listas, conversões).
+ * Nenhum temporário está vivo numa chamada ao runtime (as que acontecem
+ * no meio de uma expressão são erros, que não retornam), então os
+ * registradores preservados pelas chamadas também entram.
+ */
+#define NUM_INTEIROS 13
+
+static const char *reg32[NUM_INTEIROS] = {
+    "%ecx", "%esi", "%edi", "%r8d", "%r9d", "%r10d", "%r11d",
+    "%ebx", "%ebp", "%r12d", "%r13d", "%r14d", "%r15d"
+};
+
+/* Temporários reais: %xmm0 a %xmm14; %xmm15 é o auxiliar */
+#define NUM_REAIS 15
+
+static const char *xmm[NUM_REAIS] = {
+    "%xmm0", "%xmm1", "%xmm2", "%xmm3", "%xmm4", "%xmm5", "%xmm6", "%xmm7",
+    "%xmm8", "%xmm9", "%xmm10", "%xmm11", "%xmm12", "%xmm13", "%xmm14"
+};
+
+typedef enum {
+    CLASSE_INTEIRO,
+    CLASSE_REAL
+} Classe;
+
+/* Onde está um operando, no texto da instrução */
+typedef struct Operando {
+    char texto[48];     /* "%ecx", "$3", "v_x(%rip)", "8(%rsp)", ... */
+    int reg;            /* Índice no banco da classe, ou -1 */
+    int imediato;
+    int zero;           /* Constante com todos os bits zerados */
+} Operando;
+
+/*
+ * Condição deixada nas flags por uma comparação: inteiros com sinal
+ * (cmpl) ou reais (ucomisd, em que "não ordenado" conta como falso)
+ */
+typedef enum {
+    COND_G, COND_GE, COND_L, COND_LE, COND_E, COND_NE,
+    COND_A, COND_AE, COND_E_REAL, COND_NE_REAL
+} Condicao;
+
+static const char *desvio_verdadeiro[] = { "jg", "jge", "jl", "jle", "je", "jne", "ja", "jae" };
+static const char *desvio_falso[] = { "jle", "jl", "jge", "jg", "jne", "je", "jbe", "jb" };
+static const char *marca[] = { "setg", "setge", "setl", "setle", "sete", "setne", "seta", "setae" };
+
+/* ========== Estado da geração ========== */
+
+/* Erro de execução: código fora da linha, no fim do programa */
+#define ERRO_DIVISAO_ZERO   (-1)
+#define ERRO_ESTOURO        (-2)
+
+typedef struct SaidaErro {
+    int rotulo;
+    int linha;
+    int reg_indice;     /* Registrador com o índice, ou ERRO_DIVISAO_ZERO/ERRO_ESTOURO */
+    int tamanho;
+    ChaveId chave;
+} SaidaErro;
+
+/*
+ * Rótulo de Sethi-Ullman de uma expressão: registradores para avaliá-la
+ * sem derramar. Memorizado por nó, porque com -O2 a AST compartilha nós.
+ */
+typedef struct RotuloExpr {
+    const NoExpr *expr;
+    int registradores;
+    int pode_falhar;    /* Divisão inteira ou acesso não provado seguro */
+} RotuloExpr;
+
+typedef struct GeradorAsm {
+    FILE *saida;
+    int proximo_rotulo;
+    int derrames;           /* Posições de derramamento em uso na pilha */
+    int maior_derrame;
+
+    uint64_t *reais;        /* Constantes reais (bits), em .rodata */
+    int num_reais;
+    int cap_reais;
+
+    const char **cadeias;   /* Cadeias de ESCREVA (apontam para a AST) */
+    int num_cadeias;
+    int cap_cadeias;
+
+    SaidaErro *erros;
+    int num_erros;
+    int cap_erros;
+
+    RotuloExpr *rotulos;    /* Tabela hash aberta, capacidade potência de 2 */
+    int num_rotulos;
+    int cap_rotulos;
+
+    ResumoAsm resumo;
+} GeradorAsm;
+
+/* ========== Emissão ========== */
+
+static void *crescer(void *vetor, int *capacidade, size_t elem) {
+    *capacidade = *capacidade ? *capacidade * 2 : 64;
+    void *novo = realloc(vetor, (size_t)*capacidade * elem);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para o assembly\n");
+        exit(1);
+    }
+    return novo;
+}
+
+static void instr(GeradorAsm *g, const char *formato, ...) {
+    va_list args;
+    fputc('\t', g->saida);
+    va_start(args, formato);
+    vfprintf(g->saida, formato, args);
+    va_end(args);
+    fputc('\n', g->saida);
+    g->resumo.instrucoes++;
+}
+
+static int novo_rotulo(GeradorAsm *g) {
+    return g->proximo_rotulo++;
+}
+
+static void marcar_rotulo(GeradorAsm *g, int rotulo) {
+    fprintf(g->saida, ".L%d:\n", rotulo);
+}
+
+static const char *reg(GeradorAsm *g, Classe c, int k) {
+    if (c == CLASSE_INTEIRO) {
+        if (k + 1 > g->resumo.registradores_inteiros) {
+            g->resumo.registradores_inteiros = k + 1;
+        }
+        return reg32[k];
+    }
+    if (k + 1 > g->resumo.registradores_reais) {
+        g->resumo.registradores_reais = k + 1;
+    }
+    return xmm[k];
+}
+
+static void em_registrador(GeradorAsm *g, Operando *o, Classe c, int k) {
+    snprintf(o->texto, sizeof(o->texto), "%s", reg(g, c, k));
+    o->reg = k;
+    o->imediato = 0;
+    o->zero = 0;
+}
+
+static int constante_real(GeradorAsm *g, double valor) {
+    if (g->num_reais == g->cap_reais) {
+        g->reais = crescer(g->reais, &g->cap_reais, sizeof(uint64_t));
+    }
+    memcpy(&g->reais[g->num_reais], &valor, sizeof(double));
+    return g->num_reais++;
+}
+
+static int adicionar_cadeia(GeradorAsm *g, const char *cadeia) {
+    if (g->num_cadeias == g->cap_cadeias) {
+        g->cadeias = crescer(g->cadeias, &g->cap_cadeias, sizeof(char *));
+    }
+    g->cadeias[g->num_cadeias] = cadeia;
+    return g->num_cadeias++;
+}
+
+/* Rótulo de um novo erro de execução, emitido no fim */
+static int saida_erro(GeradorAsm *g, int linha, int reg_indice, int tamanho, ChaveId chave) {
+    if (g->num_erros == g->cap_erros) {
+        g->erros = crescer(g->erros, &g->cap_erros, sizeof(SaidaErro));
+    }
+    SaidaErro *e = &g->erros[g->num_erros++];
+    e->rotulo = novo_rotulo(g);
+    e->linha = linha;
+    e->reg_indice = reg_indice;
+    e->tamanho = tamanho;
+    e->chave = chave;
+    return e->rotulo;
+}
+
+/* Guarda R[k] na próxima posição livre da pilha e retorna o endereço */
+static void derramar(GeradorAsm *g, Classe c, int k, Operando *o) {
+    int pos = g->derrames++;
+    if (g->derrames > g->maior_derrame) {
+        g->maior_derrame = g->derrames;
+    }
+    g->resumo.derramamentos++;
+    snprintf(o->texto, sizeof(o->texto), "%d(%%rsp)", pos * 8);
+    o->reg = -1;
+    o->imediato = 0;
+    o->zero = 0;
+    instr(g, c == CLASSE_INTEIRO ? "movl\t%s, %s" : "movsd\t%s, %s", reg(g, c, k), o->texto);
+}
+
+/* ========== Variáveis e operandos ========== */
+
+static int elemento_real(EntradaSimbolo *s) {
+    return s->tipo == TIPO_REAL || s->tipo == TIPO_LISTAREAL;
+}
+
+static Classe classe_var(NoVar *var) {
+    return elemento_real(var->simbolo) ? CLASSE_REAL : CLASSE_INTEIRO;
+}
+
+static Classe classe_expr(NoExpr *expr) {
+    return expr->tipo_dado == TIPO_REAL ? CLASSE_REAL : CLASSE_INTEIRO;
+}
+
+/* Variáveis recebem o prefixo v_ para não colidir com o runtime */
+static const char *rotulo_var(ChaveId chave, char *buf) {
+    char nome[ID_MAX_CHARS + 1];
+    sprintf(buf, "v_%s", texto_id(chave, nome));
+    return buf;
+}
+
+/* Conversão de real para inteiro como a de cvttsd2si (fora do alcance: INT_MIN) */
+static int truncar(double valor) {
+    if (valor > -2147483649.0 && valor < 2147483648.0) {
+        return (int)valor;
+    }
+    return INT_MIN;
+}
+
+/*
+ * Endereço fixo da variável: simples, ou elemento de índice constante
+ * dentro dos limites. Com 'endereco' nulo, só responde se existe.
+ */
+static int endereco_fixo(NoVar *var, char *endereco, size_t tam) {
+    char nome[ID_MAX_CHARS + 4];
+    int deslocamento = 0;
+
+    if (var->indice != NULL) {
+        int i;
+        if (var->indice->tipo != EXPR_CONST_INT) return 0;
+        i = var->indice->dado.const_int;
+        if (i < 1 || i > var->simbolo->tamanho_array) return 0;
+        deslocamento = (i - 1) * (elemento_real(var->simbolo) ? 8 : 4);
+    }
+    if (endereco != NULL) {
+        rotulo_var(var->chave, nome);
+        if (deslocamento > 0) {
+            snprintf(endereco, tam, "%s+%d(%%rip)", nome, deslocamento);
+        } else {
+            snprintf(endereco, tam, "%s(%%rip)", nome);
+        }
+    }
+    return 1;
+}
+
+/*
+ * A expressão pode entrar numa instrução sem ser calculada num
+ * registrador da classe 'c': constante (imediato inteiro, ou real em
+ * .rodata) ou variável de endereço fixo. O divisor de idiv não aceita
+ * imediato. Com 'o' nulo, só responde.
+ */
+static int operando_direto(GeradorAsm *g, NoExpr *expr, Classe c, int divisor, Operando *o) {
+    double real;
+    int inteiro;
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+        case EXPR_CONST_REAL:
+            if (c == CLASSE_REAL) {
+                real = expr->tipo == EXPR_CONST_INT ? (double)expr->dado.const_int
+                                                    : expr->dado.const_real;
+                if (o != NULL) {
+                    uint64_t bits;
+                    memcpy(&bits, &real, sizeof(double));
+                    snprintf(o->texto, sizeof(o->texto), ".LR%d(%%rip)", constante_real(g, real));
+                    o->reg = -1;
+                    o->imediato = 0;
+                    o->zero = (bits == 0);
+                }
+                return 1;
+            }
+            if (divisor) return 0;
+            inteiro = expr->tipo == EXPR_CONST_INT ? expr->dado.const_int
+                                                   : truncar(expr->dado.const_real);
+            if (o != NULL) {
+                snprintf(o->texto, sizeof(o->texto), "$%d", inteiro);
+                o->reg = -1;
+                o->imediato = 1;
+                o->zero = (inteiro == 0);
+            }
+            return 1;
+
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            if (classe_var(expr->dado.var) != c) return 0;
+            if (!endereco_fixo(expr->dado.var, o != NULL ? o->texto : NULL, sizeof(o->texto))) {
+                return 0;
+            }
+            if (o != NULL) {
+                o->reg = -1;
+                o->imediato = 0;
+                o->zero = 0;
+            }
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+/* Valor do divisor inteiro, se for constante */
+static int valor_divisor(NoExpr *expr, int *valor) {
+    if (expr->tipo == EXPR_CONST_INT) {
+        *valor = expr->dado.const_int;
+        return 1;
+    }
+    if (expr->tipo == EXPR_CONST_REAL) {
+        *valor = truncar(expr->dado.const_real);
+        return 1;
+    }
+    return 0;
+}
+
+/* Divisor constante diferente de 0 e de -1: a divisão nunca falha */
+static int divisor_constante(NoExpr *expr) {
+    int valor;
+    return valor_divisor(expr, &valor) && valor != 0 && valor != -1;
+}
+
+/* ========== Rótulos de Sethi-Ullman ========== */
+
+static size_t hash_expr(const NoExpr *expr) {
+    uint64_t x = (uint64_t)(uintptr_t)expr;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
+
+static void inserir_rotulo(GeradorAsm *g, RotuloExpr r) {
+    if (2 * (g->num_rotulos + 1) > g->cap_rotulos) {
+        RotuloExpr *antigos = g->rotulos;
+        int cap_antiga = g->cap_rotulos;
+        g->cap_rotulos = cap_antiga ? cap_antiga * 2 : 256;
+        g->rotulos = (RotuloExpr *)calloc((size_t)g->cap_rotulos, sizeof(RotuloExpr));
+        if (g->rotulos == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para o assembly\n");
+            exit(1);
+        }
+        g->num_rotulos = 0;
+        for (int i = 0; i < cap_antiga; i++) {
+            if (antigos[i].expr != NULL) {
+                inserir_rotulo(g, antigos[i]);
+            }
+        }
+        free(antigos);
+    }
+    size_t mascara = (size_t)g->cap_rotulos - 1;
+    size_t i = hash_expr(r.expr) & mascara;
+    while (g->rotulos[i].expr != NULL) {
+        i = (i + 1) & mascara;
+    }
+    g->rotulos[i] = r;
+    g->num_rotulos++;
+}
+
+static RotuloExpr rotular(GeradorAsm *g, NoExpr *expr);
+
+/* Registradores de uma operação: o primeiro operando fica preso enquanto o segundo é calculado */
+static int combinar(int primeiro, int segundo) {
+    if (primeiro == segundo) return primeiro + 1;
+    return primeiro > segundo ? primeiro : segundo;
+}
+
+static RotuloExpr calcular_rotulo(GeradorAsm *g, NoExpr *expr) {
+    RotuloExpr r = { expr, 1, 0 };
+    RotuloExpr a, b;
+    Classe c;
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+        case EXPR_CONST_REAL:
+        case EXPR_VAR:
+            break;
+
+        case EXPR_VAR_ARRAY:
+            if (!endereco_fixo(expr->dado.var, NULL, 0)) {
+                a = rotular(g, expr->dado.var->indice);
+                r.registradores = a.registradores;
+                r.pode_falhar = a.pode_falhar || expr->dado.var->limite != LIMITE_SEGURO;
+            }
+            break;
+
+        case EXPR_ARITMETICA:
+            c = classe_expr(expr);
+            a = rotular(g, expr->dado.aritmetica.esq);
+            b = rotular(g, expr->dado.aritmetica.dir);
+            {
+                int divisao = expr->dado.aritmetica.op == ARIT_DIV && c == CLASSE_INTEIRO;
+                int segundo = operando_direto(g, expr->dado.aritmetica.dir, c, divisao, NULL)
+                              ? 0 : b.registradores;
+                r.registradores = combinar(a.registradores, segundo);
+                r.pode_falhar = a.pode_falhar || b.pode_falhar ||
+                                (divisao && !divisor_constante(expr->dado.aritmetica.dir));
+            }
+            break;
+
+        case EXPR_RELACIONAL:
+            c = (classe_expr(expr->dado.relacional.esq) == CLASSE_REAL ||
+                 classe_expr(expr->dado.relacional.dir) == CLASSE_REAL) ? CLASSE_REAL : CLASSE_INTEIRO;
+            a = rotular(g, expr->dado.relacional.esq);
+            b = rotular(g, expr->dado.relacional.dir);
+            r.registradores = combinar(a.registradores,
+                                       operando_direto(g, expr->dado.relacional.dir, c, 0, NULL)
+                                       ? 0 : b.registradores);
+            r.pode_falhar = a.pode_falhar || b.pode_falhar;
+            break;
+
+        case EXPR_LOGICA:
+            /* Curto-circuito: os operandos não ficam vivos ao mesmo tempo */
+            a = rotular(g, expr->dado.logica.esq);
+            b = rotular(g, expr->dado.logica.dir);
+            r.registradores = a.registradores > b.registradores ? a.registradores : b.registradores;
+            r.pode_falhar = a.pode_falhar || b.pode_falhar;
+            break;
+
+        case EXPR_NAO:
+        case EXPR_NEG:
+            r = rotular(g, expr->dado.negacao);
+            r.expr = expr;
+            break;
+    }
+    return r;
+}
+
+static RotuloExpr rotular(GeradorAsm *g, NoExpr *expr) {
+    if (g->cap_rotulos > 0) {
+        size_t mascara = (size_t)g->cap_rotulos - 1;
+        size_t i = hash_expr(expr) & mascara;
+        while (g->rotulos[i].expr != NULL) {
+            if (g->rotulos[i].expr == expr) {
+                return g->rotulos[i];
+            }
+            i = (i + 1) & mascara;
+        }
+    }
+    RotuloExpr r = calcular_rotulo(g, expr);
+    inserir_rotulo(g, r);
+    return r;
+}
+
+/* ========== Expressões ========== */
+
+/*
+ * Convenção: gerar_valor(g, e, c, bi, br) deixa o valor de 'e', na
+ * classe 'c', no registrador de índice bi (inteiro) ou br (real), e
+ * pode usar os registradores de índice maior de cada banco. Os
+ * executores avaliam o operando esquerdo antes do direito, e a ordem só
+ * é trocada (o que pede mais registradores primeiro) quando no máximo um
+ * dos dois pode interromper a execução; assim o erro relatado é o mesmo.
+ */
+static void gerar_valor(GeradorAsm *g, NoExpr *expr, Classe c, int bi, int br);
+static void gerar_desvio(GeradorAsm *g, NoExpr *expr, int sentido, int rotulo, int bi, int br);
+
+static int base(Classe c, int bi, int br) {
+    return c == CLASSE_INTEIRO ? bi : br;
+}
+
+/*
+ * Avalia os operandos de uma operação da classe 'c'. Ao final, o da
+ * esquerda está em 'esq' (registrador ou posição de derramamento) e o da
+ * direita em 'dir' (registrador, imediato ou memória). Retorna 1 se
+ * ocupou uma posição de derramamento, a liberar depois da operação.
+ */
+static int gerar_operandos(GeradorAsm *g, NoExpr *a, NoExpr *b, Classe c, int divisao,
+                           int bi, int br, Operando *esq, Operando *dir) {
+    int k = base(c, bi, br);
+    int limite = c == CLASSE_INTEIRO ? NUM_INTEIROS : NUM_REAIS;
+
+    if (operando_direto(g, b, c, divisao, dir)) {
+        gerar_valor(g, a, c, bi, br);
+        em_registrador(g, esq, c, k);
+        return 0;
+    }
+
+    RotuloExpr ra = rotular(g, a);
+    RotuloExpr rb = rotular(g, b);
+    int inverter = rb.registradores > ra.registradores && !(ra.pode_falhar && rb.pode_falhar);
+    NoExpr *primeiro = inverter ? b : a;
+    NoExpr *segundo = inverter ? a : b;
+    Operando *o1 = inverter ? dir : esq;
+    Operando *o2 = inverter ? esq : dir;
+
+    gerar_valor(g, primeiro, c, bi, br);
+    if (k + 1 < limite) {
+        gerar_valor(g, segundo, c, bi + (c == CLASSE_INTEIRO), br + (c == CLASSE_REAL));
+        em_registrador(g, o1, c, k);
+        em_registrador(g, o2, c, k + 1);
+        return 0;
+    }
+
+    /* Banco cheio: o primeiro vai para a pilha e o segundo reusa R[k] */
+    derramar(g, c, k, o1);
+    gerar_valor(g, segundo, c, bi, br);
+    em_registrador(g, o2, c, k);
+    return 1;
+}
+
+static void liberar_derrame(GeradorAsm *g, int derramou) {
+    if (derramou) {
+        g->derrames--;
+    }
+}
+
+/* Carrega um operando direto em R[k] */
+static void carregar(GeradorAsm *g, Classe c, Operando *o, int k) {
+    const char *r = reg(g, c, k);
+    if (c == CLASSE_INTEIRO) {
+        if (o->imediato && o->zero) {
+            instr(g, "xorl\t%s, %s", r, r);
+        } else {
+            instr(g, "movl\t%s, %s", o->texto, r);
+        }
+    } else if (o->zero) {
+        instr(g, "xorpd\t%s, %s", r, r);
+    } else {
+        instr(g, "movsd\t%s, %s", o->texto, r);
+    }
+}
+
+/*
+ * Calcula o índice de 'var' em R[bi], verifica os limites se não foram
+ * provados e deixa em 'endereco' o operando de memória do elemento
+ * (base da lista em %rdx, índice em %rax)
+ */
+static void endereco_elemento(GeradorAsm *g, NoVar *var, int bi, int br, char *endereco, size_t tam) {
+    EntradaSimbolo *s = var->simbolo;
+    int bytes = elemento_real(s) ? 8 : 4;
+    char nome[ID_MAX_CHARS + 4];
+    const char *r;
+
+    gerar_valor(g, var->indice, CLASSE_INTEIRO, bi, br);
+    r = reg(g, CLASSE_INTEIRO, bi);
+    if (var->limite == LIMITE_SEGURO) {
+        instr(g, "movslq\t%s, %%rax", r);
+        snprintf(endereco, tam, "-%d(%%rdx,%%rax,%d)", bytes, bytes);
+    } else {
+        /* 1 <= i <= tamanho  <=>  (unsigned)(i - 1) < tamanho */
+        instr(g, "leal\t-1(%s), %%eax", r);
+        instr(g, "cmpl\t$%d, %%eax", s->tamanho_array);
+        instr(g, "jae\t.L%d", saida_erro(g, var->linha, bi, s->tamanho_array, var->chave));
+        snprintf(endereco, tam, "(%%rdx,%%rax,%d)", bytes);
+    }
+    instr(g, "leaq\t%s(%%rip), %%rdx", rotulo_var(var->chave, nome));
+}
+
+static void gerar_aritmetica(GeradorAsm *g, NoExpr *expr, Classe c, int bi, int br) {
+    OpAritmetico op = expr->dado.aritmetica.op;
+    NoExpr *dir_expr = expr->dado.aritmetica.dir;
+    int divisao = op == ARIT_DIV && c == CLASSE_INTEIRO;
+    int k = base(c, bi, br);
+    const char *rk = reg(g, c, k);
+    Operando esq, dir;
+    int derramou = gerar_operandos(g, expr->dado.aritmetica.esq, dir_expr, c, divisao,
+                                   bi, br, &esq, &dir);
+
+    if (divisao) {
+        int d;
+        int constante = valor_divisor(dir_expr, &d);
+        if (!constante || d == 0) {
+            if (dir.reg >= 0) {
+                instr(g, "testl\t%s, %s", dir.texto, dir.texto);
+            } else {
+                instr(g, "cmpl\t$0, %s", dir.texto);
+            }
+            instr(g, "je\t.L%d", saida_erro(g, expr->linha, ERRO_DIVISAO_ZERO, 0, 0));
+        }
+        instr(g, "movl\t%s, %%eax", esq.texto);
+        /* INT_MIN / -1 não cabe em 32 bits (idiv geraria #DE) */
+        if (!constante) {
+            int continua = novo_rotulo(g);
+            instr(g, "cmpl\t$-1, %s", dir.texto);
+            instr(g, "jne\t.L%d", continua);
+            instr(g, "cmpl\t$%d, %%eax", INT_MIN);
+            instr(g, "je\t.L%d", saida_erro(g, expr->linha, ERRO_ESTOURO, 0, 0));
+            marcar_rotulo(g, continua);
+        } else if (d == -1) {
+            instr(g, "cmpl\t$%d, %%eax", INT_MIN);
+            instr(g, "je\t.L%d", saida_erro(g, expr->linha, ERRO_ESTOURO, 0, 0));
+        }
+        instr(g, "cltd");
+        instr(g, "idivl\t%s", dir.texto);
+        instr(g, "movl\t%%eax, %s", rk);
+        liberar_derrame(g, derramou);
+        return;
+    }
+
+    static const char *ops_inteiros[] = { "addl", "subl", "imull" };
+    static const char *ops_reais[] = { "addsd", "subsd", "mulsd", "divsd" };
+    const char *mnemonico = c == CLASSE_INTEIRO ? ops_inteiros[op] : ops_reais[op];
+    const char *mover = c == CLASSE_INTEIRO ? "movl" : "movapd";
+    int comutativa = op == ARIT_SOMA || op == ARIT_MULT;
+
+    if (esq.reg == k) {
+        if (c == CLASSE_INTEIRO && op == ARIT_MULT && dir.imediato) {
+            instr(g, "imull\t%s, %s, %s", dir.texto, rk, rk);
+        } else {
+            instr(g, "%s\t%s, %s", mnemonico, dir.texto, rk);
+        }
+    } else if (comutativa && dir.reg == k) {
+        /* Operandos invertidos, ou o esquerdo derramado: R[k] = dir op esq */
+        instr(g, "%s\t%s, %s", mnemonico, esq.texto, rk);
+    } else if (esq.reg >= 0) {
+        instr(g, "%s\t%s, %s", mnemonico, dir.texto, esq.texto);
+        instr(g, "%s\t%s, %s", mover, esq.texto, rk);
+    } else {
+        /* Esquerdo na pilha e direito em R[k]: passa pelo auxiliar */
+        const char *aux = c == CLASSE_INTEIRO ? "%eax" : "%xmm15";
+        instr(g, c == CLASSE_INTEIRO ? "movl\t%s, %s" : "movsd\t%s, %s", esq.texto, aux);
+        instr(g, "%s\t%s, %s", mnemonico, dir.texto, aux);
+        instr(g, "%s\t%s, %s", mover, aux, rk);
+    }
+    liberar_derrame(g, derramou);
+}
+
+/* Compara os operandos de uma expressão relacional e diz o que testar nas flags */
+static Condicao gerar_comparacao(GeradorAsm *g, NoExpr *expr, int bi, int br) {
+    static const Condicao inteiras[] = { COND_G, COND_GE, COND_L, COND_LE, COND_E, COND_NE };
+    NoExpr *a = expr->dado.relacional.esq;
+    NoExpr *b = expr->dado.relacional.dir;
+    OpRelacional op = expr->dado.relacional.op;
+    Classe c = (classe_expr(a) == CLASSE_REAL || classe_expr(b) == CLASSE_REAL)
+               ? CLASSE_REAL : CLASSE_INTEIRO;
+    Operando esq, dir;
+    Condicao cond;
+    int derramou = gerar_operandos(g, a, b, c, 0, bi, br, &esq, &dir);
+
+    if (c == CLASSE_INTEIRO) {
+        /* cmpl aceita o esquerdo derramado, já que o direito então é registrador */
+        instr(g, "cmpl\t%s, %s", dir.texto, esq.texto);
+        liberar_derrame(g, derramou);
+        return inteiras[op];
+    }
+
+    /*
+     * ucomisd compara o destino (registrador) com a fonte; a < b e
+     * a <= b viram b > a e b >= a, para que "não ordenado" (NaN) caia
+     * no lado falso com um só desvio
+     */
+    Operando *destino = &esq;
+    Operando *fonte = &dir;
+    if (op == REL_MEQ || op == REL_MEI || ((op == REL_IGU || op == REL_DIF) && esq.reg < 0)) {
+        destino = &dir;
+        fonte = &esq;
+    }
+    if (destino->reg < 0) {
+        instr(g, "movsd\t%s, %%xmm15", destino->texto);
+        instr(g, "ucomisd\t%s, %%xmm15", fonte->texto);
+    } else {
+        instr(g, "ucomisd\t%s, %s", fonte->texto, destino->texto);
+    }
+    liberar_derrame(g, derramou);
+
+    switch (op) {
+        case REL_MAQ:
+        case REL_MEQ:
+            cond = COND_A;
+            break;
+        case REL_MAI:
+        case REL_MEI:
+            cond = COND_AE;
+            break;
+        case REL_IGU:
+            cond = COND_E_REAL;
+            break;
+        default:
+            cond = COND_NE_REAL;
+            break;
+    }
+    return cond;
+}
+
+/* Desvia para 'rotulo' se a condição nas flags tiver o valor 'sentido' */
+static void desviar(GeradorAsm *g, Condicao cond, int sentido, int rotulo) {
+    if (cond == COND_E_REAL || cond == COND_NE_REAL) {
+        /* Igualdade real: PF = 1 indica NaN, que torna == falso e != verdadeiro */
+        if ((cond == COND_E_REAL) == (sentido != 0)) {
+            int pula = novo_rotulo(g);
+            instr(g, "jp\t.L%d", pula);
+            instr(g, "je\t.L%d", rotulo);
+            marcar_rotulo(g, pula);
+        } else {
+            instr(g, "jp\t.L%d", rotulo);
+            instr(g, "jne\t.L%d", rotulo);
+        }
+        return;
+    }
+    instr(g, "%s\t.L%d", sentido ? desvio_verdadeiro[cond] : desvio_falso[cond], rotulo);
+}
+
+/* Materializa em R[bi] (0 ou 1) a condição das flags */
+static void marcar_condicao(GeradorAsm *g, Condicao cond, int bi) {
+    if (cond == COND_E_REAL) {
+        instr(g, "sete\t%%al");
+        instr(g, "setnp\t%%dl");
+        instr(g, "andb\t%%dl, %%al");
+    } else if (cond == COND_NE_REAL) {
+        instr(g, "setne\t%%al");
+        instr(g, "setp\t%%dl");
+        instr(g, "orb\t%%dl, %%al");
+    } else {
+        instr(g, "%s\t%%al", marca[cond]);
+    }
+    instr(g, "movzbl\t%%al, %s", reg(g, CLASSE_INTEIRO, bi));
+}
+
+static void gerar_valor(GeradorAsm *g, NoExpr *expr, Classe c, int bi, int br) {
+    Classe propria = classe_expr(expr);
+    Operando o;
+
+    if (operando_direto(g, expr, c, 0, &o)) {
+        carregar(g, c, &o, base(c, bi, br));
+        return;
+    }
+
+    /* Conversões implícitas: INTEIRO promovido a REAL, REAL truncado */
+    if (propria != c) {
+        const char *destino = reg(g, c, base(c, bi, br));
+        const char *conversao = c == CLASSE_REAL ? "cvtsi2sdl" : "cvttsd2si";
+        if (operando_direto(g, expr, propria, 0, &o) && !o.imediato) {
+            instr(g, "%s\t%s, %s", conversao, o.texto, destino);
+        } else {
+            gerar_valor(g, expr, propria, bi, br);
+            instr(g, "%s\t%s, %s", conversao, reg(g, propria, base(propria, bi, br)), destino);
+        }
+        return;
+    }
+
+    switch (expr->tipo) {
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            {
+                /* Elemento de índice calculado (os demais casos são diretos) */
+                char endereco[48];
+                endereco_elemento(g, expr->dado.var, bi, br, endereco, sizeof(endereco));
+                instr(g, c == CLASSE_INTEIRO ? "movl\t%s, %s" : "movsd\t%s, %s",
+                      endereco, reg(g, c, base(c, bi, br)));
+            }
+            break;
+
+        case EXPR_ARITMETICA:
+            gerar_aritmetica(g, expr, c, bi, br);
+            break;
+
+        case EXPR_RELACIONAL:
+            marcar_condicao(g, gerar_comparacao(g, expr, bi, br), bi);
+            break;
+
+        case EXPR_LOGICA:
+        case EXPR_NAO:
+            {
+                const char *r = reg(g, CLASSE_INTEIRO, bi);
+                int falso = novo_rotulo(g);
+                int fim = novo_rotulo(g);
+                gerar_desvio(g, expr, 0, falso, bi, br);
+                instr(g, "movl\t$1, %s", r);
+                instr(g, "jmp\t.L%d", fim);
+                marcar_rotulo(g, falso);
+                instr(g, "xorl\t%s, %s", r, r);
+                marcar_rotulo(g, fim);
+            }
+            break;
+
+        case EXPR_NEG:
+            gerar_valor(g, expr->dado.negacao, c, bi, br);
+            if (c == CLASSE_INTEIRO) {
+                instr(g, "negl\t%s", reg(g, c, bi));
+            } else {
+                instr(g, "xorpd\t.Lx25b_sinal(%%rip), %s", reg(g, c, br));
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Desvia para 'rotulo' se o valor lógico de 'expr' for 'sentido' (curto-circuito em .E. e .OU.) */
+static void gerar_desvio(GeradorAsm *g, NoExpr *expr, int sentido, int rotulo, int bi, int br) {
+    Operando o;
+
+    switch (expr->tipo) {
+        case EXPR_RELACIONAL:
+            desviar(g, gerar_comparacao(g, expr, bi, br), sentido, rotulo);
+            return;
+
+        case EXPR_LOGICA:
+            {
+                /* E é falso (OU é verdadeiro) assim que o esquerdo decide */
+                int decide = expr->dado.logica.op == LOG_E ? 0 : 1;
+                if (sentido == decide) {
+                    gerar_desvio(g, expr->dado.logica.esq, decide, rotulo, bi, br);
+                    gerar_desvio(g, expr->dado.logica.dir, decide, rotulo, bi, br);
+                } else {
+                    int pula = novo_rotulo(g);
+                    gerar_desvio(g, expr->dado.logica.esq, decide, pula, bi, br);
+                    gerar_desvio(g, expr->dado.logica.dir, sentido, rotulo, bi, br);
+                    marcar_rotulo(g, pula);
+                }
+            }
+            return;
+
+        case EXPR_NAO:
+            gerar_desvio(g, expr->dado.negacao, !sentido, rotulo, bi, br);
+            return;
+
+        default:
+            break;
+    }
+
+    /* Valor inteiro (um REAL é truncado, como no --run): verdadeiro se não zero */
+    if (operando_direto(g, expr, CLASSE_INTEIRO, 0, &o)) {
+        if (o.imediato) {
+            if ((!o.zero) == (sentido != 0)) {
+                instr(g, "jmp\t.L%d", rotulo);
+            }
+            return;
+        }
+        instr(g, "cmpl\t$0, %s", o.texto);
+    } else {
+        const char *r;
+        gerar_valor(g, expr, CLASSE_INTEIRO, bi, br);
+        r = reg(g, CLASSE_INTEIRO, bi);
+        instr(g, "testl\t%s, %s", r, r);
+    }
+    instr(g, "%s\t.L%d", sentido ? "jne" : "je", rotulo);
+}
+
+/* ========== Comandos ========== */
+
+/* Grava o registrador de índice 0 da classe da variável nela (o valor já foi calculado) */
+static void guardar(GeradorAsm *g, NoVar *var, Operando *valor) {
+    Classe c = classe_var(var);
+    const char *mover = c == CLASSE_INTEIRO ? "movl" : "movsd";
+    char endereco[48];
+
+    if (!endereco_fixo(var, endereco, sizeof(endereco))) {
+        /* O índice é avaliado depois do valor, como no --run */
+        int ocupa = valor->imediato ? 0 : 1;
+        endereco_elemento(g, var, c == CLASSE_INTEIRO ? ocupa : 0, c == CLASSE_REAL ? ocupa : 0,
+                          endereco, sizeof(endereco));
+    }
+    instr(g, "%s\t%s, %s", mover, valor->texto, endereco);
+}
+
+static void gerar_comandos(GeradorAsm *g, NoCmd *cmd) {
+    while (cmd != NULL) {
+        fprintf(g->saida, "\t# linha %d\n", cmd->linha);
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                {
+                    NoVar *var = cmd->dado.atrib.var;
+                    Classe c = classe_var(var);
+                    Operando valor;
+                    if (!(c == CLASSE_INTEIRO &&
+                          operando_direto(g, cmd->dado.atrib.expr, c, 0, &valor) && valor.imediato)) {
+                        gerar_valor(g, cmd->dado.atrib.expr, c, 0, 0);
+                        em_registrador(g, &valor, c, 0);
+                    }
+                    guardar(g, var, &valor);
+                }
+                break;
+
+            case CMD_LEIA:
+                {
+                    ListaVar *v = cmd->dado.leia;
+                    while (v != NULL) {
+                        Classe c = classe_var(v->var);
+                        Operando valor;
+                        instr(g, "movl\t$%d, %%edi", cmd->linha);
+                        if (c == CLASSE_REAL) {
+                            instr(g, "call\tx25b_leia_real");
+                        } else {
+                            instr(g, "call\tx25b_leia_inteiro");
+                            instr(g, "movl\t%%eax, %s", reg(g, CLASSE_INTEIRO, 0));
+                        }
+                        em_registrador(g, &valor, c, 0);
+                        guardar(g, v->var, &valor);
+                        v = v->prox;
+                    }
+                }
+                break;
+
+            case CMD_ESCREVA:
+                {
+                    ListaEscreva *e = cmd->dado.escreva;
+                    while (e != NULL) {
+                        Operando o;
+                        if (e->is_cadeia) {
+                            instr(g, "leaq\t.LS%d(%%rip), %%rdi", adicionar_cadeia(g, e->item.cadeia));
+                            instr(g, "call\tx25b_escreva_cadeia");
+                        } else if (e->item.expr->tipo_dado == TIPO_REAL) {
+                            gerar_valor(g, e->item.expr, CLASSE_REAL, 0, 0);
+                            instr(g, "call\tx25b_escreva_real");
+                        } else {
+                            if (operando_direto(g, e->item.expr, CLASSE_INTEIRO, 0, &o)) {
+                                instr(g, "movl\t%s, %%edi", o.texto);
+                            } else {
+                                gerar_valor(g, e->item.expr, CLASSE_INTEIRO, 0, 0);
+                                instr(g, "movl\t%s, %%edi", reg(g, CLASSE_INTEIRO, 0));
+                            }
+                            instr(g, "call\tx25b_escreva_inteiro");
+                        }
+                        e = e->prox;
+                    }
+                    instr(g, "call\tx25b_fim_linha");
+                }
+                break;
+
+            case CMD_SE:
+                {
+                    int senao = novo_rotulo(g);
+                    gerar_desvio(g, cmd->dado.se.condicao, 0, senao, 0, 0);
+                    gerar_comandos(g, cmd->dado.se.entao);
+                    if (cmd->dado.se.senao != NULL) {
+                        int fim = novo_rotulo(g);
+                        instr(g, "jmp\t.L%d", fim);
+                        marcar_rotulo(g, senao);
+                        gerar_comandos(g, cmd->dado.se.senao);
+                        marcar_rotulo(g, fim);
+                    } else {
+                        marcar_rotulo(g, senao);
+                    }
+                }
+                break;
+
+            case CMD_ENQUANTO:
+                {
+                    /* Laço invertido, como no bytecode: um desvio por iteração */
+                    int teste = novo_rotulo(g);
+                    int corpo = novo_rotulo(g);
+                    instr(g, "jmp\t.L%d", teste);
+                    fputs("\t.p2align\t4\n", g->saida);
+                    marcar_rotulo(g, corpo);
+                    gerar_comandos(g, cmd->dado.enquanto.corpo);
+                    marcar_rotulo(g, teste);
+                    gerar_desvio(g, cmd->dado.enquanto.condicao, 1, corpo, 0, 0);
+                }
+                break;
+        }
+
+        cmd = cmd->prox;
+    }
+}
+
+/* ========== Programa ========== */
+
+static void emitir_erros(GeradorAsm *g) {
+    char nome[ID_MAX_CHARS + 1];
+
+    for (int i = 0; i < g->num_erros; i++) {
+        SaidaErro *e = &g->erros[i];
+        marcar_rotulo(g, e->rotulo);
+        if (e->reg_indice >= 0) {
+            /* O índice primeiro: o registrador pode ser um dos argumentos */
+            instr(g, "movl\t%s, %%edx", reg32[e->reg_indice]);
+            instr(g, "movl\t$%d, %%edi", e->linha);
+            instr(g, "leaq\t.Lx25b_erro_indice(%%rip), %%rsi");
+            instr(g, "leaq\t.Lnome_%s(%%rip), %%rcx", texto_id(e->chave, nome));
+            instr(g, "movl\t$%d, %%r8d", e->tamanho);
+        } else {
+            instr(g, "movl\t$%d, %%edi", e->linha);
+            instr(g, "leaq\t%s(%%rip), %%rsi",
+                  e->reg_indice == ERRO_ESTOURO ? ".Lx25b_erro_estouro" : ".Lx25b_erro_divisao");
+        }
+        instr(g, "call\tx25b_erro");
+    }
+}
+
+static void emitir_cadeia(const char *cadeia, FILE *saida) {
+    fputc('"', saida);
+    for (const unsigned char *p = (const unsigned char *)cadeia; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(saida, "\\%c", *p);
+        } else if (*p < 32 || *p >= 127) {
+            fprintf(saida, "\\%03o", *p);
+        } else {
+            fputc(*p, saida);
+        }
+    }
+    fputc('"', saida);
+}
+
+static void emitir_dados(GeradorAsm *g, NoPrograma *prog) {
+    FILE *saida = g->saida;
+    char nome[ID_MAX_CHARS + 1];
+    char rotulo[ID_MAX_CHARS + 4];
+
+    fputs("\n\t.section\t.rodata\n", saida);
+    for (int i = 0; i < g->num_cadeias; i++) {
+        fprintf(saida, ".LS%d:\t.string\t", i);
+        emitir_cadeia(g->cadeias[i], saida);
+        fputc('\n', saida);
+    }
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox) {
+        if (d->tamanho_array > 0) {
+            texto_id(d->chave, nome);
+            fprintf(saida, ".Lnome_%s:\t.string\t\"%s\"\n", nome, nome);
+        }
+    }
+    if (g->num_reais > 0) {
+        fputs("\t.balign\t8\n", saida);
+        for (int i = 0; i < g->num_reais; i++) {
+            fprintf(saida, ".LR%d:\t.quad\t0x%016llx\n", i, (unsigned long long)g->reais[i]);
+        }
+    }
+
+    /* Variáveis: zeradas, listas com tamanho_array elementos */
+    fputs("\n\t.bss\n", saida);
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox) {
+        int bytes = (d->tipo == TIPO_REAL || d->tipo == TIPO_LISTAREAL) ? 8 : 4;
+        int elementos = d->tamanho_array > 0 ? d->tamanho_array : 1;
+        fprintf(saida, "\t.balign\t%d\n", d->tamanho_array > 0 ? 16 : bytes);
+        fprintf(saida, "%s:\t.zero\t%d\n", rotulo_var(d->chave, rotulo), elementos * bytes);
+    }
+
+    fputs("\n\t.section\t.note.GNU-stack,\"\",@progbits\n", saida);
+}
+
+void gerar_asm(NoPrograma *prog, const char *origem, FILE *saida, ResumoAsm *resumo) {
+    GeradorAsm g;
+    memset(&g, 0, sizeof(g));
+    g.saida = saida;
+
+    fprintf(saida, "# Gerado pelo compilador X25b a partir de %s\n", origem);
+    fputs("# as -o prog.o prog.s && ld -o prog prog.o -lc -dynamic-linker /lib64/ld-linux-x86-64.so.2\n\n", saida);
+    fputs("\t.text\n\t.globl\t_start\n_start:\n", saida);
+    instr(&g, "andq\t$-16, %%rsp");
+    instr(&g, "subq\t$.Lx25b_pilha, %%rsp");
+
+    gerar_comandos(&g, prog->algoritmo);
+
+    instr(&g, "xorl\t%%edi, %%edi");
+    instr(&g, "call\texit@PLT");
+
+    emitir_erros(&g);
+
+    /* Posições de derramamento, com %rsp alinhado em 16 nas chamadas */
+    fprintf(saida, "\t.set\t.Lx25b_pilha, %d\n", (g.maior_derrame * 8 + 15) & ~15);
+
+    fputs(runtime_asm, saida);
+    emitir_dados(&g, prog);
+
+    if (resumo != NULL) {
+        *resumo = g.resumo;
+    }
+    free(g.reais);
+    free(g.cadeias);
+    free(g.erros);
+    free(g.rotulos);
+}
@@ -0,0 +1,40 @@
+/*
+ * Geração de assembly x86-64 a partir da AST de X25b (opção --emit-asm)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef GERADOR_ASM_H
+#define GERADOR_ASM_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/* Números da última geração, para o modo verbose */
+typedef struct ResumoAsm {
+    long instrucoes;            /* Instruções emitidas (sem o runtime) */
+    int registradores_inteiros; /* Maior número de temporários inteiros em registradores */
+    int registradores_reais;    /* O mesmo nos registradores SSE2 */
+    long derramamentos;         /* Temporários guardados na pilha por falta de registrador */
+} ResumoAsm;
+
+/*
+ * Emite um arquivo para o GNU as (sintaxe AT&T), x86-64 Linux,
+ * equivalente ao programa (já verificado pela análise semântica). As
+ * variáveis ficam em .bss (listas com tamanho_array elementos de 4 ou 8
+ * bytes), a aritmética inteira usa registradores de uso geral e a real,
+ * SSE2. Os temporários de cada expressão recebem registradores na
+ * ordem de Sethi-Ullman e vão para a pilha quando acabam. Um pequeno
+ * runtime em assembly faz LEIA/ESCREVA e os erros de execução chamando
+ * a libc, com as mensagens do modo --run.
+ *
+ * O ponto de entrada é _start, e basta o binutils para gerar o
+ * executável:
+ *
+ *     as -o prog.o prog.s
+ *     ld -o prog prog.o -lc -dynamic-linker /lib64/ld-linux-x86-64.so.2
+ *
+ * Com 'resumo' não nulo, preenche os números da geração.
+ */
+void gerar_asm(NoPrograma *prog, const char *origem, FILE *saida, ResumoAsm *resumo);
+
+#endif /* GERADOR_ASM_H */
@@ -0,0 +1,349 @@
+/*
+ * Implementação do gerador de código C99
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "gerador_c.h"
+#include "semantic.h"
+
+/* Runtime embutido em cada programa gerado (espelha runtime.c) */
+static const char *runtime_c =
+    "static inline void x25b_escreva_real(double v) {\n"
+    "    char buf[64];\n"
+    "    snprintf(buf, sizeof(buf), \"%.2f\", v);\n"
+    "    char *p = strchr(buf, '.');\n"
+    "    if (p) *p = ',';\n"
+    "    fputs(buf, stdout);\n"
+    "}\n"
+    "\n"
+    "static inline void x25b_erro(int linha, const char *formato, ...) {\n"
+    "    va_list args;\n"
+    "    fflush(stdout);\n"
+    "    fprintf(stderr, \"ERRO DE EXECUCAO na linha %d: \", linha);\n"
+    "    va_start(args, formato);\n"
+    "    vfprintf(stderr, formato, args);\n"
+    "    va_end(args);\n"
+    "    fprintf(stderr, \"\\n\");\n"
+    "    exit(2);\n"
+    "}\n"
+    "\n"
+    "static inline int x25b_palavra(char *buf, size_t tam) {\n"
+    "    int c;\n"
+    "    size_t n = 0;\n"
+    "    do { c = getchar(); } while (c == ' ' || c == '\\t' || c == '\\n' || c == '\\r');\n"
+    "    while (c != EOF && c != ' ' && c != '\\t' && c != '\\n' && c != '\\r') {\n"
+    "        if (n < tam - 1) buf[n++] = (char)c;\n"
+    "        c = getchar();\n"
+    "    }\n"
+    "    buf[n] = '\\0';\n"
+    "    return n > 0;\n"
+    "}\n"
+    "\n"
+    "static inline int x25b_leia_inteiro(int linha) {\n"
+    "    char buf[64], *fim;\n"
+    "    fflush(stdout);\n"
+    "    if (!x25b_palavra(buf, sizeof(buf))) x25b_erro(linha, \"Fim da entrada durante LEIA\");\n"
+    "    long v = strtol(buf, &fim, 10);\n"
+    "    if (*fim != '\\0') x25b_erro(linha, \"Valor inteiro invalido na entrada: '%s'\", buf);\n"
+    "    return (int)v;\n"
+    "}\n"
+    "\n"
+    "static inline double x25b_leia_real(int linha) {\n"
+    "    char buf[64], *fim;\n"
+    "    fflush(stdout);\n"
+    "    if (!x25b_palavra(buf, sizeof(buf))) x25b_erro(linha, \"Fim da entrada durante LEIA\");\n"
+    "    char *p = strchr(buf, ',');\n"
+    "    if (p) *p = '.';\n"
+    "    double v = strtod(buf, &fim);\n"
+    "    if (*fim != '\\0') x25b_erro(linha, \"Valor real invalido na entrada: '%s'\", buf);\n"
+    "    return v;\n"
+    "}\n"
+    "\n"
+    "static inline int x25b_indice(int i, int tam, const char *nome, int linha) {\n"
+    "    if (i < 1 || i > tam) {\n"
+    "        x25b_erro(linha, \"Indice %d fora dos limites de '%s' (1..%d)\", i, nome, tam);\n"
+    "    }\n"
+    "    return i - 1;\n"
+    "}\n"
+    "\n"
+    "\n"
+    "/* INTEIRO: estouros dao a volta; INT_MIN / -1 e erro, como em --run */\n"
+    "static inline int x25b_soma(int a, int b) { return (int)((unsigned)a + (unsigned)b); }\n"
+    "static inline int x25b_sub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }\n"
+    "static inline int x25b_mult(int a, int b) { return (int)((unsigned)a * (unsigned)b); }\n"
+    "static inline int x25b_neg(int a) { return (int)(0u - (unsigned)a); }\n"
+    "\n"
+    "static inline int x25b_div(int a, int b, int linha) {\n"
+    "    if (b == 0) x25b_erro(linha, \"Divisao inteira por zero\");\n"
+    "    if (b == -1 && a == INT_MIN) x25b_erro(linha, \"Estouro na divisao inteira\");\n"
+    "    return a / b;\n"
+    "}\n";
+
+/* ========== Funções auxiliares ========== */
+
+static void indentar(FILE *saida, int nivel) {
+    for (int i = 0; i < nivel; i++) {
+        fputs("    ", saida);
+    }
+}
+
+/* Variáveis recebem o prefixo v_ para não colidir com palavras de C */
+static void emitir_nome(ChaveId chave, FILE *saida) {
+    char nome[ID_MAX_CHARS + 1];
+    fprintf(saida, "v_%s", texto_id(chave, nome));
+}
+
+/* Literal real que o compilador C sempre lê como double */
+static void emitir_real(double valor, FILE *saida) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.17g", valor);
+    fputs(buf, saida);
+    if (strpbrk(buf, ".eEn") == NULL) {
+        fputs(".0", saida);
+    }
+}
+
+static void emitir_cadeia(const char *cadeia, FILE *saida) {
+    fputc('"', saida);
+    for (const char *p = cadeia; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', saida);
+        }
+        fputc(*p, saida);
+    }
+    fputc('"', saida);
+}
+
+static const char *op_c_relacional(OpRelacional op) {
+    switch (op) {
+        case REL_MAQ: return ">";
+        case REL_MAI: return ">=";
+        case REL_MEQ: return "<";
+        case REL_MEI: return "<=";
+        case REL_IGU: return "==";
+        case REL_DIF: return "!=";
+    }
+    return "?";
+}
+
+/* ========== Expressões ========== */
+
+static void emitir_expressao(NoExpr *expr, FILE *saida);
+
+static void emitir_var(NoVar *var, FILE *saida) {
+    emitir_nome(var->chave, saida);
+    if (var->indice != NULL && var->limite == LIMITE_SEGURO) {
+        /* Índice provado em 1..tamanho: sem verificação */
+        fputs("[(", saida);
+        emitir_expressao(var->indice, saida);
+        fputs(") - 1]", saida);
+    } else if (var->indice != NULL) {
+        fputs("[x25b_indice(", saida);
+        emitir_expressao(var->indice, saida);
+        char nome[ID_MAX_CHARS + 1];
+        fprintf(saida, ", %d, \"%s\", %d)]", var->simbolo->tamanho_array,
+                texto_id(var->chave, nome), var->linha);
+    }
+}
+
+static void emitir_expressao(NoExpr *expr, FILE *saida) {
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+            if (expr->dado.const_int == INT_MIN) {
+                fputs("(-2147483647 - 1)", saida);  /* Sem sufixo, 2147483648 seria long */
+            } else {
+                fprintf(saida, "%d", expr->dado.const_int);
+            }
+            break;
+
+        case EXPR_CONST_REAL:
+            emitir_real(expr->dado.const_real, saida);
+            break;
+
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            emitir_var(expr->dado.var, saida);
+            break;
+
+        case EXPR_ARITMETICA:
+            if (expr->tipo_dado != TIPO_REAL) {
+                /* Aritmética inteira pelo runtime: int em C não pode estourar */
+                static const char *funcoes[] = { "x25b_soma", "x25b_sub", "x25b_mult", "x25b_div" };
+                fprintf(saida, "%s(", funcoes[expr->dado.aritmetica.op]);
+                emitir_expressao(expr->dado.aritmetica.esq, saida);
+                fputs(", ", saida);
+                emitir_expressao(expr->dado.aritmetica.dir, saida);
+                if (expr->dado.aritmetica.op == ARIT_DIV) {
+                    fprintf(saida, ", %d", expr->linha);
+                }
+                fputc(')', saida);
+            } else {
+                static const char *ops[] = { "+", "-", "*", "/" };
+                fputc('(', saida);
+                emitir_expressao(expr->dado.aritmetica.esq, saida);
+                fprintf(saida, " %s ", ops[expr->dado.aritmetica.op]);
+                emitir_expressao(expr->dado.aritmetica.dir, saida);
+                fputc(')', saida);
+            }
+            break;
+
+        case EXPR_RELACIONAL:
+            fputc('(', saida);
+            emitir_expressao(expr->dado.relacional.esq, saida);
+            fprintf(saida, " %s ", op_c_relacional(expr->dado.relacional.op));
+            emitir_expressao(expr->dado.relacional.dir, saida);
+            fputc(')', saida);
+            break;
+
+        case EXPR_LOGICA:
+            fputc('(', saida);
+            emitir_expressao(expr->dado.logica.esq, saida);
+            fputs(expr->dado.logica.op == LOG_E ? " && " : " || ", saida);
+            emitir_expressao(expr->dado.logica.dir, saida);
+            fputc(')', saida);
+            break;
+
+        case EXPR_NAO:
+            fputs("!(", saida);
+            emitir_expressao(expr->dado.negacao, saida);
+            fputc(')', saida);
+            break;
+
+        case EXPR_NEG:
+            /* O operando pode ser INTEIRO num nó REAL: converte antes */
+            fputs(expr->tipo_dado == TIPO_REAL ? "(-(double)" : "x25b_neg(", saida);
+            emitir_expressao(expr->dado.negacao, saida);
+            fputc(')', saida);
+            break;
+    }
+}
+
+/* ========== Comandos ========== */
+
+static int elemento_real(EntradaSimbolo *s) {
+    return s->tipo == TIPO_REAL || s->tipo == TIPO_LISTAREAL;
+}
+
+static void emitir_comandos(NoCmd *cmd, int nivel, FILE *saida) {
+    while (cmd != NULL) {
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                {
+                    NoVar *var = cmd->dado.atrib.var;
+                    indentar(saida, nivel);
+                    emitir_var(var, saida);
+                    /* REAL atribuído a INTEIRO é truncado, como no --run */
+                    if (!elemento_real(var->simbolo) &&
+                        cmd->dado.atrib.expr->tipo_dado == TIPO_REAL) {
+                        fputs(" = (int)", saida);
+                    } else {
+                        fputs(" = ", saida);
+                    }
+                    emitir_expressao(cmd->dado.atrib.expr, saida);
+                    fputs(";\n", saida);
+                }
+                break;
+
+            case CMD_LEIA:
+                {
+                    ListaVar *v = cmd->dado.leia;
+                    while (v != NULL) {
+                        indentar(saida, nivel);
+                        emitir_var(v->var, saida);
+                        fprintf(saida, " = %s(%d);\n",
+                                elemento_real(v->var->simbolo) ? "x25b_leia_real" : "x25b_leia_inteiro",
+                                cmd->linha);
+                        v = v->prox;
+                    }
+                }
+                break;
+
+            case CMD_ESCREVA:
+                {
+                    ListaEscreva *e = cmd->dado.escreva;
+                    while (e != NULL) {
+                        indentar(saida, nivel);
+                        if (e->is_cadeia) {
+                            fputs("fputs(", saida);
+                            emitir_cadeia(e->item.cadeia, saida);
+                            fputs(", stdout);\n", saida);
+                        } else if (e->item.expr->tipo_dado == TIPO_REAL) {
+                            fputs("x25b_escreva_real(", saida);
+                            emitir_expressao(e->item.expr, saida);
+                            fputs(");\n", saida);
+                        } else {
+                            fputs("printf(\"%d\", ", saida);
+                            emitir_expressao(e->item.expr, saida);
+                            fputs(");\n", saida);
+                        }
+                        e = e->prox;
+                    }
+                    indentar(saida, nivel);
+                    fputs("putchar('\\n');\n", saida);
+                }
+                break;
+
+            case CMD_SE:
+                indentar(saida, nivel);
+                fputs("if (", saida);
+                emitir_expressao(cmd->dado.se.condicao, saida);
+                fputs(") {\n", saida);
+                emitir_comandos(cmd->dado.se.entao, nivel + 1, saida);
+                if (cmd->dado.se.senao != NULL) {
+                    indentar(saida, nivel);
+                    fputs("} else {\n", saida);
+                    emitir_comandos(cmd->dado.se.senao, nivel + 1, saida);
+                }
+                indentar(saida, nivel);
+                fputs("}\n", saida);
+                break;
+
+            case CMD_ENQUANTO:
+                indentar(saida, nivel);
+                fputs("while (", saida);
+                emitir_expressao(cmd->dado.enquanto.condicao, saida);
+                fputs(") {\n", saida);
+                emitir_comandos(cmd->dado.enquanto.corpo, nivel + 1, saida);
+                indentar(saida, nivel);
+                fputs("}\n", saida);
+                break;
+        }
+
+        cmd = cmd->prox;
+    }
+}
+
+/* ========== Programa ========== */
+
+void gerar_c(NoPrograma *prog, const char *origem, FILE *saida) {
+    fprintf(saida, "/* Gerado pelo compilador X25b a partir de %s */\n", origem);
+    fputs("#include <stdio.h>\n", saida);
+    fputs("#include <stdarg.h>\n", saida);
+    fputs("#include <limits.h>\n", saida);
+    fputs("#include <stdlib.h>\n", saida);
+    fputs("#include <string.h>\n\n", saida);
+    fputs(runtime_c, saida);
+    fputs("\nint main(void) {\n", saida);
+
+    /* Declarações: variáveis locais tipadas, arrays de tamanho fixo */
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox) {
+        int real = (d->tipo == TIPO_REAL || d->tipo == TIPO_LISTAREAL);
+        indentar(saida, 1);
+        fputs(real ? "double " : "int ", saida);
+        emitir_nome(d->chave, saida);
+        if (d->tamanho_array > 0) {
+            fprintf(saida, "[%d] = {0};\n", d->tamanho_array);
+        } else {
+            fputs(real ? " = 0.0;\n" : " = 0;\n", saida);
+        }
+    }
+    fputs("\n", saida);
+
+    emitir_comandos(prog->algoritmo, 1, saida);
+
+    fputs("\n    return 0;\n}\n", saida);
+}
@@ -0,0 +1,20 @@
+/*
+ * Geração de código C99 a partir da AST de X25b (opção --emit-c)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef GERADOR_C_H
+#define GERADOR_C_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/*
+ * Emite uma unidade de tradução C99 autocontida equivalente ao programa
+ * (já verificado pela análise semântica). O código gerado inclui um
+ * pequeno runtime de LEIA/ESCREVA com a convenção da vírgula decimal e
+ * se comporta como o modo --run, inclusive nos erros de execução.
+ */
+void gerar_c(NoPrograma *prog, const char *origem, FILE *saida);
+
+#endif /* GERADOR_C_H */
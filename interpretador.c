@@ -0,0 +1,395 @@
+/*
+ * Implementação do interpretador de programas X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "interpretador.h"
+#include "semantic.h"
+#include "runtime.h"
+#include "jit.h"
+
+/* Quadro de variáveis da execução corrente */
+static Valor *quadro;
+
+/* Contadores de comandos executados e de nós de expressão avaliados */
+static long comandos_executados;
+static long nos_avaliados;
+
+/* ========== JIT em camadas ========== */
+
+static long limiar_jit = JIT_DESLIGADO;
+static ResumoJit resumo;
+
+/*
+ * Voltas acumuladas de cada ENQUANTO e seu código, se já compilado, numa
+ * tabela hash aberta pelo endereço do comando (capacidade potência de 2)
+ */
+typedef struct LacoQuente {
+    NoCmd *cmd;
+    long voltas;
+    CodigoJit *codigo;
+    int falhou;             /* A compilação não foi possível: só interpreta */
+} LacoQuente;
+
+static LacoQuente *lacos;
+static int num_lacos;
+static int cap_lacos;
+
+static size_t hash_cmd(const NoCmd *cmd) {
+    size_t x = (size_t)cmd;
+    return (x >> 4) ^ (x >> 12);
+}
+
+static LacoQuente *buscar_laco(NoCmd *cmd) {
+    if (2 * (num_lacos + 1) > cap_lacos) {
+        LacoQuente *antigos = lacos;
+        int cap_antiga = cap_lacos;
+        cap_lacos = cap_antiga ? cap_antiga * 2 : 64;
+        lacos = (LacoQuente *)calloc((size_t)cap_lacos, sizeof(LacoQuente));
+        if (lacos == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para o JIT\n");
+            exit(1);
+        }
+        for (int i = 0; i < cap_antiga; i++) {
+            if (antigos[i].cmd != NULL) {
+                size_t j = hash_cmd(antigos[i].cmd) & (size_t)(cap_lacos - 1);
+                while (lacos[j].cmd != NULL) {
+                    j = (j + 1) & (size_t)(cap_lacos - 1);
+                }
+                lacos[j] = antigos[i];
+            }
+        }
+        free(antigos);
+    }
+
+    size_t i = hash_cmd(cmd) & (size_t)(cap_lacos - 1);
+    while (lacos[i].cmd != NULL && lacos[i].cmd != cmd) {
+        i = (i + 1) & (size_t)(cap_lacos - 1);
+    }
+    if (lacos[i].cmd == NULL) {
+        lacos[i].cmd = cmd;
+        num_lacos++;
+    }
+    return &lacos[i];
+}
+
+/* Compila 'cmd' (com 'sequencia', e os seguintes), contando tempo e bytes */
+static CodigoJit *compilar_trecho(NoCmd *cmd, int sequencia) {
+    struct timespec ini, fim;
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+    CodigoJit *codigo = compilar_jit(cmd, sequencia);
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    resumo.ms_compilacao += (fim.tv_sec - ini.tv_sec) * 1e3 + (fim.tv_nsec - ini.tv_nsec) / 1e6;
+    if (codigo != NULL) {
+        resumo.trechos++;
+        resumo.bytes += tamanho_jit(codigo);
+    }
+    return codigo;
+}
+
+static int avaliar_inteiro(NoExpr *expr);
+static double avaliar_real(NoExpr *expr);
+
+/* ========== Acesso a variáveis ========== */
+
+/* Tipo dos elementos armazenados por um símbolo */
+static int simbolo_real(EntradaSimbolo *s) {
+    return s->tipo == TIPO_REAL || s->tipo == TIPO_LISTAREAL;
+}
+
+/* Endereço da posição do quadro referenciada por 'var' */
+static Valor *celula(NoVar *var) {
+    EntradaSimbolo *s = var->simbolo;
+
+    if (var->indice == NULL) {
+        return &quadro[s->slot];
+    }
+
+    /* Arrays são indexados de 1 a tamanho_array (já provado, se seguro) */
+    int i = avaliar_inteiro(var->indice);
+    if (var->limite != LIMITE_SEGURO && (i < 1 || i > s->tamanho_array)) {
+        char nome[ID_MAX_CHARS + 1];
+        erro_execucao(var->linha, "Indice %d fora dos limites de '%s' (1..%d)",
+                      i, texto_id(var->chave, nome), s->tamanho_array);
+    }
+    return &quadro[s->slot + i - 1];
+}
+
+/* ========== Avaliação de expressões ========== */
+
+static int comparar_inteiros(OpRelacional op, int a, int b) {
+    switch (op) {
+        case REL_MAQ: return a > b;
+        case REL_MAI: return a >= b;
+        case REL_MEQ: return a < b;
+        case REL_MEI: return a <= b;
+        case REL_IGU: return a == b;
+        case REL_DIF: return a != b;
+    }
+    return 0;
+}
+
+static int comparar_reais(OpRelacional op, double a, double b) {
+    switch (op) {
+        case REL_MAQ: return a > b;
+        case REL_MAI: return a >= b;
+        case REL_MEQ: return a < b;
+        case REL_MEI: return a <= b;
+        case REL_IGU: return a == b;
+        case REL_DIF: return a != b;
+    }
+    return 0;
+}
+
+static int avaliar_inteiro(NoExpr *expr) {
+    /* Expressões reais usadas em contexto inteiro são truncadas */
+    if (expr->tipo_dado == TIPO_REAL) {
+        return (int)avaliar_real(expr);
+    }
+
+    nos_avaliados++;
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+            return expr->dado.const_int;
+
+        case EXPR_CONST_REAL:
+            return (int)expr->dado.const_real;
+
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            return celula(expr->dado.var)->i;
+
+        case EXPR_ARITMETICA:
+            {
+                int a = avaliar_inteiro(expr->dado.aritmetica.esq);
+                int b = avaliar_inteiro(expr->dado.aritmetica.dir);
+                switch (expr->dado.aritmetica.op) {
+                    case ARIT_SOMA: return somar_inteiros(a, b);
+                    case ARIT_SUB: return subtrair_inteiros(a, b);
+                    case ARIT_MULT: return multiplicar_inteiros(a, b);
+                    case ARIT_DIV: return dividir_inteiros(a, b, expr->linha);
+                }
+                return 0;
+            }
+
+        case EXPR_RELACIONAL:
+            {
+                NoExpr *esq = expr->dado.relacional.esq;
+                NoExpr *dir = expr->dado.relacional.dir;
+                if (esq->tipo_dado == TIPO_REAL || dir->tipo_dado == TIPO_REAL) {
+                    return comparar_reais(expr->dado.relacional.op,
+                                          avaliar_real(esq), avaliar_real(dir));
+                }
+                return comparar_inteiros(expr->dado.relacional.op,
+                                         avaliar_inteiro(esq), avaliar_inteiro(dir));
+            }
+
+        case EXPR_LOGICA:
+            if (expr->dado.logica.op == LOG_E) {
+                return avaliar_inteiro(expr->dado.logica.esq) &&
+                       avaliar_inteiro(expr->dado.logica.dir);
+            }
+            return avaliar_inteiro(expr->dado.logica.esq) ||
+                   avaliar_inteiro(expr->dado.logica.dir);
+
+        case EXPR_NAO:
+            return !avaliar_inteiro(expr->dado.negacao);
+
+        case EXPR_NEG:
+            return negar_inteiro(avaliar_inteiro(expr->dado.negacao));
+    }
+
+    return 0;
+}
+
+static double avaliar_real(NoExpr *expr) {
+    /* Promoção implícita de INTEIRO para REAL */
+    if (expr->tipo_dado != TIPO_REAL) {
+        return (double)avaliar_inteiro(expr);
+    }
+
+    nos_avaliados++;
+    switch (expr->tipo) {
+        case EXPR_CONST_REAL:
+            return expr->dado.const_real;
+
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            return celula(expr->dado.var)->r;
+
+        case EXPR_ARITMETICA:
+            {
+                double a = avaliar_real(expr->dado.aritmetica.esq);
+                double b = avaliar_real(expr->dado.aritmetica.dir);
+                switch (expr->dado.aritmetica.op) {
+                    case ARIT_SOMA: return a + b;
+                    case ARIT_SUB: return a - b;
+                    case ARIT_MULT: return a * b;
+                    case ARIT_DIV: return a / b;
+                }
+                return 0.0;
+            }
+
+        case EXPR_NEG:
+            return -avaliar_real(expr->dado.negacao);
+
+        default:
+            return (double)avaliar_inteiro(expr);
+    }
+}
+
+/* ========== Execução de comandos ========== */
+
+static void atribuir(NoVar *var, NoExpr *expr) {
+    if (simbolo_real(var->simbolo)) {
+        double valor = avaliar_real(expr);
+        celula(var)->r = valor;
+    } else {
+        int valor = avaliar_inteiro(expr);
+        celula(var)->i = valor;
+    }
+}
+
+static void executar_comandos(NoCmd *cmd) {
+    while (cmd != NULL) {
+        comandos_executados++;
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                atribuir(cmd->dado.atrib.var, cmd->dado.atrib.expr);
+                break;
+
+            case CMD_LEIA:
+                {
+                    ListaVar *v = cmd->dado.leia;
+                    while (v != NULL) {
+                        if (simbolo_real(v->var->simbolo)) {
+                            double valor = ler_real(cmd->linha);
+                            celula(v->var)->r = valor;
+                        } else {
+                            int valor = ler_inteiro(cmd->linha);
+                            celula(v->var)->i = valor;
+                        }
+                        v = v->prox;
+                    }
+                }
+                break;
+
+            case CMD_ESCREVA:
+                {
+                    ListaEscreva *e = cmd->dado.escreva;
+                    while (e != NULL) {
+                        if (e->is_cadeia) {
+                            escrever_cadeia(e->item.cadeia);
+                        } else if (e->item.expr->tipo_dado == TIPO_REAL) {
+                            escrever_real(avaliar_real(e->item.expr));
+                        } else {
+                            escrever_inteiro(avaliar_inteiro(e->item.expr));
+                        }
+                        e = e->prox;
+                    }
+                    escrever_fim_linha();
+                }
+                break;
+
+            case CMD_SE:
+                if (avaliar_inteiro(cmd->dado.se.condicao)) {
+                    executar_comandos(cmd->dado.se.entao);
+                } else {
+                    executar_comandos(cmd->dado.se.senao);
+                }
+                break;
+
+            case CMD_ENQUANTO:
+                {
+                    /* As voltas ficam num contador local: a tabela pode crescer no corpo */
+                    long voltas = 0;
+                    int contar = 0;
+                    if (limiar_jit > 0) {
+                        LacoQuente *laco = buscar_laco(cmd);
+                        if (laco->codigo != NULL) {
+                            executar_jit(laco->codigo, quadro);
+                            break;
+                        }
+                        voltas = laco->voltas;
+                        contar = !laco->falhou;
+                    }
+                    while (avaliar_inteiro(cmd->dado.enquanto.condicao)) {
+                        executar_comandos(cmd->dado.enquanto.corpo);
+
+                        /* Laço quente: o código começa pelo teste, então continua daqui */
+                        if (contar && ++voltas >= limiar_jit) {
+                            LacoQuente *laco = buscar_laco(cmd);
+                            laco->codigo = compilar_trecho(cmd, 0);
+                            laco->falhou = laco->codigo == NULL;
+                            contar = 0;
+                            if (laco->codigo != NULL) {
+                                executar_jit(laco->codigo, quadro);
+                                break;
+                            }
+                        }
+                    }
+                    if (limiar_jit > 0) {
+                        buscar_laco(cmd)->voltas = voltas;
+                    }
+                }
+                break;
+        }
+
+        cmd = cmd->prox;
+    }
+}
+
+/* ========== Execução do programa ========== */
+
+long executar_programa(NoPrograma *prog) {
+    int tamanho = prog->tamanho_quadro;
+
+    /* Variáveis começam zeradas */
+    quadro = (Valor *)calloc(tamanho > 0 ? tamanho : 1, sizeof(Valor));
+    if (quadro == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para o quadro de variaveis\n");
+        return 0;
+    }
+
+    comandos_executados = 0;
+    nos_avaliados = 0;
+    resumo.trechos = 0;
+    resumo.bytes = 0;
+    resumo.ms_compilacao = 0.0;
+
+    CodigoJit *codigo = limiar_jit == JIT_PROGRAMA ? compilar_trecho(prog->algoritmo, 1) : NULL;
+    if (codigo != NULL) {
+        executar_jit(codigo, quadro);
+        liberar_jit(codigo);
+    } else {
+        executar_comandos(prog->algoritmo);
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < cap_lacos; i++) {
+        liberar_jit(lacos[i].codigo);
+    }
+    free(lacos);
+    lacos = NULL;
+    num_lacos = cap_lacos = 0;
+
+    free(quadro);
+    quadro = NULL;
+    return comandos_executados;
+}
+
+long expressoes_avaliadas(void) {
+    return nos_avaliados;
+}
+
+void configurar_jit(long limiar) {
+    limiar_jit = limiar;
+}
+
+void resumo_jit(ResumoJit *r) {
+    *r = resumo;
+}
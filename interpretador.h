@@ -0,0 +1,55 @@
+/*
+ * Interpretador de programas X25b (modo --run)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef INTERPRETADOR_H
+#define INTERPRETADOR_H
+
+#include "ast.h"
+#include "runtime.h"
+
+/*
+ * Executa um programa já verificado pela análise semântica. As variáveis
+ * vivem em um quadro plano indexado pelo slot de cada símbolo; nenhum
+ * nome é buscado durante a execução. Retorna o número de comandos
+ * executados.
+ */
+long executar_programa(NoPrograma *prog);
+
+/*
+ * Nós de expressão avaliados na última execução (cada nó conta uma vez
+ * por avaliação), para comparar o trabalho antes e depois de otimizar
+ */
+long expressoes_avaliadas(void);
+
+/* ========== Compilação em tempo de execução (jit.h) ========== */
+
+/* Sem JIT, só interpreta (padrão) */
+#define JIT_DESLIGADO 0
+
+/* Compila o programa inteiro antes de executar */
+#define JIT_PROGRAMA -1
+
+/* Voltas de um ENQUANTO antes de compilá-lo, no modo em camadas */
+#define JIT_LIMIAR_PADRAO 1000
+
+/*
+ * Escolhe como executar_programa usa o JIT: JIT_DESLIGADO, JIT_PROGRAMA
+ * ou, com 'limiar' > 0, em camadas: interpreta, e um ENQUANTO que
+ * acumula 'limiar' voltas é compilado e continua em código de máquina
+ * (o quadro é o mesmo); nas próximas vezes, já entra compilado. Se a
+ * compilação não for possível, segue interpretando.
+ */
+void configurar_jit(long limiar);
+
+/* Números do JIT na última execução */
+typedef struct ResumoJit {
+    int trechos;            /* Trechos compilados (o programa ou laços) */
+    size_t bytes;           /* Código de máquina gerado */
+    double ms_compilacao;   /* Tempo total de compilação */
+} ResumoJit;
+
+void resumo_jit(ResumoJit *resumo);
+
+#endif /* INTERPRETADOR_H */
@@ -0,0 +1,906 @@
+/*
+ * Implementação da análise de intervalos dos índices de listas
+ * Avaliação Parcial 2 - Compiladores
+ *
+ * Interpretação abstrata sobre o grafo de fluxo (fluxo.h): cada variável
+ * acompanhada tem um intervalo [min, max] no início e no fim de cada
+ * bloco, e todas começam em 0 (os executores zeram o quadro). INTEIRO dá
+ * a volta em 32 bits, então uma operação cujo resultado pode sair da
+ * faixa de int dá o intervalo completo.
+ *
+ * As condições restringem o estado em cada aresta: na aresta verdadeira
+ * de "i .MEI. n", i.max <= n.max e n.min >= i.min; .E. verdadeiro e .OU.
+ * falso restringem pelos dois operandos. Nos cabeçalhos de laços, depois
+ * de ATRASO_ALARGAMENTO atualizações, um limite que ainda cresce vai
+ * direto ao extremo (alargamento), o que garante o fim da iteração; as
+ * passadas de estreitamento recuperam em seguida o que as condições
+ * permitem, como o i <= n do corpo.
+ *
+ * O operando direito de .E./.OU. pode não ser avaliado (o interpretador
+ * e o C gerado param no esquerdo), então um acesso ali nunca é dado como
+ * fora dos limites.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "intervalos.h"
+#include "fluxo.h"
+#include "pilha.h"
+#include "semantic.h"
+#include "contexto.h"
+
+/* Atualizações do cabeçalho de um laço antes de alargar */
+#define ATRASO_ALARGAMENTO 2
+
+/* Passadas de estreitamento após o ponto fixo */
+#define PASSADAS_ESTREITAMENTO 2
+
+/* Acima disso (variáveis x blocos), os acessos ficam todos desconhecidos */
+#define MAX_INTERVALOS (1L << 22)
+
+static void *zerado(size_t n, size_t tam) {
+    void *p = calloc(n > 0 ? n : 1, tam);
+    if (p == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a analise de intervalos\n");
+        exit(1);
+    }
+    return p;
+}
+
+static double ms_desde(const struct timespec *ini) {
+    struct timespec fim;
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    return (fim.tv_sec - ini->tv_sec) * 1e3 + (fim.tv_nsec - ini->tv_nsec) / 1e6;
+}
+
+/* ========== Intervalos ========== */
+
+typedef struct {
+    int min;
+    int max;
+} Intervalo;
+
+static const Intervalo COMPLETO = {INT_MIN, INT_MAX};
+
+/* Resultado calculado em 64 bits: fora da faixa de int, pode ser qualquer valor */
+static Intervalo faixa(long long min, long long max) {
+    if (min < INT_MIN || max > INT_MAX) {
+        return COMPLETO;
+    }
+    Intervalo r = {(int)min, (int)max};
+    return r;
+}
+
+/*
+ * Divisão truncada: com o sinal do divisor fixo, o quociente é monótono
+ * em cada operando, então os extremos estão nos cantos de cada lado do
+ * zero. Um divisor sempre 0 não produz valor (a divisão falha).
+ */
+static Intervalo dividir(Intervalo a, Intervalo b) {
+    long long min = LLONG_MAX, max = LLONG_MIN;
+    long long lados[2][2] = {
+        {b.min, b.max < -1 ? b.max : -1},
+        {b.min > 1 ? b.min : 1, b.max}
+    };
+
+    for (int k = 0; k < 2; k++) {
+        if (lados[k][0] > lados[k][1]) continue;
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) {
+                long long q = (long long)(i == 0 ? a.min : a.max) / lados[k][j];
+                if (q < min) min = q;
+                if (q > max) max = q;
+            }
+        }
+    }
+    return min > max ? COMPLETO : faixa(min, max);
+}
+
+static Intervalo operar(OpAritmetico op, Intervalo a, Intervalo b) {
+    switch (op) {
+        case ARIT_SOMA:
+            return faixa((long long)a.min + b.min, (long long)a.max + b.max);
+        case ARIT_SUB:
+            return faixa((long long)a.min - b.max, (long long)a.max - b.min);
+        case ARIT_MULT:
+            {
+                long long p[4] = {(long long)a.min * b.min, (long long)a.min * b.max,
+                                  (long long)a.max * b.min, (long long)a.max * b.max};
+                long long min = p[0], max = p[0];
+                for (int k = 1; k < 4; k++) {
+                    if (p[k] < min) min = p[k];
+                    if (p[k] > max) max = p[k];
+                }
+                return faixa(min, max);
+            }
+        case ARIT_DIV:
+            return dividir(a, b);
+    }
+    return COMPLETO;
+}
+
+static void juntar(Intervalo *destino, const Intervalo *outro, int n) {
+    for (int i = 0; i < n; i++) {
+        if (outro[i].min < destino[i].min) destino[i].min = outro[i].min;
+        if (outro[i].max > destino[i].max) destino[i].max = outro[i].max;
+    }
+}
+
+/*
+ * Alargamento no cabeçalho de um laço: 'novo' já contém 'anterior', e
+ * um limite que cresceu vai ao extremo, mas só se foi a volta do laço
+ * ('volta') que o levou além do que chega de fora ('fora'). Variáveis
+ * que o laço não altera ficam com o valor de fora, que os laços
+ * externos já limitam.
+ */
+static void alargar(const Intervalo *anterior, Intervalo *novo, const Intervalo *fora,
+                    const Intervalo *volta, int n) {
+    for (int i = 0; i < n; i++) {
+        if (novo[i].min < anterior[i].min && volta[i].min < fora[i].min) novo[i].min = INT_MIN;
+        if (novo[i].max > anterior[i].max && volta[i].max > fora[i].max) novo[i].max = INT_MAX;
+    }
+}
+
+/* ========== Estado da análise ========== */
+
+typedef struct {
+    ContextoCompilacao *ctx;
+    const GrafoFluxo *g;
+
+    /* Variáveis acompanhadas: as INTEIRO que influem em algum índice */
+    int *posicao;               /* Símbolo -> posição no estado, ou -1 */
+    int num;
+
+    Intervalo *entrada;         /* 'num' intervalos por bloco */
+    Intervalo *saida;           /* No fim do bloco, antes da condição */
+    char *alcancado;            /* O bloco tem estado (caminho viável) */
+    int *atualizacoes;
+    Intervalo *trabalho;
+    Intervalo *aresta;
+    Intervalo *volta;
+
+    Pilha quadros;
+    Pilha valores;
+    Pilha condicoes;
+    long acessos;
+
+    int classificar;            /* Última passada: marca os acessos */
+    int sem_estado;             /* ... de um bloco sem estado calculado */
+} EstadoIntervalos;
+
+static Intervalo *estado_bloco(const EstadoIntervalos *e, Intervalo *base, int bloco) {
+    return base + (size_t)bloco * e->num;
+}
+
+static int numero_simbolo(const EstadoIntervalos *e, const NoVar *var) {
+    return (int)(var->simbolo - e->ctx->tabela.simbolos);
+}
+
+/* Posição de uma variável simples no estado (-1 se não acompanhada) */
+static int acompanhada(const EstadoIntervalos *e, const NoExpr *expr) {
+    if (expr->tipo != EXPR_VAR || expr->dado.var->indice != NULL) {
+        return -1;
+    }
+    return e->posicao[numero_simbolo(e, expr->dado.var)];
+}
+
+static NoExpr *condicao_desvio(const NoCmd *desvio) {
+    return desvio->tipo == CMD_SE ? desvio->dado.se.condicao : desvio->dado.enquanto.condicao;
+}
+
+/* ========== Variáveis acompanhadas ========== */
+
+/*
+ * Uma variável entra no estado se aparece num índice, ou se o valor de
+ * uma que entrou depende dela: por atribuição (x := y + 1) ou por
+ * comparação direta (i .MEI. n restringe i por n, e n por i). As demais
+ * ficam com o intervalo completo sem ocupar espaço em cada bloco.
+ */
+typedef struct {
+    int destino;
+    int origem;
+} Dependencia;
+
+typedef struct {
+    NoExpr *expr;
+    int destino;                /* Símbolo cujo valor depende deste (-1 = nenhum) */
+    int sob_indice;
+} QuadroColeta;
+
+typedef struct {
+    EstadoIntervalos *e;
+    char *relevante;
+    Pilha fila;
+    Pilha dependencias;
+    Pilha quadros;
+} Coleta;
+
+/* Número do símbolo de uma variável INTEIRO simples, ou -1 */
+static int candidata(const EstadoIntervalos *e, const NoExpr *expr) {
+    if (expr->tipo != EXPR_VAR || expr->dado.var->simbolo->tipo != TIPO_INTEIRO) {
+        return -1;
+    }
+    return numero_simbolo(e, expr->dado.var);
+}
+
+static void tornar_relevante(Coleta *c, int simbolo) {
+    if (!c->relevante[simbolo]) {
+        c->relevante[simbolo] = 1;
+        *(int *)pilha_empilhar(&c->fila) = simbolo;
+    }
+}
+
+static void empilhar_coleta(Pilha *pilha, NoExpr *expr, int destino, int sob_indice) {
+    QuadroColeta *q = (QuadroColeta *)pilha_empilhar(pilha);
+    q->expr = expr;
+    q->destino = destino;
+    q->sob_indice = sob_indice;
+}
+
+static void coletar(Coleta *c, NoExpr *raiz, int destino, int sob_indice) {
+    Pilha *pilha = &c->quadros;
+    QuadroColeta *q;
+
+    empilhar_coleta(pilha, raiz, destino, sob_indice);
+    while ((q = (QuadroColeta *)pilha_topo(pilha)) != NULL) {
+        QuadroColeta atual = *q;
+        NoExpr *expr = atual.expr;
+        int d = expr->tipo_dado == TIPO_REAL ? -1 : atual.destino;
+        pilha_desempilhar(pilha);
+
+        switch (expr->tipo) {
+            case EXPR_VAR:
+                {
+                    int v = candidata(c->e, expr);
+                    if (v < 0) break;
+                    if (atual.sob_indice) {
+                        tornar_relevante(c, v);
+                    }
+                    if (d >= 0 && d != v) {
+                        Dependencia *dep = (Dependencia *)pilha_empilhar(&c->dependencias);
+                        dep->destino = d;
+                        dep->origem = v;
+                    }
+                }
+                break;
+            case EXPR_VAR_ARRAY:
+                c->e->acessos++;
+                empilhar_coleta(pilha, expr->dado.var->indice, -1, 1);
+                break;
+            case EXPR_ARITMETICA:
+                empilhar_coleta(pilha, expr->dado.aritmetica.esq, d, atual.sob_indice);
+                empilhar_coleta(pilha, expr->dado.aritmetica.dir, d, atual.sob_indice);
+                break;
+            case EXPR_NEG:
+                empilhar_coleta(pilha, expr->dado.negacao, d, atual.sob_indice);
+                break;
+            case EXPR_RELACIONAL:
+                {
+                    NoExpr *esq = expr->dado.relacional.esq, *dir = expr->dado.relacional.dir;
+                    int inteira = esq->tipo_dado != TIPO_REAL && dir->tipo_dado != TIPO_REAL;
+                    empilhar_coleta(pilha, esq, inteira ? candidata(c->e, dir) : -1, atual.sob_indice);
+                    empilhar_coleta(pilha, dir, inteira ? candidata(c->e, esq) : -1, atual.sob_indice);
+                }
+                break;
+            case EXPR_LOGICA:
+                empilhar_coleta(pilha, expr->dado.logica.esq, -1, atual.sob_indice);
+                empilhar_coleta(pilha, expr->dado.logica.dir, -1, atual.sob_indice);
+                break;
+            case EXPR_NAO:
+                empilhar_coleta(pilha, expr->dado.negacao, -1, atual.sob_indice);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void coletar_bloco(Coleta *c, const BlocoBasico *bloco) {
+    const GrafoFluxo *g = c->e->g;
+
+    for (int k = 0; k < bloco->num_comandos; k++) {
+        NoCmd *cmd = g->comandos[bloco->primeiro + k];
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                {
+                    NoVar *var = cmd->dado.atrib.var;
+                    if (var->indice != NULL) {
+                        c->e->acessos++;
+                        coletar(c, var->indice, -1, 1);
+                        coletar(c, cmd->dado.atrib.expr, -1, 0);
+                    } else {
+                        int alvo = var->simbolo->tipo == TIPO_INTEIRO ? numero_simbolo(c->e, var) : -1;
+                        coletar(c, cmd->dado.atrib.expr, alvo, 0);
+                    }
+                }
+                break;
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    if (v->var->indice != NULL) {
+                        c->e->acessos++;
+                        coletar(c, v->var->indice, -1, 1);
+                    }
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        coletar(c, item->item.expr, -1, 0);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (bloco->desvio != NULL) {
+        coletar(c, condicao_desvio(bloco->desvio), -1, 0);
+    }
+}
+
+/*
+ * Percorre o programa coletando os índices e as dependências e fecha o
+ * conjunto a partir das variáveis dos índices. Retorna o número de
+ * acessos a listas.
+ */
+static long escolher_variaveis(EstadoIntervalos *e) {
+    int simbolos = e->ctx->tabela.num_simbolos;
+    Coleta c;
+
+    c.e = e;
+    c.relevante = (char *)zerado((size_t)simbolos, 1);
+    pilha_iniciar(&c.fila, sizeof(int));
+    pilha_iniciar(&c.dependencias, sizeof(Dependencia));
+    pilha_iniciar(&c.quadros, sizeof(QuadroColeta));
+    for (int b = 0; b < e->g->num_blocos; b++) {
+        coletar_bloco(&c, &e->g->blocos[b]);
+    }
+
+    /* Dependências agrupadas por destino (contagem) */
+    int *inicio = (int *)zerado((size_t)simbolos + 1, sizeof(int));
+    int *origens = (int *)zerado(c.dependencias.num, sizeof(int));
+    Dependencia *deps = (Dependencia *)c.dependencias.itens;
+    for (size_t k = 0; k < c.dependencias.num; k++) {
+        inicio[deps[k].destino + 1]++;
+    }
+    for (int i = 0; i < simbolos; i++) {
+        inicio[i + 1] += inicio[i];
+    }
+    int *proxima = (int *)zerado((size_t)simbolos, sizeof(int));
+    memcpy(proxima, inicio, (size_t)simbolos * sizeof(int));
+    for (size_t k = 0; k < c.dependencias.num; k++) {
+        origens[proxima[deps[k].destino]++] = deps[k].origem;
+    }
+
+    int *topo;
+    while ((topo = (int *)pilha_topo(&c.fila)) != NULL) {
+        int v = *topo;
+        pilha_desempilhar(&c.fila);
+        for (int k = inicio[v]; k < inicio[v + 1]; k++) {
+            tornar_relevante(&c, origens[k]);
+        }
+    }
+
+    e->posicao = (int *)zerado((size_t)simbolos, sizeof(int));
+    e->num = 0;
+    for (int i = 0; i < simbolos; i++) {
+        e->posicao[i] = c.relevante[i] ? e->num++ : -1;
+    }
+
+    free(proxima);
+    free(origens);
+    free(inicio);
+    pilha_liberar(&c.quadros);
+    pilha_liberar(&c.dependencias);
+    pilha_liberar(&c.fila);
+    free(c.relevante);
+    return e->acessos;
+}
+
+/* ========== Avaliação abstrata ========== */
+
+/* Marca um acesso com o intervalo do seu índice (só na última passada) */
+static void classificar(EstadoIntervalos *e, NoVar *var, Intervalo indice, int condicional) {
+    ContextoCompilacao *ctx = e->ctx;
+    int tamanho = var->simbolo->tamanho_array;
+
+    if (!e->classificar) return;
+    ctx->acessos_lista++;
+    var->limite = LIMITE_DESCONHECIDO;
+    if (e->sem_estado) return;
+
+    if (indice.min >= 1 && indice.max <= tamanho) {
+        var->limite = LIMITE_SEGURO;
+        ctx->acessos_seguros++;
+    } else if (!condicional && (indice.max < 1 || indice.min > tamanho)) {
+        char nome[ID_MAX_CHARS + 1];
+        var->limite = LIMITE_FORA;
+        ctx->acessos_fora++;
+        if (indice.min == indice.max) {
+            erro_semantico(ctx, var->linha, var->coluna, "SEM011",
+                           "Indice %d fora dos limites de '%s' (1..%d)",
+                           indice.min, texto_id(var->chave, nome), tamanho);
+        } else {
+            erro_semantico(ctx, var->linha, var->coluna, "SEM011",
+                           "Indice de '%s' sempre fora dos limites (1..%d): entre %d e %d",
+                           texto_id(var->chave, nome), tamanho, indice.min, indice.max);
+        }
+    }
+}
+
+typedef struct {
+    NoExpr *expr;
+    int etapa;                  /* 0: empilhar os filhos; 1: combinar */
+    int condicional;            /* Dentro do operando direito de .E./.OU. */
+} QuadroAvaliacao;
+
+static int filhos(NoExpr *expr, NoExpr **f) {
+    switch (expr->tipo) {
+        case EXPR_VAR_ARRAY:
+            f[0] = expr->dado.var->indice;
+            return 1;
+        case EXPR_ARITMETICA:
+            f[0] = expr->dado.aritmetica.esq;
+            f[1] = expr->dado.aritmetica.dir;
+            return 2;
+        case EXPR_RELACIONAL:
+            f[0] = expr->dado.relacional.esq;
+            f[1] = expr->dado.relacional.dir;
+            return 2;
+        case EXPR_LOGICA:
+            f[0] = expr->dado.logica.esq;
+            f[1] = expr->dado.logica.dir;
+            return 2;
+        case EXPR_NAO:
+        case EXPR_NEG:
+            f[0] = expr->dado.negacao;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static Intervalo combinar(EstadoIntervalos *e, const Intervalo *estado, NoExpr *expr,
+                          const Intervalo *v, int condicional) {
+    if (expr->tipo == EXPR_VAR_ARRAY) {
+        classificar(e, expr->dado.var, v[0], condicional);
+        return COMPLETO;
+    }
+    if (expr->tipo_dado == TIPO_REAL) {
+        return COMPLETO;
+    }
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+            return faixa(expr->dado.const_int, expr->dado.const_int);
+        case EXPR_VAR:
+            {
+                int p = acompanhada(e, expr);
+                return p >= 0 ? estado[p] : COMPLETO;
+            }
+        case EXPR_ARITMETICA:
+            return operar(expr->dado.aritmetica.op, v[0], v[1]);
+        case EXPR_NEG:
+            return faixa(-(long long)v[0].max, -(long long)v[0].min);
+        case EXPR_RELACIONAL:
+        case EXPR_LOGICA:
+        case EXPR_NAO:
+            return faixa(0, 1);
+        default:
+            return COMPLETO;
+    }
+}
+
+/* Intervalo de 'raiz' em 'estado', sem recursão (pós-ordem) */
+static Intervalo avaliar(EstadoIntervalos *e, const Intervalo *estado, NoExpr *raiz, int condicional) {
+    QuadroAvaliacao *q = (QuadroAvaliacao *)pilha_empilhar(&e->quadros);
+    q->expr = raiz;
+    q->etapa = 0;
+    q->condicional = condicional;
+
+    while ((q = (QuadroAvaliacao *)pilha_topo(&e->quadros)) != NULL) {
+        NoExpr *expr = q->expr;
+        NoExpr *f[2];
+        int n = filhos(expr, f);
+        int cond = q->condicional;
+
+        if (q->etapa == 0) {
+            q->etapa = 1;
+            for (int k = n - 1; k >= 0; k--) {
+                QuadroAvaliacao *filho = (QuadroAvaliacao *)pilha_empilhar(&e->quadros);
+                filho->expr = f[k];
+                filho->etapa = 0;
+                filho->condicional = cond || (expr->tipo == EXPR_LOGICA && k == 1);
+            }
+            continue;
+        }
+
+        pilha_desempilhar(&e->quadros);
+        Intervalo v[2];
+        for (int k = n - 1; k >= 0; k--) {
+            v[k] = *(Intervalo *)pilha_topo(&e->valores);
+            pilha_desempilhar(&e->valores);
+        }
+        *(Intervalo *)pilha_empilhar(&e->valores) = combinar(e, estado, expr, v, cond);
+    }
+
+    Intervalo r = *(Intervalo *)pilha_topo(&e->valores);
+    pilha_desempilhar(&e->valores);
+    return r;
+}
+
+static void definir(EstadoIntervalos *e, Intervalo *estado, NoVar *var, Intervalo valor) {
+    int p = var->indice == NULL ? e->posicao[numero_simbolo(e, var)] : -1;
+    if (p >= 0) {
+        estado[p] = valor;
+    }
+}
+
+/*
+ * Executa os comandos do bloco sobre 'estado' e avalia a condição do
+ * desvio (que não altera o estado, mas pode conter acessos a listas)
+ */
+static void transferir(EstadoIntervalos *e, int b, Intervalo *estado) {
+    const BlocoBasico *bloco = &e->g->blocos[b];
+
+    for (int k = 0; k < bloco->num_comandos; k++) {
+        NoCmd *cmd = e->g->comandos[bloco->primeiro + k];
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                {
+                    NoVar *var = cmd->dado.atrib.var;
+                    Intervalo valor = avaliar(e, estado, cmd->dado.atrib.expr, 0);
+                    if (var->indice != NULL) {
+                        classificar(e, var, avaliar(e, estado, var->indice, 0), 0);
+                    } else {
+                        definir(e, estado, var, valor);
+                    }
+                }
+                break;
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    if (v->var->indice != NULL) {
+                        classificar(e, v->var, avaliar(e, estado, v->var->indice, 0), 0);
+                    } else {
+                        definir(e, estado, v->var, COMPLETO);
+                    }
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        avaliar(e, estado, item->item.expr, 0);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    if (bloco->desvio != NULL) {
+        avaliar(e, estado, condicao_desvio(bloco->desvio), 0);
+    }
+}
+
+/* ========== Condições ========== */
+
+static OpRelacional negar(OpRelacional op) {
+    switch (op) {
+        case REL_MAQ: return REL_MEI;
+        case REL_MAI: return REL_MEQ;
+        case REL_MEQ: return REL_MAI;
+        case REL_MEI: return REL_MAQ;
+        case REL_IGU: return REL_DIF;
+        case REL_DIF: return REL_IGU;
+    }
+    return op;
+}
+
+static long long maior(long long a, long long b) { return a > b ? a : b; }
+static long long menor(long long a, long long b) { return a < b ? a : b; }
+
+/*
+ * Restringe 'estado' a quando a comparação tem o valor 'verdadeira'.
+ * Os dois lados ficam restritos um pelo outro, mas só uma variável
+ * simples guarda a restrição. Retorna 0 se a comparação nunca tem esse
+ * valor.
+ */
+static int restringir_comparacao(EstadoIntervalos *e, Intervalo *estado, NoExpr *expr, int verdadeira) {
+    NoExpr *esq = expr->dado.relacional.esq, *dir = expr->dado.relacional.dir;
+    if (esq->tipo_dado == TIPO_REAL || dir->tipo_dado == TIPO_REAL) {
+        return 1;
+    }
+
+    OpRelacional op = verdadeira ? expr->dado.relacional.op : negar(expr->dado.relacional.op);
+    Intervalo a = avaliar(e, estado, esq, 0), b = avaliar(e, estado, dir, 0);
+    long long amin = a.min, amax = a.max, bmin = b.min, bmax = b.max;
+
+    switch (op) {
+        case REL_MEQ:
+            amax = menor(amax, bmax - 1);
+            bmin = maior(bmin, amin + 1);
+            break;
+        case REL_MEI:
+            amax = menor(amax, bmax);
+            bmin = maior(bmin, amin);
+            break;
+        case REL_MAQ:
+            amin = maior(amin, bmin + 1);
+            bmax = menor(bmax, amax - 1);
+            break;
+        case REL_MAI:
+            amin = maior(amin, bmin);
+            bmax = menor(bmax, amax);
+            break;
+        case REL_IGU:
+            amin = bmin = maior(amin, bmin);
+            amax = bmax = menor(amax, bmax);
+            break;
+        case REL_DIF:
+            /* Só tira um extremo igual ao valor único do outro lado */
+            if (b.min == b.max) {
+                if (amin == b.min) amin++;
+                if (amax == b.min) amax--;
+            }
+            if (a.min == a.max) {
+                if (bmin == a.min) bmin++;
+                if (bmax == a.min) bmax--;
+            }
+            break;
+    }
+    if (amin > amax || bmin > bmax) {
+        return 0;
+    }
+
+    int p = acompanhada(e, esq), q = acompanhada(e, dir);
+    if (p >= 0) {
+        estado[p] = faixa(amin, amax);
+    }
+    if (q >= 0) {
+        estado[q] = faixa(bmin, bmax);
+    }
+    return 1;
+}
+
+typedef struct {
+    NoExpr *expr;
+    int verdadeira;
+} QuadroCondicao;
+
+/* Restringe 'estado' a quando 'cond' tem o valor 'verdadeira'; 0 se nunca tem */
+static int restringir(EstadoIntervalos *e, Intervalo *estado, NoExpr *cond, int verdadeira) {
+    QuadroCondicao *q = (QuadroCondicao *)pilha_empilhar(&e->condicoes);
+    int viavel = 1;
+
+    q->expr = cond;
+    q->verdadeira = verdadeira;
+    while ((q = (QuadroCondicao *)pilha_topo(&e->condicoes)) != NULL) {
+        NoExpr *expr = q->expr;
+        int v = q->verdadeira;
+        pilha_desempilhar(&e->condicoes);
+        if (!viavel) continue;
+
+        switch (expr->tipo) {
+            case EXPR_NAO:
+                q = (QuadroCondicao *)pilha_empilhar(&e->condicoes);
+                q->expr = expr->dado.negacao;
+                q->verdadeira = !v;
+                break;
+            case EXPR_LOGICA:
+                /* .E. verdadeiro e .OU. falso: valem os dois operandos */
+                if ((expr->dado.logica.op == LOG_E) == v) {
+                    q = (QuadroCondicao *)pilha_empilhar(&e->condicoes);
+                    q->expr = expr->dado.logica.esq;
+                    q->verdadeira = v;
+                    q = (QuadroCondicao *)pilha_empilhar(&e->condicoes);
+                    q->expr = expr->dado.logica.dir;
+                    q->verdadeira = v;
+                }
+                break;
+            case EXPR_RELACIONAL:
+                viavel = restringir_comparacao(e, estado, expr, v);
+                break;
+            default:
+                break;
+        }
+    }
+    return viavel;
+}
+
+/* ========== Resolução ========== */
+
+/*
+ * Estado no início de 'b': o encontro das arestas que chegam, cada uma
+ * restrita pela condição do predecessor. Com 'volta' não nulo, as
+ * arestas de volta de um laço (de um predecessor que não vem antes na
+ * pós-ordem reversa) se encontram ali, separadas. Retorna 1 se alguma
+ * aresta de fora é viável, mais 2 se alguma de volta é.
+ */
+static int calcular_entrada(EstadoIntervalos *e, int b, Intervalo *destino, Intervalo *volta) {
+    const GrafoFluxo *g = e->g;
+    const BlocoBasico *bloco = &g->blocos[b];
+    size_t bytes = (size_t)e->num * sizeof(Intervalo);
+    int viaveis = 0;
+
+    if (b == g->entrada) {
+        memset(destino, 0, bytes);
+        return 1;
+    }
+
+    for (int k = 0; k < bloco->num_pred; k++) {
+        int p = g->predecessores[bloco->primeiro_pred + k];
+        const BlocoBasico *pred = &g->blocos[p];
+        if (!e->alcancado[p]) continue;
+
+        memcpy(e->aresta, estado_bloco(e, e->saida, p), bytes);
+        if (pred->desvio != NULL &&
+            !restringir(e, e->aresta, condicao_desvio(pred->desvio), pred->sucessores[0] == b)) {
+            continue;
+        }
+        int lado = volta != NULL && pred->ordem >= bloco->ordem ? 2 : 1;
+        Intervalo *alvo = lado == 2 ? volta : destino;
+        if (viaveis & lado) {
+            juntar(alvo, e->aresta, e->num);
+        } else {
+            memcpy(alvo, e->aresta, bytes);
+            viaveis |= lado;
+        }
+    }
+    return viaveis;
+}
+
+/* Entrada já calculada em e->trabalho: guarda e aplica a transferência */
+static void atualizar_bloco(EstadoIntervalos *e, int b) {
+    size_t bytes = (size_t)e->num * sizeof(Intervalo);
+
+    memcpy(estado_bloco(e, e->entrada, b), e->trabalho, bytes);
+    e->alcancado[b] = 1;
+    transferir(e, b, e->trabalho);
+    memcpy(estado_bloco(e, e->saida, b), e->trabalho, bytes);
+}
+
+/*
+ * Iteração crescente por lista de trabalho na pós-ordem reversa (como
+ * em resolver_problema): nos cabeçalhos de laços o estado só cresce e,
+ * depois do atraso, é alargado. Em seguida, passadas decrescentes (sem
+ * alargamento) a partir do ponto fixo, que continuam corretas.
+ */
+static void resolver(EstadoIntervalos *e) {
+    const GrafoFluxo *g = e->g;
+    size_t bytes = (size_t)e->num * sizeof(Intervalo);
+    ListaTrabalho lista;
+
+    iniciar_lista_trabalho(&lista, g->num_blocos);
+    inserir_lista_trabalho(&lista, g->blocos[g->entrada].ordem, g->entrada);
+    while (lista.num > 0) {
+        int b = retirar_lista_trabalho(&lista);
+        const BlocoBasico *bloco = &g->blocos[b];
+        Intervalo *anterior = estado_bloco(e, e->entrada, b);
+
+        int cabecalho = bloco->laco == b;
+        int viaveis = calcular_entrada(e, b, e->trabalho, cabecalho ? e->volta : NULL);
+
+        if (viaveis == 0) continue;
+        if (viaveis == 2) {
+            memcpy(e->trabalho, e->volta, bytes);
+        } else if (viaveis == 3) {
+            /* e->aresta guarda o que chega de fora durante o encontro */
+            memcpy(e->aresta, e->trabalho, bytes);
+            juntar(e->trabalho, e->volta, e->num);
+        }
+        if (e->alcancado[b]) {
+            if (cabecalho) {
+                juntar(e->trabalho, anterior, e->num);
+                if (viaveis == 3 && ++e->atualizacoes[b] > ATRASO_ALARGAMENTO) {
+                    alargar(anterior, e->trabalho, e->aresta, e->volta, e->num);
+                }
+            }
+            if (memcmp(e->trabalho, anterior, bytes) == 0) continue;
+        }
+        atualizar_bloco(e, b);
+
+        for (int k = 0; k < 2; k++) {
+            int s = bloco->sucessores[k];
+            if (s >= 0 && g->blocos[s].ordem >= 0) {
+                inserir_lista_trabalho(&lista, g->blocos[s].ordem, s);
+            }
+        }
+    }
+    liberar_lista_trabalho(&lista);
+
+    for (int passada = 0; passada < PASSADAS_ESTREITAMENTO; passada++) {
+        for (int i = 0; i < g->num_alcancaveis; i++) {
+            int b = g->rpo[i];
+            if (!e->alcancado[b]) continue;
+            if (calcular_entrada(e, b, e->trabalho, NULL)) {
+                atualizar_bloco(e, b);
+            } else {
+                e->alcancado[b] = 0;
+            }
+        }
+    }
+}
+
+/* Última passada: cada acesso é avaliado uma vez, no estado do seu bloco */
+static void classificar_acessos(EstadoIntervalos *e, int com_estado) {
+    size_t bytes = (size_t)e->num * sizeof(Intervalo);
+
+    e->classificar = 1;
+    for (int b = 0; b < e->g->num_blocos; b++) {
+        e->sem_estado = !com_estado || !e->alcancado[b];
+        if (e->sem_estado) {
+            for (int i = 0; i < e->num; i++) {
+                e->trabalho[i] = COMPLETO;
+            }
+        } else {
+            memcpy(e->trabalho, estado_bloco(e, e->entrada, b), bytes);
+        }
+        transferir(e, b, e->trabalho);
+    }
+}
+
+/* ========== Verificação ========== */
+
+static int ha_listas(const ContextoCompilacao *ctx) {
+    for (int i = 0; i < ctx->tabela.num_simbolos; i++) {
+        if (ctx->tabela.simbolos[i].tamanho_array > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void verificar_limites(ContextoCompilacao *ctx, NoPrograma *prog) {
+    struct timespec ini;
+    GrafoFluxo g;
+    EstadoIntervalos e;
+
+    ctx->acessos_lista = ctx->acessos_seguros = ctx->acessos_fora = 0;
+    if (!ha_listas(ctx)) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+    construir_grafo(&g, prog->algoritmo);
+    memset(&e, 0, sizeof(e));
+    e.ctx = ctx;
+    e.g = &g;
+    pilha_iniciar(&e.quadros, sizeof(QuadroAvaliacao));
+    pilha_iniciar(&e.valores, sizeof(Intervalo));
+    pilha_iniciar(&e.condicoes, sizeof(QuadroCondicao));
+
+    if (escolher_variaveis(&e) > 0) {
+        int com_estado = (long)e.num * g.num_blocos <= MAX_INTERVALOS;
+        size_t total = com_estado ? (size_t)e.num * g.num_blocos : 0;
+
+        e.entrada = (Intervalo *)zerado(total, sizeof(Intervalo));
+        e.saida = (Intervalo *)zerado(total, sizeof(Intervalo));
+        e.alcancado = (char *)zerado((size_t)g.num_blocos, 1);
+        e.atualizacoes = (int *)zerado((size_t)g.num_blocos, sizeof(int));
+        e.trabalho = (Intervalo *)zerado((size_t)e.num, sizeof(Intervalo));
+        e.aresta = (Intervalo *)zerado((size_t)e.num, sizeof(Intervalo));
+        e.volta = (Intervalo *)zerado((size_t)e.num, sizeof(Intervalo));
+        if (com_estado) {
+            resolver(&e);
+        }
+        classificar_acessos(&e, com_estado);
+
+        free(e.entrada);
+        free(e.saida);
+        free(e.alcancado);
+        free(e.atualizacoes);
+        free(e.trabalho);
+        free(e.aresta);
+        free(e.volta);
+    }
+
+    free(e.posicao);
+    pilha_liberar(&e.quadros);
+    pilha_liberar(&e.valores);
+    pilha_liberar(&e.condicoes);
+    liberar_grafo(&g);
+    ctx->ms_limites = ms_desde(&ini);
+}
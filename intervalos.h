@@ -0,0 +1,24 @@
+/*
+ * Análise de intervalos dos índices de listas
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef INTERVALOS_H
+#define INTERVALOS_H
+
+#include "ast.h"
+
+/*
+ * Calcula, sobre o grafo de fluxo do ALGORITMO, um intervalo de valores
+ * para cada variável INTEIRO que influi em algum índice, seguindo as
+ * atribuições e as condições de SE e ENQUANTO (i .MEI. n limita i no
+ * corpo do laço). Cada acesso a lista recebe em NoVar->limite:
+ * LIMITE_SEGURO se o índice fica sempre em 1..tamanho, LIMITE_FORA se
+ * nunca fica (erro SEM011) ou LIMITE_DESCONHECIDO.
+ *
+ * Chamada pela análise semântica quando não houve erros; as contagens
+ * e o tempo ficam em ctx (acessos_lista, acessos_seguros, ...).
+ */
+void verificar_limites(ContextoCompilacao *ctx, NoPrograma *prog);
+
+#endif /* INTERVALOS_H */
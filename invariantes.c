@@ -0,0 +1,803 @@
+/*
+ * Implementação da movimentação de código invariante de laços
+ * Avaliação Parcial 2 - Compiladores
+ *
+ * Uma subexpressão de um ENQUANTO é invariante quando nenhuma variável
+ * que ela lê é alvo de ATRIB ou de LEIA dentro do laço (atribuir a um
+ * elemento altera o array inteiro). Cada subexpressão invariante maximal
+ * com algum operador ou acesso a array passa a ser calculada num
+ * temporário antes do laço mais externo em que continua invariante.
+ *
+ * O comportamento do --run é preservado. Avaliar uma expressão sem
+ * divisão inteira nem acesso a array não tem efeito algum, então ela
+ * pode ser antecipada de qualquer ponto do laço, mesmo que nunca fosse
+ * avaliada nele. As que podem interromper a execução (divisão por zero,
+ * índice fora dos limites) só saem do laço mais interno, e só quando a
+ * primeira volta as avaliaria antes de qualquer LEIA, ESCREVA, desvio ou
+ * outra avaliação que possa falhar; ficam então sob a condição do laço:
+ *
+ *     SE cond ENTAO
+ *         _t1 := k / d
+ *         ENQUANTO cond FACA ... FIMENQ
+ *     FIMSE
+ *
+ * Assim o erro, quando acontece, é o mesmo, na mesma linha (os nós
+ * movidos mantêm a posição) e depois das mesmas saídas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "invariantes.h"
+#include "semantic.h"
+#include "contexto.h"
+
+static void *realocar(void *p, size_t tam) {
+    void *novo = realloc(p, tam > 0 ? tam : 1);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a otimizacao de lacos\n");
+        exit(1);
+    }
+    return novo;
+}
+
+/* ========== Laços e definições ========== */
+
+/*
+ * Os comandos são numerados em pré-ordem (a ordem de PercursoComandos),
+ * então os de um laço, a começar pelo próprio ENQUANTO, ocupam o
+ * intervalo [inicio, fim) de posições.
+ */
+typedef struct LacoInvariante {
+    NoCmd *cmd;
+    NoCmd **lugar;          /* Campo que aponta para o ENQUANTO */
+    int cabeca;             /* 'lugar' é o início de uma sequência */
+    int inicio;
+    int fim;
+    int pai;                /* Laço que contém este (-1 se nenhum) */
+    int profundidade;       /* 1 no laço mais externo */
+    int direto;             /* Está no nível externo do corpo de 'pai' */
+
+    /*
+     * 1 enquanto a primeira volta do corpo, até o comando corrente, não
+     * fez nada visível nem avaliou algo que possa falhar
+     */
+    int prefixo;
+
+    /* Temporários calculados antes do laço: sem e com risco de falha */
+    NoCmd *antes;
+    NoCmd *fim_antes;
+    NoCmd *protegidos;
+    NoCmd *fim_protegidos;
+} LacoInvariante;
+
+/* Comando e o laço mais interno que o contém (o próprio, num ENQUANTO) */
+typedef struct ComandoLaco {
+    NoCmd *cmd;
+    int laco;
+    int direto;             /* Está no nível externo do corpo de 'laco' */
+} ComandoLaco;
+
+/* Informações de um nó de expressão, indexadas pela posição em pré-ordem */
+typedef struct InfoNo {
+    int nivel;              /* Laço mais profundo (1 = externo) que altera um operando; 0 se nenhum */
+    int tamanho;            /* Nós da subárvore */
+    unsigned char falha;    /* A subárvore pode interromper a execução */
+    unsigned char operacao; /* Não é uma constante nem uma variável simples */
+} InfoNo;
+
+/* Expressão movida para o temporário _tK */
+typedef struct Movimento {
+    NoCmd *atrib;           /* _tK := expressão, antes do laço */
+    NoVar *referencia;      /* _tK, no lugar da expressão */
+    int linha_laco;
+    int protegido;
+} Movimento;
+
+typedef struct EstadoInvariantes {
+    ContextoCompilacao *ctx;
+    int num_variaveis;
+
+    ComandoLaco *comandos;
+    int num_comandos;
+    int capacidade_comandos;
+
+    LacoInvariante *lacos;
+    int num_lacos;
+    int capacidade_lacos;
+
+    /* Posições das definições da variável v: pos_defs[inicio_defs[v] .. inicio_defs[v + 1]) */
+    int *inicio_defs;
+    int *pos_defs;
+
+    InfoNo *info;
+    int num_info;
+    int capacidade_info;
+
+    Movimento *movimentos;
+    int num_movimentos;
+    int capacidade_movimentos;
+} EstadoInvariantes;
+
+static int indice_variavel(const EstadoInvariantes *e, const NoVar *var) {
+    return (int)(var->simbolo - e->ctx->tabela.simbolos);
+}
+
+/* Quadro do percurso que numera os comandos: o resto de uma sequência */
+typedef struct {
+    NoCmd **lugar;
+    int laco;
+    int direto;
+    int cabeca;
+    int fechar;             /* >= 0: marca o fim do laço 'fechar' */
+} QuadroComando;
+
+static void empilhar_sequencia(Pilha *pilha, NoCmd **lugar, int laco, int direto, int cabeca) {
+    QuadroComando *q = (QuadroComando *)pilha_empilhar(pilha);
+    q->lugar = lugar;
+    q->laco = laco;
+    q->direto = direto;
+    q->cabeca = cabeca;
+    q->fechar = -1;
+}
+
+static void anotar_comando(EstadoInvariantes *e, NoCmd *cmd, int laco, int direto) {
+    if (e->num_comandos == e->capacidade_comandos) {
+        e->capacidade_comandos = e->capacidade_comandos > 0 ? 2 * e->capacidade_comandos : 64;
+        e->comandos = (ComandoLaco *)realocar(e->comandos,
+                                              e->capacidade_comandos * sizeof(ComandoLaco));
+    }
+    ComandoLaco *c = &e->comandos[e->num_comandos++];
+    c->cmd = cmd;
+    c->laco = laco;
+    c->direto = direto;
+}
+
+static int novo_laco(EstadoInvariantes *e, NoCmd *cmd, NoCmd **lugar, int cabeca, int pai, int direto) {
+    if (e->num_lacos == e->capacidade_lacos) {
+        e->capacidade_lacos = e->capacidade_lacos > 0 ? 2 * e->capacidade_lacos : 16;
+        e->lacos = (LacoInvariante *)realocar(e->lacos,
+                                              e->capacidade_lacos * sizeof(LacoInvariante));
+    }
+    LacoInvariante *l = &e->lacos[e->num_lacos];
+    memset(l, 0, sizeof(*l));
+    l->cmd = cmd;
+    l->lugar = lugar;
+    l->cabeca = cabeca;
+    l->inicio = e->num_comandos;
+    l->pai = pai;
+    l->profundidade = pai >= 0 ? e->lacos[pai].profundidade + 1 : 1;
+    l->direto = direto;
+    l->prefixo = 1;
+    return e->num_lacos++;
+}
+
+/* Definições (variável, posição), agrupadas depois por variável */
+typedef struct {
+    int variavel;
+    int posicao;
+} Definicao;
+
+static void anotar_definicao(Definicao **defs, int *num, int *capacidade, int variavel, int posicao) {
+    if (*num == *capacidade) {
+        *capacidade = *capacidade > 0 ? 2 * *capacidade : 64;
+        *defs = (Definicao *)realocar(*defs, *capacidade * sizeof(Definicao));
+    }
+    (*defs)[*num].variavel = variavel;
+    (*defs)[*num].posicao = posicao;
+    (*num)++;
+}
+
+/*
+ * Numera os comandos, monta a árvore de laços e agrupa as definições
+ * por variável (ordenação por contagem: as posições já vêm crescentes)
+ */
+static void numerar_comandos(EstadoInvariantes *e, NoPrograma *prog) {
+    Definicao *defs = NULL;
+    int num_defs = 0, capacidade_defs = 0;
+    Pilha pilha;
+    QuadroComando *q;
+
+    pilha_iniciar(&pilha, sizeof(QuadroComando));
+    empilhar_sequencia(&pilha, &prog->algoritmo, -1, 0, 1);
+
+    while ((q = (QuadroComando *)pilha_topo(&pilha)) != NULL) {
+        QuadroComando quadro = *q;
+        NoCmd *cmd = quadro.fechar < 0 ? *quadro.lugar : NULL;
+        pilha_desempilhar(&pilha);
+
+        if (quadro.fechar >= 0) {
+            e->lacos[quadro.fechar].fim = e->num_comandos;
+            continue;
+        }
+        if (cmd == NULL) {
+            continue;
+        }
+
+        empilhar_sequencia(&pilha, &cmd->prox, quadro.laco, quadro.direto, 0);
+        int posicao = e->num_comandos;
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                anotar_comando(e, cmd, quadro.laco, quadro.direto);
+                anotar_definicao(&defs, &num_defs, &capacidade_defs,
+                                 indice_variavel(e, cmd->dado.atrib.var), posicao);
+                break;
+
+            case CMD_LEIA:
+                anotar_comando(e, cmd, quadro.laco, quadro.direto);
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    anotar_definicao(&defs, &num_defs, &capacidade_defs,
+                                     indice_variavel(e, v->var), posicao);
+                }
+                break;
+
+            case CMD_ESCREVA:
+                anotar_comando(e, cmd, quadro.laco, quadro.direto);
+                break;
+
+            case CMD_SE:
+                anotar_comando(e, cmd, quadro.laco, quadro.direto);
+                empilhar_sequencia(&pilha, &cmd->dado.se.senao, quadro.laco, 0, 1);
+                empilhar_sequencia(&pilha, &cmd->dado.se.entao, quadro.laco, 0, 1);
+                break;
+
+            case CMD_ENQUANTO:
+                {
+                    int l = novo_laco(e, cmd, quadro.lugar, quadro.cabeca, quadro.laco, quadro.direto);
+                    anotar_comando(e, cmd, l, 0);
+
+                    /* O fim do laço é marcado depois do corpo */
+                    QuadroComando *fim = (QuadroComando *)pilha_empilhar(&pilha);
+                    memset(fim, 0, sizeof(*fim));
+                    fim->fechar = l;
+                    empilhar_sequencia(&pilha, &cmd->dado.enquanto.corpo, l, 1, 1);
+                }
+                break;
+        }
+    }
+    pilha_liberar(&pilha);
+
+    e->inicio_defs = (int *)calloc((size_t)e->num_variaveis + 1, sizeof(int));
+    e->pos_defs = (int *)realocar(NULL, (size_t)num_defs * sizeof(int));
+    if (e->inicio_defs == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a otimizacao de lacos\n");
+        exit(1);
+    }
+    for (int i = 0; i < num_defs; i++) {
+        e->inicio_defs[defs[i].variavel + 1]++;
+    }
+    for (int v = 0; v < e->num_variaveis; v++) {
+        e->inicio_defs[v + 1] += e->inicio_defs[v];
+    }
+    int *proxima = (int *)realocar(NULL, ((size_t)e->num_variaveis + 1) * sizeof(int));
+    memcpy(proxima, e->inicio_defs, ((size_t)e->num_variaveis + 1) * sizeof(int));
+    for (int i = 0; i < num_defs; i++) {
+        e->pos_defs[proxima[defs[i].variavel]++] = defs[i].posicao;
+    }
+    free(proxima);
+    free(defs);
+}
+
+/* Profundidade do laço mais interno, entre 'laco' e os que o contêm, que inclui a posição 'p' */
+static int profundidade_com(const EstadoInvariantes *e, int laco, int p) {
+    while (laco >= 0 && (p < e->lacos[laco].inicio || p >= e->lacos[laco].fim)) {
+        laco = e->lacos[laco].pai;
+    }
+    return laco >= 0 ? e->lacos[laco].profundidade : 0;
+}
+
+/*
+ * Laço mais profundo, dos que contêm a posição 'posicao' (o mais interno
+ * é 'laco'), com alguma definição de 'var'. Como os laços são intervalos
+ * aninhados, basta olhar as definições vizinhas de 'posicao': a última
+ * antes dela (ou nela) e a primeira depois.
+ */
+static int nivel_variavel(const EstadoInvariantes *e, const NoVar *var, int posicao, int laco) {
+    int v = indice_variavel(e, var);
+    int a = e->inicio_defs[v], b = e->inicio_defs[v + 1];
+    int lo = a, hi = b;
+
+    while (lo < hi) {
+        int meio = lo + (hi - lo) / 2;
+        if (e->pos_defs[meio] <= posicao) {
+            lo = meio + 1;
+        } else {
+            hi = meio;
+        }
+    }
+
+    int nivel = 0;
+    if (lo > a) {
+        nivel = profundidade_com(e, laco, e->pos_defs[lo - 1]);
+    }
+    if (lo < b) {
+        int depois = profundidade_com(e, laco, e->pos_defs[lo]);
+        if (depois > nivel) {
+            nivel = depois;
+        }
+    }
+    return nivel;
+}
+
+/* ========== Subexpressões ========== */
+
+/* Campo do k-ésimo operando de 'expr' (na ordem de avaliação), ou NULL */
+static NoExpr **lugar_operando(NoExpr *expr, int k) {
+    switch (expr->tipo) {
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            return k == 0 && expr->dado.var->indice != NULL ? &expr->dado.var->indice : NULL;
+        case EXPR_ARITMETICA:
+            return k == 0 ? &expr->dado.aritmetica.esq : k == 1 ? &expr->dado.aritmetica.dir : NULL;
+        case EXPR_RELACIONAL:
+            return k == 0 ? &expr->dado.relacional.esq : k == 1 ? &expr->dado.relacional.dir : NULL;
+        case EXPR_LOGICA:
+            return k == 0 ? &expr->dado.logica.esq : k == 1 ? &expr->dado.logica.dir : NULL;
+        case EXPR_NAO:
+        case EXPR_NEG:
+            return k == 0 ? &expr->dado.negacao : NULL;
+        default:
+            return NULL;
+    }
+}
+
+/* O próprio nó pode interromper a execução (e não só um operando) */
+static int falha_propria(const NoExpr *expr) {
+    if (expr->tipo == EXPR_VAR_ARRAY) {
+        return 1;
+    }
+    if (expr->tipo == EXPR_ARITMETICA && expr->dado.aritmetica.op == ARIT_DIV &&
+        expr->tipo_dado != TIPO_REAL) {
+        /* Um divisor constante diferente de 0 e de -1 nunca falha */
+        NoExpr *dir = expr->dado.aritmetica.dir;
+        return !(dir->tipo == EXPR_CONST_INT && dir->dado.const_int != 0 && dir->dado.const_int != -1);
+    }
+    return 0;
+}
+
+static int novo_info(EstadoInvariantes *e) {
+    if (e->num_info == e->capacidade_info) {
+        e->capacidade_info = e->capacidade_info > 0 ? 2 * e->capacidade_info : 256;
+        e->info = (InfoNo *)realocar(e->info, e->capacidade_info * sizeof(InfoNo));
+    }
+    return e->num_info++;
+}
+
+typedef struct {
+    NoExpr *expr;
+    int indice;
+    int etapa;
+} QuadroMedida;
+
+/*
+ * Preenche e->info para a expressão 'raiz' do comando na posição
+ * 'posicao' (o nó i em pré-ordem fica em e->info[i]); sem recursão
+ */
+static void medir_expressao(EstadoInvariantes *e, NoExpr *raiz, int posicao, int laco) {
+    Pilha pilha;
+    QuadroMedida *q;
+
+    e->num_info = 0;
+    pilha_iniciar(&pilha, sizeof(QuadroMedida));
+    q = (QuadroMedida *)pilha_empilhar(&pilha);
+    q->expr = raiz;
+    q->etapa = 0;
+
+    while ((q = (QuadroMedida *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = q->expr;
+        int etapa = q->etapa++;
+        if (etapa == 0) {
+            q->indice = novo_info(e);
+        }
+        int i = q->indice;
+
+        NoExpr **operando = lugar_operando(expr, etapa);
+        if (operando != NULL) {
+            QuadroMedida *filho = (QuadroMedida *)pilha_empilhar(&pilha);
+            filho->expr = *operando;
+            filho->etapa = 0;
+            continue;
+        }
+        pilha_desempilhar(&pilha);
+
+        /* Operandos concluídos: combina nível e falha da subárvore */
+        InfoNo *in = &e->info[i];
+        in->tamanho = e->num_info - i;
+        in->nivel = 0;
+        in->falha = (unsigned char)falha_propria(expr);
+        in->operacao = !(expr->tipo == EXPR_CONST_INT || expr->tipo == EXPR_CONST_REAL ||
+                         expr->tipo == EXPR_VAR);
+
+        if (expr->tipo == EXPR_VAR || expr->tipo == EXPR_VAR_ARRAY) {
+            in->nivel = nivel_variavel(e, expr->dado.var, posicao, laco);
+        }
+        for (int j = i + 1; j < e->num_info; j += e->info[j].tamanho) {
+            if (e->info[j].nivel > in->nivel) {
+                in->nivel = e->info[j].nivel;
+            }
+            in->falha |= e->info[j].falha;
+        }
+    }
+
+    pilha_liberar(&pilha);
+}
+
+/* ========== Movimentação ========== */
+
+static NoVar *nova_referencia(ContextoCompilacao *ctx, ChaveId chave, const NoExpr *origem) {
+    NoVar *var = criar_var_simples(ctx, chave);
+    var->linha = origem->linha;
+    var->coluna = origem->coluna;
+    return var;
+}
+
+static void anexar(NoCmd **inicio, NoCmd **fim, NoCmd *cmd) {
+    if (*inicio == NULL) {
+        *inicio = cmd;
+    } else {
+        (*fim)->prox = cmd;
+    }
+    *fim = cmd;
+    (*inicio)->ultimo = cmd;
+}
+
+/*
+ * Troca *lugar por um temporário calculado antes do laço de profundidade
+ * 'nivel' + 1 que contém 'laco' (o símbolo é ligado no final)
+ */
+static void mover(EstadoInvariantes *e, NoExpr **lugar, int laco, int nivel, int protegido) {
+    ContextoCompilacao *ctx = e->ctx;
+    NoExpr *expr = *lugar;
+    char nome[16];          /* "_t" e até 6 dígitos: cabe em ID_MAX_CHARS */
+
+    int alvo = laco;
+    while (e->lacos[alvo].profundidade > nivel + 1) {
+        alvo = e->lacos[alvo].pai;
+    }
+
+    snprintf(nome, sizeof(nome), "_t%d", e->num_movimentos + 1);
+    ChaveId chave = chave_id(nome, strlen(nome));
+
+    NoCmd *atrib = criar_cmd_atrib(ctx, nova_referencia(ctx, chave, expr), expr);
+    atrib->linha = expr->linha;
+    atrib->coluna = expr->coluna;
+
+    NoVar *referencia = nova_referencia(ctx, chave, expr);
+    NoExpr *leitura = criar_expr_var(ctx, referencia);
+    leitura->tipo_dado = expr->tipo_dado;
+    leitura->linha = expr->linha;
+    leitura->coluna = expr->coluna;
+    *lugar = leitura;
+
+    LacoInvariante *l = &e->lacos[alvo];
+    if (protegido) {
+        anexar(&l->protegidos, &l->fim_protegidos, atrib);
+    } else {
+        anexar(&l->antes, &l->fim_antes, atrib);
+    }
+
+    if (e->num_movimentos == e->capacidade_movimentos) {
+        e->capacidade_movimentos = e->capacidade_movimentos > 0 ? 2 * e->capacidade_movimentos : 16;
+        e->movimentos = (Movimento *)realocar(e->movimentos,
+                                              e->capacidade_movimentos * sizeof(Movimento));
+    }
+    Movimento *m = &e->movimentos[e->num_movimentos++];
+    m->atrib = atrib;
+    m->referencia = referencia;
+    m->linha_laco = l->cmd->dado.enquanto.condicao->linha;   /* O comando fica na linha do FIMENQ */
+    m->protegido = protegido;
+}
+
+/* Nó em análise: só move operandos que saem de laços mais externos que 'limite' */
+typedef struct {
+    NoExpr **lugar;
+    NoExpr *expr;
+    int indice;
+    int limite;
+    int etapa;
+    int movida;             /* O nó, ou um ancestral, já saiu do laço */
+} QuadroMovimento;
+
+static void empilhar_movimento(Pilha *pilha, NoExpr **lugar, int indice, int limite, int movida) {
+    QuadroMovimento *q = (QuadroMovimento *)pilha_empilhar(pilha);
+    q->lugar = lugar;
+    q->expr = *lugar;
+    q->indice = indice;
+    q->limite = limite;
+    q->etapa = 0;
+    q->movida = movida;
+}
+
+/*
+ * Move as subexpressões invariantes de *lugar, uma expressão do comando
+ * na posição 'posicao' cujo laço mais interno é 'laco'. Percorre na ordem
+ * de avaliação: *prefixo diz se, na primeira volta, nada visível nem nada
+ * que possa falhar aconteceu antes do ponto corrente, e é zerado quando
+ * isso deixa de valer.
+ */
+static void mover_expressao(EstadoInvariantes *e, NoExpr **lugar, int posicao, int laco, int *prefixo) {
+    int profundidade = e->lacos[laco].profundidade;
+    Pilha pilha;
+    QuadroMovimento *q;
+
+    medir_expressao(e, *lugar, posicao, laco);
+
+    pilha_iniciar(&pilha, sizeof(QuadroMovimento));
+    empilhar_movimento(&pilha, lugar, 0, profundidade, 0);
+
+    while ((q = (QuadroMovimento *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = q->expr;
+        int etapa = q->etapa++;
+        InfoNo in = e->info[q->indice];
+
+        if (etapa == 0 && in.operacao &&
+            (expr->tipo_dado == TIPO_INTEIRO || expr->tipo_dado == TIPO_REAL) &&
+            e->num_movimentos < MAX_TEMPORARIOS) {
+            /* Sem risco, sai de todos os laços em que é invariante; com risco, só do mais interno */
+            int nivel = -1;
+            if (!in.falha) {
+                nivel = in.nivel;
+            } else if (!q->movida && *prefixo && in.nivel < profundidade) {
+                nivel = profundidade - 1;
+            }
+            if (nivel >= 0 && nivel < q->limite) {
+                mover(e, q->lugar, laco, nivel, in.falha);
+                q->limite = nivel;
+                q->movida = 1;
+            }
+        }
+
+        if (!q->movida) {
+            /* Os lados de uma comparação não têm ordem de avaliação definida */
+            if (etapa == 0 && expr->tipo == EXPR_RELACIONAL &&
+                e->info[q->indice + 1].falha &&
+                e->info[q->indice + 1 + e->info[q->indice + 1].tamanho].falha) {
+                *prefixo = 0;
+            }
+            /* O lado direito de .E. e .OU. nem sempre é avaliado */
+            if (etapa == 1 && expr->tipo == EXPR_LOGICA &&
+                e->info[q->indice + 1 + e->info[q->indice + 1].tamanho].falha) {
+                *prefixo = 0;
+            }
+        }
+
+        NoExpr **operando = lugar_operando(expr, etapa);
+        if (operando != NULL) {
+            int indice = q->indice + 1;
+            if (etapa == 1) {
+                indice += e->info[indice].tamanho;
+            }
+            empilhar_movimento(&pilha, operando, indice, q->limite, q->movida);
+            continue;
+        }
+
+        if (!q->movida && falha_propria(expr)) {
+            *prefixo = 0;
+        }
+        pilha_desempilhar(&pilha);
+    }
+
+    pilha_liberar(&pilha);
+}
+
+/* Move as subexpressões invariantes de cada comando dentro de laços */
+static void mover_comandos(EstadoInvariantes *e) {
+    for (int c = 0; c < e->num_comandos; c++) {
+        NoCmd *cmd = e->comandos[c].cmd;
+        int laco = e->comandos[c].laco;
+        int fora = 0;
+
+        if (laco < 0) {
+            continue;
+        }
+        int *prefixo = e->comandos[c].direto ? &e->lacos[laco].prefixo : &fora;
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                {
+                    NoVar *var = cmd->dado.atrib.var;
+                    if (var->indice != NULL) {
+                        /* O índice do destino e o valor não têm ordem definida entre os executores */
+                        *prefixo = 0;
+                    }
+                    mover_expressao(e, &cmd->dado.atrib.expr, c, laco, prefixo);
+                    if (var->indice != NULL) {
+                        mover_expressao(e, &var->indice, c, laco, prefixo);
+                    }
+                }
+                break;
+
+            case CMD_LEIA:
+                *prefixo = 0;
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    if (v->var->indice != NULL) {
+                        mover_expressao(e, &v->var->indice, c, laco, prefixo);
+                    }
+                }
+                break;
+
+            case CMD_ESCREVA:
+                /* Cada item é escrito antes de o seguinte ser avaliado */
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        mover_expressao(e, &item->item.expr, c, laco, prefixo);
+                    }
+                    *prefixo = 0;
+                }
+                break;
+
+            case CMD_SE:
+                mover_expressao(e, &cmd->dado.se.condicao, c, laco, prefixo);
+                *prefixo = 0;
+                break;
+
+            case CMD_ENQUANTO:
+                {
+                    /* A condição é avaliada antes de cada volta e também conta como do laço */
+                    LacoInvariante *l = &e->lacos[laco];
+                    mover_expressao(e, &cmd->dado.enquanto.condicao, c, laco, &fora);
+                    if (l->direto) {
+                        e->lacos[l->pai].prefixo = 0;
+                    }
+                }
+                break;
+        }
+    }
+}
+
+/* ========== Temporários e inserção antes dos laços ========== */
+
+typedef struct {
+    NoExpr *origem;
+    NoExpr **destino;
+} QuadroCopia;
+
+/* Cópia independente de uma expressão já analisada (sem recursão) */
+static NoExpr *copiar_expressao(ContextoCompilacao *ctx, NoExpr *raiz) {
+    NoExpr *copia = NULL;
+    Pilha pilha;
+    QuadroCopia *q;
+
+    pilha_iniciar(&pilha, sizeof(QuadroCopia));
+    q = (QuadroCopia *)pilha_empilhar(&pilha);
+    q->origem = raiz;
+    q->destino = &copia;
+
+    while ((q = (QuadroCopia *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *origem = q->origem;
+        NoExpr **destino = q->destino;
+        pilha_desempilhar(&pilha);
+
+        NoExpr *novo = (NoExpr *)arena_alocar(&ctx->arena, sizeof(NoExpr));
+        *novo = *origem;
+        *destino = novo;
+
+        if (origem->tipo == EXPR_VAR || origem->tipo == EXPR_VAR_ARRAY) {
+            NoVar *var = (NoVar *)arena_alocar(&ctx->arena, sizeof(NoVar));
+            *var = *origem->dado.var;
+            novo->dado.var = var;
+        }
+        for (int k = 0; k < 2; k++) {
+            NoExpr **operando = lugar_operando(novo, k);
+            if (operando != NULL) {
+                QuadroCopia *filho = (QuadroCopia *)pilha_empilhar(&pilha);
+                filho->origem = *operando;
+                filho->destino = operando;
+            }
+        }
+    }
+
+    pilha_liberar(&pilha);
+    return copia;
+}
+
+/* Declara os temporários e liga as suas referências aos símbolos */
+static void declarar_temporarios(EstadoInvariantes *e, NoPrograma *prog) {
+    ContextoCompilacao *ctx = e->ctx;
+
+    EntradaSimbolo *anterior = reservar_simbolos(ctx, e->num_movimentos);
+    if (anterior != NULL) {
+        /* As atribuições dos temporários ainda estão fora da AST, nas listas dos laços */
+        religar_simbolos(ctx, prog->algoritmo, anterior);
+        for (int i = 0; i < e->num_lacos; i++) {
+            religar_simbolos(ctx, e->lacos[i].antes, anterior);
+            religar_simbolos(ctx, e->lacos[i].protegidos, anterior);
+        }
+        free(anterior);
+    }
+
+    for (int i = 0; i < e->num_movimentos; i++) {
+        Movimento *m = &e->movimentos[i];
+        NoVar *destino = m->atrib->dado.atrib.var;
+        NoExpr *expr = m->atrib->dado.atrib.expr;
+        int indice = ctx->tabela.num_simbolos;
+
+        inserir_simbolo(ctx, destino->chave, expr->tipo_dado, 0, expr->linha, expr->coluna);
+        destino->simbolo = &ctx->tabela.simbolos[indice];
+        m->referencia->simbolo = destino->simbolo;
+
+        NoDecl *decl = criar_declaracao(ctx, expr->tipo_dado, destino->chave, 0);
+        decl->linha = expr->linha;
+        decl->coluna = expr->coluna;
+        prog->declaracoes = concat_declaracoes(prog->declaracoes, decl);
+    }
+    prog->tamanho_quadro = ctx->tabela.tamanho_quadro;
+}
+
+/*
+ * Põe os temporários antes de cada laço. Os laços são tratados do último
+ * para o primeiro, para que os 'lugar' ainda não usados continuem
+ * válidos; quando há temporários protegidos, o próprio nó do ENQUANTO
+ * vira o SE (mantendo a posição na sequência) e o laço passa a uma cópia.
+ */
+static void inserir_temporarios(EstadoInvariantes *e) {
+    ContextoCompilacao *ctx = e->ctx;
+
+    for (int i = e->num_lacos - 1; i >= 0; i--) {
+        LacoInvariante *l = &e->lacos[i];
+        NoCmd *cmd = l->cmd;
+
+        if (l->protegidos != NULL) {
+            NoCmd *laco = (NoCmd *)arena_alocar(&ctx->arena, sizeof(NoCmd));
+            *laco = *cmd;
+            laco->prox = NULL;
+            laco->ultimo = laco;
+            anexar(&l->protegidos, &l->fim_protegidos, laco);
+
+            cmd->tipo = CMD_SE;
+            cmd->dado.se.condicao = copiar_expressao(ctx, laco->dado.enquanto.condicao);
+            cmd->dado.se.entao = l->protegidos;
+            cmd->dado.se.senao = NULL;
+        }
+
+        if (l->antes != NULL) {
+            l->fim_antes->prox = cmd;
+            if (l->cabeca) {
+                l->antes->ultimo = cmd->ultimo;
+            }
+            *l->lugar = l->antes;
+        }
+    }
+}
+
+/* ========== Passo completo ========== */
+
+long mover_invariantes(ContextoCompilacao *ctx, NoPrograma *prog, FILE *registro) {
+    EstadoInvariantes e;
+
+    memset(&e, 0, sizeof(e));
+    e.ctx = ctx;
+    e.num_variaveis = ctx->tabela.num_simbolos;
+
+    numerar_comandos(&e, prog);
+    mover_comandos(&e);
+
+    if (e.num_movimentos > 0) {
+        declarar_temporarios(&e, prog);
+        inserir_temporarios(&e);
+    }
+
+    if (registro != NULL) {
+        char nome[ID_MAX_CHARS + 1];
+        for (int i = 0; i < e.num_movimentos; i++) {
+            Movimento *m = &e.movimentos[i];
+            NoExpr *expr = m->atrib->dado.atrib.expr;
+            fprintf(registro, ">>> Invariante na linha %d: %s := ", expr->linha,
+                    texto_id(m->referencia->chave, nome));
+            imprimir_expressao(expr, registro);
+            fprintf(registro, " antes do ENQUANTO da linha %d%s\n", m->linha_laco,
+                    m->protegido ? " (sob a condicao do laco)" : "");
+        }
+    }
+
+    ctx->invariantes_movidos = e.num_movimentos;
+
+    free(e.comandos);
+    free(e.lacos);
+    free(e.inicio_defs);
+    free(e.pos_defs);
+    free(e.info);
+    free(e.movimentos);
+    return ctx->invariantes_movidos;
+}
@@ -0,0 +1,28 @@
+/*
+ * Movimentação de código invariante de laços (ENQUANTO)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef INVARIANTES_H
+#define INVARIANTES_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/* Temporários criados pela movimentação: "_t1", "_t2", ... (cabem em 8 caracteres) */
+#define MAX_TEMPORARIOS 999999
+
+/*
+ * Calcula antes de cada ENQUANTO, em temporários, as subexpressões do
+ * laço (condição e corpo) cujos operandos ele nunca altera: os alvos de
+ * atribuições e de LEIA no laço, inclusive em laços internos, são os
+ * conjuntos de variáveis que deixam de ser invariantes. Os temporários
+ * entram na tabela de símbolos e nas declarações do programa.
+ *
+ * Deve ser chamada após uma análise semântica sem erros. Com 'registro'
+ * não nulo, escreve ali uma linha por expressão movida. Retorna o número
+ * de expressões movidas (também em ctx->invariantes_movidos).
+ */
+long mover_invariantes(ContextoCompilacao *ctx, NoPrograma *prog, FILE *registro);
+
+#endif /* INVARIANTES_H */
@@ -0,0 +1,1219 @@
+/*
+ * Implementação da compilação em tempo de execução (JIT) para x86-64
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#define _DEFAULT_SOURCE     /* MAP_ANONYMOUS */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "jit.h"
+#include "semantic.h"
+
+struct CodigoJit {
+    unsigned char *memoria;         /* Páginas executáveis (somente leitura) */
+    size_t mapeado;
+    size_t tamanho;
+    char (*nomes)[ID_MAX_CHARS + 1]; /* Nomes das listas nas mensagens de erro */
+};
+
+#if defined(__x86_64__)
+
+/* ========== Registradores ========== */
+
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+/*
+ * %rbx guarda o endereço do quadro; %rax e %rdx são auxiliares (divisão,
+ * índices, flags), e %r11 leva o endereço das chamadas ao runtime. Como
+ * no gerador de assembly, nenhum temporário fica vivo numa chamada que
+ * retorna, então os demais registradores servem a temporários.
+ */
+#define NUM_INTEIROS 12
+
+static const int inteiros[NUM_INTEIROS] = {
+    RCX, RSI, RDI, R8, R9, R10, R11, RBP, R12, R13, R14, R15
+};
+
+/* Temporários reais: %xmm0 a %xmm14; %xmm15 é o auxiliar */
+#define NUM_REAIS 15
+#define XMM_AUX 15
+
+/* Códigos de condição (o avesso de cada um é o código com o bit 0 trocado) */
+enum {
+    CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+    CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF,
+    COND_E_REAL = 0x10,     /* Igualdade real: falsa se não ordenado (NaN) */
+    COND_NE_REAL = 0x11
+};
+
+typedef enum {
+    CLASSE_INTEIRO,
+    CLASSE_REAL
+} Classe;
+
+typedef enum {
+    OPERANDO_REG,
+    OPERANDO_IMEDIATO,
+    OPERANDO_MEMORIA
+} TipoOperando;
+
+typedef struct Operando {
+    TipoOperando tipo;
+    int reg;            /* Registrador físico (0-15, de uso geral ou SSE2) */
+    int base;           /* Memória: base + índice << escala + deslocamento */
+    int indice;         /* -1 se não há */
+    int escala;
+    int32_t desloc;
+    int32_t valor;      /* Imediato */
+} Operando;
+
+/* ========== Estado da compilação ========== */
+
+/* Desvio de 32 bits a resolver quando o rótulo for marcado */
+typedef struct Desvio {
+    size_t posicao;
+    int rotulo;
+} Desvio;
+
+#define ERRO_DIVISAO_ZERO   (-1)
+#define ERRO_ESTOURO        (-2)
+
+typedef struct SaidaErro {
+    int rotulo;
+    int linha;
+    int reg_indice;     /* Registrador com o índice, ou ERRO_DIVISAO_ZERO/ERRO_ESTOURO */
+    int tamanho;
+    ChaveId chave;
+} SaidaErro;
+
+/* Rótulo de Sethi-Ullman, memorizado por nó (a AST pode compartilhar nós) */
+typedef struct RotuloExpr {
+    const NoExpr *expr;
+    int registradores;
+    int pode_falhar;
+} RotuloExpr;
+
+typedef struct Jit {
+    unsigned char *codigo;
+    size_t tamanho;
+    size_t capacidade;
+
+    size_t *rotulos;        /* Posição de cada rótulo */
+    int num_rotulos;
+    int cap_rotulos;
+
+    Desvio *desvios;
+    int num_desvios;
+    int cap_desvios;
+
+    SaidaErro *erros;
+    int num_erros;
+    int cap_erros;
+
+    RotuloExpr *memo;       /* Tabela hash aberta, capacidade potência de 2 */
+    int num_memo;
+    int cap_memo;
+
+    int derrames;
+    int maior_derrame;
+} Jit;
+
+static void *crescer(void *vetor, int *capacidade, size_t elem) {
+    *capacidade = *capacidade ? *capacidade * 2 : 64;
+    void *novo = realloc(vetor, (size_t)*capacidade * elem);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para o JIT\n");
+        exit(1);
+    }
+    return novo;
+}
+
+/* ========== Codificação ========== */
+
+static void byte(Jit *j, unsigned b) {
+    if (j->tamanho == j->capacidade) {
+        j->capacidade = j->capacidade ? j->capacidade * 2 : 4096;
+        j->codigo = realloc(j->codigo, j->capacidade);
+        if (j->codigo == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para o JIT\n");
+            exit(1);
+        }
+    }
+    j->codigo[j->tamanho++] = (unsigned char)b;
+}
+
+static void dword(Jit *j, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        byte(j, (v >> (8 * i)) & 0xFF);
+    }
+}
+
+static void qword(Jit *j, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        byte(j, (unsigned)((v >> (8 * i)) & 0xFF));
+    }
+}
+
+static Operando em_reg(int reg) {
+    Operando o = { OPERANDO_REG, reg, 0, -1, 0, 0, 0 };
+    return o;
+}
+
+static Operando imediato(int32_t valor) {
+    Operando o = { OPERANDO_IMEDIATO, -1, 0, -1, 0, 0, valor };
+    return o;
+}
+
+static Operando memoria(int base, int32_t desloc) {
+    Operando o = { OPERANDO_MEMORIA, -1, base, -1, 0, desloc, 0 };
+    return o;
+}
+
+/*
+ * Instrução com operando ModR/M: [prefixo] [REX] opcode (1 ou 2 bytes,
+ * 0x0Fxx) ModR/M [SIB] [desloc32]. 'reg' vai no campo reg (registrador
+ * ou extensão do opcode) e 'rm' é registrador ou memória.
+ */
+static void instrucao(Jit *j, unsigned prefixo, unsigned opcode, int w, int reg, const Operando *rm) {
+    unsigned rex = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0);
+    if (rm->tipo == OPERANDO_REG) {
+        rex |= (rm->reg & 8) ? 1 : 0;
+    } else {
+        rex |= (rm->indice >= 0 && (rm->indice & 8)) ? 2 : 0;
+        rex |= (rm->base & 8) ? 1 : 0;
+    }
+    if (prefixo) byte(j, prefixo);
+    if (rex != 0x40) byte(j, rex);
+    if (opcode > 0xFF) byte(j, opcode >> 8);
+    byte(j, opcode & 0xFF);
+
+    if (rm->tipo == OPERANDO_REG) {
+        byte(j, 0xC0 | ((reg & 7) << 3) | (rm->reg & 7));
+        return;
+    }
+    /* Sempre deslocamento de 32 bits (mod = 10) */
+    if (rm->indice >= 0 || (rm->base & 7) == RSP) {
+        byte(j, 0x80 | ((reg & 7) << 3) | 4);
+        byte(j, (rm->escala << 6) | (((rm->indice >= 0 ? rm->indice : RSP) & 7) << 3) | (rm->base & 7));
+    } else {
+        byte(j, 0x80 | ((reg & 7) << 3) | (rm->base & 7));
+    }
+    dword(j, (uint32_t)rm->desloc);
+}
+
+static int novo_rotulo(Jit *j) {
+    if (j->num_rotulos == j->cap_rotulos) {
+        j->rotulos = crescer(j->rotulos, &j->cap_rotulos, sizeof(size_t));
+    }
+    j->rotulos[j->num_rotulos] = (size_t)-1;
+    return j->num_rotulos++;
+}
+
+static void marcar_rotulo(Jit *j, int rotulo) {
+    j->rotulos[rotulo] = j->tamanho;
+}
+
+static void alvo(Jit *j, int rotulo) {
+    if (j->num_desvios == j->cap_desvios) {
+        j->desvios = crescer(j->desvios, &j->cap_desvios, sizeof(Desvio));
+    }
+    j->desvios[j->num_desvios].posicao = j->tamanho;
+    j->desvios[j->num_desvios].rotulo = rotulo;
+    j->num_desvios++;
+    dword(j, 0);
+}
+
+static void jmp(Jit *j, int rotulo) {
+    byte(j, 0xE9);
+    alvo(j, rotulo);
+}
+
+static void jcc(Jit *j, int cc, int rotulo) {
+    byte(j, 0x0F);
+    byte(j, 0x80 + cc);
+    alvo(j, rotulo);
+}
+
+static void movabs(Jit *j, int reg, uint64_t valor) {
+    byte(j, 0x48 | ((reg & 8) ? 1 : 0));
+    byte(j, 0xB8 + (reg & 7));
+    qword(j, valor);
+}
+
+/* Chamada a uma função do runtime pelo endereço absoluto (call *%r11) */
+static void chamar(Jit *j, uint64_t funcao) {
+    movabs(j, R11, funcao);
+    byte(j, 0x41);
+    byte(j, 0xFF);
+    byte(j, 0xD3);
+}
+
+#define ENDERECO(f) ((uint64_t)(uintptr_t)(f))
+
+/* mov de 32 bits para registrador (imediato zero vira xor) */
+static void mover32(Jit *j, int destino, const Operando *fonte) {
+    if (fonte->tipo == OPERANDO_IMEDIATO) {
+        if (fonte->valor == 0) {
+            Operando d = em_reg(destino);
+            instrucao(j, 0, 0x31, 0, destino, &d);
+        } else {
+            if (destino & 8) byte(j, 0x41);
+            byte(j, 0xB8 + (destino & 7));
+            dword(j, (uint32_t)fonte->valor);
+        }
+    } else if (fonte->tipo != OPERANDO_REG || fonte->reg != destino) {
+        instrucao(j, 0, 0x8B, 0, destino, fonte);
+    }
+}
+
+static void mover_real(Jit *j, int destino, const Operando *fonte) {
+    if (fonte->tipo == OPERANDO_REG) {
+        if (fonte->reg != destino) {
+            instrucao(j, 0x66, 0x0F28, 0, destino, fonte);      /* movapd */
+        }
+    } else {
+        instrucao(j, 0xF2, 0x0F10, 0, destino, fonte);          /* movsd */
+    }
+}
+
+static void guardar_reg(Jit *j, Classe c, const Operando *destino, int fonte) {
+    if (c == CLASSE_INTEIRO) {
+        instrucao(j, 0, 0x89, 0, fonte, destino);
+    } else {
+        instrucao(j, 0xF2, 0x0F11, 0, fonte, destino);
+    }
+}
+
+/* Constante real num registrador SSE2, pelos bits num registrador de uso geral */
+static void carregar_real(Jit *j, int destino, double valor) {
+    uint64_t bits;
+    memcpy(&bits, &valor, sizeof(double));
+    if (bits == 0) {
+        Operando d = em_reg(destino);
+        instrucao(j, 0x66, 0x0F57, 0, destino, &d);             /* xorpd */
+        return;
+    }
+    movabs(j, RAX, bits);
+    Operando a = em_reg(RAX);
+    instrucao(j, 0x66, 0x0F6E, 1, destino, &a);                 /* movq %rax, %xmmN */
+}
+
+/* Operações aritméticas e comparação entre um registrador e um operando */
+enum { ALU_SOMA, ALU_SUB, ALU_MULT, ALU_DIV, ALU_CMP };
+
+static void alu(Jit *j, Classe c, int op, int destino, const Operando *fonte) {
+    static const unsigned inteiras[] = { 0x03, 0x2B, 0x0FAF, 0, 0x3B };
+    static const int extensoes[] = { 0, 5, 0, 0, 7 };
+    static const unsigned reais[] = { 0x0F58, 0x0F5C, 0x0F59, 0x0F5E };
+
+    if (c == CLASSE_REAL) {
+        if (op == ALU_CMP) {
+            instrucao(j, 0x66, 0x0F2E, 0, destino, fonte);      /* ucomisd */
+        } else {
+            instrucao(j, 0xF2, reais[op], 0, destino, fonte);
+        }
+        return;
+    }
+    if (fonte->tipo == OPERANDO_IMEDIATO) {
+        Operando d = em_reg(destino);
+        if (op == ALU_MULT) {
+            instrucao(j, 0, 0x69, 0, destino, &d);
+        } else {
+            instrucao(j, 0, 0x81, 0, extensoes[op], &d);
+        }
+        dword(j, (uint32_t)fonte->valor);
+        return;
+    }
+    instrucao(j, 0, inteiras[op], 0, destino, fonte);
+}
+
+/* ========== Variáveis e operandos ========== */
+
+static int elemento_real(EntradaSimbolo *s) {
+    return s->tipo == TIPO_REAL || s->tipo == TIPO_LISTAREAL;
+}
+
+static Classe classe_var(NoVar *var) {
+    return elemento_real(var->simbolo) ? CLASSE_REAL : CLASSE_INTEIRO;
+}
+
+static Classe classe_expr(NoExpr *expr) {
+    return expr->tipo_dado == TIPO_REAL ? CLASSE_REAL : CLASSE_INTEIRO;
+}
+
+static int reg_classe(Classe c, int k) {
+    return c == CLASSE_INTEIRO ? inteiros[k] : k;
+}
+
+static int base(Classe c, int bi, int br) {
+    return c == CLASSE_INTEIRO ? bi : br;
+}
+
+/* Conversão de real para inteiro como a de cvttsd2si (fora do alcance: INT_MIN) */
+static int truncar(double valor) {
+    if (valor > -2147483649.0 && valor < 2147483648.0) {
+        return (int)valor;
+    }
+    return INT_MIN;
+}
+
+/*
+ * Posição fixa no quadro: variável simples ou elemento de índice
+ * constante dentro dos limites. Com 'o' nulo, só responde.
+ */
+static int posicao_fixa(NoVar *var, Operando *o) {
+    int slot = var->simbolo->slot;
+
+    if (var->indice != NULL) {
+        int i;
+        if (var->indice->tipo != EXPR_CONST_INT) return 0;
+        i = var->indice->dado.const_int;
+        if (i < 1 || i > var->simbolo->tamanho_array) return 0;
+        slot += i - 1;
+    }
+    if (o != NULL) {
+        *o = memoria(RBX, slot * (int32_t)sizeof(Valor));
+    }
+    return 1;
+}
+
+/*
+ * Operando que entra numa instrução da classe 'c' sem ser calculado
+ * num registrador: imediato inteiro (exceto como divisor) ou posição
+ * fixa do quadro. Constantes reais precisam de registrador.
+ */
+static int operando_direto(NoExpr *expr, Classe c, int divisor, Operando *o) {
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+        case EXPR_CONST_REAL:
+            if (c == CLASSE_REAL || divisor) return 0;
+            if (o != NULL) {
+                *o = imediato(expr->tipo == EXPR_CONST_INT ? expr->dado.const_int
+                                                           : truncar(expr->dado.const_real));
+            }
+            return 1;
+
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            if (classe_var(expr->dado.var) != c) return 0;
+            return posicao_fixa(expr->dado.var, o);
+
+        default:
+            return 0;
+    }
+}
+
+static int valor_divisor(NoExpr *expr, int *valor) {
+    if (expr->tipo == EXPR_CONST_INT) {
+        *valor = expr->dado.const_int;
+        return 1;
+    }
+    if (expr->tipo == EXPR_CONST_REAL) {
+        *valor = truncar(expr->dado.const_real);
+        return 1;
+    }
+    return 0;
+}
+
+/* Divisor constante diferente de 0 e de -1: a divisão nunca falha */
+static int divisor_constante(NoExpr *expr) {
+    int valor;
+    return valor_divisor(expr, &valor) && valor != 0 && valor != -1;
+}
+
+static int saida_erro(Jit *j, int linha, int reg_indice, int tamanho, ChaveId chave) {
+    if (j->num_erros == j->cap_erros) {
+        j->erros = crescer(j->erros, &j->cap_erros, sizeof(SaidaErro));
+    }
+    SaidaErro *e = &j->erros[j->num_erros++];
+    e->rotulo = novo_rotulo(j);
+    e->linha = linha;
+    e->reg_indice = reg_indice;
+    e->tamanho = tamanho;
+    e->chave = chave;
+    return e->rotulo;
+}
+
+/* ========== Rótulos de Sethi-Ullman ========== */
+
+static size_t hash_expr(const NoExpr *expr) {
+    uint64_t x = (uint64_t)(uintptr_t)expr;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return (size_t)x;
+}
+
+static void inserir_memo(Jit *j, RotuloExpr r) {
+    if (2 * (j->num_memo + 1) > j->cap_memo) {
+        RotuloExpr *antigos = j->memo;
+        int cap_antiga = j->cap_memo;
+        j->cap_memo = cap_antiga ? cap_antiga * 2 : 256;
+        j->memo = (RotuloExpr *)calloc((size_t)j->cap_memo, sizeof(RotuloExpr));
+        if (j->memo == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para o JIT\n");
+            exit(1);
+        }
+        j->num_memo = 0;
+        for (int i = 0; i < cap_antiga; i++) {
+            if (antigos[i].expr != NULL) {
+                inserir_memo(j, antigos[i]);
+            }
+        }
+        free(antigos);
+    }
+    size_t mascara = (size_t)j->cap_memo - 1;
+    size_t i = hash_expr(r.expr) & mascara;
+    while (j->memo[i].expr != NULL) {
+        i = (i + 1) & mascara;
+    }
+    j->memo[i] = r;
+    j->num_memo++;
+}
+
+static RotuloExpr rotular(Jit *j, NoExpr *expr);
+
+static int combinar(int primeiro, int segundo) {
+    if (primeiro == segundo) return primeiro + 1;
+    return primeiro > segundo ? primeiro : segundo;
+}
+
+static RotuloExpr calcular_rotulo(Jit *j, NoExpr *expr) {
+    RotuloExpr r = { expr, 1, 0 };
+    RotuloExpr a, b;
+    Classe c;
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+        case EXPR_CONST_REAL:
+        case EXPR_VAR:
+            break;
+
+        case EXPR_VAR_ARRAY:
+            if (!posicao_fixa(expr->dado.var, NULL)) {
+                a = rotular(j, expr->dado.var->indice);
+                r.registradores = a.registradores;
+                r.pode_falhar = a.pode_falhar || expr->dado.var->limite != LIMITE_SEGURO;
+            }
+            break;
+
+        case EXPR_ARITMETICA:
+            c = classe_expr(expr);
+            a = rotular(j, expr->dado.aritmetica.esq);
+            b = rotular(j, expr->dado.aritmetica.dir);
+            {
+                int divisao = expr->dado.aritmetica.op == ARIT_DIV && c == CLASSE_INTEIRO;
+                int segundo = operando_direto(expr->dado.aritmetica.dir, c, divisao, NULL)
+                              ? 0 : b.registradores;
+                r.registradores = combinar(a.registradores, segundo);
+                r.pode_falhar = a.pode_falhar || b.pode_falhar ||
+                                (divisao && !divisor_constante(expr->dado.aritmetica.dir));
+            }
+            break;
+
+        case EXPR_RELACIONAL:
+            c = (classe_expr(expr->dado.relacional.esq) == CLASSE_REAL ||
+                 classe_expr(expr->dado.relacional.dir) == CLASSE_REAL) ? CLASSE_REAL : CLASSE_INTEIRO;
+            a = rotular(j, expr->dado.relacional.esq);
+            b = rotular(j, expr->dado.relacional.dir);
+            r.registradores = combinar(a.registradores,
+                                       operando_direto(expr->dado.relacional.dir, c, 0, NULL)
+                                       ? 0 : b.registradores);
+            r.pode_falhar = a.pode_falhar || b.pode_falhar;
+            break;
+
+        case EXPR_LOGICA:
+            a = rotular(j, expr->dado.logica.esq);
+            b = rotular(j, expr->dado.logica.dir);
+            r.registradores = a.registradores > b.registradores ? a.registradores : b.registradores;
+            r.pode_falhar = a.pode_falhar || b.pode_falhar;
+            break;
+
+        case EXPR_NAO:
+        case EXPR_NEG:
+            r = rotular(j, expr->dado.negacao);
+            r.expr = expr;
+            break;
+    }
+    return r;
+}
+
+static RotuloExpr rotular(Jit *j, NoExpr *expr) {
+    if (j->cap_memo > 0) {
+        size_t mascara = (size_t)j->cap_memo - 1;
+        size_t i = hash_expr(expr) & mascara;
+        while (j->memo[i].expr != NULL) {
+            if (j->memo[i].expr == expr) {
+                return j->memo[i];
+            }
+            i = (i + 1) & mascara;
+        }
+    }
+    RotuloExpr r = calcular_rotulo(j, expr);
+    inserir_memo(j, r);
+    return r;
+}
+
+/* ========== Expressões ========== */
+
+/*
+ * Mesma convenção do gerador de assembly: gerar_valor(j, e, c, bi, br)
+ * deixa o valor no temporário bi (inteiro) ou br (real) e pode usar os
+ * de índice maior; a ordem dos operandos só é trocada quando no máximo
+ * um dos dois pode interromper a execução.
+ */
+static void gerar_valor(Jit *j, NoExpr *expr, Classe c, int bi, int br);
+static void gerar_desvio(Jit *j, NoExpr *expr, int sentido, int rotulo, int bi, int br);
+
+/* Guarda o temporário k na próxima posição de derramamento da pilha */
+static Operando derramar(Jit *j, Classe c, int k) {
+    Operando o = memoria(RSP, j->derrames * 8);
+    j->derrames++;
+    if (j->derrames > j->maior_derrame) {
+        j->maior_derrame = j->derrames;
+    }
+    guardar_reg(j, c, &o, reg_classe(c, k));
+    return o;
+}
+
+/* Avalia os operandos; retorna 1 se ocupou uma posição de derramamento */
+static int gerar_operandos(Jit *j, NoExpr *a, NoExpr *b, Classe c, int divisao,
+                           int bi, int br, Operando *esq, Operando *dir) {
+    int k = base(c, bi, br);
+    int limite = c == CLASSE_INTEIRO ? NUM_INTEIROS : NUM_REAIS;
+
+    if (operando_direto(b, c, divisao, dir)) {
+        gerar_valor(j, a, c, bi, br);
+        *esq = em_reg(reg_classe(c, k));
+        return 0;
+    }
+
+    RotuloExpr ra = rotular(j, a);
+    RotuloExpr rb = rotular(j, b);
+    int inverter = rb.registradores > ra.registradores && !(ra.pode_falhar && rb.pode_falhar);
+    NoExpr *primeiro = inverter ? b : a;
+    NoExpr *segundo = inverter ? a : b;
+    Operando *o1 = inverter ? dir : esq;
+    Operando *o2 = inverter ? esq : dir;
+
+    gerar_valor(j, primeiro, c, bi, br);
+    if (k + 1 < limite) {
+        gerar_valor(j, segundo, c, bi + (c == CLASSE_INTEIRO), br + (c == CLASSE_REAL));
+        *o1 = em_reg(reg_classe(c, k));
+        *o2 = em_reg(reg_classe(c, k + 1));
+        return 0;
+    }
+
+    *o1 = derramar(j, c, k);
+    gerar_valor(j, segundo, c, bi, br);
+    *o2 = em_reg(reg_classe(c, k));
+    return 1;
+}
+
+static void liberar_derrame(Jit *j, int derramou) {
+    if (derramou) {
+        j->derrames--;
+    }
+}
+
+/*
+ * Calcula o índice de 'var' no temporário bi, verifica os limites se
+ * não foram provados e devolve o elemento (%rbx + %rax * 8 + desloc)
+ */
+static Operando endereco_elemento(Jit *j, NoVar *var, int bi, int br) {
+    EntradaSimbolo *s = var->simbolo;
+    int r = inteiros[bi];
+    Operando ri = em_reg(r);
+    Operando o = memoria(RBX, s->slot * (int32_t)sizeof(Valor));
+
+    gerar_valor(j, var->indice, CLASSE_INTEIRO, bi, br);
+    if (var->limite == LIMITE_SEGURO) {
+        instrucao(j, 0, 0x63, 1, RAX, &ri);                     /* movslq */
+        o.desloc -= (int32_t)sizeof(Valor);
+    } else {
+        /* 1 <= i <= tamanho  <=>  (unsigned)(i - 1) < tamanho */
+        Operando menos_um = memoria(r, -1);
+        Operando a = em_reg(RAX);
+        instrucao(j, 0, 0x8D, 0, RAX, &menos_um);               /* lea -1(r), %eax */
+        instrucao(j, 0, 0x81, 0, 7, &a);                        /* cmp $tamanho, %eax */
+        dword(j, (uint32_t)s->tamanho_array);
+        jcc(j, CC_AE, saida_erro(j, var->linha, r, s->tamanho_array, var->chave));
+    }
+    o.indice = RAX;
+    o.escala = 3;
+    return o;
+}
+
+static void gerar_aritmetica(Jit *j, NoExpr *expr, Classe c, int bi, int br) {
+    OpAritmetico op = expr->dado.aritmetica.op;
+    NoExpr *dir_expr = expr->dado.aritmetica.dir;
+    int divisao = op == ARIT_DIV && c == CLASSE_INTEIRO;
+    int rk = reg_classe(c, base(c, bi, br));
+    Operando esq, dir;
+    int derramou = gerar_operandos(j, expr->dado.aritmetica.esq, dir_expr, c, divisao,
+                                   bi, br, &esq, &dir);
+
+    if (divisao) {
+        Operando d = em_reg(rk);
+        Operando a = em_reg(RAX);
+        int v;
+        int constante = valor_divisor(dir_expr, &v);
+        if (!constante || v == 0) {
+            if (dir.tipo == OPERANDO_REG) {
+                instrucao(j, 0, 0x85, 0, dir.reg, &dir);        /* test */
+            } else {
+                instrucao(j, 0, 0x81, 0, 7, &dir);              /* cmp $0 */
+                dword(j, 0);
+            }
+            jcc(j, CC_E, saida_erro(j, expr->linha, ERRO_DIVISAO_ZERO, 0, 0));
+        }
+        mover32(j, RAX, &esq);
+        /* INT_MIN / -1 não cabe em 32 bits (idiv geraria #DE) */
+        if (!constante) {
+            int continua = novo_rotulo(j);
+            instrucao(j, 0, 0x81, 0, 7, &dir);                  /* cmp $-1 */
+            dword(j, 0xFFFFFFFFu);
+            jcc(j, CC_NE, continua);
+            instrucao(j, 0, 0x81, 0, 7, &a);                    /* cmp $INT_MIN, %eax */
+            dword(j, 0x80000000u);
+            jcc(j, CC_E, saida_erro(j, expr->linha, ERRO_ESTOURO, 0, 0));
+            marcar_rotulo(j, continua);
+        } else if (v == -1) {
+            instrucao(j, 0, 0x81, 0, 7, &a);
+            dword(j, 0x80000000u);
+            jcc(j, CC_E, saida_erro(j, expr->linha, ERRO_ESTOURO, 0, 0));
+        }
+        byte(j, 0x99);                                          /* cltd */
+        instrucao(j, 0, 0xF7, 0, 7, &dir);                      /* idiv */
+        instrucao(j, 0, 0x89, 0, RAX, &d);
+        liberar_derrame(j, derramou);
+        return;
+    }
+
+    int comutativa = op == ARIT_SOMA || op == ARIT_MULT;
+    if (esq.tipo == OPERANDO_REG && esq.reg == rk) {
+        alu(j, c, op, rk, &dir);
+    } else if (comutativa && dir.tipo == OPERANDO_REG && dir.reg == rk) {
+        alu(j, c, op, rk, &esq);
+    } else if (esq.tipo == OPERANDO_REG) {
+        alu(j, c, op, esq.reg, &dir);
+        if (c == CLASSE_INTEIRO) {
+            mover32(j, rk, &esq);
+        } else {
+            mover_real(j, rk, &esq);
+        }
+    } else {
+        /* Esquerdo na pilha e direito no temporário: passa pelo auxiliar */
+        int aux = c == CLASSE_INTEIRO ? RAX : XMM_AUX;
+        Operando o = em_reg(aux);
+        if (c == CLASSE_INTEIRO) {
+            mover32(j, aux, &esq);
+            alu(j, c, op, aux, &dir);
+            mover32(j, rk, &o);
+        } else {
+            mover_real(j, aux, &esq);
+            alu(j, c, op, aux, &dir);
+            mover_real(j, rk, &o);
+        }
+    }
+    liberar_derrame(j, derramou);
+}
+
+/* Compara os operandos de uma relacional e diz o que testar nas flags */
+static int gerar_comparacao(Jit *j, NoExpr *expr, int bi, int br) {
+    static const int inteiras[] = { CC_G, CC_GE, CC_L, CC_LE, CC_E, CC_NE };
+    NoExpr *a = expr->dado.relacional.esq;
+    NoExpr *b = expr->dado.relacional.dir;
+    OpRelacional op = expr->dado.relacional.op;
+    Classe c = (classe_expr(a) == CLASSE_REAL || classe_expr(b) == CLASSE_REAL)
+               ? CLASSE_REAL : CLASSE_INTEIRO;
+    Operando esq, dir;
+    int derramou = gerar_operandos(j, a, b, c, 0, bi, br, &esq, &dir);
+
+    if (c == CLASSE_INTEIRO) {
+        if (esq.tipo == OPERANDO_REG) {
+            alu(j, c, ALU_CMP, esq.reg, &dir);
+        } else {
+            instrucao(j, 0, 0x39, 0, dir.reg, &esq);            /* cmp reg, mem */
+        }
+        liberar_derrame(j, derramou);
+        return inteiras[op];
+    }
+
+    /* a < b e a <= b viram b > a e b >= a: NaN cai no lado falso */
+    Operando *destino = &esq;
+    Operando *fonte = &dir;
+    if (op == REL_MEQ || op == REL_MEI ||
+        ((op == REL_IGU || op == REL_DIF) && esq.tipo != OPERANDO_REG)) {
+        destino = &dir;
+        fonte = &esq;
+    }
+    if (destino->tipo != OPERANDO_REG) {
+        mover_real(j, XMM_AUX, destino);
+        alu(j, c, ALU_CMP, XMM_AUX, fonte);
+    } else {
+        alu(j, c, ALU_CMP, destino->reg, fonte);
+    }
+    liberar_derrame(j, derramou);
+
+    switch (op) {
+        case REL_MAQ:
+        case REL_MEQ:
+            return CC_A;
+        case REL_MAI:
+        case REL_MEI:
+            return CC_AE;
+        case REL_IGU:
+            return COND_E_REAL;
+        default:
+            return COND_NE_REAL;
+    }
+}
+
+static void desviar(Jit *j, int cond, int sentido, int rotulo) {
+    if (cond == COND_E_REAL || cond == COND_NE_REAL) {
+        /* PF = 1 indica NaN, que torna == falso e != verdadeiro */
+        if ((cond == COND_E_REAL) == (sentido != 0)) {
+            int pula = novo_rotulo(j);
+            jcc(j, CC_P, pula);
+            jcc(j, CC_E, rotulo);
+            marcar_rotulo(j, pula);
+        } else {
+            jcc(j, CC_P, rotulo);
+            jcc(j, CC_NE, rotulo);
+        }
+        return;
+    }
+    jcc(j, sentido ? cond : cond ^ 1, rotulo);
+}
+
+/* setcc %al (e %dl para NaN), depois movzbl %al para o temporário bi */
+static void marcar_condicao(Jit *j, int cond, int bi) {
+    Operando al = em_reg(RAX);
+    Operando dl = em_reg(RDX);
+    if (cond == COND_E_REAL || cond == COND_NE_REAL) {
+        int e = cond == COND_E_REAL;
+        instrucao(j, 0, 0x0F90 + (e ? CC_E : CC_NE), 0, 0, &al);
+        instrucao(j, 0, 0x0F90 + (e ? CC_NP : CC_P), 0, 0, &dl);
+        instrucao(j, 0, e ? 0x20 : 0x08, 0, RDX, &al);          /* andb/orb %dl, %al */
+    } else {
+        instrucao(j, 0, 0x0F90 + cond, 0, 0, &al);
+    }
+    instrucao(j, 0, 0x0FB6, 0, inteiros[bi], &al);
+}
+
+static void gerar_valor(Jit *j, NoExpr *expr, Classe c, int bi, int br) {
+    Classe propria = classe_expr(expr);
+    int destino = reg_classe(c, base(c, bi, br));
+    Operando o;
+
+    if (operando_direto(expr, c, 0, &o)) {
+        if (c == CLASSE_INTEIRO) {
+            mover32(j, destino, &o);
+        } else {
+            mover_real(j, destino, &o);
+        }
+        return;
+    }
+    if (c == CLASSE_REAL && (expr->tipo == EXPR_CONST_INT || expr->tipo == EXPR_CONST_REAL)) {
+        carregar_real(j, destino, expr->tipo == EXPR_CONST_INT ? (double)expr->dado.const_int
+                                                               : expr->dado.const_real);
+        return;
+    }
+
+    /* Conversões implícitas: INTEIRO promovido a REAL, REAL truncado */
+    if (propria != c) {
+        unsigned conversao = c == CLASSE_REAL ? 0x0F2A : 0x0F2C;   /* cvtsi2sd, cvttsd2si */
+        if (!operando_direto(expr, propria, 0, &o) || o.tipo == OPERANDO_IMEDIATO) {
+            gerar_valor(j, expr, propria, bi, br);
+            o = em_reg(reg_classe(propria, base(propria, bi, br)));
+        }
+        instrucao(j, 0xF2, conversao, 0, destino, &o);
+        return;
+    }
+
+    switch (expr->tipo) {
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            o = endereco_elemento(j, expr->dado.var, bi, br);
+            if (c == CLASSE_INTEIRO) {
+                mover32(j, destino, &o);
+            } else {
+                mover_real(j, destino, &o);
+            }
+            break;
+
+        case EXPR_ARITMETICA:
+            gerar_aritmetica(j, expr, c, bi, br);
+            break;
+
+        case EXPR_RELACIONAL:
+            marcar_condicao(j, gerar_comparacao(j, expr, bi, br), bi);
+            break;
+
+        case EXPR_LOGICA:
+        case EXPR_NAO:
+            {
+                int falso = novo_rotulo(j);
+                int fim = novo_rotulo(j);
+                Operando um = imediato(1);
+                Operando zero = imediato(0);
+                gerar_desvio(j, expr, 0, falso, bi, br);
+                mover32(j, destino, &um);
+                jmp(j, fim);
+                marcar_rotulo(j, falso);
+                mover32(j, destino, &zero);
+                marcar_rotulo(j, fim);
+            }
+            break;
+
+        case EXPR_NEG:
+            gerar_valor(j, expr->dado.negacao, c, bi, br);
+            o = em_reg(destino);
+            if (c == CLASSE_INTEIRO) {
+                instrucao(j, 0, 0xF7, 0, 3, &o);                /* neg */
+            } else {
+                Operando aux = em_reg(XMM_AUX);
+                Operando a = em_reg(RAX);
+                movabs(j, RAX, 0x8000000000000000ULL);
+                instrucao(j, 0x66, 0x0F6E, 1, XMM_AUX, &a);     /* movq */
+                instrucao(j, 0x66, 0x0F57, 0, destino, &aux);   /* xorpd */
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Desvia para 'rotulo' se o valor lógico de 'expr' for 'sentido' (curto-circuito em .E. e .OU.) */
+static void gerar_desvio(Jit *j, NoExpr *expr, int sentido, int rotulo, int bi, int br) {
+    Operando o;
+
+    switch (expr->tipo) {
+        case EXPR_RELACIONAL:
+            desviar(j, gerar_comparacao(j, expr, bi, br), sentido, rotulo);
+            return;
+
+        case EXPR_LOGICA:
+            {
+                int decide = expr->dado.logica.op == LOG_E ? 0 : 1;
+                if (sentido == decide) {
+                    gerar_desvio(j, expr->dado.logica.esq, decide, rotulo, bi, br);
+                    gerar_desvio(j, expr->dado.logica.dir, decide, rotulo, bi, br);
+                } else {
+                    int pula = novo_rotulo(j);
+                    gerar_desvio(j, expr->dado.logica.esq, decide, pula, bi, br);
+                    gerar_desvio(j, expr->dado.logica.dir, sentido, rotulo, bi, br);
+                    marcar_rotulo(j, pula);
+                }
+            }
+            return;
+
+        case EXPR_NAO:
+            gerar_desvio(j, expr->dado.negacao, !sentido, rotulo, bi, br);
+            return;
+
+        default:
+            break;
+    }
+
+    if (operando_direto(expr, CLASSE_INTEIRO, 0, &o)) {
+        if (o.tipo == OPERANDO_IMEDIATO) {
+            if ((o.valor != 0) == (sentido != 0)) {
+                jmp(j, rotulo);
+            }
+            return;
+        }
+        instrucao(j, 0, 0x81, 0, 7, &o);                        /* cmp $0 */
+        dword(j, 0);
+    } else {
+        gerar_valor(j, expr, CLASSE_INTEIRO, bi, br);
+        o = em_reg(inteiros[bi]);
+        instrucao(j, 0, 0x85, 0, o.reg, &o);                    /* test */
+    }
+    jcc(j, sentido ? CC_NE : CC_E, rotulo);
+}
+
+/* ========== Comandos ========== */
+
+/* Grava na variável o valor já calculado (temporário 0 da classe, ou imediato) */
+static void guardar(Jit *j, NoVar *var, const Operando *valor) {
+    Classe c = classe_var(var);
+    Operando destino;
+
+    if (!posicao_fixa(var, &destino)) {
+        /* O índice é avaliado depois do valor, como no interpretador */
+        int ocupa = valor->tipo == OPERANDO_IMEDIATO ? 0 : 1;
+        destino = endereco_elemento(j, var, c == CLASSE_INTEIRO ? ocupa : 0,
+                                    c == CLASSE_REAL ? ocupa : 0);
+    }
+    if (valor->tipo == OPERANDO_IMEDIATO) {
+        instrucao(j, 0, 0xC7, 0, 0, &destino);
+        dword(j, (uint32_t)valor->valor);
+    } else {
+        guardar_reg(j, c, &destino, valor->reg);
+    }
+}
+
+static void gerar_comando(Jit *j, NoCmd *cmd);
+
+static void gerar_comandos(Jit *j, NoCmd *cmd) {
+    while (cmd != NULL) {
+        gerar_comando(j, cmd);
+        cmd = cmd->prox;
+    }
+}
+
+static void gerar_comando(Jit *j, NoCmd *cmd) {
+    Operando o;
+
+    switch (cmd->tipo) {
+        case CMD_ATRIB:
+            {
+                NoVar *var = cmd->dado.atrib.var;
+                Classe c = classe_var(var);
+                if (!(c == CLASSE_INTEIRO && operando_direto(cmd->dado.atrib.expr, c, 0, &o) &&
+                      o.tipo == OPERANDO_IMEDIATO)) {
+                    gerar_valor(j, cmd->dado.atrib.expr, c, 0, 0);
+                    o = em_reg(reg_classe(c, 0));
+                }
+                guardar(j, var, &o);
+            }
+            break;
+
+        case CMD_LEIA:
+            {
+                Operando linha = imediato(cmd->linha);
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    Classe c = classe_var(v->var);
+                    mover32(j, RDI, &linha);
+                    if (c == CLASSE_REAL) {
+                        chamar(j, ENDERECO(ler_real));
+                    } else {
+                        Operando a = em_reg(RAX);
+                        chamar(j, ENDERECO(ler_inteiro));
+                        mover32(j, inteiros[0], &a);
+                    }
+                    o = em_reg(reg_classe(c, 0));
+                    guardar(j, v->var, &o);
+                }
+            }
+            break;
+
+        case CMD_ESCREVA:
+            for (ListaEscreva *e = cmd->dado.escreva; e != NULL; e = e->prox) {
+                if (e->is_cadeia) {
+                    movabs(j, RDI, ENDERECO(e->item.cadeia));
+                    chamar(j, ENDERECO(escrever_cadeia));
+                } else if (e->item.expr->tipo_dado == TIPO_REAL) {
+                    gerar_valor(j, e->item.expr, CLASSE_REAL, 0, 0);
+                    chamar(j, ENDERECO(escrever_real));
+                } else {
+                    if (!operando_direto(e->item.expr, CLASSE_INTEIRO, 0, &o)) {
+                        gerar_valor(j, e->item.expr, CLASSE_INTEIRO, 0, 0);
+                        o = em_reg(inteiros[0]);
+                    }
+                    mover32(j, RDI, &o);
+                    chamar(j, ENDERECO(escrever_inteiro));
+                }
+            }
+            chamar(j, ENDERECO(escrever_fim_linha));
+            break;
+
+        case CMD_SE:
+            {
+                int senao = novo_rotulo(j);
+                gerar_desvio(j, cmd->dado.se.condicao, 0, senao, 0, 0);
+                gerar_comandos(j, cmd->dado.se.entao);
+                if (cmd->dado.se.senao != NULL) {
+                    int fim = novo_rotulo(j);
+                    jmp(j, fim);
+                    marcar_rotulo(j, senao);
+                    gerar_comandos(j, cmd->dado.se.senao);
+                    marcar_rotulo(j, fim);
+                } else {
+                    marcar_rotulo(j, senao);
+                }
+            }
+            break;
+
+        case CMD_ENQUANTO:
+            {
+                /* Laço invertido; o trecho de um ENQUANTO começa pelo teste */
+                int teste = novo_rotulo(j);
+                int corpo = novo_rotulo(j);
+                jmp(j, teste);
+                marcar_rotulo(j, corpo);
+                gerar_comandos(j, cmd->dado.enquanto.corpo);
+                marcar_rotulo(j, teste);
+                gerar_desvio(j, cmd->dado.enquanto.condicao, 1, corpo, 0, 0);
+            }
+            break;
+    }
+}
+
+/* ========== Trecho ========== */
+
+static const char formato_indice[] = "Indice %d fora dos limites de '%s' (1..%d)";
+static const char formato_divisao[] = "Divisao inteira por zero";
+static const char formato_estouro[] = "Estouro na divisao inteira";
+
+/* Chamadas a erro_execucao, que não retorna; o índice vai primeiro para %edx */
+static void gerar_erros(Jit *j, CodigoJit *codigo) {
+    codigo->nomes = calloc(j->num_erros > 0 ? (size_t)j->num_erros : 1, sizeof(*codigo->nomes));
+    if (codigo->nomes == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para o JIT\n");
+        exit(1);
+    }
+    for (int i = 0; i < j->num_erros; i++) {
+        SaidaErro *e = &j->erros[i];
+        Operando linha = imediato(e->linha);
+        Operando a = em_reg(RAX);
+        marcar_rotulo(j, e->rotulo);
+        if (e->reg_indice >= 0) {
+            Operando r = em_reg(e->reg_indice);
+            Operando tamanho = imediato(e->tamanho);
+            mover32(j, RDX, &r);
+            mover32(j, RDI, &linha);
+            movabs(j, RSI, ENDERECO(formato_indice));
+            texto_id(e->chave, codigo->nomes[i]);
+            movabs(j, RCX, ENDERECO(codigo->nomes[i]));
+            mover32(j, R8, &tamanho);
+        } else {
+            mover32(j, RDI, &linha);
+            movabs(j, RSI, e->reg_indice == ERRO_ESTOURO ? ENDERECO(formato_estouro)
+                                                         : ENDERECO(formato_divisao));
+        }
+        instrucao(j, 0, 0x31, 0, RAX, &a);                      /* xor %eax, %eax (variádica) */
+        chamar(j, ENDERECO(erro_execucao));
+    }
+}
+
+static const int preservados[] = { RBP, RBX, R12, R13, R14, R15 };
+#define NUM_PRESERVADOS 6
+
+CodigoJit *compilar_jit(NoCmd *cmd, int sequencia) {
+    Jit j;
+    CodigoJit *codigo;
+    size_t pos_reserva, pos_devolve;
+    Operando rsp = em_reg(RSP);
+    Operando rbx = em_reg(RBX);
+
+    memset(&j, 0, sizeof(j));
+    codigo = calloc(1, sizeof(CodigoJit));
+    if (codigo == NULL) {
+        return NULL;
+    }
+
+    /* void trecho(Valor *quadro): preserva os registradores, quadro em %rbx */
+    for (int i = 0; i < NUM_PRESERVADOS; i++) {
+        if (preservados[i] & 8) byte(&j, 0x41);
+        byte(&j, 0x50 + (preservados[i] & 7));
+    }
+    instrucao(&j, 0, 0x81, 1, 5, &rsp);                         /* subq $pilha, %rsp */
+    pos_reserva = j.tamanho;
+    dword(&j, 0);
+    instrucao(&j, 0, 0x89, 1, RDI, &rbx);                       /* movq %rdi, %rbx */
+
+    if (sequencia) {
+        gerar_comandos(&j, cmd);
+    } else {
+        gerar_comando(&j, cmd);
+    }
+
+    instrucao(&j, 0, 0x81, 1, 0, &rsp);                         /* addq $pilha, %rsp */
+    pos_devolve = j.tamanho;
+    dword(&j, 0);
+    for (int i = NUM_PRESERVADOS - 1; i >= 0; i--) {
+        if (preservados[i] & 8) byte(&j, 0x41);
+        byte(&j, 0x58 + (preservados[i] & 7));
+    }
+    byte(&j, 0xC3);
+
+    gerar_erros(&j, codigo);
+
+    /* Derramamentos, com %rsp alinhado em 16 nas chamadas (6 push + retorno = 56 bytes) */
+    uint32_t pilha = (uint32_t)j.maior_derrame * 8;
+    if (pilha % 16 == 0) {
+        pilha += 8;
+    }
+    for (int i = 0; i < 4; i++) {
+        j.codigo[pos_reserva + i] = (unsigned char)(pilha >> (8 * i));
+        j.codigo[pos_devolve + i] = (unsigned char)(pilha >> (8 * i));
+    }
+    for (int i = 0; i < j.num_desvios; i++) {
+        Desvio *d = &j.desvios[i];
+        int32_t rel = (int32_t)((long)j.rotulos[d->rotulo] - (long)(d->posicao + 4));
+        memcpy(j.codigo + d->posicao, &rel, sizeof(int32_t));
+    }
+
+    /* W^X: copia para páginas graváveis e só então as torna executáveis */
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    codigo->tamanho = j.tamanho;
+    codigo->mapeado = (j.tamanho + pagina - 1) / pagina * pagina;
+    void *mem = mmap(NULL, codigo->mapeado, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem != MAP_FAILED) {
+        memcpy(mem, j.codigo, j.tamanho);
+        if (mprotect(mem, codigo->mapeado, PROT_READ | PROT_EXEC) != 0) {
+            munmap(mem, codigo->mapeado);
+            mem = MAP_FAILED;
+        }
+    }
+
+    free(j.codigo);
+    free(j.rotulos);
+    free(j.desvios);
+    free(j.erros);
+    free(j.memo);
+    if (mem == MAP_FAILED) {
+        free(codigo->nomes);
+        free(codigo);
+        return NULL;
+    }
+    codigo->memoria = mem;
+    return codigo;
+}
+
+void executar_jit(const CodigoJit *codigo, Valor *quadro) {
+    void (*trecho)(Valor *);
+    void *inicio = codigo->memoria;
+    memcpy(&trecho, &inicio, sizeof(trecho));
+    trecho(quadro);
+}
+
+#else /* !__x86_64__ */
+
+CodigoJit *compilar_jit(NoCmd *cmd, int sequencia) {
+    (void)cmd;
+    (void)sequencia;
+    return NULL;
+}
+
+void executar_jit(const CodigoJit *codigo, Valor *quadro) {
+    (void)codigo;
+    (void)quadro;
+}
+
+#endif
+
+size_t tamanho_jit(const CodigoJit *codigo) {
+    return codigo->tamanho;
+}
+
+void liberar_jit(CodigoJit *codigo) {
+    if (codigo == NULL) {
+        return;
+    }
+    munmap(codigo->memoria, codigo->mapeado);
+    free(codigo->nomes);
+    free(codigo);
+}
@@ -0,0 +1,39 @@
+/*
+ * Compilação em tempo de execução (JIT) para x86-64 (opção --jit)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+#include "ast.h"
+#include "runtime.h"
+
+/* Código de máquina de um trecho do programa, pronto para executar */
+typedef struct CodigoJit CodigoJit;
+
+/*
+ * Compila 'cmd' (com 'sequencia', também os comandos seguintes) para
+ * x86-64, num buffer obtido com mmap que recebe o código gravável e só
+ * depois vira executável (nunca os dois ao mesmo tempo). O código
+ * trabalha sobre o quadro de variáveis do interpretador, indexado pelo
+ * slot de cada símbolo, e é especializado pelo tipo_dado de cada nó:
+ * inteiros em registradores de uso geral, reais em SSE2. LEIA, ESCREVA
+ * e os erros de execução chamam o runtime (runtime.h). O programa deve
+ * ter passado pela análise semântica sem erros.
+ *
+ * Retorna NULL se a plataforma não for x86-64 ou se a memória
+ * executável não puder ser obtida; quem chama continua interpretando.
+ */
+CodigoJit *compilar_jit(NoCmd *cmd, int sequencia);
+
+/* Executa o trecho até o fim (os erros de execução encerram o programa) */
+void executar_jit(const CodigoJit *codigo, Valor *quadro);
+
+/* Bytes de código de máquina do trecho */
+size_t tamanho_jit(const CodigoJit *codigo);
+
+void liberar_jit(CodigoJit *codigo);
+
+#endif /* JIT_H */
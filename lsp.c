@@ -0,0 +1,1401 @@
+/*
+ * Implementação do servidor LSP
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "lsp.h"
+#include "contexto.h"
+#include "semantic.h"
+#include "fluxo.h"
+#include "intervalos.h"
+#include "cache.h"
+
+/* Maior mensagem aceita (o texto inteiro de um documento vem em didOpen) */
+#define LSP_MAX_MENSAGEM (256u * 1024 * 1024)
+
+/* Objetos e listas JSON aninhados além disto são rejeitados */
+#define JSON_MAX_PROFUNDIDADE 64
+
+/*
+ * As ASTs dos trechos reanalisados se acumulam na arena do documento;
+ * quando ela passa do dobro do que a última análise completa usou (mais
+ * esta folga), a próxima edição refaz a análise completa e a compacta.
+ */
+#define LSP_FOLGA_ARENA (1u << 20)
+
+/* Códigos de erro do JSON-RPC */
+#define JSONRPC_JSON_INVALIDO (-32700)
+#define JSONRPC_REQUISICAO_INVALIDA (-32600)
+#define JSONRPC_METODO_DESCONHECIDO (-32601)
+
+/* ========== Leitura de JSON ========== */
+
+typedef enum {
+    JSON_NULO,
+    JSON_BOOLEANO,
+    JSON_NUMERO,
+    JSON_CADEIA,
+    JSON_LISTA,
+    JSON_OBJETO
+} TipoJson;
+
+/* Valor lido; os nós e as cadeias decodificadas ficam numa arena */
+typedef struct ValorJson {
+    TipoJson tipo;
+    double numero;              /* JSON_NUMERO; 0 ou 1 em JSON_BOOLEANO */
+    const char *cadeia;         /* JSON_CADEIA, sem escapes, terminada em '\0' */
+    size_t tamanho;
+    const char *chave;          /* Nome do membro, quando dentro de um objeto */
+    const char *bruto;          /* O valor como veio na mensagem (para ecoar o id) */
+    size_t tamanho_bruto;
+    struct ValorJson *filhos;   /* Elementos da lista ou membros do objeto */
+    struct ValorJson *prox;
+} ValorJson;
+
+typedef struct {
+    const char *p;
+    const char *fim;
+    Arena *arena;
+    int profundidade;
+} LeitorJson;
+
+static void pular_espacos(LeitorJson *l) {
+    while (l->p < l->fim && (*l->p == ' ' || *l->p == '\t' || *l->p == '\n' || *l->p == '\r')) {
+        l->p++;
+    }
+}
+
+static int hex4(const char *p, unsigned *valor) {
+    *valor = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        *valor <<= 4;
+        if (c >= '0' && c <= '9') *valor |= (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') *valor |= (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') *valor |= (unsigned)(c - 'A' + 10);
+        else return 0;
+    }
+    return 1;
+}
+
+static char *utf8(char *q, unsigned cp) {
+    if (cp < 0x80) {
+        *q++ = (char)cp;
+    } else if (cp < 0x800) {
+        *q++ = (char)(0xC0 | (cp >> 6));
+        *q++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *q++ = (char)(0xE0 | (cp >> 12));
+        *q++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *q++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *q++ = (char)(0xF0 | (cp >> 18));
+        *q++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *q++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *q++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return q;
+}
+
+/* Cadeia a partir da aspa inicial; um escape nunca ocupa menos bytes decodificado */
+static int ler_cadeia(LeitorJson *l, const char **cadeia, size_t *tamanho) {
+    const char *p = ++l->p;
+    while (p < l->fim && *p != '"') {
+        p += (*p == '\\') ? 2 : 1;
+    }
+    if (p >= l->fim) return 0;
+
+    char *q = (char *)arena_alocar(l->arena, (size_t)(p - l->p) + 1);
+    *cadeia = q;
+    while (l->p < p) {
+        char c = *l->p++;
+        if (c != '\\') {
+            *q++ = c;
+            continue;
+        }
+        c = *l->p++;
+        switch (c) {
+            case '"': case '\\': case '/': *q++ = c; break;
+            case 'b': *q++ = '\b'; break;
+            case 'f': *q++ = '\f'; break;
+            case 'n': *q++ = '\n'; break;
+            case 'r': *q++ = '\r'; break;
+            case 't': *q++ = '\t'; break;
+            case 'u': {
+                unsigned cp, baixo;
+                if (p - l->p < 4 || !hex4(l->p, &cp)) return 0;
+                l->p += 4;
+                /* Par substituto do UTF-16 */
+                if (cp >= 0xD800 && cp < 0xDC00 && p - l->p >= 6 && l->p[0] == '\\' &&
+                    l->p[1] == 'u' && hex4(l->p + 2, &baixo) && baixo >= 0xDC00 && baixo < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (baixo - 0xDC00);
+                    l->p += 6;
+                }
+                q = utf8(q, cp);
+                break;
+            }
+            default:
+                return 0;
+        }
+    }
+    *q = '\0';
+    *tamanho = (size_t)(q - *cadeia);
+    l->p = p + 1;
+    return 1;
+}
+
+static ValorJson *ler_valor(LeitorJson *l);
+
+/* Elementos de uma lista ou membros de um objeto, até 'fecha' */
+static int ler_filhos(LeitorJson *l, ValorJson *v, char fecha) {
+    ValorJson **ultimo = &v->filhos;
+
+    l->p++;
+    pular_espacos(l);
+    if (l->p < l->fim && *l->p == fecha) {
+        l->p++;
+        return 1;
+    }
+    for (;;) {
+        const char *chave = NULL;
+        size_t tam_chave;
+
+        pular_espacos(l);
+        if (fecha == '}') {
+            if (l->p >= l->fim || *l->p != '"' || !ler_cadeia(l, &chave, &tam_chave)) return 0;
+            pular_espacos(l);
+            if (l->p >= l->fim || *l->p != ':') return 0;
+            l->p++;
+        }
+        ValorJson *filho = ler_valor(l);
+        if (filho == NULL) return 0;
+        filho->chave = chave;
+        *ultimo = filho;
+        ultimo = &filho->prox;
+
+        pular_espacos(l);
+        if (l->p >= l->fim) return 0;
+        if (*l->p == fecha) {
+            l->p++;
+            return 1;
+        }
+        if (*l->p != ',') return 0;
+        l->p++;
+    }
+}
+
+static ValorJson *ler_valor(LeitorJson *l) {
+    pular_espacos(l);
+    if (l->p >= l->fim) return NULL;
+
+    ValorJson *v = (ValorJson *)arena_alocar(l->arena, sizeof(ValorJson));
+    memset(v, 0, sizeof(*v));
+    v->bruto = l->p;
+
+    char c = *l->p;
+    if (c == '{' || c == '[') {
+        if (++l->profundidade > JSON_MAX_PROFUNDIDADE) return NULL;
+        v->tipo = c == '{' ? JSON_OBJETO : JSON_LISTA;
+        if (!ler_filhos(l, v, c == '{' ? '}' : ']')) return NULL;
+        l->profundidade--;
+    } else if (c == '"') {
+        v->tipo = JSON_CADEIA;
+        if (!ler_cadeia(l, &v->cadeia, &v->tamanho)) return NULL;
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+        /* A mensagem termina em '\0', então strtod não passa do fim */
+        char *depois;
+        v->tipo = JSON_NUMERO;
+        v->numero = strtod(l->p, &depois);
+        if (depois == l->p) return NULL;
+        l->p = depois;
+    } else if (l->fim - l->p >= 4 && strncmp(l->p, "true", 4) == 0) {
+        v->tipo = JSON_BOOLEANO;
+        v->numero = 1;
+        l->p += 4;
+    } else if (l->fim - l->p >= 5 && strncmp(l->p, "false", 5) == 0) {
+        v->tipo = JSON_BOOLEANO;
+        l->p += 5;
+    } else if (l->fim - l->p >= 4 && strncmp(l->p, "null", 4) == 0) {
+        v->tipo = JSON_NULO;
+        l->p += 4;
+    } else {
+        return NULL;
+    }
+    v->tamanho_bruto = (size_t)(l->p - v->bruto);
+    return v;
+}
+
+static ValorJson *membro(const ValorJson *objeto, const char *chave) {
+    if (objeto == NULL || objeto->tipo != JSON_OBJETO) return NULL;
+    for (ValorJson *m = objeto->filhos; m != NULL; m = m->prox) {
+        if (strcmp(m->chave, chave) == 0) return m;
+    }
+    return NULL;
+}
+
+static const char *cadeia_de(const ValorJson *v) {
+    return v != NULL && v->tipo == JSON_CADEIA ? v->cadeia : NULL;
+}
+
+static int inteiro_de(const ValorJson *v, int padrao) {
+    return v != NULL && v->tipo == JSON_NUMERO ? (int)v->numero : padrao;
+}
+
+/* ========== Documentos ========== */
+
+/*
+ * Um comando do nível externo de ALGORITMO, do seu primeiro token até o
+ * início do próximo (ou até FIMPROG), com os comentários que o seguem.
+ * Os diagnósticos guardam a linha relativa a 'linha' e, na linha 0, a
+ * coluna relativa a 'coluna': deslocar o trecho não os altera.
+ */
+typedef struct Trecho {
+    size_t inicio;              /* Posição no texto do documento */
+    int linha;
+    int coluna;
+    int linha_ast;              /* Onde o trecho estava quando a AST foi montada */
+    int coluna_ast;
+    NoCmd *comandos;            /* Cadeia só deste trecho (prox) */
+    int erro_sintaxe;
+    ListaDiagnosticos diagnosticos;
+} Trecho;
+
+typedef struct Documento {
+    char *uri;
+    char *texto;
+    size_t tamanho;
+    size_t capacidade;
+    ContextoCompilacao ctx;     /* Dono da AST (arena) e da tabela de símbolos */
+
+    /*
+     * Com 'segmentado', a área ALGORITMO foi dividida em trechos e vai
+     * até 'fim' (o token FIMPROG). Sem isso (cabeçalho ou declarações
+     * com erro, FIMPROG ausente), toda edição refaz a análise completa.
+     */
+    int segmentado;
+    Trecho *trechos;
+    int num_trechos;
+    int capacidade_trechos;
+    size_t fim;
+    int linha_fim;
+    int coluna_fim;
+    int tamanho_fim;
+
+    ListaDiagnosticos gerais;   /* Antes de ALGORITMO, em posição absoluta */
+    ListaDiagnosticos finais;   /* Após FIMPROG, relativos a ele */
+    ListaDiagnosticos programa; /* Das análises do programa inteiro, em posição absoluta */
+    size_t arena_completa;      /* Arena usada pela última análise completa */
+    struct Documento *prox;
+} Documento;
+
+typedef struct {
+    Documento *documentos;
+    MarcasComandos marcas;
+    char *rascunho;             /* Cópia do texto analisado, com dois '\0' */
+    size_t capacidade_rascunho;
+    Arena arena_json;
+    int verbose;
+    int desligado;              /* shutdown recebido */
+
+    /* Latências, para o resumo com -v */
+    long edicoes_incrementais;
+    long trechos_reanalisados;
+    double ms_incrementais;
+    double maior_incremental;
+    long analises_completas;
+    double ms_completas;
+} ServidorLsp;
+
+static double ms_desde(const struct timespec *ini) {
+    struct timespec fim;
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    return (fim.tv_sec - ini->tv_sec) * 1e3 + (fim.tv_nsec - ini->tv_nsec) / 1e6;
+}
+
+static void anexar(ListaDiagnosticos *lista, const Diagnostico *d) {
+    if (lista->num == lista->capacidade) {
+        int nova = lista->capacidade > 0 ? 2 * lista->capacidade : 4;
+        Diagnostico *itens = (Diagnostico *)realloc(lista->itens, nova * sizeof(Diagnostico));
+        if (itens == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para os diagnosticos\n");
+            exit(1);
+        }
+        lista->itens = itens;
+        lista->capacidade = nova;
+    }
+    lista->itens[lista->num++] = *d;
+}
+
+/* Esvazia a lista sem liberar as mensagens, que passaram a outra lista */
+static void esvaziar(ListaDiagnosticos *lista) {
+    lista->num = 0;
+}
+
+static int antes(int linha1, int coluna1, int linha2, int coluna2) {
+    return linha1 < linha2 || (linha1 == linha2 && coluna1 < coluna2);
+}
+
+/* Guarda 'd' em 't', relativo ao início do trecho */
+static void anexar_ao_trecho(Trecho *t, Diagnostico d) {
+    if (d.linha == t->linha) {
+        d.coluna -= t->coluna;
+    }
+    d.linha -= t->linha;
+    if (d.origem == ORIGEM_LEXICA || d.origem == ORIGEM_SINTATICA) {
+        t->erro_sintaxe = 1;
+    }
+    anexar(&t->diagnosticos, &d);
+}
+
+static void liberar_trechos(Trecho *trechos, int n) {
+    for (int i = 0; i < n; i++) {
+        liberar_diagnosticos(&trechos[i].diagnosticos);
+    }
+}
+
+static void limpar_documento(Documento *d) {
+    liberar_trechos(d->trechos, d->num_trechos);
+    d->num_trechos = 0;
+    d->segmentado = 0;
+    liberar_diagnosticos(&d->gerais);
+    liberar_diagnosticos(&d->finais);
+    liberar_diagnosticos(&d->programa);
+}
+
+static Documento *buscar_documento(ServidorLsp *s, const char *uri) {
+    for (Documento *d = s->documentos; d != NULL; d = d->prox) {
+        if (uri != NULL && strcmp(d->uri, uri) == 0) return d;
+    }
+    return NULL;
+}
+
+static void fechar_documento(ServidorLsp *s, Documento *d) {
+    Documento **p = &s->documentos;
+    while (*p != d) p = &(*p)->prox;
+    *p = d->prox;
+
+    limpar_documento(d);
+    liberar_contexto(&d->ctx);
+    free(d->trechos);
+    free(d->texto);
+    free(d->uri);
+    free(d);
+}
+
+/* Texto a analisar, seguido dos dois '\0' que o FLEX exige */
+static char *preparar_rascunho(ServidorLsp *s, const char *texto, size_t tamanho) {
+    if (tamanho + 2 > s->capacidade_rascunho) {
+        size_t nova = s->capacidade_rascunho > 0 ? s->capacidade_rascunho : 64 * 1024;
+        while (nova < tamanho + 2) nova *= 2;
+        char *buf = (char *)realloc(s->rascunho, nova);
+        if (buf == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para o texto do documento\n");
+            exit(1);
+        }
+        s->rascunho = buf;
+        s->capacidade_rascunho = nova;
+    }
+    memcpy(s->rascunho, texto, tamanho);
+    s->rascunho[tamanho] = s->rascunho[tamanho + 1] = '\0';
+    return s->rascunho;
+}
+
+static void substituir_texto(Documento *d, size_t a, size_t b, const char *novo, size_t tam_novo) {
+    size_t tamanho = d->tamanho - (b - a) + tam_novo;
+
+    if (tamanho > d->capacidade) {
+        size_t nova = d->capacidade > 0 ? d->capacidade : 4096;
+        while (nova < tamanho) nova *= 2;
+        char *texto = (char *)realloc(d->texto, nova);
+        if (texto == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para o texto do documento\n");
+            exit(1);
+        }
+        d->texto = texto;
+        d->capacidade = nova;
+    }
+    memmove(d->texto + a + tam_novo, d->texto + b, d->tamanho - b);
+    memcpy(d->texto + a, novo, tam_novo);
+    d->tamanho = tamanho;
+}
+
+/* ========== Posições ========== */
+
+/* Avança de (linha, coluna) sobre 'n' bytes de 'texto' */
+static void avancar_posicao(const char *texto, size_t n, int *linha, int *coluna) {
+    for (size_t i = 0; i < n; i++) {
+        if (texto[i] == '\n') {
+            (*linha)++;
+            *coluna = 1;
+        } else {
+            (*coluna)++;
+        }
+    }
+}
+
+/* Último trecho que começa em 'posicao' ou antes (-1 se nenhum) */
+static int trecho_da_posicao(const Documento *d, size_t posicao) {
+    int lo = 0, hi = d->num_trechos - 1, r = -1;
+    while (lo <= hi) {
+        int meio = (lo + hi) / 2;
+        if (d->trechos[meio].inicio <= posicao) {
+            r = meio;
+            lo = meio + 1;
+        } else {
+            hi = meio - 1;
+        }
+    }
+    return r;
+}
+
+/* Último trecho que começa em (linha, coluna) ou antes (-1 se nenhum) */
+static int trecho_da_linha(const Documento *d, int linha, int coluna) {
+    int lo = 0, hi = d->num_trechos - 1, r = -1;
+    while (lo <= hi) {
+        int meio = (lo + hi) / 2;
+        const Trecho *t = &d->trechos[meio];
+        if (!antes(linha, coluna, t->linha, t->coluna)) {
+            r = meio;
+            lo = meio + 1;
+        } else {
+            hi = meio - 1;
+        }
+    }
+    return r;
+}
+
+/*
+ * Posição no texto de uma posição do LSP (linha e caractere a partir de
+ * 0). A busca parte do trecho que contém a linha, então só percorre o
+ * texto de um comando; sem trechos, parte do início do documento.
+ */
+static size_t posicao_no_texto(const Documento *d, int linha_lsp, int caractere) {
+    int linha = linha_lsp + 1, coluna = caractere + 1;
+    size_t p = 0;
+    int l = 1, c = 1;
+
+    if (d->segmentado && !antes(linha, coluna, d->linha_fim, d->coluna_fim)) {
+        p = d->fim;
+        l = d->linha_fim;
+        c = d->coluna_fim;
+    } else if (d->segmentado) {
+        int k = trecho_da_linha(d, linha, coluna);
+        if (k >= 0) {
+            p = d->trechos[k].inicio;
+            l = d->trechos[k].linha;
+            c = d->trechos[k].coluna;
+        }
+    }
+    while (p < d->tamanho && l < linha) {
+        if (d->texto[p++] == '\n') {
+            l++;
+            c = 1;
+        }
+    }
+    while (p < d->tamanho && c < coluna && d->texto[p] != '\n') {
+        p++;
+        c++;
+    }
+    return p;
+}
+
+/* ========== Análise ========== */
+
+static void preparar_analise(ContextoCompilacao *ctx) {
+    ctx->erros_lexicos = 0;
+    ctx->erros_sintaticos = 0;
+    ctx->erros_semanticos = 0;
+    ctx->avisos = 0;
+    ctx->programa = NULL;
+    liberar_diagnosticos(&ctx->coletados);
+}
+
+/*
+ * Trechos das marcas em s->marcas, analisadas a partir de 'buf' (que
+ * está na posição 'base' do documento). Separa a cadeia de comandos de
+ * cada marca e faz a análise semântica dela, guardando no trecho os
+ * diagnósticos produzidos. Com 'ancorar', o primeiro trecho começa em
+ * 'base' (linha, coluna), e não no seu primeiro token. Retorna o vetor
+ * novo (NULL se não há marcas) e o seu tamanho em *n.
+ */
+static Trecho *montar_trechos(ServidorLsp *s, Documento *d, const char *buf, size_t base,
+                              int ancorar, int linha, int coluna, int *n) {
+    ContextoCompilacao *ctx = &d->ctx;
+    MarcasComandos *m = &s->marcas;
+
+    *n = m->num;
+    if (m->num == 0) return NULL;
+
+    Trecho *novos = (Trecho *)calloc((size_t)m->num, sizeof(Trecho));
+    if (novos == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para os trechos\n");
+        exit(1);
+    }
+    for (int k = 0; k < m->num; k++) {
+        MarcaComando *marca = &m->itens[k];
+        Trecho *t = &novos[k];
+
+        t->inicio = base + (size_t)(marca->texto - buf);
+        t->linha = marca->linha;
+        t->coluna = marca->coluna;
+        if (k == 0 && ancorar) {
+            t->inicio = base;
+            t->linha = linha;
+            t->coluna = coluna;
+        }
+        t->linha_ast = t->linha;
+        t->coluna_ast = t->coluna;
+
+        if (marca->num_comandos > 0) {
+            NoCmd *ultimo = marca->comandos;
+            for (int i = 1; i < marca->num_comandos; i++) {
+                ultimo = ultimo->prox;
+            }
+            ultimo->prox = NULL;
+            marca->comandos->ultimo = ultimo;
+            t->comandos = marca->comandos;
+
+            analisar_comandos(ctx, t->comandos);
+            for (int i = 0; i < ctx->coletados.num; i++) {
+                anexar_ao_trecho(t, ctx->coletados.itens[i]);
+            }
+            esvaziar(&ctx->coletados);
+        }
+    }
+    return novos;
+}
+
+/* O trecho de 'novos' onde fica um diagnóstico da análise sintática */
+static int trecho_do_diagnostico(const Trecho *novos, int n, const Diagnostico *diag) {
+    int r = 0;
+    for (int lo = 0, hi = n - 1; lo <= hi;) {
+        int meio = (lo + hi) / 2;
+        if (!antes(diag->linha, diag->coluna, novos[meio].linha, novos[meio].coluna)) {
+            r = meio;
+            lo = meio + 1;
+        } else {
+            hi = meio - 1;
+        }
+    }
+    return r;
+}
+
+/* Algum erro (léxico, sintático ou semântico) no documento? */
+static int documento_com_erros(const Documento *d) {
+    const ListaDiagnosticos *listas[] = { &d->gerais, &d->finais };
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; i < listas[k]->num; i++) {
+            if (listas[k]->itens[i].severidade == SEVERIDADE_ERRO) return 1;
+        }
+    }
+    for (int k = 0; k < d->num_trechos; k++) {
+        const ListaDiagnosticos *l = &d->trechos[k].diagnosticos;
+        for (int i = 0; i < l->num; i++) {
+            if (l->itens[i].severidade == SEVERIDADE_ERRO) return 1;
+        }
+    }
+    return 0;
+}
+
+#define DESLOCAR(no, primeira, dl, dc) do { \
+        if ((no)->linha == (primeira)) (no)->coluna += (dc); \
+        (no)->linha += (dl); \
+    } while (0)
+
+/*
+ * Leva as posições dos nós de 't' (absolutas, de quando a AST foi
+ * montada) para o lugar atual do trecho, que edições anteriores a ele
+ * deslocaram.
+ */
+static void atualizar_posicoes(Trecho *t) {
+    int primeira = t->linha_ast;
+    int dl = t->linha - t->linha_ast, dc = t->coluna - t->coluna_ast;
+    if (dl == 0 && dc == 0) return;
+
+    PercursoComandos percurso;
+    Pilha pilha;
+    NoCmd *cmd;
+    NoExpr **topo;
+
+    pilha_iniciar(&pilha, sizeof(NoExpr *));
+    iniciar_percurso(&percurso, t->comandos);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        DESLOCAR(cmd, primeira, dl, dc);
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                DESLOCAR(cmd->dado.atrib.var, primeira, dl, dc);
+                if (cmd->dado.atrib.var->indice != NULL) {
+                    *(NoExpr **)pilha_empilhar(&pilha) = cmd->dado.atrib.var->indice;
+                }
+                *(NoExpr **)pilha_empilhar(&pilha) = cmd->dado.atrib.expr;
+                break;
+            case CMD_LEIA:
+                for (ListaVar *l = cmd->dado.leia; l != NULL; l = l->prox) {
+                    DESLOCAR(l->var, primeira, dl, dc);
+                    if (l->var->indice != NULL) {
+                        *(NoExpr **)pilha_empilhar(&pilha) = l->var->indice;
+                    }
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *l = cmd->dado.escreva; l != NULL; l = l->prox) {
+                    if (!l->is_cadeia) {
+                        *(NoExpr **)pilha_empilhar(&pilha) = l->item.expr;
+                    }
+                }
+                break;
+            case CMD_SE:
+                *(NoExpr **)pilha_empilhar(&pilha) = cmd->dado.se.condicao;
+                break;
+            case CMD_ENQUANTO:
+                *(NoExpr **)pilha_empilhar(&pilha) = cmd->dado.enquanto.condicao;
+                break;
+        }
+
+        while ((topo = (NoExpr **)pilha_topo(&pilha)) != NULL) {
+            NoExpr *expr = *topo;
+            pilha_desempilhar(&pilha);
+            DESLOCAR(expr, primeira, dl, dc);
+            switch (expr->tipo) {
+                case EXPR_VAR:
+                case EXPR_VAR_ARRAY:
+                    DESLOCAR(expr->dado.var, primeira, dl, dc);
+                    if (expr->dado.var->indice != NULL) {
+                        *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.var->indice;
+                    }
+                    break;
+                case EXPR_ARITMETICA:
+                case EXPR_RELACIONAL:
+                case EXPR_LOGICA:
+                    *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.aritmetica.esq;
+                    *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.aritmetica.dir;
+                    break;
+                case EXPR_NAO:
+                case EXPR_NEG:
+                    *(NoExpr **)pilha_empilhar(&pilha) = expr->dado.negacao;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    terminar_percurso(&percurso);
+    pilha_liberar(&pilha);
+
+    t->linha_ast = t->linha;
+    t->coluna_ast = t->coluna;
+}
+
+/*
+ * Análises que precisam do ALGORITMO inteiro (leituras sem atribuição,
+ * variáveis sem uso e limites dos índices), refeitas depois de toda
+ * análise, completa ou incremental, em que o documento não tem erros,
+ * como em analisar_semantica. Os trechos são encadeados só durante a
+ * análise, com as posições dos nós atualizadas, e os diagnósticos ficam
+ * em d->programa.
+ */
+static void analisar_programa(Documento *d) {
+    ContextoCompilacao *ctx = &d->ctx;
+    NoPrograma *prog = ctx->programa;
+
+    liberar_diagnosticos(&d->programa);
+    if (prog == NULL || documento_com_erros(d)) return;
+
+    NoCmd *algoritmo = prog->algoritmo;
+    NoCmd *cauda = NULL;
+    if (d->segmentado) {
+        prog->algoritmo = NULL;
+        for (int k = 0; k < d->num_trechos; k++) {
+            Trecho *t = &d->trechos[k];
+            if (t->comandos == NULL) continue;
+            atualizar_posicoes(t);
+            if (cauda != NULL) {
+                cauda->prox = t->comandos;
+            } else {
+                prog->algoritmo = t->comandos;
+            }
+            cauda = t->comandos->ultimo;
+        }
+    }
+
+    ctx->erros_semanticos = 0;
+    verificar_inicializacao(ctx, prog);
+    if (ctx->erros_semanticos == 0) {
+        verificar_limites(ctx, prog);
+    }
+    for (int i = 0; i < ctx->coletados.num; i++) {
+        anexar(&d->programa, &ctx->coletados.itens[i]);
+    }
+    esvaziar(&ctx->coletados);
+
+    if (d->segmentado) {
+        for (int k = 0; k < d->num_trechos; k++) {
+            if (d->trechos[k].comandos != NULL) {
+                d->trechos[k].comandos->ultimo->prox = NULL;
+            }
+        }
+        prog->algoritmo = algoritmo;
+    }
+}
+
+static void analisar_completo(ServidorLsp *s, Documento *d) {
+    ContextoCompilacao *ctx = &d->ctx;
+    struct timespec ini;
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+
+    limpar_documento(d);
+    reiniciar_contexto(ctx, d->uri, DESTINO_LISTA);
+    ctx->relatorio = 0;
+    ctx->mostrar_tabela = 0;
+
+    char *buf = preparar_rascunho(s, d->texto, d->tamanho);
+    s->marcas.num = 0;
+    s->marcas.fim = NULL;
+    ctx->marcas = &s->marcas;
+    analisar_memoria(ctx, buf, d->tamanho);
+    ctx->marcas = NULL;
+
+    NoPrograma *prog = ctx->programa;
+    int declaracoes = 0;
+    for (NoDecl *decl = prog != NULL ? prog->declaracoes : NULL; decl != NULL; decl = decl->prox) {
+        declaracoes++;
+    }
+    inicializar_tabela(ctx, declaracoes);
+    if (prog != NULL) {
+        analisar_declaracoes(ctx, prog->declaracoes);
+    }
+
+    /* Diagnósticos da sintaxe e das declarações: distribuídos por posição */
+    ListaDiagnosticos pendentes = ctx->coletados;
+    memset(&ctx->coletados, 0, sizeof(ctx->coletados));
+
+    d->segmentado = prog != NULL && s->marcas.fim != NULL;
+    if (!d->segmentado) {
+        if (prog != NULL) {
+            analisar_comandos(ctx, prog->algoritmo);
+        }
+        for (int i = 0; i < pendentes.num; i++) {
+            anexar(&d->gerais, &pendentes.itens[i]);
+        }
+        for (int i = 0; i < ctx->coletados.num; i++) {
+            anexar(&d->gerais, &ctx->coletados.itens[i]);
+        }
+        esvaziar(&ctx->coletados);
+    } else {
+        d->fim = (size_t)(s->marcas.fim - buf);
+        d->linha_fim = s->marcas.linha_fim;
+        d->coluna_fim = s->marcas.coluna_fim;
+        d->tamanho_fim = s->marcas.tamanho_fim;
+
+        int n;
+        free(d->trechos);
+        d->trechos = montar_trechos(s, d, buf, 0, 0, 1, 1, &n);
+        d->num_trechos = d->capacidade_trechos = n;
+
+        for (int i = 0; i < pendentes.num; i++) {
+            Diagnostico diag = pendentes.itens[i];
+            if (n == 0 || antes(diag.linha, diag.coluna, d->trechos[0].linha, d->trechos[0].coluna)) {
+                anexar(&d->gerais, &diag);
+            } else if (antes(d->linha_fim, d->coluna_fim + d->tamanho_fim, diag.linha, diag.coluna)) {
+                /* Depois de FIMPROG; um erro no próprio FIMPROG é do último comando */
+                if (diag.linha == d->linha_fim) diag.coluna -= d->coluna_fim;
+                diag.linha -= d->linha_fim;
+                anexar(&d->finais, &diag);
+            } else {
+                anexar_ao_trecho(&d->trechos[trecho_do_diagnostico(d->trechos, n, &diag)], diag);
+            }
+        }
+    }
+    free(pendentes.itens);
+    analisar_programa(d);
+
+    d->arena_completa = ctx->arena.bytes_usados;
+    double ms = ms_desde(&ini);
+    s->analises_completas++;
+    s->ms_completas += ms;
+    if (s->verbose) {
+        fprintf(stderr, ">>> %s: analise completa (%d trecho(s)), %.3f ms\n",
+                d->uri, d->num_trechos, ms);
+    }
+}
+
+/* 'texto' tem a palavra FIMPROG? (um trecho não pode conter o fim do programa) */
+static int contem_fimprog(const char *texto, size_t tamanho) {
+    for (size_t i = 0; i + 7 <= tamanho; i++) {
+        if (texto[i] == 'F' && strncmp(texto + i, "FIMPROG", 7) == 0) return 1;
+    }
+    return 0;
+}
+
+/* Algum erro de sintaxe no fim do texto analisado (comando incompleto)? */
+static int erro_no_fim(const ContextoCompilacao *ctx, int linha, int coluna) {
+    for (int i = 0; i < ctx->coletados.num; i++) {
+        const Diagnostico *diag = &ctx->coletados.itens[i];
+        if (diag->origem == ORIGEM_SINTATICA && diag->linha == linha && diag->coluna == coluna) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Substitui o texto entre as posições 'a' e 'b' e reanalisa só os
+ * trechos atingidos. Retorna 0 se a edição exige a análise completa:
+ * fora de ALGORITMO, inserindo FIMPROG, com a arena já muito grande,
+ * ou com um comando (um SE sem FIMSE) que só termina em FIMPROG.
+ */
+static int editar_incremental(ServidorLsp *s, Documento *d, size_t a, size_t b,
+                              const char *novo, size_t tam_novo) {
+    ContextoCompilacao *ctx = &d->ctx;
+
+    if (!d->segmentado || d->num_trechos == 0 || a < d->trechos[0].inicio || b > d->fim ||
+        contem_fimprog(novo, tam_novo) || ctx->arena.bytes_usados > 2 * d->arena_completa + LSP_FOLGA_ARENA) {
+        substituir_texto(d, a, b, novo, tam_novo);
+        d->segmentado = 0;
+        return 0;
+    }
+    struct timespec ini;
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+
+    /*
+     * Trechos de i a j: os que contêm a edição, o anterior quando ela
+     * começa no limite entre dois (o texto inserido pode continuar o
+     * comando anterior) e os vizinhos com erro de sintaxe, cujo texto
+     * pode formar um comando com o editado (um SE e o seu FIMSE).
+     */
+    int i = trecho_da_posicao(d, a);
+    int j = trecho_da_posicao(d, b);
+    if (i > 0 && a == d->trechos[i].inicio) i--;
+    while (i > 0 && d->trechos[i - 1].erro_sintaxe) i--;
+    while (j + 1 < d->num_trechos && d->trechos[j + 1].erro_sintaxe) j++;
+
+    size_t inicio = d->trechos[i].inicio;
+    int linha = d->trechos[i].linha, coluna = d->trechos[i].coluna;
+    substituir_texto(d, a, b, novo, tam_novo);
+    size_t delta = tam_novo - (b - a);      /* Aritmética módulo 2^n: pode "diminuir" */
+
+    /*
+     * O trecho vira um programa sem cabeçalho (o do documento fica).
+     * Se o texto termina no meio de um comando, o comando continua nos
+     * trechos seguintes, como na análise completa: a análise é refeita
+     * com o dobro de trechos até ele terminar.
+     */
+    NoPrograma *prog = ctx->programa;
+    size_t fim_antigo, tamanho;
+    int linha_antiga, coluna_antiga, linha_nova, coluna_nova;
+    char *buf;
+    for (;;) {
+        if (j + 1 < d->num_trechos) {
+            fim_antigo = d->trechos[j + 1].inicio;
+            linha_antiga = d->trechos[j + 1].linha;
+            coluna_antiga = d->trechos[j + 1].coluna;
+        } else {
+            fim_antigo = d->fim;
+            linha_antiga = d->linha_fim;
+            coluna_antiga = d->coluna_fim;
+        }
+        tamanho = fim_antigo + delta - inicio;
+
+        buf = preparar_rascunho(s, d->texto + inicio, tamanho);
+        preparar_analise(ctx);
+        ctx->linha = linha;
+        ctx->coluna = coluna;
+        ctx->trecho = 1;
+        s->marcas.num = 0;
+        ctx->marcas = &s->marcas;
+        analisar_memoria(ctx, buf, tamanho);
+        ctx->marcas = NULL;
+        ctx->trecho = 0;
+        ctx->programa = prog;
+
+        linha_nova = linha;
+        coluna_nova = coluna;
+        avancar_posicao(buf, tamanho, &linha_nova, &coluna_nova);
+        if (!erro_no_fim(ctx, linha_nova, coluna_nova)) break;
+        if (j + 1 == d->num_trechos) {
+            d->segmentado = 0;
+            return 0;
+        }
+        j += j - i + 1;
+        if (j >= d->num_trechos) j = d->num_trechos - 1;
+    }
+
+    /* Trechos novos; os erros de sintaxe vão para o trecho em que ocorreram */
+    ListaDiagnosticos pendentes = ctx->coletados;
+    memset(&ctx->coletados, 0, sizeof(ctx->coletados));
+    int n;
+    Trecho *novos = montar_trechos(s, d, buf, inicio, 1, linha, coluna, &n);
+    if (n == 0 && pendentes.num > 0) {
+        novos = (Trecho *)calloc(1, sizeof(Trecho));
+        novos->inicio = inicio;
+        novos->linha = novos->linha_ast = linha;
+        novos->coluna = novos->coluna_ast = coluna;
+        n = 1;
+    }
+    for (int k = 0; k < pendentes.num; k++) {
+        anexar_ao_trecho(&novos[trecho_do_diagnostico(novos, n, &pendentes.itens[k])],
+                         pendentes.itens[k]);
+    }
+    free(pendentes.itens);
+
+    /* Troca os trechos i..j pelos novos */
+    int removidos = j - i + 1;
+    int total = d->num_trechos - removidos + n;
+    if (total > d->capacidade_trechos) {
+        int nova = d->capacidade_trechos > 0 ? d->capacidade_trechos : 16;
+        while (nova < total) nova *= 2;
+        Trecho *trechos = (Trecho *)realloc(d->trechos, (size_t)nova * sizeof(Trecho));
+        if (trechos == NULL) {
+            fprintf(stderr, "Erro: memoria insuficiente para os trechos\n");
+            exit(1);
+        }
+        d->trechos = trechos;
+        d->capacidade_trechos = nova;
+    }
+    liberar_trechos(d->trechos + i, removidos);
+    memmove(d->trechos + i + n, d->trechos + j + 1,
+            (size_t)(d->num_trechos - j - 1) * sizeof(Trecho));
+    if (n > 0) {
+        memcpy(d->trechos + i, novos, (size_t)n * sizeof(Trecho));
+    }
+    free(novos);
+    d->num_trechos = total;
+
+    /* Os seguintes só mudam de lugar: linhas a mais ou a menos, e colunas na linha do corte */
+    for (int k = i + n; k < d->num_trechos; k++) {
+        Trecho *t = &d->trechos[k];
+        t->inicio += delta;
+        if (t->linha == linha_antiga) {
+            t->coluna += coluna_nova - coluna_antiga;
+        }
+        t->linha += linha_nova - linha_antiga;
+    }
+    d->fim += delta;
+    if (d->linha_fim == linha_antiga) {
+        d->coluna_fim += coluna_nova - coluna_antiga;
+    }
+    d->linha_fim += linha_nova - linha_antiga;
+    analisar_programa(d);
+    if (d->num_trechos == 0) {
+        d->segmentado = 0;      /* Sem comandos: a próxima edição refaz tudo */
+    }
+
+    double ms = ms_desde(&ini);
+    s->edicoes_incrementais++;
+    s->trechos_reanalisados += n;
+    s->ms_incrementais += ms;
+    if (ms > s->maior_incremental) s->maior_incremental = ms;
+    if (s->verbose) {
+        fprintf(stderr, ">>> %s: %d trecho(s) reanalisado(s) nas linhas %d-%d, %.3f ms\n",
+                d->uri, n, linha, linha_nova, ms);
+    }
+    return 1;
+}
+
+/* ========== Saída ========== */
+
+static void enviar_mensagem(const char *corpo, size_t tamanho) {
+    printf("Content-Length: %zu\r\n\r\n", tamanho);
+    fwrite(corpo, 1, tamanho, stdout);
+    fflush(stdout);
+}
+
+/* Abre o corpo de uma mensagem; terminar_mensagem a envia */
+static FILE *iniciar_mensagem(char **corpo, size_t *tamanho) {
+    FILE *f = open_memstream(corpo, tamanho);
+    if (f == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a resposta LSP\n");
+        exit(1);
+    }
+    fputs("{\"jsonrpc\": \"2.0\"", f);
+    return f;
+}
+
+static void terminar_mensagem(FILE *f, char **corpo, size_t *tamanho) {
+    fputs("}", f);
+    fclose(f);
+    enviar_mensagem(*corpo, *tamanho);
+    free(*corpo);
+}
+
+static void responder(const ValorJson *id, const char *resultado) {
+    char *corpo;
+    size_t tamanho;
+    FILE *f = iniciar_mensagem(&corpo, &tamanho);
+    fprintf(f, ", \"id\": %.*s, \"result\": %s", (int)id->tamanho_bruto, id->bruto, resultado);
+    terminar_mensagem(f, &corpo, &tamanho);
+}
+
+static void responder_erro(const ValorJson *id, int codigo, const char *mensagem) {
+    char *corpo;
+    size_t tamanho;
+    FILE *f = iniciar_mensagem(&corpo, &tamanho);
+    if (id != NULL) {
+        fprintf(f, ", \"id\": %.*s", (int)id->tamanho_bruto, id->bruto);
+    } else {
+        fputs(", \"id\": null", f);
+    }
+    fprintf(f, ", \"error\": {\"code\": %d, \"message\": ", codigo);
+    escrever_cadeia_json(f, mensagem);
+    fputs("}", f);
+    terminar_mensagem(f, &corpo, &tamanho);
+}
+
+static void escrever_intervalo(FILE *f, int linha, int coluna, int largura) {
+    fprintf(f, "{\"start\": {\"line\": %d, \"character\": %d}, "
+               "\"end\": {\"line\": %d, \"character\": %d}}",
+            linha, coluna, linha, coluna + largura);
+}
+
+static void escrever_diagnostico_lsp(FILE *f, const Diagnostico *diag, int linha, int coluna,
+                                     int *primeiro) {
+    /* As posições do analisador são de 1 em diante; sem posição, a linha 1 */
+    int l = linha > 0 ? linha - 1 : 0;
+    int c = coluna > 0 ? coluna - 1 : 0;
+
+    fputs(*primeiro ? "" : ", ", f);
+    *primeiro = 0;
+    fputs("{\"range\": ", f);
+    escrever_intervalo(f, l, c, 1);
+    fprintf(f, ", \"severity\": %d, \"code\": \"%s\", \"source\": \"x25b\", \"message\": ",
+            diag->severidade == SEVERIDADE_ERRO ? 1 : 2, diag->codigo);
+    escrever_cadeia_json(f, diag->mensagem);
+    fputs("}", f);
+}
+
+static void publicar_diagnosticos(Documento *d, const char *uri) {
+    char *corpo;
+    size_t tamanho;
+    int primeiro = 1;
+    FILE *f = iniciar_mensagem(&corpo, &tamanho);
+
+    fputs(", \"method\": \"textDocument/publishDiagnostics\", \"params\": {\"uri\": ", f);
+    escrever_cadeia_json(f, uri);
+    fputs(", \"diagnostics\": [", f);
+    if (d != NULL) {
+        for (int i = 0; i < d->gerais.num; i++) {
+            const Diagnostico *diag = &d->gerais.itens[i];
+            escrever_diagnostico_lsp(f, diag, diag->linha, diag->coluna, &primeiro);
+        }
+        for (int k = 0; k < d->num_trechos; k++) {
+            const Trecho *t = &d->trechos[k];
+            for (int i = 0; i < t->diagnosticos.num; i++) {
+                const Diagnostico *diag = &t->diagnosticos.itens[i];
+                escrever_diagnostico_lsp(f, diag, t->linha + diag->linha,
+                                         diag->linha == 0 ? t->coluna + diag->coluna : diag->coluna,
+                                         &primeiro);
+            }
+        }
+        for (int i = 0; i < d->programa.num; i++) {
+            const Diagnostico *diag = &d->programa.itens[i];
+            escrever_diagnostico_lsp(f, diag, diag->linha, diag->coluna, &primeiro);
+        }
+        for (int i = 0; i < d->finais.num; i++) {
+            const Diagnostico *diag = &d->finais.itens[i];
+            escrever_diagnostico_lsp(f, diag, d->linha_fim + diag->linha,
+                                     diag->linha == 0 ? d->coluna_fim + diag->coluna : diag->coluna,
+                                     &primeiro);
+        }
+    }
+    fputs("]}", f);
+    terminar_mensagem(f, &corpo, &tamanho);
+}
+
+/* ========== Símbolos ========== */
+
+static int caractere_id(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+/* Símbolo declarado cujo nome está sob a posição (NULL se nenhum) */
+static EntradaSimbolo *simbolo_na_posicao(Documento *d, const ValorJson *params) {
+    const ValorJson *pos = membro(params, "position");
+    size_t p = posicao_no_texto(d, inteiro_de(membro(pos, "line"), 0),
+                                inteiro_de(membro(pos, "character"), 0));
+    size_t ini = p, fim = p;
+
+    while (ini > 0 && caractere_id(d->texto[ini - 1])) ini--;
+    while (fim < d->tamanho && caractere_id(d->texto[fim])) fim++;
+    if (fim == ini || fim - ini > ID_MAX_CHARS || (d->texto[ini] >= '0' && d->texto[ini] <= '9')) {
+        return NULL;
+    }
+    if (d->ctx.tabela.simbolos == NULL) return NULL;
+    return buscar_simbolo(&d->ctx, chave_id(d->texto + ini, fim - ini));
+}
+
+static void atender_hover(Documento *d, const ValorJson *id, const ValorJson *params) {
+    EntradaSimbolo *s = d != NULL ? simbolo_na_posicao(d, params) : NULL;
+    if (s == NULL) {
+        responder(id, "null");
+        return;
+    }
+
+    char nome[ID_MAX_CHARS + 1];
+    char texto[128];
+    if (s->tamanho_array > 0) {
+        snprintf(texto, sizeof(texto), "```x25b\n%s %s[%d]\n```\nDeclarada na linha %d",
+                 tipo_para_string(s->tipo), texto_id(s->chave, nome), s->tamanho_array,
+                 s->linha_declaracao);
+    } else {
+        snprintf(texto, sizeof(texto), "```x25b\n%s %s\n```\nDeclarada na linha %d",
+                 tipo_para_string(s->tipo), texto_id(s->chave, nome), s->linha_declaracao);
+    }
+
+    char *resultado;
+    size_t tamanho;
+    FILE *f = open_memstream(&resultado, &tamanho);
+    if (f == NULL) {
+        responder(id, "null");
+        return;
+    }
+    fputs("{\"contents\": {\"kind\": \"markdown\", \"value\": ", f);
+    escrever_cadeia_json(f, texto);
+    fputs("}}", f);
+    fclose(f);
+    responder(id, resultado);
+    free(resultado);
+}
+
+static void atender_definicao(Documento *d, const ValorJson *id, const ValorJson *params) {
+    EntradaSimbolo *s = d != NULL ? simbolo_na_posicao(d, params) : NULL;
+    if (s == NULL) {
+        responder(id, "null");
+        return;
+    }
+
+    /* A coluna vem da declaração na AST; a tabela guarda só a linha */
+    int linha = s->linha_declaracao, coluna = 1;
+    if (d->ctx.programa != NULL) {
+        for (NoDecl *decl = d->ctx.programa->declaracoes; decl != NULL; decl = decl->prox) {
+            if (decl->chave == s->chave && decl->linha == linha) {
+                coluna = decl->coluna;
+                break;
+            }
+        }
+    }
+
+    char nome[ID_MAX_CHARS + 1];
+    char *resultado;
+    size_t tamanho;
+    FILE *f = open_memstream(&resultado, &tamanho);
+    if (f == NULL) {
+        responder(id, "null");
+        return;
+    }
+    fputs("{\"uri\": ", f);
+    escrever_cadeia_json(f, d->uri);
+    fputs(", \"range\": ", f);
+    escrever_intervalo(f, linha - 1, coluna - 1, (int)strlen(texto_id(s->chave, nome)));
+    fputs("}", f);
+    fclose(f);
+    responder(id, resultado);
+    free(resultado);
+}
+
+/* ========== Sincronização de documentos ========== */
+
+static void abrir_documento(ServidorLsp *s, const ValorJson *params) {
+    const ValorJson *doc = membro(params, "textDocument");
+    const char *uri = cadeia_de(membro(doc, "uri"));
+    const ValorJson *texto = membro(doc, "text");
+    if (uri == NULL || texto == NULL || texto->tipo != JSON_CADEIA) return;
+
+    Documento *d = buscar_documento(s, uri);
+    if (d != NULL) {
+        fechar_documento(s, d);
+    }
+    d = (Documento *)calloc(1, sizeof(Documento));
+    d->uri = strdup(uri);
+    if (d == NULL || d->uri == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para o documento\n");
+        exit(1);
+    }
+    inicializar_contexto(&d->ctx, d->uri, DESTINO_LISTA);
+    substituir_texto(d, 0, 0, texto->cadeia, texto->tamanho);
+    d->prox = s->documentos;
+    s->documentos = d;
+
+    analisar_completo(s, d);
+    publicar_diagnosticos(d, d->uri);
+}
+
+static void mudar_documento(ServidorLsp *s, const ValorJson *params) {
+    Documento *d = buscar_documento(s, cadeia_de(membro(membro(params, "textDocument"), "uri")));
+    const ValorJson *mudancas = membro(params, "contentChanges");
+    if (d == NULL || mudancas == NULL || mudancas->tipo != JSON_LISTA) return;
+
+    /*
+     * Uma mudança que exige a análise completa só altera o texto: as
+     * seguintes também, e a análise é feita uma vez, no final.
+     */
+    int completa = 0;
+    for (const ValorJson *m = mudancas->filhos; m != NULL; m = m->prox) {
+        const ValorJson *texto = membro(m, "text");
+        const ValorJson *intervalo = membro(m, "range");
+        if (texto == NULL || texto->tipo != JSON_CADEIA) continue;
+
+        if (intervalo == NULL) {
+            substituir_texto(d, 0, d->tamanho, texto->cadeia, texto->tamanho);
+            d->segmentado = 0;
+            completa = 1;
+            continue;
+        }
+        const ValorJson *ini = membro(intervalo, "start");
+        const ValorJson *fim = membro(intervalo, "end");
+        size_t a = posicao_no_texto(d, inteiro_de(membro(ini, "line"), 0),
+                                    inteiro_de(membro(ini, "character"), 0));
+        size_t b = posicao_no_texto(d, inteiro_de(membro(fim, "line"), 0),
+                                    inteiro_de(membro(fim, "character"), 0));
+        if (b < a) b = a;
+
+        if (completa) {
+            substituir_texto(d, a, b, texto->cadeia, texto->tamanho);
+        } else if (!editar_incremental(s, d, a, b, texto->cadeia, texto->tamanho)) {
+            completa = 1;
+        }
+    }
+    if (completa) {
+        analisar_completo(s, d);
+    }
+    publicar_diagnosticos(d, d->uri);
+}
+
+/* ========== Laço principal ========== */
+
+/* Lê uma mensagem em *buf; retorna o tamanho, 0 no fim da entrada ou -1 se inválida */
+static long ler_mensagem(FILE *entrada, char **buf, size_t *capacidade) {
+    char *linha = NULL;
+    size_t cap_linha = 0;
+    long tamanho = -1;
+    ssize_t n;
+    int alguma = 0;
+
+    while ((n = getline(&linha, &cap_linha, entrada)) > 0) {
+        alguma = 1;
+        if (strcmp(linha, "\r\n") == 0 || strcmp(linha, "\n") == 0) break;
+        if (strncasecmp(linha, "Content-Length:", 15) == 0) {
+            tamanho = strtol(linha + 15, NULL, 10);
+        }
+    }
+    free(linha);
+    if (!alguma) return 0;
+    if (n <= 0 || tamanho < 0 || (unsigned long)tamanho > LSP_MAX_MENSAGEM) return -1;
+
+    if ((size_t)tamanho + 1 > *capacidade) {
+        char *novo = (char *)realloc(*buf, (size_t)tamanho + 1);
+        if (novo == NULL) return -1;
+        *buf = novo;
+        *capacidade = (size_t)tamanho + 1;
+    }
+    if (fread(*buf, 1, (size_t)tamanho, entrada) != (size_t)tamanho) return -1;
+    (*buf)[tamanho] = '\0';
+    return tamanho > 0 ? tamanho : -1;
+}
+
+/* Atende uma mensagem; retorna 0 quando o cliente pede exit */
+static int atender(ServidorLsp *s, const ValorJson *msg) {
+    const char *metodo = cadeia_de(membro(msg, "method"));
+    const ValorJson *id = membro(msg, "id");
+    const ValorJson *params = membro(msg, "params");
+    const char *uri = cadeia_de(membro(membro(params, "textDocument"), "uri"));
+
+    if (metodo == NULL) {
+        /* Resposta a um pedido do servidor (não fazemos nenhum) */
+        return 1;
+    }
+    if (strcmp(metodo, "exit") == 0) {
+        return 0;
+    }
+    if (s->desligado && id != NULL) {
+        responder_erro(id, JSONRPC_REQUISICAO_INVALIDA, "servidor desligado (shutdown)");
+        return 1;
+    }
+
+    if (strcmp(metodo, "initialize") == 0 && id != NULL) {
+        responder(id, "{\"capabilities\": {\"positionEncoding\": \"utf-8\", "
+                      "\"textDocumentSync\": {\"openClose\": true, \"change\": 2, \"save\": true}, "
+                      "\"hoverProvider\": true, \"definitionProvider\": true}, "
+                      "\"serverInfo\": {\"name\": \"x25b\", \"version\": \"" X25B_VERSAO "\"}}");
+    } else if (strcmp(metodo, "shutdown") == 0 && id != NULL) {
+        s->desligado = 1;
+        responder(id, "null");
+    } else if (strcmp(metodo, "textDocument/didOpen") == 0) {
+        abrir_documento(s, params);
+    } else if (strcmp(metodo, "textDocument/didChange") == 0) {
+        mudar_documento(s, params);
+    } else if (strcmp(metodo, "textDocument/didSave") == 0) {
+        /* Reconcilia o que as análises incrementais não juntaram */
+        Documento *d = buscar_documento(s, uri);
+        if (d != NULL) {
+            analisar_completo(s, d);
+            publicar_diagnosticos(d, d->uri);
+        }
+    } else if (strcmp(metodo, "textDocument/didClose") == 0) {
+        Documento *d = buscar_documento(s, uri);
+        if (d != NULL) {
+            fechar_documento(s, d);
+            publicar_diagnosticos(NULL, uri);
+        }
+    } else if (strcmp(metodo, "textDocument/hover") == 0 && id != NULL) {
+        atender_hover(buscar_documento(s, uri), id, params);
+    } else if (strcmp(metodo, "textDocument/definition") == 0 && id != NULL) {
+        atender_definicao(buscar_documento(s, uri), id, params);
+    } else if (id != NULL) {
+        responder_erro(id, JSONRPC_METODO_DESCONHECIDO, metodo);
+    }
+    /* Outras notificações (initialized, $/...) não pedem nada */
+    return 1;
+}
+
+int executar_lsp(int verbose) {
+    ServidorLsp s;
+    char *buf = NULL;
+    size_t capacidade = 0;
+    long tamanho;
+
+    memset(&s, 0, sizeof(s));
+    s.verbose = verbose;
+    if (verbose) {
+        fprintf(stderr, ">>> Servidor LSP X25b em stdio\n");
+    }
+
+    while ((tamanho = ler_mensagem(stdin, &buf, &capacidade)) != 0) {
+        if (tamanho < 0) {
+            fprintf(stderr, "Erro: mensagem LSP invalida (cabecalho Content-Length)\n");
+            break;
+        }
+        arena_reiniciar(&s.arena_json);
+        LeitorJson leitor = { buf, buf + tamanho, &s.arena_json, 0 };
+        ValorJson *msg = ler_valor(&leitor);
+        if (msg == NULL || msg->tipo != JSON_OBJETO) {
+            responder_erro(NULL, JSONRPC_JSON_INVALIDO, "JSON invalido");
+            continue;
+        }
+        if (!atender(&s, msg)) break;
+    }
+
+    if (verbose) {
+        fprintf(stderr, ">>> LSP: %ld edicao(oes) incremental(is), %ld trecho(s) reanalisado(s), "
+                        "media %.3f ms, maior %.3f ms\n",
+                s.edicoes_incrementais, s.trechos_reanalisados,
+                s.edicoes_incrementais > 0 ? s.ms_incrementais / s.edicoes_incrementais : 0.0,
+                s.maior_incremental);
+        fprintf(stderr, ">>> LSP: %ld analise(s) completa(s), media %.3f ms\n",
+                s.analises_completas,
+                s.analises_completas > 0 ? s.ms_completas / s.analises_completas : 0.0);
+    }
+
+    while (s.documentos != NULL) {
+        fechar_documento(&s, s.documentos);
+    }
+    free(s.marcas.itens);
+    free(s.rascunho);
+    arena_liberar(&s.arena_json);
+    free(buf);
+    return s.desligado ? 0 : 1;
+}
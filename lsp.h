@@ -0,0 +1,30 @@
+/*
+ * Servidor Language Server Protocol sobre stdio (opção --lsp)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef LSP_H
+#define LSP_H
+
+/*
+ * Mensagens JSON-RPC com cabeçalho Content-Length na entrada e na saída
+ * padrão. Atende initialize, shutdown, exit, textDocument/didOpen,
+ * didChange (sincronização incremental), didSave, didClose, hover e
+ * definition, e publica os diagnósticos de cada documento após cada
+ * mudança. Posições são contadas em bytes (fontes X25b são ASCII).
+ *
+ * Cada documento aberto guarda o texto, a AST e a tabela de símbolos.
+ * A área ALGORITMO é dividida em trechos, um por comando do nível
+ * externo, cada um com os seus comandos e diagnósticos. Uma edição
+ * dentro de ALGORITMO reanalisa (sintaxe e semântica) só os trechos que
+ * ela atinge, mais os vizinhos com erro de sintaxe; os trechos seguintes
+ * apenas têm a posição deslocada. Edições no cabeçalho ou em
+ * DECLARACOES, e a gravação do arquivo, refazem a análise completa.
+ * Os avisos de fluxo de dados (AVI003 a AVI006), que dependem do
+ * programa inteiro, ficam só na compilação pela linha de comando.
+ */
+
+/* Atende até receber exit ou o fim da entrada; retorna 0 após shutdown */
+int executar_lsp(int verbose);
+
+#endif /* LSP_H */
@@ -11,22 +11,63 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include "ast.h"
+#include "contexto.h"
 #include "semantic.h"
-
-/* Declarações externas */
-extern FILE *yyin;
-extern int yyparse(void);
-extern NoPrograma *programa_raiz;
-extern int erros_sintaticos;
-extern int erros_semanticos;
-extern int linha;
-extern int coluna;
+#include "interpretador.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "gerador_c.h"
+#include "gerador_asm.h"
+#include "otimizacao.h"
+#include "paralelo.h"
+#include "estatisticas.h"
+#include "cache.h"
+#include "ast_compacta.h"
+#include "servidor.h"
+#include "lsp.h"
 
 /* Flags de execução */
 int mostrar_ast = 0;
 int mostrar_tabela = 1;
 int modo_verbose = 0;
+int modo_execucao = 0;
+int mostrar_bytecode = 0;
+int modo_silencioso = 0;
+int otimizar = OTIMIZAR_EXPRESSOES;
+const char *arquivo_c = NULL;
+const char *arquivo_asm = NULL;
+long limiar_jit = JIT_DESLIGADO;
+int num_threads = 0;
+int modo_estatisticas = 0;   /* 1 = texto, 2 = JSON */
+const char *dir_cache = NULL;
+int modo_ast_compacta = 0;
+int modo_quieto = 0;
+FormatoDiagnosticos formato_diagnosticos = DIAGNOSTICOS_TEXTO;
+
+/* Servidor de compilação (--server), cliente (--client, --stop-server) e LSP (--lsp) */
+enum { PAPEL_COMPILADOR, PAPEL_SERVIDOR, PAPEL_CLIENTE, PAPEL_PARAR_SERVIDOR, PAPEL_LSP };
+int papel = PAPEL_COMPILADOR;
+const char *caminho_socket = NULL;
+
+/* Executores disponíveis para --run e --vm */
+enum { EXECUTAR_NADA, EXECUTAR_ARVORE, EXECUTAR_BYTECODE };
+
+/*
+ * Destino das mensagens do compilador. Ao executar o programa (--run),
+ * stdout pertence ao programa X25b e os relatórios vão para stderr.
+ */
+static FILE *relatorio;
+
+/* Mensagem de progresso, suprimida no modo silencioso */
+static void progresso(const char *formato, ...) {
+    va_list args;
+    if (modo_silencioso) return;
+    va_start(args, formato);
+    vfprintf(relatorio, formato, args);
+    va_end(args);
+}
 
 void imprimir_cabecalho(void) {
     printf("\n");
@@ -43,16 +84,40 @@ void imprimir_cabecalho(void) {
 }
 
 void imprimir_uso(const char *programa) {
-    printf("Uso: %s [opcoes] <arquivo.x25b>\n\n", programa);
+    printf("Uso: %s [opcoes] <arquivo.x25b | ->\n", programa);
+    printf("     %s [-j N] [-v] [-O0|-O2] <arquivo.x25b>...\n\n", programa);
     printf("Opcoes:\n");
     printf("  -a, --ast      Mostra a arvore sintatica abstrata\n");
     printf("  -t, --tabela   Mostra a tabela de simbolos (padrao: ativado)\n");
     printf("  -v, --verbose  Modo verbose\n");
+    printf("  -r, --run      Executa o programa apos a compilacao\n");
+    printf("  --vm           Executa o programa na maquina virtual de bytecode\n");
+    printf("  --jit[=camadas] Executa compilando para x86-64 na memoria: o programa\n");
+    printf("                 inteiro, ou so os ENQUANTO apos %d voltas interpretadas\n", JIT_LIMIAR_PADRAO);
+    printf("  --dump-bytecode  Mostra o bytecode gerado\n");
+    printf("  --emit-c ARQ   Gera codigo C99 equivalente em ARQ ('-' = saida padrao)\n");
+    printf("  --emit-asm ARQ Gera assembly x86-64 (GNU as) em ARQ ('-' = saida padrao)\n");
+    printf("  -O0            Desativa o dobramento de constantes\n");
+    printf("  -O2            Tambem remove codigo morto, move expressoes invariantes para\n");
+    printf("                 fora dos ENQUANTO e reaproveita subexpressoes comuns\n");
+    printf("  -j N           Compila varios arquivos com N threads\n");
+    printf("  --stats[=json] Mostra tempo por fase, tokens, nos da AST e memoria\n");
+    printf("  --cache[=DIR]  Reaproveita ASTs verificadas de fontes inalteradas\n");
+    printf("                 (padrao: %s)\n", CACHE_DIR_PADRAO);
+    printf("  --ast-compacta Compara memoria e percurso da AST compacta (vetores)\n");
+    printf("  -q, --quiet    Sem cabecalho, progresso nem tabela; diagnosticos numa\n");
+    printf("                 unica escrita no final\n");
+    printf("  --diagnostics=json  Diagnosticos em JSON (uma linha por arquivo) em stderr\n");
+    printf("  --server[=SOCK]     Servidor de compilacao residente no socket Unix SOCK\n");
+    printf("  --client[=SOCK]     Verifica o arquivo no servidor (aceita -a, -t, -v e\n");
+    printf("                      --diagnostics=json)\n");
+    printf("  --stop-server[=SOCK]  Encerra o servidor\n");
+    printf("  --lsp          Servidor Language Server Protocol em stdio (editores)\n");
     printf("  -h, --help     Mostra esta mensagem de ajuda\n");
     printf("\n");
 }
 
-void imprimir_resultado(int sucesso) {
+void imprimir_resultado(ContextoCompilacao *ctx, int sucesso) {
     printf("\n");
     printf("══════════════════════════════════════════════════════════════════\n");
     if (sucesso) {
@@ -60,35 +125,183 @@ void imprimir_resultado(int sucesso) {
         printf("  O programa em X25b foi reconhecido sem erros.\n");
     } else {
         printf("  ✗ COMPILACAO FALHOU!\n");
-        if (erros_sintaticos > 0) {
-            printf("  Erros sintaticos encontrados: %d\n", erros_sintaticos);
+        if (ctx->erros_sintaticos > 0) {
+            printf("  Erros sintaticos encontrados: %d\n", ctx->erros_sintaticos);
         }
-        if (erros_semanticos > 0) {
-            printf("  Erros semanticos encontrados: %d\n", erros_semanticos);
+        if (ctx->erros_semanticos > 0) {
+            printf("  Erros semanticos encontrados: %d\n", ctx->erros_semanticos);
         }
     }
     printf("══════════════════════════════════════════════════════════════════\n");
     printf("\n");
 }
 
+/*
+ * Escreve os diagnósticos retidos em memória (--quiet, --diagnostics=json)
+ * numa única escrita em stderr e libera o contexto
+ */
+static void encerrar(ContextoCompilacao *ctx) {
+    if (ctx->destino == DESTINO_LISTA) {
+        char *texto = NULL;
+        size_t tamanho = 0;
+        FILE *saida = open_memstream(&texto, &tamanho);
+        if (saida != NULL) {
+            escrever_diagnosticos_json(ctx, saida);
+            fclose(saida);
+            fwrite(texto, 1, tamanho, stderr);
+            free(texto);
+        }
+    } else if (ctx->destino == DESTINO_MEMORIA) {
+        const char *texto = diagnosticos_contexto(ctx);
+        fwrite(texto, 1, strlen(texto), stderr);
+    }
+    liberar_contexto(ctx);
+}
+
+static long total_nos(const ResumoAst *r) {
+    long total = 0;
+    for (int i = 0; i <= EXPR_NEG; i++) total += r->nos_expr[i];
+    for (int i = 0; i <= CMD_ENQUANTO; i++) total += r->nos_cmd[i];
+    return total;
+}
+
+/*
+ * Achata a AST (--ast-compacta) e calcula o mesmo resumo nas duas
+ * representações, relatando memória e tempo de percurso de cada uma.
+ */
+static void comparar_ast_compacta(ContextoCompilacao *ctx, Estatisticas *est) {
+    AstCompacta ac;
+    ResumoAst ponteiros, compacta;
+    Instante inicio;
+    
+    marcar_instante(&inicio);
+    if (!compactar_programa(ctx, ctx->programa, &ac)) {
+        fprintf(stderr, "Erro: memoria insuficiente para a AST compacta\n");
+        return;
+    }
+    double ms_compactacao = registrar_fase(est, "compactacao", &inicio);
+    
+    marcar_instante(&inicio);
+    resumir_ast(ctx->programa, &ponteiros);
+    double ms_ponteiros = registrar_fase(est, "percurso_ponteiros", &inicio);
+    
+    marcar_instante(&inicio);
+    resumir_ast_compacta(&ac, &compacta);
+    double ms_compacta = registrar_fase(est, "percurso_compacto", &inicio);
+    
+    /* Os dois percursos devem enxergar exatamente a mesma árvore */
+    if (memcmp(ponteiros.nos_expr, compacta.nos_expr, sizeof(ponteiros.nos_expr)) != 0 ||
+        memcmp(ponteiros.nos_cmd, compacta.nos_cmd, sizeof(ponteiros.nos_cmd)) != 0 ||
+        ponteiros.vars != compacta.vars || ponteiros.itens != compacta.itens ||
+        ponteiros.cadeias != compacta.cadeias || ponteiros.sequencias != compacta.sequencias ||
+        ponteiros.maior_profundidade != compacta.maior_profundidade) {
+        fprintf(stderr, "Erro interno: AST compacta difere da original\n");
+    }
+    
+    fprintf(relatorio, ">>> AST compacta: %ld nos, %ld variaveis, %ld sequencia(s), profundidade %d\n",
+            total_nos(&compacta), compacta.vars, compacta.sequencias, compacta.maior_profundidade);
+    fprintf(relatorio, ">>> Memoria: %zu bytes (ponteiros) -> %zu bytes (compacta), %.1f%%\n",
+            ponteiros.bytes, compacta.bytes,
+            ponteiros.bytes > 0 ? 100.0 * compacta.bytes / ponteiros.bytes : 0.0);
+    fprintf(relatorio, ">>> Percurso: %.3f ms (ponteiros) x %.3f ms (compacta); compactacao em %.3f ms\n",
+            ms_ponteiros, ms_compacta, ms_compactacao);
+    
+    liberar_ast_compacta(&ac);
+}
+
 int main(int argc, char *argv[]) {
     char *arquivo_entrada = NULL;
+    char *arquivos[argc > 1 ? argc : 1];
+    int num_arquivos = 0;
+    ContextoCompilacao contexto;
+    ContextoCompilacao *ctx = &contexto;
+    int pedidos = 0;        /* Saídas pedidas ao servidor com --client */
+    char socket_padrao[64];
     int i;
     
+    relatorio = stdout;
+    
     /* Processa argumentos */
     for (i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--ast") == 0) {
             mostrar_ast = 1;
+            pedidos |= PEDIDO_AST;
         } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--tabela") == 0) {
             mostrar_tabela = 1;
+            pedidos |= PEDIDO_TABELA;
         } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             modo_verbose = 1;
+        } else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--run") == 0) {
+            modo_execucao = EXECUTAR_ARVORE;
+        } else if (strcmp(argv[i], "--vm") == 0) {
+            modo_execucao = EXECUTAR_BYTECODE;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            modo_execucao = EXECUTAR_ARVORE;
+            limiar_jit = JIT_PROGRAMA;
+        } else if (strcmp(argv[i], "--jit=camadas") == 0) {
+            modo_execucao = EXECUTAR_ARVORE;
+            limiar_jit = JIT_LIMIAR_PADRAO;
+        } else if (strcmp(argv[i], "--dump-bytecode") == 0) {
+            mostrar_bytecode = 1;
+        } else if (strcmp(argv[i], "-O0") == 0) {
+            otimizar = OTIMIZAR_NADA;
+        } else if (strcmp(argv[i], "-O2") == 0) {
+            otimizar = OTIMIZAR_LACOS;
+        } else if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=texto") == 0) {
+            modo_estatisticas = 1;
+        } else if (strcmp(argv[i], "--stats=json") == 0) {
+            modo_estatisticas = 2;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            dir_cache = CACHE_DIR_PADRAO;
+        } else if (strncmp(argv[i], "--cache=", 8) == 0 && argv[i][8] != '\0') {
+            dir_cache = argv[i] + 8;
+        } else if (strcmp(argv[i], "--ast-compacta") == 0) {
+            modo_ast_compacta = 1;
+        } else if (strcmp(argv[i], "-q") == 0 || strcmp(argv[i], "--quiet") == 0) {
+            modo_quieto = 1;
+        } else if (strcmp(argv[i], "--diagnostics=json") == 0) {
+            formato_diagnosticos = DIAGNOSTICOS_JSON;
+            pedidos |= PEDIDO_JSON;
+        } else if (strcmp(argv[i], "--diagnostics=texto") == 0 ||
+                   strcmp(argv[i], "--diagnostics=text") == 0) {
+            formato_diagnosticos = DIAGNOSTICOS_TEXTO;
+        } else if (strncmp(argv[i], "--server", 8) == 0 && (argv[i][8] == '\0' || argv[i][8] == '=')) {
+            papel = PAPEL_SERVIDOR;
+            caminho_socket = argv[i][8] == '=' ? argv[i] + 9 : NULL;
+        } else if (strncmp(argv[i], "--client", 8) == 0 && (argv[i][8] == '\0' || argv[i][8] == '=')) {
+            papel = PAPEL_CLIENTE;
+            caminho_socket = argv[i][8] == '=' ? argv[i] + 9 : NULL;
+        } else if (strncmp(argv[i], "--stop-server", 13) == 0 &&
+                   (argv[i][13] == '\0' || argv[i][13] == '=')) {
+            papel = PAPEL_PARAR_SERVIDOR;
+            caminho_socket = argv[i][13] == '=' ? argv[i] + 14 : NULL;
+        } else if (strcmp(argv[i], "--lsp") == 0) {
+            papel = PAPEL_LSP;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char *n = argv[i][2] != '\0' ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : "");
+            num_threads = atoi(n);
+            if (num_threads < 1) {
+                fprintf(stderr, "Opcao -j requer um numero de threads\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--emit-c") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Opcao --emit-c requer um arquivo de saida\n");
+                return 1;
+            }
+            arquivo_c = argv[++i];
+        } else if (strcmp(argv[i], "--emit-asm") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "Opcao --emit-asm requer um arquivo de saida\n");
+                return 1;
+            }
+            arquivo_asm = argv[++i];
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             imprimir_cabecalho();
             imprimir_uso(argv[0]);
             return 0;
-        } else if (argv[i][0] != '-') {
-            arquivo_entrada = argv[i];
+        } else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            arquivos[num_arquivos++] = argv[i];
         } else {
             fprintf(stderr, "Opcao desconhecida: %s\n", argv[i]);
             imprimir_uso(argv[0]);
@@ -96,7 +309,63 @@ int main(int argc, char *argv[]) {
         }
     }
     
-    imprimir_cabecalho();
+    /* Servidor e cliente: nada é compilado neste processo */
+    if (papel == PAPEL_LSP) {
+        return executar_lsp(modo_verbose);
+    }
+    if (papel != PAPEL_COMPILADOR) {
+        if (caminho_socket == NULL || caminho_socket[0] == '\0') {
+            caminho_socket_padrao(socket_padrao, sizeof(socket_padrao));
+            caminho_socket = socket_padrao;
+        }
+        if (papel == PAPEL_SERVIDOR) {
+            return executar_servidor(caminho_socket, otimizar, modo_verbose);
+        }
+        if (papel == PAPEL_PARAR_SERVIDOR) {
+            return parar_servidor(caminho_socket);
+        }
+        if (num_arquivos != 1) {
+            fprintf(stderr, "Erro: --client verifica exatamente um arquivo\n");
+            return 1;
+        }
+        return executar_cliente(caminho_socket, arquivos[0], pedidos, modo_verbose);
+    }
+    
+    /* JSON nos diagnósticos: nada mais é escrito além dele */
+    if (formato_diagnosticos == DIAGNOSTICOS_JSON) {
+        modo_quieto = 1;
+    }
+    
+    /* Vários arquivos (ou -j): só compila, em paralelo */
+    if (num_arquivos > 1 || (num_arquivos == 1 && num_threads > 0)) {
+        if (modo_execucao || mostrar_bytecode || mostrar_ast || arquivo_c != NULL || arquivo_asm != NULL ||
+            modo_estatisticas || modo_ast_compacta) {
+            fprintf(stderr, "Erro: --run, --vm, --jit, --emit-c, --emit-asm, -a, --dump-bytecode, --stats e --ast-compacta aceitam um unico arquivo\n");
+            return 1;
+        }
+        int falhas = compilar_em_paralelo(arquivos, num_arquivos,
+                                          num_threads > 0 ? num_threads : 1,
+                                          otimizar, modo_verbose, dir_cache,
+                                          modo_quieto, formato_diagnosticos);
+        return falhas == 0 ? 0 : 1;
+    }
+    arquivo_entrada = num_arquivos > 0 ? arquivos[0] : NULL;
+    
+    /* Ao executar ou gerar C ou assembly na saída padrão, ela fica reservada ao programa */
+    if (modo_execucao || (arquivo_c != NULL && strcmp(arquivo_c, "-") == 0) ||
+        (arquivo_asm != NULL && strcmp(arquivo_asm, "-") == 0)) {
+        modo_silencioso = 1;
+        relatorio = stderr;
+    }
+    
+    /* Com --stats=json, o objeto JSON é a única coisa no relatório */
+    if (modo_estatisticas == 2 || modo_quieto) {
+        modo_silencioso = 1;
+    }
+    
+    if (!modo_silencioso) {
+        imprimir_cabecalho();
+    }
     
     /* Verifica se foi fornecido arquivo de entrada */
     if (arquivo_entrada == NULL) {
@@ -105,55 +374,256 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    /* Abre arquivo de entrada */
-    yyin = fopen(arquivo_entrada, "r");
-    if (yyin == NULL) {
-        fprintf(stderr, "Erro: Nao foi possivel abrir o arquivo '%s'\n", arquivo_entrada);
+    /* A entrada padrão não pode ser ao mesmo tempo fonte e dados de LEIA */
+    if (modo_execucao && strcmp(arquivo_entrada, "-") == 0) {
+        fprintf(stderr, "Erro: --run, --vm e --jit leem a entrada padrao; informe a fonte em um arquivo\n");
         return 1;
     }
     
-    printf(">>> Processando arquivo: %s\n\n", arquivo_entrada);
+    /*
+     * Um único arquivo: diagnósticos vão direto para stderr, ou ficam em
+     * memória até o fim com --quiet e --diagnostics=json
+     */
+    DestinoDiagnosticos destino = DESTINO_STDERR;
+    if (formato_diagnosticos == DIAGNOSTICOS_JSON) {
+        destino = DESTINO_LISTA;
+    } else if (modo_quieto) {
+        destino = DESTINO_MEMORIA;
+    }
+    if (!inicializar_contexto(ctx, arquivo_entrada, destino)) {
+        fprintf(stderr, "Erro: memoria insuficiente para os diagnosticos\n");
+        return 1;
+    }
+    ctx->relatorio = !modo_silencioso;
+    ctx->mostrar_tabela = mostrar_tabela && !modo_silencioso;
     
-    /* Fase 1: Análise Léxica e Sintática */
-    printf(">>> Fase 1: Analise Lexica e Sintatica\n");
+    /* Abre arquivo de entrada (mapeado em memória se for regular) */
+    if (!abrir_fonte(ctx, arquivo_entrada)) {
+        diagnosticar(ctx, SEVERIDADE_ERRO, ORIGEM_COMPILADOR, "CMP001", 0, 0,
+                     "Nao foi possivel abrir o arquivo '%s'", arquivo_entrada);
+        encerrar(ctx);
+        return 1;
+    }
     
-    linha = 1;
-    coluna = 1;
-    erros_sintaticos = 0;
-    erros_semanticos = 0;
+    progresso(">>> Processando arquivo: %s\n\n", arquivo_entrada);
+    if (modo_verbose) {
+        if (ctx->mapa != NULL) {
+            fprintf(relatorio, ">>> Fonte mapeada em memoria (%zu bytes)\n", ctx->tamanho_fonte);
+        } else {
+            fprintf(relatorio, ">>> Fonte lida em fluxo\n");
+        }
+    }
+    
+    Estatisticas est;
+    Instante inicio;
+    memset(&est, 0, sizeof(est));
+    
+    /* Fonte inalterada desde a última compilação: as fases 1 e 2 já foram feitas */
+    marcar_instante(&inicio);
+    if (dir_cache != NULL && carregar_ast_cache(ctx, dir_cache)) {
+        registrar_fase(&est, "cache", &inicio);
+        contar_nos(&est, ctx->programa);
+        progresso(">>> Fases 1-2: AST verificada carregada do cache (%s)\n", dir_cache);
+        if (mostrar_ast) {
+            printf("\n");
+            imprimir_ast(ctx->programa, stdout);
+        }
+        if (ctx->mostrar_tabela) {
+            imprimir_tabela_simbolos(ctx, stdout);
+        }
+    } else {
+        /* Fase 1: Análise Léxica e Sintática */
+        progresso(">>> Fase 1: Analise Lexica e Sintatica\n");
+        
+        marcar_instante(&inicio);
+        int resultado_parse = analisar_sintaxe(ctx);
+        registrar_fase(&est, "lexico_sintatico", &inicio);
+        
+        contar_nos(&est, ctx->programa);
+        
+        if (!resultado_parse) {
+            progresso(">>> Analise sintatica encontrou erros.\n");
+            if (!modo_silencioso) {
+                imprimir_resultado(ctx, 0);
+            }
+            if (modo_estatisticas) {
+                coletar_contexto(&est, ctx);
+                imprimir_estatisticas(&est, relatorio, modo_estatisticas == 2);
+            }
+            encerrar(ctx);
+            return 1;
+        }
+        
+        progresso(">>> Analise lexica e sintatica concluidas com sucesso!\n");
+        
+        /* Mostra AST se solicitado */
+        if (mostrar_ast && ctx->programa != NULL) {
+            printf("\n");
+            imprimir_ast(ctx->programa, stdout);
+        }
+        
+        /* Fase 2: Análise Semântica */
+        progresso("\n>>> Fase 2: Analise Semantica\n");
+        
+        marcar_instante(&inicio);
+        analisar_semantica(ctx, ctx->programa);
+        double ms_semantica = registrar_fase(&est, "semantica", &inicio);
+        
+        if (modo_verbose) {
+            fprintf(relatorio, ">>> Analise semantica em %.3f ms\n", ms_semantica);
+            fprintf(relatorio, ">>> Buscas na tabela de simbolos: %ld (%ld declaracoes + %ld referencias)\n",
+                    ctx->buscas_tabela, ctx->declaracoes_analisadas, ctx->referencias_variaveis);
+            fprintf(relatorio, ">>> Sondagens: %.2f por busca (maior %d), %d simbolo(s) em %d baldes\n",
+                    ctx->buscas_tabela > 0 ? (double)ctx->sondagens_tabela / ctx->buscas_tabela : 0.0,
+                    ctx->maior_sondagem_busca, ctx->tabela.num_simbolos, ctx->tabela.num_baldes);
+            if (ctx->blocos_fluxo > 0) {
+                fprintf(relatorio, ">>> Fluxo de dados: %d bloco(s), %d laco(s), %ld visita(s) em %.3f ms\n",
+                        ctx->blocos_fluxo, ctx->lacos_fluxo, ctx->visitas_fluxo, ctx->ms_fluxo);
+            }
+            if (ctx->acessos_lista > 0) {
+                fprintf(relatorio, ">>> Limites de listas: %ld de %ld acesso(s) provados seguros (%.1f%%) em %.3f ms\n",
+                        ctx->acessos_seguros, ctx->acessos_lista,
+                        100.0 * ctx->acessos_seguros / ctx->acessos_lista, ctx->ms_limites);
+            }
+        }
+        
+        /* Grava antes da otimização, que altera a AST */
+        if (dir_cache != NULL) {
+            salvar_ast_cache(ctx, dir_cache);
+        }
+    }
     
-    int resultado_parse = yyparse();
+    /* Resultado final */
+    int sucesso = (ctx->erros_sintaticos == 0 && ctx->erros_semanticos == 0);
+    if (!modo_silencioso) {
+        imprimir_resultado(ctx, sucesso);
+    }
     
-    fclose(yyin);
+    /* Dobramento de constantes e simplificações algébricas */
+    if (sucesso && otimizar) {
+        marcar_instante(&inicio);
+        long eliminados = otimizar_programa(ctx, ctx->programa, otimizar,
+                                            modo_verbose ? relatorio : NULL);
+        registrar_fase(&est, "otimizacao", &inicio);
+        if (modo_verbose) {
+            fprintf(relatorio, ">>> Otimizacao: %ld de %ld nos de expressao eliminados\n",
+                    eliminados, ctx->nos_antes_otimizacao);
+            if (otimizar >= OTIMIZAR_LACOS) {
+                fprintf(relatorio, ">>> Codigo morto: %ld comando(s) removido(s) (%ld atribuicao(oes) sem leitura, "
+                                   "%ld desvio(s) constante(s) ou vazio(s))\n",
+                        ctx->comandos_removidos, ctx->atribuicoes_mortas, ctx->desvios_constantes);
+                fprintf(relatorio, ">>> Invariantes de laco: %ld expressao(oes) movida(s)\n",
+                        ctx->invariantes_movidos);
+                fprintf(relatorio, ">>> Subexpressoes comuns: %ld ocorrencia(s) em %ld temporario(s), "
+                                   "%ld no(s) de expressao a menos\n",
+                        ctx->subexpressoes_comuns, ctx->temporarios_comuns, ctx->avaliacoes_removidas);
+                fprintf(relatorio, ">>> Compartilhamento: %ld no(s) de expressao iguais a outros, "
+                                   "%ld unicos (%ld bytes a menos na AST)\n",
+                        ctx->nos_compartilhados, ctx->nos_unicos, ctx->bytes_compartilhados);
+            }
+        }
+    }
     
-    if (resultado_parse != 0 || erros_sintaticos > 0) {
-        printf(">>> Analise sintatica encontrou erros.\n");
-        imprimir_resultado(0);
-        return 1;
+    /* AST compacta: mesmos nós em vetores, comparados com a de ponteiros */
+    if (sucesso && modo_ast_compacta) {
+        comparar_ast_compacta(ctx, &est);
     }
     
-    printf(">>> Analise lexica e sintatica concluidas com sucesso!\n");
+    if (modo_verbose) {
+        fprintf(relatorio, ">>> Arena da AST: pico de %zu bytes (%zu reservados em %d bloco(s))\n",
+                ctx->arena.pico, ctx->arena.bytes_reservados, ctx->arena.num_blocos);
+    }
     
-    /* Mostra AST se solicitado */
-    if (mostrar_ast && programa_raiz != NULL) {
-        printf("\n");
-        imprimir_ast(programa_raiz);
+    /* Bytecode (listagem e/ou execução na máquina virtual) */
+    Bytecode *bc = NULL;
+    if (sucesso && (mostrar_bytecode || modo_execucao == EXECUTAR_BYTECODE)) {
+        marcar_instante(&inicio);
+        bc = compilar_bytecode(ctx->programa);
+        registrar_fase(&est, "bytecode", &inicio);
+        if (mostrar_bytecode) {
+            imprimir_bytecode(bc, relatorio);
+        }
     }
     
-    /* Fase 2: Análise Semântica */
-    printf("\n>>> Fase 2: Analise Semantica\n");
+    /* Geração de código C */
+    if (sucesso && arquivo_c != NULL) {
+        FILE *saida_c = strcmp(arquivo_c, "-") == 0 ? stdout : fopen(arquivo_c, "w");
+        if (saida_c == NULL) {
+            fprintf(stderr, "Erro: Nao foi possivel criar o arquivo '%s'\n", arquivo_c);
+            sucesso = 0;
+        } else {
+            marcar_instante(&inicio);
+            gerar_c(ctx->programa, arquivo_entrada, saida_c);
+            registrar_fase(&est, "gerador_c", &inicio);
+            if (saida_c != stdout) {
+                fclose(saida_c);
+            }
+            progresso(">>> Codigo C gerado em: %s\n", arquivo_c);
+        }
+    }
     
-    analisar_semantica(programa_raiz);
+    /* Geração de assembly x86-64 */
+    if (sucesso && arquivo_asm != NULL) {
+        FILE *saida_asm = strcmp(arquivo_asm, "-") == 0 ? stdout : fopen(arquivo_asm, "w");
+        if (saida_asm == NULL) {
+            fprintf(stderr, "Erro: Nao foi possivel criar o arquivo '%s'\n", arquivo_asm);
+            sucesso = 0;
+        } else {
+            ResumoAsm resumo;
+            marcar_instante(&inicio);
+            gerar_asm(ctx->programa, arquivo_entrada, saida_asm, &resumo);
+            registrar_fase(&est, "gerador_asm", &inicio);
+            if (saida_asm != stdout) {
+                fclose(saida_asm);
+            }
+            progresso(">>> Assembly x86-64 gerado em: %s\n", arquivo_asm);
+            if (modo_verbose) {
+                fprintf(relatorio, ">>> Assembly: %ld instrucoes, %d registrador(es) inteiro(s) e "
+                        "%d real(is) para temporarios, %ld derramamento(s)\n",
+                        resumo.instrucoes, resumo.registradores_inteiros,
+                        resumo.registradores_reais, resumo.derramamentos);
+            }
+        }
+    }
     
-    /* Resultado final */
-    int sucesso = (erros_sintaticos == 0 && erros_semanticos == 0);
-    imprimir_resultado(sucesso);
+    /* Fase 3: Execução (apenas para programas sem erros) */
+    if (sucesso && modo_execucao == EXECUTAR_ARVORE) {
+        marcar_instante(&inicio);
+        configurar_jit(limiar_jit);
+        long comandos = executar_programa(ctx->programa);
+        double ms = registrar_fase(&est, "execucao", &inicio);
+        
+        if (modo_verbose && limiar_jit != JIT_DESLIGADO) {
+            ResumoJit jit;
+            resumo_jit(&jit);
+            fprintf(relatorio, ">>> JIT: %d trecho(s) compilado(s), %zu bytes de codigo em %.3f ms\n",
+                    jit.trechos, jit.bytes, jit.ms_compilacao);
+            fprintf(relatorio, ">>> Execucao (JIT): %.3f ms, incluindo a compilacao (%ld comandos interpretados)\n",
+                    ms, comandos);
+        } else if (modo_verbose) {
+            fprintf(relatorio, ">>> Execucao: %ld comandos em %.3f ms (%.0f comandos/s)\n",
+                    comandos, ms, ms > 0 ? comandos / (ms / 1e3) : 0.0);
+            fprintf(relatorio, ">>> Avaliacoes: %ld nos de expressao\n", expressoes_avaliadas());
+        }
+    } else if (sucesso && modo_execucao == EXECUTAR_BYTECODE) {
+        marcar_instante(&inicio);
+        long instrucoes = executar_bytecode(bc);
+        double ms = registrar_fase(&est, "execucao", &inicio);
+        
+        if (modo_verbose) {
+            fprintf(relatorio, ">>> Execucao (VM): %ld instrucoes em %.3f ms (%.0f instrucoes/s)\n",
+                    instrucoes, ms, ms > 0 ? instrucoes / (ms / 1e3) : 0.0);
+        }
+    }
+    liberar_bytecode(bc);
     
-    /* Libera memória */
-    if (programa_raiz != NULL) {
-        liberar_programa(programa_raiz);
+    if (modo_estatisticas) {
+        coletar_contexto(&est, ctx);
+        imprimir_estatisticas(&est, relatorio, modo_estatisticas == 2);
     }
-    liberar_tabela_simbolos();
+    
+    /* Libera memória (AST, tabela de símbolos) */
+    encerrar(ctx);
     
     return sucesso ? 0 : 1;
 }
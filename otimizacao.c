@@ -0,0 +1,478 @@
+/*
+ * Implementação das otimizações sobre a AST
+ * Avaliação Parcial 2 - Compiladores
+ *
+ * Todas as reescritas preservam exatamente o comportamento do modo --run:
+ * divisões inteiras por zero e estouros de INT_MIN / -1 não são dobrados
+ * (o erro continua acontecendo em tempo de execução), e subexpressões só
+ * são descartadas quando nunca seriam avaliadas (curto-circuito).
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include "otimizacao.h"
+#include "invariantes.h"
+#include "subexpressoes.h"
+#include "codigo_morto.h"
+#include "semantic.h"
+#include "contexto.h"
+
+/* ========== Contagem de nós ========== */
+
+/*
+ * Contagem, simplificação e percurso dos comandos usam pilhas explícitas
+ * (pilha.h) em vez de recursão: expressões geradas com milhões de termos
+ * encadeados não cabem na pilha de chamadas.
+ */
+
+static void empilhar_no(Pilha *pilha, NoExpr *expr) {
+    if (expr != NULL) {
+        *(NoExpr **)pilha_empilhar(pilha) = expr;
+    }
+}
+
+static long contar_expressao(NoExpr *raiz) {
+    Pilha pilha;
+    NoExpr **topo;
+    long total = 0;
+
+    pilha_iniciar(&pilha, sizeof(NoExpr *));
+    empilhar_no(&pilha, raiz);
+
+    while ((topo = (NoExpr **)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = *topo;
+        pilha_desempilhar(&pilha);
+        total++;
+
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                empilhar_no(&pilha, expr->dado.var->indice);
+                break;
+            case EXPR_ARITMETICA:
+                empilhar_no(&pilha, expr->dado.aritmetica.esq);
+                empilhar_no(&pilha, expr->dado.aritmetica.dir);
+                break;
+            case EXPR_RELACIONAL:
+                empilhar_no(&pilha, expr->dado.relacional.esq);
+                empilhar_no(&pilha, expr->dado.relacional.dir);
+                break;
+            case EXPR_LOGICA:
+                empilhar_no(&pilha, expr->dado.logica.esq);
+                empilhar_no(&pilha, expr->dado.logica.dir);
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_no(&pilha, expr->dado.negacao);
+                break;
+            default:
+                break;
+        }
+    }
+
+    pilha_liberar(&pilha);
+    return total;
+}
+
+static long contar_var(NoVar *var) {
+    return var->indice != NULL ? contar_expressao(var->indice) : 0;
+}
+
+static long contar_comandos(NoCmd *cmd) {
+    PercursoComandos percurso;
+    long total = 0;
+
+    iniciar_percurso(&percurso, cmd);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                total += contar_var(cmd->dado.atrib.var) + contar_expressao(cmd->dado.atrib.expr);
+                break;
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    total += contar_var(v->var);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *e = cmd->dado.escreva; e != NULL; e = e->prox) {
+                    if (!e->is_cadeia) total += contar_expressao(e->item.expr);
+                }
+                break;
+            case CMD_SE:
+                total += contar_expressao(cmd->dado.se.condicao);
+                break;
+            case CMD_ENQUANTO:
+                total += contar_expressao(cmd->dado.enquanto.condicao);
+                break;
+        }
+    }
+    terminar_percurso(&percurso);
+    return total;
+}
+
+/* ========== Funções auxiliares ========== */
+
+static int eh_constante(NoExpr *e) {
+    return e->tipo == EXPR_CONST_INT || e->tipo == EXPR_CONST_REAL;
+}
+
+/* Valor da constante nos contextos real e inteiro (como no interpretador) */
+static double valor_real(NoExpr *e) {
+    return e->tipo == EXPR_CONST_INT ? (double)e->dado.const_int : e->dado.const_real;
+}
+
+static int valor_inteiro(NoExpr *e) {
+    return e->tipo == EXPR_CONST_INT ? e->dado.const_int : (int)e->dado.const_real;
+}
+
+/* Constante inteira com valor 'v' */
+static int eh_inteiro(NoExpr *e, int v) {
+    return e->tipo == EXPR_CONST_INT && e->dado.const_int == v;
+}
+
+/* Constante (inteira ou real) com valor 'v' */
+static int eh_valor(NoExpr *e, double v) {
+    return eh_constante(e) && valor_real(e) == v;
+}
+
+/* Expressões que sempre valem 0 ou 1 */
+static int eh_booleano(NoExpr *e) {
+    return e->tipo == EXPR_RELACIONAL || e->tipo == EXPR_LOGICA || e->tipo == EXPR_NAO ||
+           eh_inteiro(e, 0) || eh_inteiro(e, 1);
+}
+
+/* Transformam o nó, no lugar, em uma constante */
+static NoExpr *tornar_inteiro(NoExpr *e, int valor) {
+    e->tipo = EXPR_CONST_INT;
+    e->tipo_dado = TIPO_INTEIRO;
+    e->dado.const_int = valor;
+    return e;
+}
+
+static NoExpr *tornar_real(NoExpr *e, double valor) {
+    e->tipo = EXPR_CONST_REAL;
+    e->tipo_dado = TIPO_REAL;
+    e->dado.const_real = valor;
+    return e;
+}
+
+/* Aritmética inteira com o mesmo estouro (módulo 2^32) da execução */
+static int somar_int(int a, int b) { return (int)((unsigned)a + (unsigned)b); }
+static int subtrair_int(int a, int b) { return (int)((unsigned)a - (unsigned)b); }
+static int multiplicar_int(int a, int b) { return (int)((unsigned)a * (unsigned)b); }
+
+/* ========== Simplificação de expressões ========== */
+
+static NoExpr *simplificar(ContextoCompilacao *ctx, NoExpr *raiz);
+
+static void simplificar_var(ContextoCompilacao *ctx, NoVar *var) {
+    if (var->indice != NULL) {
+        var->indice = simplificar(ctx, var->indice);
+    }
+}
+
+/* Negação cujo operando já foi simplificado */
+static NoExpr *simplificar_neg(NoExpr *expr) {
+    NoExpr *op = expr->dado.negacao;
+    if (op->tipo == EXPR_CONST_INT && expr->tipo_dado != TIPO_REAL) {
+        return tornar_inteiro(expr, subtrair_int(0, op->dado.const_int));
+    }
+    if (op->tipo == EXPR_NEG && op->dado.negacao->tipo_dado == expr->tipo_dado) {
+        return op->dado.negacao;
+    }
+    return expr;
+}
+
+/*
+ * As funções simplificar_* recebem o nó com os operandos já simplificados
+ * e retornam o nó que o substitui.
+ */
+
+/* 'divisor_literal': o operando direito era uma constante antes de simplificado */
+static NoExpr *simplificar_aritmetica(ContextoCompilacao *ctx, NoExpr *expr, int divisor_literal) {
+    OpAritmetico op = expr->dado.aritmetica.op;
+    NoExpr *esq = expr->dado.aritmetica.esq;
+    NoExpr *dir = expr->dado.aritmetica.dir;
+
+    if (op == ARIT_DIV && !divisor_literal && eh_valor(dir, 0.0)) {
+        aviso_semantico(ctx, expr->linha, expr->coluna, "AVI002",
+                        "Divisao por zero em expressao constante");
+    }
+
+    /* Dobramento: a promoção para REAL segue tipo_resultante */
+    if (eh_constante(esq) && eh_constante(dir)) {
+        if (expr->tipo_dado == TIPO_REAL) {
+            double a = valor_real(esq), b = valor_real(dir);
+            switch (op) {
+                case ARIT_SOMA: return tornar_real(expr, a + b);
+                case ARIT_SUB:  return tornar_real(expr, a - b);
+                case ARIT_MULT: return tornar_real(expr, a * b);
+                case ARIT_DIV:  return tornar_real(expr, a / b);
+            }
+        } else {
+            int a = valor_inteiro(esq), b = valor_inteiro(dir);
+            switch (op) {
+                case ARIT_SOMA: return tornar_inteiro(expr, somar_int(a, b));
+                case ARIT_SUB:  return tornar_inteiro(expr, subtrair_int(a, b));
+                case ARIT_MULT: return tornar_inteiro(expr, multiplicar_int(a, b));
+                case ARIT_DIV:
+                    if (b == 0 || (a == INT_MIN && b == -1)) {
+                        return expr;  /* Fica para o erro de execução */
+                    }
+                    return tornar_inteiro(expr, a / b);
+            }
+        }
+    }
+
+    /*
+     * Identidades: só quando o operando restante já tem o tipo do nó,
+     * para não trocar uma expressão REAL por uma INTEIRA. Em REAL, x + 0
+     * e 0 - x não são reescritos (mudariam o sinal de -0,0).
+     */
+    int real = (expr->tipo_dado == TIPO_REAL);
+    switch (op) {
+        case ARIT_SOMA:
+            if (!real && eh_inteiro(esq, 0)) return dir;
+            if (!real && eh_inteiro(dir, 0)) return esq;
+            break;
+        case ARIT_SUB:
+            if (eh_valor(dir, 0.0) && esq->tipo_dado == expr->tipo_dado) return esq;
+            if (!real && eh_inteiro(esq, 0)) {
+                /* 0 - x (inclusive o menos unário do parser) vira negação */
+                expr->tipo = EXPR_NEG;
+                expr->dado.negacao = dir;
+                return simplificar_neg(expr);
+            }
+            break;
+        case ARIT_MULT:
+            if (eh_valor(esq, 1.0) && dir->tipo_dado == expr->tipo_dado) return dir;
+            if (eh_valor(dir, 1.0) && esq->tipo_dado == expr->tipo_dado) return esq;
+            break;
+        case ARIT_DIV:
+            if (eh_valor(dir, 1.0) && esq->tipo_dado == expr->tipo_dado) return esq;
+            break;
+    }
+
+    return expr;
+}
+
+static NoExpr *simplificar_relacional(NoExpr *expr) {
+    NoExpr *esq = expr->dado.relacional.esq;
+    NoExpr *dir = expr->dado.relacional.dir;
+
+    if (!eh_constante(esq) || !eh_constante(dir)) {
+        return expr;
+    }
+
+    /* Compara como REAL se algum lado for REAL, como no interpretador */
+    double a, b;
+    if (esq->tipo_dado == TIPO_REAL || dir->tipo_dado == TIPO_REAL) {
+        a = valor_real(esq);
+        b = valor_real(dir);
+    } else {
+        a = valor_inteiro(esq);
+        b = valor_inteiro(dir);
+    }
+
+    switch (expr->dado.relacional.op) {
+        case REL_MAQ: return tornar_inteiro(expr, a > b);
+        case REL_MAI: return tornar_inteiro(expr, a >= b);
+        case REL_MEQ: return tornar_inteiro(expr, a < b);
+        case REL_MEI: return tornar_inteiro(expr, a <= b);
+        case REL_IGU: return tornar_inteiro(expr, a == b);
+        case REL_DIF: return tornar_inteiro(expr, a != b);
+    }
+    return expr;
+}
+
+static NoExpr *simplificar_logica(NoExpr *expr) {
+    NoExpr *esq = expr->dado.logica.esq;
+    NoExpr *dir = expr->dado.logica.dir;
+
+    /* b .E. 1 e b .OU. 0 valem b: o esquerdo continua sendo avaliado */
+    if (!eh_constante(esq)) {
+        int neutro = (expr->dado.logica.op == LOG_E) ? 1 : 0;
+        if (eh_constante(dir) && (valor_inteiro(dir) != 0) == neutro && eh_booleano(esq)) {
+            return esq;
+        }
+        return expr;
+    }
+
+    /* Constante à esquerda: o direito pode nem ser avaliado */
+
+    int v = valor_inteiro(esq) != 0;
+    if (expr->dado.logica.op == LOG_E ? !v : v) {
+        return tornar_inteiro(expr, v);   /* Curto-circuito */
+    }
+    if (eh_constante(dir)) {
+        return tornar_inteiro(expr, valor_inteiro(dir) != 0);
+    }
+    if (eh_booleano(dir)) {
+        return dir;
+    }
+    return expr;
+}
+
+static NoExpr *simplificar_nao(NoExpr *expr) {
+    NoExpr *op = expr->dado.negacao;
+    if (eh_constante(op)) {
+        return tornar_inteiro(expr, !valor_inteiro(op));
+    }
+    /* .NAO. (.NAO. e) == e quando e já vale 0 ou 1 */
+    if (op->tipo == EXPR_NAO && eh_booleano(op->dado.negacao)) {
+        return op->dado.negacao;
+    }
+    return expr;
+}
+
+/* Nó em simplificação: o campo que aponta para ele recebe o substituto */
+typedef struct {
+    NoExpr **lugar;
+    int operandos_empilhados;
+    int divisor_literal;
+} QuadroSimplificacao;
+
+static void empilhar_lugar(Pilha *pilha, NoExpr **lugar) {
+    QuadroSimplificacao *q = (QuadroSimplificacao *)pilha_empilhar(pilha);
+    q->lugar = lugar;
+    q->operandos_empilhados = 0;
+    q->divisor_literal = 0;
+}
+
+/*
+ * Simplifica em pós-ordem: os operandos de um nó (empilhados da direita
+ * para a esquerda, para que os avisos saiam na ordem do fonte) são
+ * simplificados antes dele.
+ */
+static NoExpr *simplificar(ContextoCompilacao *ctx, NoExpr *raiz) {
+    Pilha pilha;
+    QuadroSimplificacao *q;
+
+    pilha_iniciar(&pilha, sizeof(QuadroSimplificacao));
+    empilhar_lugar(&pilha, &raiz);
+
+    while ((q = (QuadroSimplificacao *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = *q->lugar;
+
+        if (q->operandos_empilhados) {
+            NoExpr **lugar = q->lugar;
+            int divisor_literal = q->divisor_literal;
+            pilha_desempilhar(&pilha);
+
+            switch (expr->tipo) {
+                case EXPR_ARITMETICA:
+                    *lugar = simplificar_aritmetica(ctx, expr, divisor_literal);
+                    break;
+                case EXPR_RELACIONAL:
+                    *lugar = simplificar_relacional(expr);
+                    break;
+                case EXPR_LOGICA:
+                    *lugar = simplificar_logica(expr);
+                    break;
+                case EXPR_NAO:
+                    *lugar = simplificar_nao(expr);
+                    break;
+                case EXPR_NEG:
+                    *lugar = simplificar_neg(expr);
+                    break;
+                default:
+                    break;
+            }
+            continue;
+        }
+
+        q->operandos_empilhados = 1;
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                if (expr->dado.var->indice != NULL) {
+                    empilhar_lugar(&pilha, &expr->dado.var->indice);
+                }
+                break;
+            case EXPR_ARITMETICA:
+                q->divisor_literal = eh_constante(expr->dado.aritmetica.dir);
+                empilhar_lugar(&pilha, &expr->dado.aritmetica.dir);
+                empilhar_lugar(&pilha, &expr->dado.aritmetica.esq);
+                break;
+            case EXPR_RELACIONAL:
+                empilhar_lugar(&pilha, &expr->dado.relacional.dir);
+                empilhar_lugar(&pilha, &expr->dado.relacional.esq);
+                break;
+            case EXPR_LOGICA:
+                empilhar_lugar(&pilha, &expr->dado.logica.dir);
+                empilhar_lugar(&pilha, &expr->dado.logica.esq);
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_lugar(&pilha, &expr->dado.negacao);
+                break;
+            default:
+                break;
+        }
+    }
+
+    pilha_liberar(&pilha);
+    return raiz;
+}
+
+/* ========== Comandos ========== */
+
+static void otimizar_comandos(ContextoCompilacao *ctx, NoCmd *cmd) {
+    PercursoComandos percurso;
+
+    iniciar_percurso(&percurso, cmd);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                simplificar_var(ctx, cmd->dado.atrib.var);
+                cmd->dado.atrib.expr = simplificar(ctx, cmd->dado.atrib.expr);
+                break;
+
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    simplificar_var(ctx, v->var);
+                }
+                break;
+
+            case CMD_ESCREVA:
+                for (ListaEscreva *e = cmd->dado.escreva; e != NULL; e = e->prox) {
+                    if (!e->is_cadeia) {
+                        e->item.expr = simplificar(ctx, e->item.expr);
+                    }
+                }
+                break;
+
+            case CMD_SE:
+                cmd->dado.se.condicao = simplificar(ctx, cmd->dado.se.condicao);
+                break;
+
+            case CMD_ENQUANTO:
+                cmd->dado.enquanto.condicao = simplificar(ctx, cmd->dado.enquanto.condicao);
+                break;
+        }
+    }
+    terminar_percurso(&percurso);
+}
+
+long otimizar_programa(ContextoCompilacao *ctx, NoPrograma *prog, int nivel, FILE *registro) {
+    ctx->nos_antes_otimizacao = contar_comandos(prog->algoritmo);
+    otimizar_comandos(ctx, prog->algoritmo);
+
+    /* Os desvios que o dobramento deixou constantes e as atribuições sem leitura */
+    if (nivel >= OTIMIZAR_LACOS) {
+        eliminar_codigo_morto(ctx, prog, registro);
+    }
+    ctx->nos_depois_otimizacao = contar_comandos(prog->algoritmo);
+
+    /* Depois do dobramento, para que as expressões movidas já estejam simplificadas */
+    if (nivel >= OTIMIZAR_LACOS) {
+        mover_invariantes(ctx, prog, registro);
+
+        /* O que se repete dentro dos laços e fora deles; por último, os nós iguais */
+        long antes = contar_comandos(prog->algoritmo);
+        eliminar_subexpressoes(ctx, prog, registro);
+        ctx->avaliacoes_removidas = antes - contar_comandos(prog->algoritmo);
+        compartilhar_expressoes(ctx, prog);
+    }
+    return ctx->nos_antes_otimizacao - ctx->nos_depois_otimizacao;
+}
@@ -0,0 +1,36 @@
+/*
+ * Otimizações sobre a AST de X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef OTIMIZACAO_H
+#define OTIMIZACAO_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/* Níveis de otimização (-O0, padrão, -O2) */
+#define OTIMIZAR_NADA 0
+#define OTIMIZAR_EXPRESSOES 1   /* Dobramento de constantes e simplificações */
+#define OTIMIZAR_LACOS 2        /* E código morto, invariantes de laços e
+                                   subexpressões comuns (codigo_morto.h,
+                                   invariantes.h, subexpressoes.h) */
+
+/*
+ * Dobramento de constantes e simplificações algébricas e, a partir de
+ * OTIMIZAR_LACOS, eliminação de código morto, movimentação de código
+ * invariante dos ENQUANTO, eliminação de subexpressões comuns e
+ * compartilhamento dos nós iguais. O nível padrão não remove comandos:
+ * --emit-c e --emit-asm traduzem todas as atribuições do programa.
+ * Deve ser chamada após uma análise semântica sem erros (usa tipo_dado).
+ * Reescreve as expressões no lugar e retorna o número de nós de
+ * expressão eliminados pelo dobramento e, em OTIMIZAR_LACOS, pelo código
+ * morto (as contagens
+ * antes e depois, os comandos removidos, as expressões movidas e as
+ * reaproveitadas ficam em ctx; avisos vão para ctx). Com 'registro' não
+ * nulo, o código removido, as expressões movidas e os temporários comuns
+ * são listados ali.
+ */
+long otimizar_programa(ContextoCompilacao *ctx, NoPrograma *prog, int nivel, FILE *registro);
+
+#endif /* OTIMIZACAO_H */
@@ -0,0 +1,277 @@
+/*
+ * Implementação da compilação paralela com roubo de tarefas
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "paralelo.h"
+#include "contexto.h"
+#include "semantic.h"
+#include "otimizacao.h"
+#include "cache.h"
+
+/* Resultado de um arquivo, preenchido pela thread que o compilou */
+typedef struct {
+    int sucesso;
+    int erros_sintaticos;
+    int erros_semanticos;
+    int do_cache;           /* AST carregada do cache */
+    char *diagnosticos;
+} Resultado;
+
+/*
+ * Fila de tarefas de uma thread: os índices [inicio, fim) da lista de
+ * arquivos. A dona consome pelo fim; as outras roubam pelo início, de
+ * modo que dona e ladrões raramente disputam a mesma ponta.
+ */
+typedef struct Trabalhador {
+    pthread_t thread;
+    pthread_mutex_t trava;
+    int inicio;
+    int fim;
+    int id;
+    long compilados;
+    long roubados;
+    struct Pool *pool;
+} Trabalhador;
+
+typedef struct Pool {
+    char **arquivos;
+    Resultado *resultados;
+    Trabalhador *trabalhadores;
+    int num_trabalhadores;
+    int otimizar;
+    const char *dir_cache;  /* NULL sem --cache */
+    FormatoDiagnosticos formato;
+} Pool;
+
+/* ========== Compilação de um arquivo ========== */
+
+/* Diagnósticos guardados de ctx, como uma linha de JSON */
+static char *diagnosticos_json(ContextoCompilacao *ctx) {
+    char *texto = NULL;
+    size_t tamanho = 0;
+    FILE *saida = open_memstream(&texto, &tamanho);
+
+    if (saida == NULL) return NULL;
+    escrever_diagnosticos_json(ctx, saida);
+    fclose(saida);
+    return texto;
+}
+
+static void compilar_arquivo(const char *arquivo, int otimizar, const char *dir_cache,
+                             FormatoDiagnosticos formato, Resultado *r) {
+    ContextoCompilacao ctx;
+
+    memset(r, 0, sizeof(*r));
+    if (!inicializar_contexto(&ctx, arquivo,
+                              formato == DIAGNOSTICOS_JSON ? DESTINO_LISTA : DESTINO_MEMORIA)) {
+        r->diagnosticos = strdup("Erro: memoria insuficiente para os diagnosticos\n");
+        return;
+    }
+    ctx.relatorio = 0;
+    ctx.mostrar_tabela = 0;
+
+    if (!abrir_fonte(&ctx, arquivo)) {
+        diagnosticar(&ctx, SEVERIDADE_ERRO, ORIGEM_COMPILADOR, "CMP001", 0, 0,
+                     "Nao foi possivel abrir o arquivo '%s'", arquivo);
+    } else if (dir_cache != NULL && carregar_ast_cache(&ctx, dir_cache)) {
+        if (otimizar) {
+            otimizar_programa(&ctx, ctx.programa, otimizar, NULL);
+        }
+        r->sucesso = 1;
+        r->do_cache = 1;
+    } else {
+        int ok = analisar_sintaxe(&ctx);
+
+        if (ok && ctx.programa != NULL) {
+            analisar_semantica(&ctx, ctx.programa);
+            if (dir_cache != NULL) {
+                salvar_ast_cache(&ctx, dir_cache);
+            }
+            if (ctx.erros_semanticos == 0) {
+                if (otimizar) {
+                    otimizar_programa(&ctx, ctx.programa, otimizar, NULL);
+                }
+                r->sucesso = 1;
+            }
+        }
+    }
+
+    r->erros_sintaticos = ctx.erros_sintaticos;
+    r->erros_semanticos = ctx.erros_semanticos;
+    r->diagnosticos = formato == DIAGNOSTICOS_JSON ? diagnosticos_json(&ctx)
+                                                   : strdup(diagnosticos_contexto(&ctx));
+    liberar_contexto(&ctx);
+}
+
+/* ========== Filas com roubo de tarefas ========== */
+
+/* Próxima tarefa da própria fila (pelo fim), ou -1 */
+static int retirar(Trabalhador *t) {
+    int tarefa = -1;
+    pthread_mutex_lock(&t->trava);
+    if (t->inicio < t->fim) {
+        tarefa = --t->fim;
+    }
+    pthread_mutex_unlock(&t->trava);
+    return tarefa;
+}
+
+/* Rouba a primeira tarefa da fila de 'vitima', ou -1 */
+static int roubar(Trabalhador *vitima) {
+    int tarefa = -1;
+    pthread_mutex_lock(&vitima->trava);
+    if (vitima->inicio < vitima->fim) {
+        tarefa = vitima->inicio++;
+    }
+    pthread_mutex_unlock(&vitima->trava);
+    return tarefa;
+}
+
+static void *laco_trabalhador(void *arg) {
+    Trabalhador *t = (Trabalhador *)arg;
+    Pool *pool = t->pool;
+
+    for (;;) {
+        int tarefa = retirar(t);
+
+        /* Fila vazia: procura trabalho nas demais, a partir da vizinha */
+        for (int i = 1; tarefa < 0 && i < pool->num_trabalhadores; i++) {
+            Trabalhador *vitima = &pool->trabalhadores[(t->id + i) % pool->num_trabalhadores];
+            tarefa = roubar(vitima);
+            if (tarefa >= 0) {
+                t->roubados++;
+            }
+        }
+
+        /* Nenhuma tarefa nova é criada: se todas estão vazias, acabou */
+        if (tarefa < 0) {
+            break;
+        }
+
+        compilar_arquivo(pool->arquivos[tarefa], pool->otimizar, pool->dir_cache,
+                         pool->formato, &pool->resultados[tarefa]);
+        t->compilados++;
+    }
+    return NULL;
+}
+
+/* ========== Interface ========== */
+
+int compilar_em_paralelo(char **arquivos, int n, int num_threads, int otimizar, int verbose,
+                         const char *dir_cache, int silencioso, FormatoDiagnosticos formato) {
+    Pool pool;
+    struct timespec ini, fim;
+
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > n) num_threads = n > 0 ? n : 1;
+
+    pool.arquivos = arquivos;
+    pool.otimizar = otimizar;
+    pool.dir_cache = dir_cache;
+    pool.formato = formato;
+    pool.num_trabalhadores = num_threads;
+    pool.resultados = (Resultado *)calloc(n > 0 ? n : 1, sizeof(Resultado));
+    pool.trabalhadores = (Trabalhador *)calloc(num_threads, sizeof(Trabalhador));
+    if (pool.resultados == NULL || pool.trabalhadores == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a compilacao paralela\n");
+        free(pool.resultados);
+        free(pool.trabalhadores);
+        return n;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+
+    /* Cada thread começa com uma fatia contígua da lista */
+    for (int i = 0; i < num_threads; i++) {
+        Trabalhador *t = &pool.trabalhadores[i];
+        t->id = i;
+        t->pool = &pool;
+        t->inicio = (int)((long)n * i / num_threads);
+        t->fim = (int)((long)n * (i + 1) / num_threads);
+        pthread_mutex_init(&t->trava, NULL);
+    }
+
+    /* A thread principal trabalha como a de índice 0 */
+    int criadas = 1;
+    for (int i = 1; i < num_threads; i++) {
+        if (pthread_create(&pool.trabalhadores[i].thread, NULL,
+                           laco_trabalhador, &pool.trabalhadores[i]) != 0) {
+            break;  /* As fatias restantes serão roubadas pelas demais */
+        }
+        criadas++;
+    }
+    laco_trabalhador(&pool.trabalhadores[0]);
+    for (int i = 1; i < criadas; i++) {
+        pthread_join(pool.trabalhadores[i].thread, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+
+    /*
+     * Resultados agrupados por arquivo, na ordem da linha de comando. No
+     * modo silencioso, só os diagnósticos, juntados numa única escrita.
+     */
+    char *texto_lote = NULL;
+    size_t tamanho_lote = 0;
+    FILE *lote = silencioso ? open_memstream(&texto_lote, &tamanho_lote) : NULL;
+    int falhas = 0;
+    int acertos = 0;
+    for (int i = 0; i < n; i++) {
+        Resultado *r = &pool.resultados[i];
+        if (!r->sucesso) {
+            falhas++;
+        }
+        if (!silencioso) {
+            if (r->sucesso) {
+                printf("%s: OK%s\n", arquivos[i], r->do_cache ? " (cache)" : "");
+            } else {
+                printf("%s: FALHOU (%d erro(s) sintatico(s), %d erro(s) semantico(s))\n",
+                       arquivos[i], r->erros_sintaticos, r->erros_semanticos);
+            }
+        }
+        if (r->diagnosticos != NULL && r->diagnosticos[0] != '\0') {
+            if (lote != NULL) {
+                fputs(r->diagnosticos, lote);
+            } else {
+                fflush(stdout);
+                fputs(r->diagnosticos, stderr);
+                fflush(stderr);
+            }
+        }
+        acertos += r->do_cache;
+        free(r->diagnosticos);
+    }
+    if (lote != NULL) {
+        fclose(lote);
+        fwrite(texto_lote, 1, tamanho_lote, stderr);
+        free(texto_lote);
+    }
+
+    double ms = (fim.tv_sec - ini.tv_sec) * 1e3 + (fim.tv_nsec - ini.tv_nsec) / 1e6;
+    if (!silencioso) {
+        printf(">>> %d arquivo(s), %d com erro(s), %d thread(s), %.3f ms\n",
+               n, falhas, criadas, ms);
+    }
+    if (dir_cache != NULL && !silencioso) {
+        printf(">>> Cache (%s): %d acerto(s), %d falha(s)\n", dir_cache, acertos, n - acertos);
+    }
+    if (verbose) {
+        for (int i = 0; i < criadas; i++) {
+            printf(">>>   thread %d: %ld arquivo(s) compilado(s), %ld roubado(s)\n",
+                   i, pool.trabalhadores[i].compilados, pool.trabalhadores[i].roubados);
+        }
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        pthread_mutex_destroy(&pool.trabalhadores[i].trava);
+    }
+    free(pool.resultados);
+    free(pool.trabalhadores);
+    return falhas;
+}
@@ -0,0 +1,31 @@
+/*
+ * Compilação de vários arquivos em paralelo (opção -j)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef PARALELO_H
+#define PARALELO_H
+
+#include "diagnosticos.h"
+
+/*
+ * Compila (léxico, sintático, semântico e as otimizações do nível
+ * 'otimizar', ver otimizacao.h) os 'n' arquivos com 'num_threads' threads. Cada thread
+ * começa com uma fatia contígua da lista e, ao esvaziá-la, rouba
+ * arquivos do início da fatia das outras (work stealing).
+ *
+ * Os diagnósticos de cada arquivo são acumulados em memória e impressos
+ * juntos, na ordem dos arquivos na linha de comando. Retorna o número de
+ * arquivos com erro.
+ *
+ * Com 'dir_cache' (não NULL), cada arquivo inalterado desde a última
+ * compilação tem a AST verificada carregada de lá (ver cache.h).
+ *
+ * Com 'silencioso', nada vai para a saída padrão e os diagnósticos de
+ * todos os arquivos saem numa única escrita; em DIAGNOSTICOS_JSON, uma
+ * linha de JSON por arquivo (ver escrever_diagnosticos_json).
+ */
+int compilar_em_paralelo(char **arquivos, int n, int num_threads, int otimizar, int verbose,
+                         const char *dir_cache, int silencioso, FormatoDiagnosticos formato);
+
+#endif /* PARALELO_H */
@@ -9,31 +9,46 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ast.h"
-#include "semantic.h"
+#include "contexto.h"
 
-/* Funções externas */
-extern int yylex(void);
-extern FILE *yyin;
-extern int linha;
-extern int coluna;
-extern char *yytext;
+/*
+ * As pilhas do parser crescem no heap; o limite padrão (10000) cortaria
+ * programas com milhares de SE/ENQUANTO ou parênteses aninhados.
+ */
+#define YYMAXDEPTH 10000000
 
-/* Variável para raiz do programa (declarada aqui, extern em main.c) */
-NoPrograma *programa_raiz = NULL;
+%}
 
-/* Contadores de erros */
-int erros_sintaticos = 0;
+/*
+ * Parser puro: nenhum estado global. O analisador léxico reentrante
+ * ('scanner') e o contexto da compilação chegam como parâmetros, e a
+ * raiz do programa e os erros ficam em ctx.
+ */
+%define api.pure full
+%parse-param {void *scanner} {ContextoCompilacao *ctx}
+%lex-param {void *scanner}
 
-/* Função de tratamento de erros */
-void yyerror(const char *s);
+%code requires {
+#include "ast.h"
+}
 
-%}
+%code {
+/* Funções externas */
+int yylex(YYSTYPE *yylval_param, void *scanner);
+char *yyget_text(void *scanner);
+int yyget_leng(void *scanner);
+
+/* Funções de tratamento de erros */
+void yyerror(void *scanner, ContextoCompilacao *ctx, const char *s);
+static void erro_sintatico(ContextoCompilacao *ctx, const char *codigo, const char *s);
+}
 
 /* União para valores semânticos */
 %union {
     int ival;
     double fval;
     char *sval;
+    ChaveId chave;
     struct NoPrograma *programa;
     struct NoDecl *declaracao;
     struct NoCmd *comando;
@@ -53,6 +68,9 @@ void yyerror(const char *s);
 %token ENQUANTO FACA FIMENQ
 %token ATRIB
 
+/* Primeiro token de um trecho de ALGORITMO (ctx->trecho, ver contexto.h) */
+%token INICIO_TRECHO
+
 /* Operadores relacionais */
 %token OP_MAQ OP_MAI OP_MEQ OP_MEI OP_IGU OP_DIF
 
@@ -63,14 +81,14 @@ void yyerror(const char *s);
 %token <ival> CONST_INT
 %token <fval> CONST_REAL
 %token <sval> CADEIA_LIT
-%token <sval> ID
+%token <chave> ID
 
 /* Tipos dos não-terminais */
 %type <programa> programa
 %type <declaracao> area_declaracoes lista_declaracoes declaracao
-%type <comando> area_algoritmo lista_comandos comando cmd_atrib cmd_leia cmd_escreva cmd_se cmd_enquanto
+%type <comando> area_algoritmo comandos_algoritmo lista_comandos comando cmd_atrib cmd_leia cmd_escreva cmd_se cmd_enquanto
 %type <expressao> expressao expr_aritmetica expr_relacional expr_logica termo fator
-%type <variavel> variavel
+%type <variavel> variavel nome_variavel
 %type <lista_var> lista_variaveis
 %type <lista_escreva> lista_escreva item_escreva
 %type <tipo_dado> tipo
@@ -88,11 +106,19 @@ void yyerror(const char *s);
 
 /* ========== Regras da Gramática ========== */
 
+entrada
+    : programa
+    | INICIO_TRECHO comandos_algoritmo
+        { ctx->programa = criar_programa(ctx, NULL, NULL, $2); }
+    | INICIO_TRECHO
+        { ctx->programa = criar_programa(ctx, NULL, NULL, NULL); }
+    ;
+
 programa
     : PROGRAMA area_declaracoes area_algoritmo FIMPROG
         {
-            $$ = criar_programa(NULL, $2, $3);
-            programa_raiz = $$;
+            $$ = criar_programa(ctx, NULL, $2, $3);
+            ctx->programa = $$;
         }
     ;
 
@@ -115,15 +141,15 @@ lista_declaracoes
 declaracao
     : tipo ID
         { 
-            $$ = criar_declaracao($1, $2, 0); 
+            $$ = criar_declaracao(ctx, $1, $2, 0); 
         }
     | tipo ID '[' CONST_INT ']'
         { 
             if ($1 == TIPO_LISTAINT || $1 == TIPO_LISTAREAL) {
-                $$ = criar_declaracao($1, $2, $4);
+                $$ = criar_declaracao(ctx, $1, $2, $4);
             } else {
-                yyerror("Array deve ser declarado com LISTAINT ou LISTAREAL");
-                $$ = criar_declaracao($1, $2, $4);
+                erro_sintatico(ctx, "SIN002", "Array deve ser declarado com LISTAINT ou LISTAREAL");
+                $$ = criar_declaracao(ctx, $1, $2, $4);
             }
         }
     ;
@@ -140,12 +166,60 @@ tipo
     ;
 
 area_algoritmo
-    : ALGORITMO lista_comandos
-        { $$ = $2; }
+    : ALGORITMO comandos_algoritmo
+        {
+            $$ = $2;
+            if (ctx->marcas != NULL) {
+                marcar_fim_algoritmo(ctx, yyget_text(scanner), yyget_leng(scanner));
+            }
+        }
     | ALGORITMO
+        {
+            $$ = NULL;
+            if (ctx->marcas != NULL) {
+                marcar_fim_algoritmo(ctx, yyget_text(scanner), yyget_leng(scanner));
+            }
+        }
+    ;
+
+/*
+ * Comandos do nível externo de ALGORITMO. Um erro de sintaxe descarta
+ * só o comando em que ocorreu: o parser retoma no início do próximo e
+ * os erros seguintes também são relatados. Com ctx->marcas, o início de
+ * cada comando (o token de lookahead em inicio_comando) é registrado,
+ * para a reanálise incremental do servidor LSP.
+ */
+comandos_algoritmo
+    : comandos_algoritmo inicio_comando comando
+        {
+            $$ = concat_comandos($1, $3);
+            if (ctx->marcas != NULL) {
+                ligar_comando(ctx, $3);
+            }
+        }
+    | comandos_algoritmo inicio_comando error
+        { $$ = $1; }
+    | inicio_comando comando
+        {
+            $$ = $2;
+            if (ctx->marcas != NULL) {
+                ligar_comando(ctx, $2);
+            }
+        }
+    | inicio_comando error
         { $$ = NULL; }
     ;
 
+inicio_comando
+    : /* vazio */
+        {
+            /* Durante a recuperação de um erro, o comando fica no trecho do erro */
+            if (ctx->marcas != NULL && !YYRECOVERING()) {
+                marcar_comando(ctx, yyget_text(scanner), yyget_leng(scanner));
+            }
+        }
+    ;
+
 lista_comandos
     : lista_comandos comando
         { $$ = concat_comandos($1, $2); }
@@ -168,24 +242,24 @@ comando
 
 cmd_atrib
     : variavel ATRIB expressao
-        { $$ = criar_cmd_atrib($1, $3); }
+        { $$ = criar_cmd_atrib(ctx, $1, $3); }
     ;
 
 cmd_leia
     : LEIA lista_variaveis
-        { $$ = criar_cmd_leia($2); }
+        { $$ = criar_cmd_leia(ctx, $2); }
     ;
 
 lista_variaveis
     : lista_variaveis ',' variavel
-        { $$ = concat_lista_var($1, $3); }
+        { $$ = concat_lista_var(ctx, $1, $3); }
     | variavel
-        { $$ = criar_lista_var($1); }
+        { $$ = criar_lista_var(ctx, $1); }
     ;
 
 cmd_escreva
     : ESCREVA lista_escreva
-        { $$ = criar_cmd_escreva($2); }
+        { $$ = criar_cmd_escreva(ctx, $2); }
     ;
 
 lista_escreva
@@ -197,34 +271,43 @@ lista_escreva
 
 item_escreva
     : CADEIA_LIT
-        { $$ = criar_item_cadeia($1); }
+        { $$ = criar_item_cadeia(ctx, $1); }
     | expressao
-        { $$ = criar_item_expr($1); }
+        { $$ = criar_item_expr(ctx, $1); }
     ;
 
 cmd_se
     : SE expr_relacional ENTAO lista_comandos FIMSE
-        { $$ = criar_cmd_se($2, $4, NULL); }
+        { $$ = criar_cmd_se(ctx, $2, $4, NULL); }
     | SE expr_relacional ENTAO lista_comandos SENAO lista_comandos FIMSE
-        { $$ = criar_cmd_se($2, $4, $6); }
+        { $$ = criar_cmd_se(ctx, $2, $4, $6); }
     | SE expr_relacional ENTAO comando FIMSE
-        { $$ = criar_cmd_se($2, $4, NULL); }
+        { $$ = criar_cmd_se(ctx, $2, $4, NULL); }
     | SE expr_relacional ENTAO comando SENAO comando FIMSE
-        { $$ = criar_cmd_se($2, $4, $6); }
+        { $$ = criar_cmd_se(ctx, $2, $4, $6); }
     ;
 
 cmd_enquanto
     : ENQUANTO expr_relacional FACA lista_comandos FIMENQ
-        { $$ = criar_cmd_enquanto($2, $4); }
+        { $$ = criar_cmd_enquanto(ctx, $2, $4); }
     | ENQUANTO expr_relacional FACA comando FIMENQ
-        { $$ = criar_cmd_enquanto($2, $4); }
+        { $$ = criar_cmd_enquanto(ctx, $2, $4); }
     ;
 
 variavel
+    : nome_variavel
+        { $$ = $1; }
+    | nome_variavel '[' expressao ']'
+        { $$ = $1; $$->indice = $3; }
+    ;
+
+/*
+ * Regra à parte para que o ID seja reduzido sem ler o lookahead (que
+ * pode ser o ID do próximo comando): o nó fica com a posição do nome
+ */
+nome_variavel
     : ID
-        { $$ = criar_var_simples($1); }
-    | ID '[' expressao ']'
-        { $$ = criar_var_array($1, $3); }
+        { $$ = criar_var_simples(ctx, $1); }
     ;
 
 /* Expressões */
@@ -243,41 +326,41 @@ expr_relacional
 
 expr_logica
     : expr_logica OP_OU expr_logica
-        { $$ = criar_expr_logica(LOG_OU, $1, $3); }
+        { $$ = criar_expr_logica(ctx, LOG_OU, $1, $3); }
     | expr_logica OP_E expr_logica
-        { $$ = criar_expr_logica(LOG_E, $1, $3); }
+        { $$ = criar_expr_logica(ctx, LOG_E, $1, $3); }
     | OP_NAO '(' expr_logica ')'
-        { $$ = criar_expr_nao($3); }
+        { $$ = criar_expr_nao(ctx, $3); }
     | '(' expr_logica ')'
         { $$ = $2; }
     | expr_aritmetica OP_MAQ expr_aritmetica
-        { $$ = criar_expr_relacional(REL_MAQ, $1, $3); }
+        { $$ = criar_expr_relacional(ctx, REL_MAQ, $1, $3); }
     | expr_aritmetica OP_MAI expr_aritmetica
-        { $$ = criar_expr_relacional(REL_MAI, $1, $3); }
+        { $$ = criar_expr_relacional(ctx, REL_MAI, $1, $3); }
     | expr_aritmetica OP_MEQ expr_aritmetica
-        { $$ = criar_expr_relacional(REL_MEQ, $1, $3); }
+        { $$ = criar_expr_relacional(ctx, REL_MEQ, $1, $3); }
     | expr_aritmetica OP_MEI expr_aritmetica
-        { $$ = criar_expr_relacional(REL_MEI, $1, $3); }
+        { $$ = criar_expr_relacional(ctx, REL_MEI, $1, $3); }
     | expr_aritmetica OP_IGU expr_aritmetica
-        { $$ = criar_expr_relacional(REL_IGU, $1, $3); }
+        { $$ = criar_expr_relacional(ctx, REL_IGU, $1, $3); }
     | expr_aritmetica OP_DIF expr_aritmetica
-        { $$ = criar_expr_relacional(REL_DIF, $1, $3); }
+        { $$ = criar_expr_relacional(ctx, REL_DIF, $1, $3); }
     ;
 
 expr_aritmetica
     : expr_aritmetica '+' termo
-        { $$ = criar_expr_aritmetica(ARIT_SOMA, $1, $3); }
+        { $$ = criar_expr_aritmetica(ctx, ARIT_SOMA, $1, $3); }
     | expr_aritmetica '-' termo
-        { $$ = criar_expr_aritmetica(ARIT_SUB, $1, $3); }
+        { $$ = criar_expr_aritmetica(ctx, ARIT_SUB, $1, $3); }
     | termo
         { $$ = $1; }
     ;
 
 termo
     : termo '*' fator
-        { $$ = criar_expr_aritmetica(ARIT_MULT, $1, $3); }
+        { $$ = criar_expr_aritmetica(ctx, ARIT_MULT, $1, $3); }
     | termo '/' fator
-        { $$ = criar_expr_aritmetica(ARIT_DIV, $1, $3); }
+        { $$ = criar_expr_aritmetica(ctx, ARIT_DIV, $1, $3); }
     | fator
         { $$ = $1; }
     ;
@@ -286,16 +369,16 @@ fator
     : '(' expr_aritmetica ')'
         { $$ = $2; }
     | CONST_INT
-        { $$ = criar_expr_const_int($1); }
+        { $$ = criar_expr_const_int(ctx, $1); }
     | CONST_REAL
-        { $$ = criar_expr_const_real($1); }
+        { $$ = criar_expr_const_real(ctx, $1); }
     | variavel
-        { $$ = criar_expr_var($1); }
+        { $$ = criar_expr_var(ctx, $1); }
     | '-' fator %prec UMINUS
         { 
             /* Unário negativo: 0 - fator */
-            NoExpr *zero = criar_expr_const_int(0);
-            $$ = criar_expr_aritmetica(ARIT_SUB, zero, $2);
+            NoExpr *zero = criar_expr_const_int(ctx, 0);
+            $$ = criar_expr_aritmetica(ctx, ARIT_SUB, zero, $2);
         }
     ;
 
@@ -303,8 +386,12 @@ fator
 
 /* ========== Tratamento de Erros ========== */
 
-void yyerror(const char *s) {
-    fprintf(stderr, "ERRO SINTATICO na linha %d, coluna %d: %s\n", linha, coluna, s);
-    erros_sintaticos++;
+static void erro_sintatico(ContextoCompilacao *ctx, const char *codigo, const char *s) {
+    diagnosticar(ctx, SEVERIDADE_ERRO, ORIGEM_SINTATICA, codigo, ctx->linha, ctx->coluna, "%s", s);
+    ctx->erros_sintaticos++;
 }
 
+void yyerror(void *scanner, ContextoCompilacao *ctx, const char *s) {
+    (void)scanner;
+    erro_sintatico(ctx, "SIN001", s);
+}
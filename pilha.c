@@ -0,0 +1,62 @@
+/*
+ * Implementação da pilha explícita
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pilha.h"
+
+void pilha_iniciar(Pilha *p, size_t tamanho_quadro) {
+    p->itens = p->local.bytes;
+    p->tamanho_quadro = tamanho_quadro;
+    p->num = 0;
+    p->capacidade = PILHA_LOCAL / tamanho_quadro;
+}
+
+static void crescer(Pilha *p) {
+    size_t capacidade = p->capacidade > 0 ? p->capacidade * 2 : 16;
+    unsigned char *itens;
+
+    if (p->itens == p->local.bytes) {
+        itens = (unsigned char *)malloc(capacidade * p->tamanho_quadro);
+        if (itens != NULL) {
+            memcpy(itens, p->local.bytes, p->num * p->tamanho_quadro);
+        }
+    } else {
+        itens = (unsigned char *)realloc(p->itens, capacidade * p->tamanho_quadro);
+    }
+    if (itens == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para percorrer a AST\n");
+        exit(1);
+    }
+    p->itens = itens;
+    p->capacidade = capacidade;
+}
+
+void *pilha_empilhar(Pilha *p) {
+    if (p->num == p->capacidade) {
+        crescer(p);
+    }
+    return p->itens + p->num++ * p->tamanho_quadro;
+}
+
+void *pilha_topo(Pilha *p) {
+    return p->num > 0 ? p->itens + (p->num - 1) * p->tamanho_quadro : NULL;
+}
+
+void pilha_desempilhar(Pilha *p) {
+    if (p->num > 0) {
+        p->num--;
+    }
+}
+
+void pilha_liberar(Pilha *p) {
+    if (p->itens != p->local.bytes) {
+        free(p->itens);
+    }
+    p->itens = p->local.bytes;
+    p->num = 0;
+    p->capacidade = PILHA_LOCAL / p->tamanho_quadro;
+}
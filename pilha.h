@@ -0,0 +1,52 @@
+/*
+ * Pilha explícita para os percursos da AST
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef PILHA_H
+#define PILHA_H
+
+#include <stddef.h>
+
+/* Bytes de quadros guardados na própria Pilha antes de recorrer ao heap */
+#define PILHA_LOCAL 512
+
+/*
+ * Pilha de quadros de tamanho fixo, usada no lugar da recursão para que
+ * a profundidade da AST (expressões com milhões de termos encadeados,
+ * milhares de SE/ENQUANTO aninhados) seja limitada só pela memória.
+ *
+ * Os primeiros quadros ficam em 'local'; acima disso, a pilha passa ao
+ * heap e dobra de capacidade. Como 'itens' pode apontar para dentro da
+ * própria estrutura, uma Pilha não pode ser copiada depois de iniciada.
+ */
+typedef struct Pilha {
+    unsigned char *itens;
+    size_t tamanho_quadro;
+    size_t num;
+    size_t capacidade;          /* Em quadros */
+    union {
+        unsigned char bytes[PILHA_LOCAL];
+        void *ponteiro;
+        double real;
+        long longo;
+    } local;
+} Pilha;
+
+void pilha_iniciar(Pilha *p, size_t tamanho_quadro);
+
+/*
+ * Reserva um quadro no topo e retorna seu endereço; nunca retorna NULL
+ * (aborta sem memória). Endereços de quadros valem só até o próximo
+ * empilhamento.
+ */
+void *pilha_empilhar(Pilha *p);
+
+/* Quadro do topo, ou NULL se a pilha estiver vazia */
+void *pilha_topo(Pilha *p);
+
+void pilha_desempilhar(Pilha *p);
+
+void pilha_liberar(Pilha *p);
+
+#endif /* PILHA_H */
@@ -0,0 +1,97 @@
+/*
+ * Implementação das rotinas de entrada e saída de X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "runtime.h"
+
+/* ========== Saída (ESCREVA) ========== */
+
+void escrever_inteiro(int valor) {
+    printf("%d", valor);
+}
+
+void escrever_real(double valor) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.2f", valor);
+    char *p = strchr(buf, '.');
+    if (p) *p = ',';
+    fputs(buf, stdout);
+}
+
+void escrever_cadeia(const char *cadeia) {
+    fputs(cadeia, stdout);
+}
+
+void escrever_fim_linha(void) {
+    putchar('\n');
+}
+
+/* ========== Entrada (LEIA) ========== */
+
+/* Lê a próxima palavra da entrada padrão; retorna 0 no fim da entrada */
+static int ler_palavra(char *buf, size_t tam) {
+    int c;
+    size_t n = 0;
+
+    do {
+        c = getchar();
+    } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+
+    while (c != EOF && c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+        if (n < tam - 1) buf[n++] = (char)c;
+        c = getchar();
+    }
+    buf[n] = '\0';
+    return n > 0;
+}
+
+int ler_inteiro(int linha) {
+    char buf[64];
+    char *fim;
+
+    fflush(stdout);
+    if (!ler_palavra(buf, sizeof(buf))) {
+        erro_execucao(linha, "Fim da entrada durante LEIA");
+    }
+    long valor = strtol(buf, &fim, 10);
+    if (*fim != '\0') {
+        erro_execucao(linha, "Valor inteiro invalido na entrada: '%s'", buf);
+    }
+    return (int)valor;
+}
+
+double ler_real(int linha) {
+    char buf[64];
+    char *fim;
+
+    fflush(stdout);
+    if (!ler_palavra(buf, sizeof(buf))) {
+        erro_execucao(linha, "Fim da entrada durante LEIA");
+    }
+    /* Aceita vírgula (convenção X25b) ou ponto como separador decimal */
+    char *p = strchr(buf, ',');
+    if (p) *p = '.';
+    double valor = strtod(buf, &fim);
+    if (*fim != '\0') {
+        erro_execucao(linha, "Valor real invalido na entrada: '%s'", buf);
+    }
+    return valor;
+}
+
+/* ========== Erros de execução ========== */
+
+void erro_execucao(int linha, const char *formato, ...) {
+    va_list args;
+    fflush(stdout);
+    fprintf(stderr, "ERRO DE EXECUCAO na linha %d: ", linha);
+    va_start(args, formato);
+    vfprintf(stderr, formato, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    exit(2);
+}
@@ -0,0 +1,62 @@
+/*
+ * Rotinas de entrada e saída usadas na execução de programas X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <limits.h>
+
+/* Valor armazenado em uma posição do quadro de variáveis */
+typedef union Valor {
+    int i;
+    double r;
+} Valor;
+
+/*
+ * Convenções de X25b: números reais usam vírgula como separador decimal,
+ * tanto na leitura (LEIA) quanto na escrita (ESCREVA). Cada ESCREVA
+ * imprime seus itens lado a lado e termina a linha.
+ */
+
+/* ========== Saída (ESCREVA) ========== */
+void escrever_inteiro(int valor);
+void escrever_real(double valor);
+void escrever_cadeia(const char *cadeia);
+void escrever_fim_linha(void);
+
+/* ========== Entrada (LEIA) ========== */
+int ler_inteiro(int linha);
+double ler_real(int linha);
+
+/* ========== Erros de execução ========== */
+
+/* Reporta o erro, descarrega a saída e encerra o programa */
+void erro_execucao(int linha, const char *formato, ...);
+
+/* ========== Aritmética inteira ========== */
+
+/*
+ * INTEIRO tem 32 bits em todos os modos de execução: soma, subtração,
+ * multiplicação e negação dão a volta em complemento de dois (sem o
+ * comportamento indefinido do estouro de int em C), e a divisão trunca
+ * em direção a zero e é um erro de execução com divisor 0 ou em
+ * INT_MIN / -1, cujo quociente não cabe em 32 bits.
+ */
+static inline int somar_inteiros(int a, int b) { return (int)((unsigned)a + (unsigned)b); }
+static inline int subtrair_inteiros(int a, int b) { return (int)((unsigned)a - (unsigned)b); }
+static inline int multiplicar_inteiros(int a, int b) { return (int)((unsigned)a * (unsigned)b); }
+static inline int negar_inteiro(int a) { return (int)(0u - (unsigned)a); }
+
+static inline int dividir_inteiros(int a, int b, int linha) {
+    if (b == 0) {
+        erro_execucao(linha, "Divisao inteira por zero");
+    }
+    if (b == -1 && a == INT_MIN) {
+        erro_execucao(linha, "Estouro na divisao inteira");
+    }
+    return a / b;
+}
+
+#endif /* RUNTIME_H */
@@ -9,141 +9,344 @@
 #include <string.h>
 #include <stdarg.h>
 #include "semantic.h"
+#include "contexto.h"
+#include "pilha.h"
+#include "fluxo.h"
+#include "intervalos.h"
 
-/* Declaração explícita para evitar warnings */
-extern char *strdup(const char *s);
+/*
+ * Todo o estado da análise (tabela, contadores, destino das mensagens)
+ * fica no ContextoCompilacao: arquivos diferentes podem ser analisados
+ * ao mesmo tempo em threads diferentes.
+ */
 
-/* Tabela de símbolos global */
-static TabelaSimbolos tabela;
+/* ========== Funções Hash ========== */
 
-/* Contador de erros semânticos */
-int erros_semanticos = 0;
+/*
+ * Hash multiplicativo (Fibonacci) da chave empacotada: os bits altos do
+ * produto, que dependem de todos os caracteres do identificador.
+ */
+static unsigned int hash(ChaveId chave, const TabelaSimbolos *t) {
+    return (unsigned int)((chave * 0x9E3779B97F4A7C15ULL) >> (64 - t->bits_baldes));
+}
 
-/* ========== Funções Hash ========== */
+/* ========== Implementação da Tabela de Símbolos ========== */
 
-static unsigned int hash(const char *str) {
-    unsigned int h = 0;
-    while (*str) {
-        h = h * 31 + (unsigned char)*str++;
+/* Menor potência de 2 que mantém 'n' símbolos com carga até 1/2 */
+static int baldes_para(int n) {
+    int baldes = TAB_SIMBOLOS_INICIAL;
+    while (baldes < 2 * n) {
+        baldes *= 2;
     }
-    return h % TAB_SIMBOLOS_TAM;
+    return baldes;
 }
 
-/* ========== Implementação da Tabela de Símbolos ========== */
+static void criar_indice(TabelaSimbolos *t, int num_baldes) {
+    t->baldes = (BaldeSimbolo *)malloc(num_baldes * sizeof(BaldeSimbolo));
+    t->num_baldes = num_baldes;
+    t->bits_baldes = 0;
+    while ((1 << t->bits_baldes) < num_baldes) {
+        t->bits_baldes++;
+    }
+    for (int i = 0; i < num_baldes; i++) {
+        t->baldes[i].indice = -1;
+    }
+}
 
-void inicializar_tabela(void) {
-    for (int i = 0; i < TAB_SIMBOLOS_TAM; i++) {
-        tabela.entradas[i] = NULL;
+/* Coloca a entrada 'i' no primeiro balde livre a partir do seu hash */
+static void indexar(TabelaSimbolos *t, int i) {
+    unsigned int h = hash(t->simbolos[i].chave, t);
+    while (t->baldes[h].indice >= 0) {
+        h = (h + 1) & (unsigned int)(t->num_baldes - 1);
     }
-    tabela.num_simbolos = 0;
+    t->baldes[h].chave = t->simbolos[i].chave;
+    t->baldes[h].indice = i;
 }
 
-int inserir_simbolo(const char *nome, TipoDado tipo, int tamanho, int linha) {
+/* Dobra o índice e reinsere as chaves; as entradas não se movem */
+static void crescer_indice(TabelaSimbolos *t) {
+    free(t->baldes);
+    criar_indice(t, t->num_baldes * 2);
+    for (int i = 0; i < t->num_simbolos; i++) {
+        indexar(t, i);
+    }
+}
+
+void inicializar_tabela(ContextoCompilacao *ctx, int previstos) {
+    TabelaSimbolos *t = &ctx->tabela;
+    
+    t->capacidade_simbolos = previstos > TAB_SIMBOLOS_INICIAL ? previstos : TAB_SIMBOLOS_INICIAL;
+    t->simbolos = (EntradaSimbolo *)malloc(t->capacidade_simbolos * sizeof(EntradaSimbolo));
+    t->num_simbolos = 0;
+    t->tamanho_quadro = 0;
+    criar_indice(t, baldes_para(previstos));
+}
+
+int inserir_simbolo(ContextoCompilacao *ctx, ChaveId chave, TipoDado tipo, int tamanho,
+                    int linha, int coluna) {
+    TabelaSimbolos *t = &ctx->tabela;
+    char nome[ID_MAX_CHARS + 1];
+    
     /* Verifica se já existe */
-    if (buscar_simbolo(nome) != NULL) {
-        erro_semantico(linha, "Variavel '%s' ja foi declarada", nome);
+    if (buscar_simbolo(ctx, chave) != NULL) {
+        erro_semantico(ctx, linha, coluna, "SEM001", "Variavel '%s' ja foi declarada", texto_id(chave, nome));
         return 0;
     }
     
-    /* Cria nova entrada */
-    EntradaSimbolo *nova = (EntradaSimbolo *)malloc(sizeof(EntradaSimbolo));
-    nova->nome = strdup(nome);
+    if (2 * (t->num_simbolos + 1) > t->num_baldes) {
+        crescer_indice(t);
+    }
+    if (t->num_simbolos == t->capacidade_simbolos) {
+        t->capacidade_simbolos *= 2;
+        t->simbolos = (EntradaSimbolo *)realloc(t->simbolos,
+                                                t->capacidade_simbolos * sizeof(EntradaSimbolo));
+    }
+    
+    /* Nova entrada no fim do vetor (ordem de declaração) */
+    EntradaSimbolo *nova = &t->simbolos[t->num_simbolos];
+    nova->chave = chave;
     nova->tipo = tipo;
     nova->tamanho_array = tamanho;
     nova->linha_declaracao = linha;
     nova->inicializada = 0;
+    nova->slot = t->tamanho_quadro;
+    t->tamanho_quadro += tamanho > 0 ? tamanho : 1;
     
-    /* Insere na tabela */
-    unsigned int h = hash(nome);
-    nova->prox = tabela.entradas[h];
-    tabela.entradas[h] = nova;
-    tabela.num_simbolos++;
+    indexar(t, t->num_simbolos++);
     
     return 1;
 }
 
-EntradaSimbolo *buscar_simbolo(const char *nome) {
-    unsigned int h = hash(nome);
-    EntradaSimbolo *atual = tabela.entradas[h];
+EntradaSimbolo *reservar_simbolos(ContextoCompilacao *ctx, int n) {
+    TabelaSimbolos *t = &ctx->tabela;
     
-    while (atual != NULL) {
-        if (strcmp(atual->nome, nome) == 0) {
-            return atual;
+    if (t->num_simbolos + n <= t->capacidade_simbolos) {
+        return NULL;
+    }
+    
+    /* Novo vetor, sem liberar o anterior: o chamador ainda religa os ponteiros */
+    EntradaSimbolo *anterior = t->simbolos;
+    while (t->capacidade_simbolos < t->num_simbolos + n) {
+        t->capacidade_simbolos *= 2;
+    }
+    t->simbolos = (EntradaSimbolo *)malloc(t->capacidade_simbolos * sizeof(EntradaSimbolo));
+    memcpy(t->simbolos, anterior, (size_t)t->num_simbolos * sizeof(EntradaSimbolo));
+    return anterior;
+}
+
+static void religar_var(NoVar *var, const EntradaSimbolo *anterior, EntradaSimbolo *simbolos) {
+    if (var->simbolo != NULL) {
+        var->simbolo = simbolos + (var->simbolo - anterior);
+    }
+}
+
+static void religar_expressao(NoExpr *raiz, const EntradaSimbolo *anterior, EntradaSimbolo *simbolos,
+                              Pilha *pilha) {
+    NoExpr **topo;
+    
+    if (raiz == NULL) return;
+    
+    *(NoExpr **)pilha_empilhar(pilha) = raiz;
+    while ((topo = (NoExpr **)pilha_topo(pilha)) != NULL) {
+        NoExpr *expr = *topo;
+        pilha_desempilhar(pilha);
+        
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                religar_var(expr->dado.var, anterior, simbolos);
+                if (expr->dado.var->indice != NULL) {
+                    *(NoExpr **)pilha_empilhar(pilha) = expr->dado.var->indice;
+                }
+                break;
+            case EXPR_ARITMETICA:
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.aritmetica.esq;
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.aritmetica.dir;
+                break;
+            case EXPR_RELACIONAL:
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.relacional.esq;
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.relacional.dir;
+                break;
+            case EXPR_LOGICA:
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.logica.esq;
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.logica.dir;
+                break;
+            case EXPR_NAO:
+            case EXPR_NEG:
+                *(NoExpr **)pilha_empilhar(pilha) = expr->dado.negacao;
+                break;
+            default:
+                break;
         }
-        atual = atual->prox;
     }
+}
+
+static void religar_alvo(NoVar *var, const EntradaSimbolo *anterior, EntradaSimbolo *simbolos,
+                         Pilha *pilha) {
+    religar_var(var, anterior, simbolos);
+    religar_expressao(var->indice, anterior, simbolos, pilha);
+}
+
+void religar_simbolos(ContextoCompilacao *ctx, NoCmd *algoritmo, const EntradaSimbolo *anterior) {
+    EntradaSimbolo *simbolos = ctx->tabela.simbolos;
+    PercursoComandos percurso;
+    NoCmd *cmd;
+    Pilha pilha;
     
-    return NULL;
+    pilha_iniciar(&pilha, sizeof(NoExpr *));
+    iniciar_percurso(&percurso, algoritmo);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                religar_alvo(cmd->dado.atrib.var, anterior, simbolos, &pilha);
+                religar_expressao(cmd->dado.atrib.expr, anterior, simbolos, &pilha);
+                break;
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    religar_alvo(v->var, anterior, simbolos, &pilha);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        religar_expressao(item->item.expr, anterior, simbolos, &pilha);
+                    }
+                }
+                break;
+            case CMD_SE:
+                religar_expressao(cmd->dado.se.condicao, anterior, simbolos, &pilha);
+                break;
+            case CMD_ENQUANTO:
+                religar_expressao(cmd->dado.enquanto.condicao, anterior, simbolos, &pilha);
+                break;
+        }
+    }
+    terminar_percurso(&percurso);
+    pilha_liberar(&pilha);
+}
+
+void restaurar_tabela(ContextoCompilacao *ctx, const EntradaSimbolo *entradas, int n) {
+    TabelaSimbolos *t = &ctx->tabela;
+    
+    inicializar_tabela(ctx, n);
+    memcpy(t->simbolos, entradas, (size_t)n * sizeof(EntradaSimbolo));
+    t->num_simbolos = n;
+    for (int i = 0; i < n; i++) {
+        int fim = entradas[i].slot + (entradas[i].tamanho_array > 0 ? entradas[i].tamanho_array : 1);
+        if (fim > t->tamanho_quadro) {
+            t->tamanho_quadro = fim;
+        }
+        indexar(t, i);
+    }
+}
+
+EntradaSimbolo *buscar_simbolo(ContextoCompilacao *ctx, ChaveId chave) {
+    TabelaSimbolos *t = &ctx->tabela;
+    unsigned int h = hash(chave, t);
+    EntradaSimbolo *achado = NULL;
+    int sondagens = 1;
+    
+    ctx->buscas_tabela++;
+    while (t->baldes[h].indice >= 0) {
+        if (t->baldes[h].chave == chave) {
+            achado = &t->simbolos[t->baldes[h].indice];
+            break;
+        }
+        h = (h + 1) & (unsigned int)(t->num_baldes - 1);
+        sondagens++;
+    }
+    
+    ctx->sondagens_tabela += sondagens;
+    if (sondagens > ctx->maior_sondagem_busca) {
+        ctx->maior_sondagem_busca = sondagens;
+    }
+    return achado;
 }
 
-void marcar_inicializado(const char *nome) {
-    EntradaSimbolo *s = buscar_simbolo(nome);
+void marcar_inicializado(EntradaSimbolo *s) {
     if (s != NULL) {
         s->inicializada = 1;
     }
 }
 
-void imprimir_tabela_simbolos(void) {
-    printf("\n=== TABELA DE SIMBOLOS ===\n");
-    printf("%-15s %-12s %-10s %-8s\n", "Nome", "Tipo", "Tamanho", "Linha");
-    printf("----------------------------------------------\n");
+void imprimir_tabela_simbolos(ContextoCompilacao *ctx, FILE *saida) {
+    char nome[ID_MAX_CHARS + 1];
     
-    for (int i = 0; i < TAB_SIMBOLOS_TAM; i++) {
-        EntradaSimbolo *atual = tabela.entradas[i];
-        while (atual != NULL) {
-            const char *tipo_str;
-            switch (atual->tipo) {
-                case TIPO_INTEIRO: tipo_str = "INTEIRO"; break;
-                case TIPO_REAL: tipo_str = "REAL"; break;
-                case TIPO_LISTAINT: tipo_str = "LISTAINT"; break;
-                case TIPO_LISTAREAL: tipo_str = "LISTAREAL"; break;
-                default: tipo_str = "???"; break;
-            }
-            
-            printf("%-15s %-12s %-10d %-8d\n", 
-                   atual->nome, 
-                   tipo_str,
-                   atual->tamanho_array,
-                   atual->linha_declaracao);
-            atual = atual->prox;
+    fprintf(saida, "\n=== TABELA DE SIMBOLOS ===\n");
+    fprintf(saida, "%-15s %-12s %-10s %-8s\n", "Nome", "Tipo", "Tamanho", "Linha");
+    fprintf(saida, "----------------------------------------------\n");
+    
+    for (int i = 0; i < ctx->tabela.num_simbolos; i++) {
+        EntradaSimbolo *atual = &ctx->tabela.simbolos[i];
+        const char *tipo_str;
+        switch (atual->tipo) {
+            case TIPO_INTEIRO: tipo_str = "INTEIRO"; break;
+            case TIPO_REAL: tipo_str = "REAL"; break;
+            case TIPO_LISTAINT: tipo_str = "LISTAINT"; break;
+            case TIPO_LISTAREAL: tipo_str = "LISTAREAL"; break;
+            default: tipo_str = "???"; break;
         }
+        
+        fprintf(saida, "%-15s %-12s %-10d %-8d\n", 
+               texto_id(atual->chave, nome), 
+               tipo_str,
+               atual->tamanho_array,
+               atual->linha_declaracao);
     }
-    printf("==========================\n\n");
+    fprintf(saida, "==========================\n\n");
 }
 
-void liberar_tabela_simbolos(void) {
-    for (int i = 0; i < TAB_SIMBOLOS_TAM; i++) {
-        EntradaSimbolo *atual = tabela.entradas[i];
-        while (atual != NULL) {
-            EntradaSimbolo *prox = atual->prox;
-            free(atual->nome);
-            free(atual);
-            atual = prox;
+void ocupacao_tabela(ContextoCompilacao *ctx, OcupacaoTabela *o) {
+    TabelaSimbolos *t = &ctx->tabela;
+    long total = 0;
+    
+    memset(o, 0, sizeof(*o));
+    o->simbolos = t->num_simbolos;
+    o->baldes = t->num_baldes;
+    if (t->num_baldes == 0) {
+        return;
+    }
+    
+    /* Sondagens de uma busca bem-sucedida: distância ao balde de origem + 1 */
+    for (int i = 0; i < t->num_baldes; i++) {
+        if (t->baldes[i].indice < 0) continue;
+        unsigned int origem = hash(t->baldes[i].chave, t);
+        int sondagens = (int)(((unsigned int)i - origem) & (unsigned int)(t->num_baldes - 1)) + 1;
+        total += sondagens;
+        if (sondagens > o->maior_sondagem) {
+            o->maior_sondagem = sondagens;
         }
-        tabela.entradas[i] = NULL;
     }
-    tabela.num_simbolos = 0;
+    o->fator_carga = (double)t->num_simbolos / t->num_baldes;
+    o->sondagem_media = t->num_simbolos > 0 ? (double)total / t->num_simbolos : 0.0;
+    o->bytes = (size_t)t->capacidade_simbolos * sizeof(EntradaSimbolo)
+             + (size_t)t->num_baldes * sizeof(BaldeSimbolo);
+}
+
+void liberar_tabela_simbolos(ContextoCompilacao *ctx) {
+    free(ctx->tabela.simbolos);
+    free(ctx->tabela.baldes);
+    memset(&ctx->tabela, 0, sizeof(ctx->tabela));
 }
 
 /* ========== Mensagens de Erro ========== */
 
-void erro_semantico(int linha, const char *formato, ...) {
+void erro_semantico(ContextoCompilacao *ctx, int linha, int coluna, const char *codigo,
+                    const char *formato, ...) {
     va_list args;
-    fprintf(stderr, "ERRO SEMANTICO na linha %d: ", linha);
     va_start(args, formato);
-    vfprintf(stderr, formato, args);
+    vdiagnosticar(ctx, SEVERIDADE_ERRO, ORIGEM_SEMANTICA, codigo, linha, coluna, formato, args);
     va_end(args);
-    fprintf(stderr, "\n");
-    erros_semanticos++;
+    ctx->erros_semanticos++;
 }
 
-void aviso_semantico(int linha, const char *formato, ...) {
+void aviso_semantico(ContextoCompilacao *ctx, int linha, int coluna, const char *codigo,
+                     const char *formato, ...) {
     va_list args;
-    fprintf(stderr, "AVISO na linha %d: ", linha);
+    ctx->avisos++;
     va_start(args, formato);
-    vfprintf(stderr, formato, args);
+    vdiagnosticar(ctx, SEVERIDADE_AVISO, ORIGEM_SEMANTICA, codigo, linha, coluna, formato, args);
     va_end(args);
-    fprintf(stderr, "\n");
 }
 
 /* ========== Verificação de Tipos ========== */
@@ -170,32 +373,34 @@ TipoDado tipo_resultante(TipoDado t1, TipoDado t2) {
 
 /* ========== Análise de Declarações ========== */
 
-int analisar_declaracoes(NoDecl *decl) {
+int analisar_declaracoes(ContextoCompilacao *ctx, NoDecl *decl) {
     int ok = 1;
+    char nome[ID_MAX_CHARS + 1];
     
     while (decl != NULL) {
-        /* Verifica o nome da variável */
-        if (strlen(decl->nome) > 8) {
-            erro_semantico(decl->linha, "Nome de variavel '%s' excede 8 caracteres", decl->nome);
-            ok = 0;
-        }
+        ctx->declaracoes_analisadas++;
+        
+        /* O limite de 8 caracteres do nome já é garantido pela ChaveId */
         
         /* Verifica tamanho do array */
         if (decl->tamanho_array > 0) {
             if (decl->tamanho_array < 10 || decl->tamanho_array > 40) {
-                erro_semantico(decl->linha, "Tamanho do array '%s' deve ser entre 10 e 40", decl->nome);
+                erro_semantico(ctx, decl->linha, decl->coluna, "SEM002", "Tamanho do array '%s' deve ser entre 10 e 40",
+                               texto_id(decl->chave, nome));
                 ok = 0;
             }
             
             /* Verifica se o tipo é compatível com array */
             if (decl->tipo != TIPO_LISTAINT && decl->tipo != TIPO_LISTAREAL) {
-                erro_semantico(decl->linha, "Tipo '%s' nao pode ser usado para arrays", decl->nome);
+                erro_semantico(ctx, decl->linha, decl->coluna, "SEM003", "Tipo '%s' nao pode ser usado para arrays",
+                               texto_id(decl->chave, nome));
                 ok = 0;
             }
         }
         
         /* Insere na tabela de símbolos */
-        if (!inserir_simbolo(decl->nome, decl->tipo, decl->tamanho_array, decl->linha)) {
+        if (!inserir_simbolo(ctx, decl->chave, decl->tipo, decl->tamanho_array,
+                             decl->linha, decl->coluna)) {
             ok = 0;
         }
         
@@ -207,156 +412,256 @@ int analisar_declaracoes(NoDecl *decl) {
 
 /* ========== Análise de Variáveis ========== */
 
-int verificar_variavel(NoVar *var) {
-    EntradaSimbolo *s = buscar_simbolo(var->nome);
+/* Resultado da primeira metade da verificação de uma variável */
+enum { VAR_ERRO, VAR_OK, VAR_INDICE };
+
+/*
+ * Busca a variável, liga NoVar->simbolo e confere o uso com ou sem
+ * índice. Com VAR_INDICE, falta analisar o índice e conferir seu tipo
+ * (concluir_variavel).
+ */
+static int iniciar_variavel(ContextoCompilacao *ctx, NoVar *var) {
+    char nome[ID_MAX_CHARS + 1];
+    EntradaSimbolo *s = buscar_simbolo(ctx, var->chave);
     
+    ctx->referencias_variaveis++;
     if (s == NULL) {
-        erro_semantico(var->linha, "Variavel '%s' nao foi declarada", var->nome);
-        return 0;
+        erro_semantico(ctx, var->linha, var->coluna, "SEM004", "Variavel '%s' nao foi declarada", texto_id(var->chave, nome));
+        return VAR_ERRO;
     }
     
-    /* Verifica uso de índice */
+    /* Liga a referência ao símbolo: nenhuma outra busca por nome */
+    var->simbolo = s;
+    
     if (var->indice != NULL) {
         /* Usando como array */
         if (s->tamanho_array == 0) {
-            erro_semantico(var->linha, "Variavel '%s' nao e um array", var->nome);
-            return 0;
-        }
-        
-        /* Verifica tipo do índice */
-        TipoDado tipo_indice = analisar_expressao(var->indice);
-        if (tipo_indice != TIPO_INTEIRO) {
-            erro_semantico(var->linha, "Indice do array '%s' deve ser inteiro", var->nome);
-            return 0;
-        }
-    } else {
-        /* Usando como variável simples */
-        if (s->tamanho_array > 0) {
-            erro_semantico(var->linha, "Array '%s' requer indice", var->nome);
-            return 0;
+            erro_semantico(ctx, var->linha, var->coluna, "SEM005", "Variavel '%s' nao e um array", texto_id(var->chave, nome));
+            return VAR_ERRO;
         }
+        return VAR_INDICE;
     }
     
+    /* Usando como variável simples */
+    if (s->tamanho_array > 0) {
+        erro_semantico(ctx, var->linha, var->coluna, "SEM006", "Array '%s' requer indice", texto_id(var->chave, nome));
+        return VAR_ERRO;
+    }
+    return VAR_OK;
+}
+
+/* Confere o tipo do índice, já analisado */
+static int concluir_variavel(ContextoCompilacao *ctx, NoVar *var) {
+    char nome[ID_MAX_CHARS + 1];
+    
+    if (var->indice->tipo_dado != TIPO_INTEIRO) {
+        erro_semantico(ctx, var->linha, var->coluna, "SEM007", "Indice do array '%s' deve ser inteiro", texto_id(var->chave, nome));
+        return 0;
+    }
     return 1;
 }
 
+int verificar_variavel(ContextoCompilacao *ctx, NoVar *var) {
+    int r = iniciar_variavel(ctx, var);
+    
+    if (r == VAR_INDICE) {
+        analisar_expressao(ctx, var->indice);
+        return concluir_variavel(ctx, var);
+    }
+    return r == VAR_OK;
+}
+
 /* ========== Análise de Expressões ========== */
 
-TipoDado analisar_expressao(NoExpr *expr) {
-    if (expr == NULL) return TIPO_INDEFINIDO;
-    
+/*
+ * A análise é feita em pós-ordem com uma pilha explícita (pilha.h), e
+ * não por recursão: uma expressão gerada com milhões de operandos
+ * encadeados estouraria a pilha de chamadas.
+ */
+
+/* Quadro da pilha: o nó e em que ponto da sua análise ele está */
+typedef struct {
+    NoExpr *expr;
+    int operandos_empilhados;
+    int variavel;           /* VAR_ERRO, VAR_OK ou VAR_INDICE */
+} QuadroExpr;
+
+static void empilhar_expr(Pilha *pilha, NoExpr *expr) {
+    if (expr != NULL) {
+        QuadroExpr *q = (QuadroExpr *)pilha_empilhar(pilha);
+        q->expr = expr;
+        q->operandos_empilhados = 0;
+        q->variavel = VAR_OK;
+    }
+}
+
+static TipoDado tipo_de(NoExpr *expr) {
+    return expr != NULL ? expr->tipo_dado : TIPO_INDEFINIDO;
+}
+
+/* Define o tipo de 'expr', cujos operandos já foram analisados */
+static void concluir_expressao(ContextoCompilacao *ctx, NoExpr *expr, int variavel) {
     switch (expr->tipo) {
         case EXPR_CONST_INT:
             expr->tipo_dado = TIPO_INTEIRO;
-            return TIPO_INTEIRO;
+            break;
             
         case EXPR_CONST_REAL:
             expr->tipo_dado = TIPO_REAL;
-            return TIPO_REAL;
+            break;
             
         case EXPR_VAR:
         case EXPR_VAR_ARRAY:
             {
-                if (!verificar_variavel(expr->dado.var)) {
+                if (variavel == VAR_INDICE) {
+                    variavel = concluir_variavel(ctx, expr->dado.var) ? VAR_OK : VAR_ERRO;
+                }
+                if (variavel == VAR_ERRO) {
                     expr->tipo_dado = TIPO_INDEFINIDO;
-                    return TIPO_INDEFINIDO;
+                    break;
                 }
                 
-                EntradaSimbolo *s = buscar_simbolo(expr->dado.var->nome);
-                if (s != NULL) {
-                    /* Para arrays, o tipo do elemento */
-                    if (s->tipo == TIPO_LISTAINT) {
-                        expr->tipo_dado = TIPO_INTEIRO;
-                        return TIPO_INTEIRO;
-                    } else if (s->tipo == TIPO_LISTAREAL) {
-                        expr->tipo_dado = TIPO_REAL;
-                        return TIPO_REAL;
-                    }
+                /* Para arrays, o tipo do elemento */
+                EntradaSimbolo *s = expr->dado.var->simbolo;
+                if (s->tipo == TIPO_LISTAINT) {
+                    expr->tipo_dado = TIPO_INTEIRO;
+                } else if (s->tipo == TIPO_LISTAREAL) {
+                    expr->tipo_dado = TIPO_REAL;
+                } else {
                     expr->tipo_dado = s->tipo;
-                    return s->tipo;
                 }
-                return TIPO_INDEFINIDO;
             }
+            break;
             
         case EXPR_ARITMETICA:
             {
-                TipoDado t1 = analisar_expressao(expr->dado.aritmetica.esq);
-                TipoDado t2 = analisar_expressao(expr->dado.aritmetica.dir);
+                TipoDado t1 = tipo_de(expr->dado.aritmetica.esq);
+                TipoDado t2 = tipo_de(expr->dado.aritmetica.dir);
                 
                 if (!tipos_compativeis(t1, t2)) {
-                    erro_semantico(expr->linha, "Tipos incompativeis em operacao aritmetica");
+                    erro_semantico(ctx, expr->linha, expr->coluna, "SEM008", "Tipos incompativeis em operacao aritmetica");
                     expr->tipo_dado = TIPO_INDEFINIDO;
-                    return TIPO_INDEFINIDO;
+                    break;
                 }
                 
                 /* Verifica divisão por zero (constantes) */
                 if (expr->dado.aritmetica.op == ARIT_DIV) {
                     NoExpr *dir = expr->dado.aritmetica.dir;
                     if (dir->tipo == EXPR_CONST_INT && dir->dado.const_int == 0) {
-                        aviso_semantico(expr->linha, "Possivel divisao por zero");
+                        aviso_semantico(ctx, expr->linha, expr->coluna, "AVI001", "Possivel divisao por zero");
                     }
                     if (dir->tipo == EXPR_CONST_REAL && dir->dado.const_real == 0.0) {
-                        aviso_semantico(expr->linha, "Possivel divisao por zero");
+                        aviso_semantico(ctx, expr->linha, expr->coluna, "AVI001", "Possivel divisao por zero");
                     }
                 }
                 
                 expr->tipo_dado = tipo_resultante(t1, t2);
-                return expr->tipo_dado;
             }
+            break;
             
         case EXPR_RELACIONAL:
-            {
-                TipoDado t1 = analisar_expressao(expr->dado.relacional.esq);
-                TipoDado t2 = analisar_expressao(expr->dado.relacional.dir);
-                
-                if (!tipos_compativeis(t1, t2)) {
-                    erro_semantico(expr->linha, "Tipos incompativeis em comparacao");
-                }
-                
-                expr->tipo_dado = TIPO_INTEIRO;  /* Booleano representado como inteiro */
-                return TIPO_INTEIRO;
+            if (!tipos_compativeis(tipo_de(expr->dado.relacional.esq),
+                                   tipo_de(expr->dado.relacional.dir))) {
+                erro_semantico(ctx, expr->linha, expr->coluna, "SEM009", "Tipos incompativeis em comparacao");
             }
+            expr->tipo_dado = TIPO_INTEIRO;  /* Booleano representado como inteiro */
+            break;
             
         case EXPR_LOGICA:
-            {
-                /* Analisa operandos lógicos */
-                analisar_expressao(expr->dado.logica.esq);
-                analisar_expressao(expr->dado.logica.dir);
-                
-                /* Operandos lógicos devem ser "booleanos" (resultado de expressões relacionais) */
-                /* Por simplificação, aceitamos inteiros */
-                
-                expr->tipo_dado = TIPO_INTEIRO;
-                return TIPO_INTEIRO;
-            }
+            /* Operandos lógicos devem ser "booleanos" (resultado de expressões relacionais) */
+            /* Por simplificação, aceitamos inteiros */
+            expr->tipo_dado = TIPO_INTEIRO;
+            break;
             
         case EXPR_NAO:
-            {
-                analisar_expressao(expr->dado.negacao);
-                expr->tipo_dado = TIPO_INTEIRO;
-                return TIPO_INTEIRO;
-            }
+            expr->tipo_dado = TIPO_INTEIRO;
+            break;
+            
+        case EXPR_NEG:
+            expr->tipo_dado = tipo_de(expr->dado.negacao);
+            break;
+    }
+}
+
+TipoDado analisar_expressao(ContextoCompilacao *ctx, NoExpr *raiz) {
+    Pilha pilha;
+    QuadroExpr *q;
+    
+    if (raiz == NULL) return TIPO_INDEFINIDO;
+    
+    pilha_iniciar(&pilha, sizeof(QuadroExpr));
+    empilhar_expr(&pilha, raiz);
+    
+    while ((q = (QuadroExpr *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = q->expr;
+        
+        if (q->operandos_empilhados) {
+            int variavel = q->variavel;
+            pilha_desempilhar(&pilha);
+            concluir_expressao(ctx, expr, variavel);
+            continue;
+        }
+        
+        /* Operandos empilhados da direita para a esquerda: o esquerdo sai primeiro */
+        q->operandos_empilhados = 1;
+        switch (expr->tipo) {
+            case EXPR_VAR:
+            case EXPR_VAR_ARRAY:
+                q->variavel = iniciar_variavel(ctx, expr->dado.var);
+                if (q->variavel == VAR_INDICE) {
+                    empilhar_expr(&pilha, expr->dado.var->indice);
+                }
+                break;
+                
+            case EXPR_ARITMETICA:
+                empilhar_expr(&pilha, expr->dado.aritmetica.dir);
+                empilhar_expr(&pilha, expr->dado.aritmetica.esq);
+                break;
+                
+            case EXPR_RELACIONAL:
+                empilhar_expr(&pilha, expr->dado.relacional.dir);
+                empilhar_expr(&pilha, expr->dado.relacional.esq);
+                break;
+                
+            case EXPR_LOGICA:
+                empilhar_expr(&pilha, expr->dado.logica.dir);
+                empilhar_expr(&pilha, expr->dado.logica.esq);
+                break;
+                
+            case EXPR_NAO:
+            case EXPR_NEG:
+                empilhar_expr(&pilha, expr->dado.negacao);
+                break;
+                
+            default:
+                break;
+        }
     }
     
-    return TIPO_INDEFINIDO;
+    pilha_liberar(&pilha);
+    return raiz->tipo_dado;
 }
 
 /* ========== Análise de Comandos ========== */
 
-int analisar_comandos(NoCmd *cmd) {
+/* Os blocos de SE e ENQUANTO são visitados pelo percurso, sem recursão */
+int analisar_comandos(ContextoCompilacao *ctx, NoCmd *cmd) {
+    PercursoComandos percurso;
     int ok = 1;
     
-    while (cmd != NULL) {
+    iniciar_percurso(&percurso, cmd);
+    
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
         switch (cmd->tipo) {
             case CMD_ATRIB:
                 {
                     /* Verifica a variável destino */
-                    if (!verificar_variavel(cmd->dado.atrib.var)) {
+                    if (!verificar_variavel(ctx, cmd->dado.atrib.var)) {
                         ok = 0;
                     } else {
                         /* Verifica tipos */
-                        EntradaSimbolo *s = buscar_simbolo(cmd->dado.atrib.var->nome);
-                        TipoDado tipo_expr = analisar_expressao(cmd->dado.atrib.expr);
+                        EntradaSimbolo *s = cmd->dado.atrib.var->simbolo;
+                        TipoDado tipo_expr = analisar_expressao(ctx, cmd->dado.atrib.expr);
                         
                         if (s != NULL) {
                             TipoDado tipo_var = s->tipo;
@@ -365,14 +670,15 @@ int analisar_comandos(NoCmd *cmd) {
                             if (tipo_var == TIPO_LISTAREAL) tipo_var = TIPO_REAL;
                             
                             if (!tipos_compativeis(tipo_var, tipo_expr)) {
-                                erro_semantico(cmd->linha, 
+                                char nome[ID_MAX_CHARS + 1];
+                                erro_semantico(ctx, cmd->linha, cmd->coluna, "SEM010",
                                     "Tipo incompativel na atribuicao a '%s'", 
-                                    cmd->dado.atrib.var->nome);
+                                    texto_id(cmd->dado.atrib.var->chave, nome));
                                 ok = 0;
                             }
                             
                             /* Marca como inicializada */
-                            marcar_inicializado(cmd->dado.atrib.var->nome);
+                            marcar_inicializado(s);
                         }
                     }
                 }
@@ -382,10 +688,10 @@ int analisar_comandos(NoCmd *cmd) {
                 {
                     ListaVar *v = cmd->dado.leia;
                     while (v != NULL) {
-                        if (!verificar_variavel(v->var)) {
+                        if (!verificar_variavel(ctx, v->var)) {
                             ok = 0;
                         } else {
-                            marcar_inicializado(v->var->nome);
+                            marcar_inicializado(v->var->simbolo);
                         }
                         v = v->prox;
                     }
@@ -397,7 +703,7 @@ int analisar_comandos(NoCmd *cmd) {
                     ListaEscreva *e = cmd->dado.escreva;
                     while (e != NULL) {
                         if (!e->is_cadeia) {
-                            analisar_expressao(e->item.expr);
+                            analisar_expressao(ctx, e->item.expr);
                         }
                         e = e->prox;
                     }
@@ -405,79 +711,76 @@ int analisar_comandos(NoCmd *cmd) {
                 break;
                 
             case CMD_SE:
-                {
-                    /* Analisa condição */
-                    analisar_expressao(cmd->dado.se.condicao);
-                    
-                    /* Analisa blocos */
-                    if (!analisar_comandos(cmd->dado.se.entao)) {
-                        ok = 0;
-                    }
-                    if (cmd->dado.se.senao != NULL) {
-                        if (!analisar_comandos(cmd->dado.se.senao)) {
-                            ok = 0;
-                        }
-                    }
-                }
+                analisar_expressao(ctx, cmd->dado.se.condicao);
                 break;
                 
             case CMD_ENQUANTO:
-                {
-                    /* Analisa condição */
-                    analisar_expressao(cmd->dado.enquanto.condicao);
-                    
-                    /* Analisa corpo */
-                    if (!analisar_comandos(cmd->dado.enquanto.corpo)) {
-                        ok = 0;
-                    }
-                }
-                break;
-                
-            case CMD_BLOCO:
-                if (!analisar_comandos(cmd->dado.bloco.cmd)) {
-                    ok = 0;
-                }
+                analisar_expressao(ctx, cmd->dado.enquanto.condicao);
                 break;
         }
-        
-        cmd = cmd->prox;
     }
     
+    terminar_percurso(&percurso);
     return ok;
 }
 
 /* ========== Análise Principal ========== */
 
-int analisar_semantica(NoPrograma *prog) {
+int analisar_semantica(ContextoCompilacao *ctx, NoPrograma *prog) {
     if (prog == NULL) {
-        fprintf(stderr, "Programa vazio!\n");
+        diagnosticar(ctx, SEVERIDADE_ERRO, ORIGEM_COMPILADOR, "CMP003", 0, 0, "programa vazio");
         return 0;
     }
     
-    printf("\n>>> Iniciando analise semantica...\n");
+    if (ctx->relatorio) {
+        printf("\n>>> Iniciando analise semantica...\n");
+    }
     
-    /* Inicializa tabela de símbolos */
-    inicializar_tabela();
+    /* Inicializa tabela de símbolos (uma entrada por declaração) */
+    int declaracoes = 0;
+    for (NoDecl *d = prog->declaracoes; d != NULL; d = d->prox) {
+        declaracoes++;
+    }
+    inicializar_tabela(ctx, declaracoes);
     
     /* Analisa declarações */
-    if (!analisar_declaracoes(prog->declaracoes)) {
+    if (!analisar_declaracoes(ctx, prog->declaracoes)) {
         /* Continua mesmo com erros nas declarações */
     }
     
     /* Analisa algoritmo */
-    if (!analisar_comandos(prog->algoritmo)) {
+    if (!analisar_comandos(ctx, prog->algoritmo)) {
         /* Continua mesmo com erros nos comandos */
     }
     
+    /* Leituras sem inicialização, pelos caminhos de SE/ENQUANTO */
+    if (ctx->erros_semanticos == 0) {
+        verificar_inicializacao(ctx, prog);
+    }
+    
+    /* Índices de listas provados dentro ou fora dos limites */
+    if (ctx->erros_semanticos == 0) {
+        verificar_limites(ctx, prog);
+    }
+    
+    /* Layout do quadro de variáveis usado pelos executores */
+    prog->tamanho_quadro = ctx->tabela.tamanho_quadro;
+    
     /* Imprime tabela de símbolos */
-    imprimir_tabela_simbolos();
+    if (ctx->mostrar_tabela) {
+        imprimir_tabela_simbolos(ctx, stdout);
+    }
     
     /* Retorna sucesso se não houve erros */
-    if (erros_semanticos == 0) {
-        printf(">>> Analise semantica concluida com sucesso!\n");
+    if (ctx->erros_semanticos == 0) {
+        if (ctx->relatorio) {
+            printf(">>> Analise semantica concluida com sucesso!\n");
+        }
         return 1;
     } else {
-        printf(">>> Analise semantica encontrou %d erro(s).\n", erros_semanticos);
+        if (ctx->relatorio) {
+            printf(">>> Analise semantica encontrou %d erro(s).\n", ctx->erros_semanticos);
+        }
         return 0;
     }
 }
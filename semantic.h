@@ -10,63 +10,127 @@
 
 /* ========== Tabela de Símbolos ========== */
 
-#define TAB_SIMBOLOS_TAM 256
+/*
+ * Endereçamento aberto com sondagem linear. As entradas ficam contíguas,
+ * na ordem de declaração, em 'simbolos'; o índice de hash guarda a chave
+ * junto com a posição da entrada, de modo que uma sondagem só toca o
+ * vetor de baldes. A capacidade do índice é potência de 2 e dobra quando
+ * a carga passaria de 1/2.
+ */
+#define TAB_SIMBOLOS_INICIAL 16
 
 /* Entrada na tabela de símbolos */
 typedef struct EntradaSimbolo {
-    char *nome;
+    ChaveId chave;
     TipoDado tipo;
     int tamanho_array;      /* 0 para variáveis simples */
     int linha_declaracao;
     int inicializada;       /* Flag para verificar se foi inicializada */
-    struct EntradaSimbolo *prox;  /* Para tratamento de colisões */
+    int slot;               /* Posição no quadro de variáveis (arrays ocupam
+                               tamanho_array posições consecutivas) */
 } EntradaSimbolo;
 
+/* Balde do índice: posição em 'simbolos' (-1 = vazio) e a chave */
+typedef struct BaldeSimbolo {
+    ChaveId chave;
+    int indice;
+} BaldeSimbolo;
+
 /* Tabela de símbolos */
 typedef struct TabelaSimbolos {
-    EntradaSimbolo *entradas[TAB_SIMBOLOS_TAM];
+    EntradaSimbolo *simbolos;   /* Em ordem de declaração */
     int num_simbolos;
+    int capacidade_simbolos;
+    BaldeSimbolo *baldes;
+    int num_baldes;             /* Potência de 2 */
+    int bits_baldes;            /* log2(num_baldes) */
+    int tamanho_quadro;         /* Total de posições alocadas em slots */
 } TabelaSimbolos;
 
+/* Ocupação da tabela (para --stats) */
+typedef struct OcupacaoTabela {
+    int simbolos;
+    int baldes;
+    double fator_carga;
+    double sondagem_media;  /* Baldes visitados para achar cada símbolo */
+    int maior_sondagem;
+    size_t bytes;           /* Entradas + índice */
+} OcupacaoTabela;
+
 /* ========== Funções da Tabela de Símbolos ========== */
 
-/* Inicializa a tabela de símbolos */
-void inicializar_tabela(void);
+/*
+ * Todas as funções recebem o contexto da compilação, dono da tabela,
+ * dos contadores e do destino das mensagens de erro (ver contexto.h).
+ */
+
+/*
+ * Inicializa a tabela com espaço para 'previstos' símbolos. Os ponteiros
+ * devolvidos por buscar_simbolo só continuam válidos enquanto o vetor de
+ * entradas não crescer; a análise reserva o número de declarações.
+ */
+void inicializar_tabela(ContextoCompilacao *ctx, int previstos);
 
 /* Insere um símbolo na tabela */
-int inserir_simbolo(const char *nome, TipoDado tipo, int tamanho, int linha);
+int inserir_simbolo(ContextoCompilacao *ctx, ChaveId chave, TipoDado tipo, int tamanho,
+                    int linha, int coluna);
 
-/* Busca um símbolo na tabela */
-EntradaSimbolo *buscar_simbolo(const char *nome);
+/* Busca um símbolo na tabela (conta buscas e sondagens em ctx) */
+EntradaSimbolo *buscar_simbolo(ContextoCompilacao *ctx, ChaveId chave);
 
 /* Marca um símbolo como inicializado */
-void marcar_inicializado(const char *nome);
+void marcar_inicializado(EntradaSimbolo *s);
 
-/* Imprime a tabela de símbolos */
-void imprimir_tabela_simbolos(void);
+/*
+ * Garante espaço para mais 'n' inserções sem mover o vetor de entradas.
+ * Se foi preciso movê-lo, retorna o vetor anterior, ainda alocado: o
+ * chamador religa os ponteiros NoVar->simbolo e o libera com free.
+ * Retorna NULL se o vetor não mudou.
+ */
+EntradaSimbolo *reservar_simbolos(ContextoCompilacao *ctx, int n);
+
+/*
+ * Aponta para o vetor atual as referências NoVar->simbolo do ALGORITMO
+ * que ainda apontam para 'anterior' (devolvido por reservar_simbolos).
+ * Variáveis sem símbolo (NULL) ficam como estão.
+ */
+void religar_simbolos(ContextoCompilacao *ctx, NoCmd *algoritmo, const EntradaSimbolo *anterior);
+
+/* Recria a tabela a partir de 'n' entradas já analisadas (cache de AST) */
+void restaurar_tabela(ContextoCompilacao *ctx, const EntradaSimbolo *entradas, int n);
+
+/* Imprime a tabela de símbolos, em ordem de declaração */
+void imprimir_tabela_simbolos(ContextoCompilacao *ctx, FILE *saida);
+
+/* Mede a carga e o comprimento das sondagens */
+void ocupacao_tabela(ContextoCompilacao *ctx, OcupacaoTabela *o);
 
 /* Libera a tabela de símbolos */
-void liberar_tabela_simbolos(void);
+void liberar_tabela_simbolos(ContextoCompilacao *ctx);
 
 /* ========== Análise Semântica ========== */
 
-/* Contador de erros semânticos */
-extern int erros_semanticos;
+/*
+ * Os erros são contados em ctx->erros_semanticos. Com ctx->relatorio
+ * igual a 0, não imprime progresso nem a tabela. Cada declaração e cada
+ * referência a variável fazem exatamente uma busca (ctx->buscas_tabela);
+ * depois disso, NoVar->simbolo é usado.
+ */
 
-/* Analisa semanticamente o programa completo */
-int analisar_semantica(NoPrograma *prog);
+/* Analisa semanticamente o programa completo (define prog->tamanho_quadro) */
+int analisar_semantica(ContextoCompilacao *ctx, NoPrograma *prog);
 
 /* Analisa as declarações */
-int analisar_declaracoes(NoDecl *decl);
+int analisar_declaracoes(ContextoCompilacao *ctx, NoDecl *decl);
 
 /* Analisa os comandos */
-int analisar_comandos(NoCmd *cmd);
+int analisar_comandos(ContextoCompilacao *ctx, NoCmd *cmd);
 
 /* Analisa uma expressão e retorna seu tipo */
-TipoDado analisar_expressao(NoExpr *expr);
+TipoDado analisar_expressao(ContextoCompilacao *ctx, NoExpr *expr);
 
-/* Verifica se uma variável foi declarada */
-int verificar_variavel(NoVar *var);
+/* Verifica se uma variável foi declarada e liga NoVar->simbolo */
+int verificar_variavel(ContextoCompilacao *ctx, NoVar *var);
 
 /* Verifica compatibilidade de tipos */
 int tipos_compativeis(TipoDado t1, TipoDado t2);
@@ -76,8 +140,11 @@ TipoDado tipo_resultante(TipoDado t1, TipoDado t2);
 
 /* ========== Mensagens de Erro ========== */
 
-void erro_semantico(int linha, const char *formato, ...);
-void aviso_semantico(int linha, const char *formato, ...);
+/* Erros e avisos com posição e código (ver diagnosticos.h) */
+void erro_semantico(ContextoCompilacao *ctx, int linha, int coluna, const char *codigo,
+                    const char *formato, ...);
+void aviso_semantico(ContextoCompilacao *ctx, int linha, int coluna, const char *codigo,
+                     const char *formato, ...);
 
 #endif /* SEMANTIC_H */
 
@@ -0,0 +1,492 @@
+/*
+ * Implementação do servidor de compilação residente e do cliente
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#define _DEFAULT_SOURCE     /* realpath */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "servidor.h"
+#include "contexto.h"
+#include "semantic.h"
+#include "otimizacao.h"
+
+/* Uma conexão parada por mais que isto é fechada (o servidor atende uma por vez) */
+#define SERVIDOR_ESPERA_S 10
+
+/* Linha de requisição: comando, opções e um caminho absoluto */
+#define TAM_CABECALHO 4200
+
+static volatile sig_atomic_t encerrar = 0;
+
+static void ao_sinal(int sinal) {
+    (void)sinal;
+    encerrar = 1;
+}
+
+/* ========== Socket ========== */
+
+void caminho_socket_padrao(char *buf, size_t tam) {
+    snprintf(buf, tam, "/tmp/x25b-%ld.sock", (long)getuid());
+}
+
+static int preparar_endereco(const char *caminho, struct sockaddr_un *end) {
+    if (strlen(caminho) >= sizeof(end->sun_path)) {
+        fprintf(stderr, "Erro: caminho do socket muito longo: '%s'\n", caminho);
+        return 0;
+    }
+    memset(end, 0, sizeof(*end));
+    end->sun_family = AF_UNIX;
+    strcpy(end->sun_path, caminho);
+    return 1;
+}
+
+static int conectar(const char *caminho) {
+    struct sockaddr_un end;
+    if (!preparar_endereco(caminho, &end)) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&end, sizeof(end)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Envia 'a' e 'b' juntos, numa só chamada quando o socket aceita tudo */
+static int enviar(int fd, const char *a, size_t na, const char *b, size_t nb) {
+    struct iovec partes[2];
+    struct msghdr msg;
+
+    partes[0].iov_base = (void *)a;
+    partes[0].iov_len = na;
+    partes[1].iov_base = (void *)b;
+    partes[1].iov_len = nb;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = partes;
+    msg.msg_iovlen = 2;
+
+    while (partes[0].iov_len + partes[1].iov_len > 0) {
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        for (int i = 0; i < 2; i++) {
+            size_t feito = (size_t)n < partes[i].iov_len ? (size_t)n : partes[i].iov_len;
+            partes[i].iov_base = (char *)partes[i].iov_base + feito;
+            partes[i].iov_len -= feito;
+            n -= (ssize_t)feito;
+        }
+    }
+    return 1;
+}
+
+/* Lê exatamente 'tam' bytes de 'entrada' para um buffer novo, com dois '\0' no fim */
+static char *ler_bytes(FILE *entrada, size_t tam) {
+    char *buf = (char *)malloc(tam + 2);
+    if (buf == NULL) return NULL;
+    if (fread(buf, 1, tam, entrada) != tam) {
+        free(buf);
+        return NULL;
+    }
+    buf[tam] = buf[tam + 1] = '\0';
+    return buf;
+}
+
+static int pedidos_de(const char *opcoes) {
+    int pedidos = 0;
+    if (strcmp(opcoes, "-") == 0) return 0;
+    for (; *opcoes; opcoes++) {
+        switch (*opcoes) {
+            case 'a': pedidos |= PEDIDO_AST; break;
+            case 't': pedidos |= PEDIDO_TABELA; break;
+            case 'j': pedidos |= PEDIDO_JSON; break;
+            default: return -1;
+        }
+    }
+    return pedidos;
+}
+
+static void opcoes_de(int pedidos, char *buf) {
+    char *p = buf;
+    if (pedidos & PEDIDO_AST) *p++ = 'a';
+    if (pedidos & PEDIDO_TABELA) *p++ = 't';
+    if (pedidos & PEDIDO_JSON) *p++ = 'j';
+    if (p == buf) *p++ = '-';
+    *p = '\0';
+}
+
+/* ========== Servidor ========== */
+
+typedef struct {
+    ContextoCompilacao ctx;     /* Reaproveitado: a arena não volta ao malloc */
+    int otimizar;
+    int verbose;
+    long requisicoes;
+    char *linha;
+    size_t capacidade_linha;
+} Servidor;
+
+/*
+ * Compila 'nome' (do disco, ou de 'fonte' se não for NULL), escrevendo em
+ * 'saida' a AST e a tabela pedidas. Os diagnósticos ficam em s->ctx.
+ */
+static int compilar(Servidor *s, const char *nome, char *fonte, size_t tamanho, int pedidos,
+                    FILE *saida) {
+    ContextoCompilacao *ctx = &s->ctx;
+    int sucesso = 0;
+
+    reiniciar_contexto(ctx, nome, (pedidos & PEDIDO_JSON) ? DESTINO_LISTA : DESTINO_MEMORIA);
+    ctx->relatorio = 0;
+    ctx->mostrar_tabela = 0;
+
+    if (fonte != NULL) {
+        usar_fonte_memoria(ctx, fonte, tamanho);
+    } else if (!abrir_fonte(ctx, nome)) {
+        diagnosticar(ctx, SEVERIDADE_ERRO, ORIGEM_COMPILADOR, "CMP001", 0, 0,
+                     "Nao foi possivel abrir o arquivo '%s'", nome);
+        return 1;
+    }
+
+    if (analisar_sintaxe(ctx)) {
+        analisar_semantica(ctx, ctx->programa);
+        sucesso = ctx->erros_semanticos == 0;
+        if (pedidos & PEDIDO_AST) {
+            imprimir_ast(ctx->programa, saida);
+        }
+        if (pedidos & PEDIDO_TABELA) {
+            imprimir_tabela_simbolos(ctx, saida);
+        }
+        /* Os avisos do dobramento de constantes também fazem parte da verificação */
+        if (sucesso && s->otimizar) {
+            otimizar_programa(ctx, ctx->programa, s->otimizar, NULL);
+        }
+    }
+    return sucesso ? 0 : 1;
+}
+
+static int responder(int fd, int estado, const char *saida, size_t tam_saida,
+                     const char *diagnosticos, size_t tam_diagnosticos) {
+    char cabecalho[96];
+    char *corpo = NULL;
+    size_t tam_corpo = 0;
+    int n = snprintf(cabecalho, sizeof(cabecalho), "X25B %d %zu %zu\n",
+                     estado, tam_saida, tam_diagnosticos);
+
+    /* Saída e diagnósticos em sequência: uma única escrita no socket */
+    if (tam_saida > 0 && tam_diagnosticos > 0) {
+        FILE *junta = open_memstream(&corpo, &tam_corpo);
+        if (junta == NULL) return 0;
+        fwrite(saida, 1, tam_saida, junta);
+        fwrite(diagnosticos, 1, tam_diagnosticos, junta);
+        fclose(junta);
+    }
+    int ok = enviar(fd, cabecalho, (size_t)n,
+                    corpo != NULL ? corpo : (tam_saida > 0 ? saida : diagnosticos),
+                    tam_saida + tam_diagnosticos);
+    free(corpo);
+    return ok;
+}
+
+static int responder_erro(int fd, const char *mensagem) {
+    char texto[256];
+    int n = snprintf(texto, sizeof(texto), "Erro: %s\n", mensagem);
+    return responder(fd, 2, NULL, 0, texto, (size_t)n);
+}
+
+/* Atende uma requisição; retorna 0 para fechar a conexão */
+static int atender(Servidor *s, FILE *entrada, int fd) {
+    ssize_t lidos = getline(&s->linha, &s->capacidade_linha, entrada);
+    if (lidos <= 0) return 0;
+    if (s->linha[lidos - 1] == '\n') s->linha[--lidos] = '\0';
+
+    char *comando = s->linha;
+    char *resto = strchr(comando, ' ');
+    if (resto != NULL) *resto++ = '\0';
+
+    if (strcmp(comando, "PARAR") == 0) {
+        encerrar = 1;
+        responder(fd, 0, NULL, 0, NULL, 0);
+        return 0;
+    }
+
+    char *opcoes = resto;
+    char *argumento = opcoes != NULL ? strchr(opcoes, ' ') : NULL;
+    if (argumento != NULL) *argumento++ = '\0';
+    int pedidos = opcoes != NULL ? pedidos_de(opcoes) : -1;
+
+    char *fonte = NULL;
+    size_t tamanho = 0;
+    const char *nome = argumento;
+    if (pedidos < 0 || argumento == NULL) {
+        responder_erro(fd, "requisicao invalida");
+        return 0;
+    } else if (strcmp(comando, "FONTE") == 0) {
+        char *fim;
+        unsigned long bytes = strtoul(argumento, &fim, 10);
+        if (fim == argumento || *fim != ' ' || bytes > SERVIDOR_MAX_FONTE) {
+            responder_erro(fd, "tamanho de fonte invalido");
+            return 0;
+        }
+        nome = fim + 1;
+        tamanho = bytes;
+        fonte = ler_bytes(entrada, tamanho);
+        if (fonte == NULL) {
+            responder_erro(fd, "fonte incompleta");
+            return 0;
+        }
+    } else if (strcmp(comando, "ARQUIVO") != 0 || strcmp(argumento, "-") == 0) {
+        responder_erro(fd, "requisicao invalida");
+        return 0;
+    }
+
+    struct timespec ini, fim;
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+
+    char *texto_saida = NULL;
+    size_t tam_saida = 0;
+    FILE *saida = open_memstream(&texto_saida, &tam_saida);
+    if (saida == NULL) {
+        free(fonte);
+        responder_erro(fd, "memoria insuficiente");
+        return 0;
+    }
+    int estado = compilar(s, nome, fonte, tamanho, pedidos, saida);
+    fclose(saida);
+
+    char *texto_json = NULL;
+    size_t tam_json = 0;
+    const char *diagnosticos;
+    size_t tam_diagnosticos;
+    if (pedidos & PEDIDO_JSON) {
+        FILE *json = open_memstream(&texto_json, &tam_json);
+        if (json != NULL) {
+            escrever_diagnosticos_json(&s->ctx, json);
+            fclose(json);
+        }
+        diagnosticos = texto_json;
+        tam_diagnosticos = tam_json;
+    } else {
+        diagnosticos = diagnosticos_contexto(&s->ctx);
+        tam_diagnosticos = strlen(diagnosticos);
+    }
+
+    int ok = responder(fd, estado, texto_saida, tam_saida, diagnosticos, tam_diagnosticos);
+    s->requisicoes++;
+
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    if (s->verbose) {
+        fprintf(stderr, ">>> %s %s: estado %d, %.3f ms\n", comando, nome, estado,
+                (fim.tv_sec - ini.tv_sec) * 1e3 + (fim.tv_nsec - ini.tv_nsec) / 1e6);
+    }
+
+    /* O contexto ainda aponta para a fonte, mas não a lê mais */
+    free(fonte);
+    free(texto_saida);
+    free(texto_json);
+    return ok;
+}
+
+int executar_servidor(const char *caminho, int otimizar, int verbose) {
+    struct sockaddr_un end;
+    if (!preparar_endereco(caminho, &end)) return 1;
+
+    /* Um arquivo que não aceita conexões é resto de um servidor que caiu */
+    int outro = conectar(caminho);
+    if (outro >= 0) {
+        close(outro);
+        fprintf(stderr, "Erro: ja existe um servidor X25b em '%s'\n", caminho);
+        return 1;
+    }
+    unlink(caminho);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&end, sizeof(end)) != 0 || listen(fd, 64) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel escutar em '%s': %s\n", caminho, strerror(errno));
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    /* Sem SA_RESTART: o sinal interrompe o accept e o laço termina */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = ao_sinal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    Servidor s;
+    memset(&s, 0, sizeof(s));
+    s.otimizar = otimizar;
+    s.verbose = verbose;
+    inicializar_contexto(&s.ctx, "", DESTINO_MEMORIA);
+
+    fprintf(stderr, ">>> Servidor X25b em %s (pid %ld)\n", caminho, (long)getpid());
+
+    while (!encerrar) {
+        int conexao = accept(fd, NULL, NULL);
+        if (conexao < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Erro: accept: %s\n", strerror(errno));
+            break;
+        }
+
+        struct timeval espera = { SERVIDOR_ESPERA_S, 0 };
+        setsockopt(conexao, SOL_SOCKET, SO_RCVTIMEO, &espera, sizeof(espera));
+
+        FILE *entrada = fdopen(conexao, "r");
+        if (entrada == NULL) {
+            close(conexao);
+            continue;
+        }
+        while (!encerrar && atender(&s, entrada, conexao)) {
+            continue;
+        }
+        fclose(entrada);
+    }
+
+    fprintf(stderr, ">>> Servidor encerrado: %ld requisicao(oes) atendida(s)\n", s.requisicoes);
+    liberar_contexto(&s.ctx);
+    free(s.linha);
+    close(fd);
+    unlink(caminho);
+    return 0;
+}
+
+/* ========== Cliente ========== */
+
+/* Lê a resposta e repassa saída e diagnósticos; retorna o estado */
+static int receber(int fd) {
+    FILE *entrada = fdopen(fd, "r");
+    char *linha = NULL;
+    size_t capacidade = 0;
+    int estado = 2;
+    size_t tam_saida, tam_diagnosticos;
+
+    if (entrada == NULL) {
+        close(fd);
+        return 2;
+    }
+    if (getline(&linha, &capacidade, entrada) > 0 &&
+        sscanf(linha, "X25B %d %zu %zu", &estado, &tam_saida, &tam_diagnosticos) == 3) {
+        char *saida = ler_bytes(entrada, tam_saida);
+        char *diagnosticos = ler_bytes(entrada, tam_diagnosticos);
+        if (saida != NULL && diagnosticos != NULL) {
+            fwrite(saida, 1, tam_saida, stdout);
+            fflush(stdout);
+            fwrite(diagnosticos, 1, tam_diagnosticos, stderr);
+        } else {
+            fprintf(stderr, "Erro: resposta incompleta do servidor X25b\n");
+            estado = 2;
+        }
+        free(saida);
+        free(diagnosticos);
+    } else {
+        fprintf(stderr, "Erro: resposta invalida do servidor X25b\n");
+        estado = 2;
+    }
+    free(linha);
+    fclose(entrada);
+    return estado;
+}
+
+/* A entrada padrão inteira, num buffer novo */
+static char *ler_entrada_padrao(size_t *tamanho) {
+    size_t capacidade = 64 * 1024;
+    char *buf = (char *)malloc(capacidade);
+    size_t n;
+
+    *tamanho = 0;
+    while (buf != NULL && (n = fread(buf + *tamanho, 1, capacidade - *tamanho, stdin)) > 0) {
+        *tamanho += n;
+        if (*tamanho == capacidade) {
+            char *maior = (char *)realloc(buf, capacidade *= 2);
+            if (maior == NULL) free(buf);
+            buf = maior;
+        }
+    }
+    return buf;
+}
+
+int executar_cliente(const char *caminho, const char *arquivo, int pedidos, int verbose) {
+    char opcoes[8];
+    char cabecalho[TAM_CABECALHO];
+    char *fonte = NULL;
+    size_t tamanho = 0;
+    int n;
+
+    opcoes_de(pedidos, opcoes);
+    if (strcmp(arquivo, "-") == 0) {
+        fonte = ler_entrada_padrao(&tamanho);
+        if (fonte == NULL || tamanho > SERVIDOR_MAX_FONTE) {
+            fprintf(stderr, "Erro: nao foi possivel ler a fonte da entrada padrao\n");
+            free(fonte);
+            return 1;
+        }
+        n = snprintf(cabecalho, sizeof(cabecalho), "FONTE %s %zu -\n", opcoes, tamanho);
+    } else {
+        /* O servidor tem o seu próprio diretório corrente */
+        char *absoluto = realpath(arquivo, NULL);
+        if (absoluto == NULL) {
+            fprintf(stderr, "Erro: Nao foi possivel abrir o arquivo '%s'\n", arquivo);
+            return 1;
+        }
+        n = snprintf(cabecalho, sizeof(cabecalho), "ARQUIVO %s %s\n", opcoes, absoluto);
+        free(absoluto);
+    }
+    if (n < 0 || (size_t)n >= sizeof(cabecalho)) {
+        fprintf(stderr, "Erro: caminho muito longo: '%s'\n", arquivo);
+        free(fonte);
+        return 1;
+    }
+
+    struct timespec ini, fim;
+    clock_gettime(CLOCK_MONOTONIC, &ini);
+
+    int fd = conectar(caminho);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: nenhum servidor X25b em '%s' (inicie com --server)\n", caminho);
+        free(fonte);
+        return 2;
+    }
+    int estado = 2;
+    if (enviar(fd, cabecalho, (size_t)n, fonte, tamanho)) {
+        estado = receber(fd);
+    } else {
+        fprintf(stderr, "Erro: falha ao enviar a requisicao: %s\n", strerror(errno));
+        close(fd);
+    }
+    free(fonte);
+
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+    if (verbose) {
+        fprintf(stderr, ">>> Resposta do servidor em %.3f ms\n",
+                (fim.tv_sec - ini.tv_sec) * 1e3 + (fim.tv_nsec - ini.tv_nsec) / 1e6);
+    }
+    return estado;
+}
+
+int parar_servidor(const char *caminho) {
+    int fd = conectar(caminho);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: nenhum servidor X25b em '%s'\n", caminho);
+        return 1;
+    }
+    if (!enviar(fd, "PARAR\n", 6, NULL, 0)) {
+        close(fd);
+        return 1;
+    }
+    return receber(fd) == 0 ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+/*
+ * Servidor de compilação residente e cliente (opções --server e --client)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+#include <stddef.h>
+
+/*
+ * Protocolo, em texto, sobre um socket Unix local. Uma conexão pode
+ * levar várias requisições, uma após a outra:
+ *
+ *   ARQUIVO <opcoes> <caminho>\n              compila o arquivo 'caminho'
+ *   FONTE <opcoes> <bytes> <nome>\n<fonte>    compila a fonte enviada
+ *   PARAR\n                                   encerra o servidor
+ *
+ * <opcoes> são letras de PEDIDO_* ("a", "t", "j"), ou "-" para nenhuma.
+ * A resposta traz a saída pedida (AST, tabela) e os diagnósticos:
+ *
+ *   X25B <estado> <bytes da saida> <bytes dos diagnosticos>\n<saida><diagnosticos>
+ *
+ * com estado 0 (sem erros), 1 (erros no programa) ou 2 (requisição
+ * inválida, explicada nos diagnósticos).
+ */
+#define PEDIDO_AST      1       /* 'a': AST, como em -a */
+#define PEDIDO_TABELA   2       /* 't': tabela de símbolos */
+#define PEDIDO_JSON     4       /* 'j': diagnósticos como em --diagnostics=json */
+
+/* Maior fonte aceita numa requisição FONTE */
+#define SERVIDOR_MAX_FONTE (64u * 1024 * 1024)
+
+/* Caminho usado sem =SOCK: /tmp/x25b-<uid>.sock */
+void caminho_socket_padrao(char *buf, size_t tam);
+
+/*
+ * Atende requisições em 'caminho' até receber PARAR, SIGINT ou SIGTERM.
+ * Um único contexto de compilação é reaproveitado entre requisições
+ * (reiniciar_contexto). Retorna 0, ou 1 se o socket não pôde ser criado.
+ */
+int executar_servidor(const char *caminho, int otimizar, int verbose);
+
+/*
+ * Envia 'arquivo' (pelo caminho absoluto; "-" envia a entrada padrão)
+ * ao servidor em 'caminho' e escreve a saída em stdout e os
+ * diagnósticos em stderr. Retorna o estado da resposta, ou 2 se o
+ * servidor não respondeu.
+ */
+int executar_cliente(const char *caminho, const char *arquivo, int pedidos, int verbose);
+
+/* Pede ao servidor em 'caminho' que encerre; retorna 0 se ele respondeu */
+int parar_servidor(const char *caminho);
+
+#endif /* SERVIDOR_H */
@@ -0,0 +1,992 @@
+/*
+ * Implementação das subexpressões comuns e do compartilhamento de nós
+ * Avaliação Parcial 2 - Compiladores
+ *
+ * A eliminação numera valores: uma leitura de variável recebe o par
+ * (símbolo, versão), e a versão do símbolo muda a cada atribuição ou
+ * LEIA dele. Duas ocorrências com o mesmo número têm então o mesmo valor,
+ * sem que uma atribuição precise procurar o que invalida. Soma e
+ * multiplicação ordenam os números dos operandos (a + b = b + a).
+ *
+ * As ocorrências disponíveis ficam num vetor indexado pelo número de
+ * valor. O que um bloco de SE registra é desfeito na saída dele; as
+ * versões não voltam, e uma atribuição num ramo invalida o valor dali em
+ * diante nos dois caminhos. No corpo de um ENQUANTO, uma barreira
+ * esconde o que foi registrado antes do laço: a volta seguinte pode ter
+ * mudado um operando depois do ponto de uso.
+ *
+ * O compartilhamento roda por último, sobre o resultado: consolida por
+ * hash os nós estruturalmente iguais, sem olhar versões.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "subexpressoes.h"
+#include "invariantes.h"
+#include "semantic.h"
+#include "contexto.h"
+
+static void *realocar(void *p, size_t tam) {
+    void *novo = realloc(p, tam > 0 ? tam : 1);
+    if (novo == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a eliminacao de subexpressoes\n");
+        exit(1);
+    }
+    return novo;
+}
+
+static uint64_t misturar(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+static unsigned int finalizar(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (unsigned int)h;
+}
+
+/* Campo do k-ésimo operando de 'expr' (na ordem de avaliação), ou NULL */
+static NoExpr **lugar_operando(NoExpr *expr, int k) {
+    switch (expr->tipo) {
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            return k == 0 && expr->dado.var->indice != NULL ? &expr->dado.var->indice : NULL;
+        case EXPR_ARITMETICA:
+            return k == 0 ? &expr->dado.aritmetica.esq : k == 1 ? &expr->dado.aritmetica.dir : NULL;
+        case EXPR_RELACIONAL:
+            return k == 0 ? &expr->dado.relacional.esq : k == 1 ? &expr->dado.relacional.dir : NULL;
+        case EXPR_LOGICA:
+            return k == 0 ? &expr->dado.logica.esq : k == 1 ? &expr->dado.logica.dir : NULL;
+        case EXPR_NAO:
+        case EXPR_NEG:
+            return k == 0 ? &expr->dado.negacao : NULL;
+        default:
+            return NULL;
+    }
+}
+
+/* ========== Números de valor ========== */
+
+typedef struct ChaveValor {
+    int tipo;
+    int tipo_dado;
+    int op;
+    int64_t a;              /* Constante, símbolo ou operando esquerdo */
+    int64_t b;              /* Versão do símbolo ou operando direito */
+    int64_t c;              /* Índice de um acesso a lista */
+} ChaveValor;
+
+/* Endereçamento aberto; o número de um valor é a sua ordem de criação */
+typedef struct TabelaValores {
+    ChaveValor *chaves;     /* Por número */
+    int num;
+    int capacidade;
+    int *baldes;            /* Número ou -1 */
+    int num_baldes;         /* Potência de 2 */
+} TabelaValores;
+
+static unsigned int hash_valor(const ChaveValor *k) {
+    uint64_t h = (uint64_t)k->tipo;
+    h = misturar(h, (uint64_t)k->tipo_dado);
+    h = misturar(h, (uint64_t)k->op);
+    h = misturar(h, (uint64_t)k->a);
+    h = misturar(h, (uint64_t)k->b);
+    h = misturar(h, (uint64_t)k->c);
+    return finalizar(h);
+}
+
+static int valores_iguais(const ChaveValor *x, const ChaveValor *y) {
+    return x->tipo == y->tipo && x->tipo_dado == y->tipo_dado && x->op == y->op &&
+           x->a == y->a && x->b == y->b && x->c == y->c;
+}
+
+static void indexar_valores(TabelaValores *t, int num_baldes) {
+    free(t->baldes);
+    t->num_baldes = num_baldes;
+    t->baldes = (int *)realocar(NULL, (size_t)num_baldes * sizeof(int));
+    memset(t->baldes, 0xff, (size_t)num_baldes * sizeof(int));
+    for (int v = 0; v < t->num; v++) {
+        unsigned int h = hash_valor(&t->chaves[v]) & (unsigned int)(num_baldes - 1);
+        while (t->baldes[h] >= 0) {
+            h = (h + 1) & (unsigned int)(num_baldes - 1);
+        }
+        t->baldes[h] = v;
+    }
+}
+
+static int numero_valor(TabelaValores *t, const ChaveValor *k) {
+    if (2 * (t->num + 1) > t->num_baldes) {
+        indexar_valores(t, t->num_baldes > 0 ? 2 * t->num_baldes : 1024);
+    }
+
+    unsigned int h = hash_valor(k) & (unsigned int)(t->num_baldes - 1);
+    while (t->baldes[h] >= 0) {
+        if (valores_iguais(&t->chaves[t->baldes[h]], k)) {
+            return t->baldes[h];
+        }
+        h = (h + 1) & (unsigned int)(t->num_baldes - 1);
+    }
+
+    if (t->num == t->capacidade) {
+        t->capacidade = t->capacidade > 0 ? 2 * t->capacidade : 512;
+        t->chaves = (ChaveValor *)realocar(t->chaves, (size_t)t->capacidade * sizeof(ChaveValor));
+    }
+    t->chaves[t->num] = *k;
+    t->baldes[h] = t->num;
+    return t->num++;
+}
+
+/* ========== Estado da eliminação ========== */
+
+/* Primeira ocorrência disponível de um valor */
+typedef struct Comum {
+    NoExpr **lugar;
+    NoCmd **lugar_comando;  /* Campo que aponta para o comando dela */
+    int cabeca;             /* 'lugar_comando' é o início de uma sequência */
+    int comando;            /* Posição do comando em pré-ordem */
+    int tamanho;            /* Nós da expressão */
+    int repeticoes;         /* Ocorrências depois da primeira */
+    int ultima;             /* Última delas em 'ocorrencias' (-1 se nenhuma) */
+} Comum;
+
+/* Ocorrência repetida de um comum, encadeada com a anterior */
+typedef struct Ocorrencia {
+    NoExpr **lugar;
+    int anterior;
+} Ocorrencia;
+
+/* _cK := expressão, antes do comando da primeira ocorrência */
+typedef struct Temporario {
+    int comum;
+    NoCmd *atrib;
+    int ocorrencias;
+} Temporario;
+
+/* Leitura de um temporário, ligada ao símbolo depois da declaração */
+typedef struct Referencia {
+    NoVar *var;
+    int temporario;
+} Referencia;
+
+/* Valor que 'disponivel' tinha antes de um registro (para desfazer) */
+typedef struct Desfazer {
+    int valor;
+    int anterior;
+} Desfazer;
+
+/* Informações de um nó, indexadas pela posição em pré-ordem na expressão */
+typedef struct InfoNo {
+    int valor;
+    int tamanho;            /* Nós da subárvore */
+    unsigned char falha;    /* A subárvore pode interromper a execução */
+    unsigned char candidata;
+} InfoNo;
+
+typedef struct EstadoComuns {
+    ContextoCompilacao *ctx;
+    TabelaValores valores;
+    int *versao;            /* Por símbolo */
+
+    int *disponivel;        /* Por número de valor: Comum registrado ou -1 */
+    int capacidade_disponivel;
+    int barreira;           /* Comuns de índice menor não valem no laço corrente */
+    Pilha desfazer;
+
+    Comum *comuns;
+    int num_comuns;
+    int capacidade_comuns;
+
+    Ocorrencia *ocorrencias;
+    int num_ocorrencias;
+    int capacidade_ocorrencias;
+
+    InfoNo *info;
+    int num_info;
+    int capacidade_info;
+
+    Temporario *temporarios;
+    int num_temporarios;
+    int capacidade_temporarios;
+
+    Referencia *referencias;
+    int num_referencias;
+    int capacidade_referencias;
+
+    /* Comando corrente */
+    NoCmd **lugar_comando;
+    int cabeca;
+    int comando;
+
+    long trocadas;
+} EstadoComuns;
+
+static int indice_simbolo(const EstadoComuns *e, const NoVar *var) {
+    return (int)(var->simbolo - e->ctx->tabela.simbolos);
+}
+
+/* Comum disponível com o valor 'v' no ponto corrente, ou -1 */
+static int disponivel(const EstadoComuns *e, int v) {
+    int c = v < e->capacidade_disponivel ? e->disponivel[v] : -1;
+    return c >= e->barreira ? c : -1;
+}
+
+static void registrar(EstadoComuns *e, int v, NoExpr **lugar, int tamanho) {
+    if (v >= e->capacidade_disponivel) {
+        int anterior = e->capacidade_disponivel;
+        e->capacidade_disponivel = e->valores.capacidade;
+        e->disponivel = (int *)realocar(e->disponivel, (size_t)e->capacidade_disponivel * sizeof(int));
+        memset(e->disponivel + anterior, 0xff, (size_t)(e->capacidade_disponivel - anterior) * sizeof(int));
+    }
+    if (e->num_comuns == e->capacidade_comuns) {
+        e->capacidade_comuns = e->capacidade_comuns > 0 ? 2 * e->capacidade_comuns : 256;
+        e->comuns = (Comum *)realocar(e->comuns, (size_t)e->capacidade_comuns * sizeof(Comum));
+    }
+    Comum *m = &e->comuns[e->num_comuns];
+    m->lugar = lugar;
+    m->lugar_comando = e->lugar_comando;
+    m->cabeca = e->cabeca;
+    m->comando = e->comando;
+    m->tamanho = tamanho;
+    m->repeticoes = 0;
+    m->ultima = -1;
+
+    Desfazer *d = (Desfazer *)pilha_empilhar(&e->desfazer);
+    d->valor = v;
+    d->anterior = e->disponivel[v];
+    e->disponivel[v] = e->num_comuns++;
+}
+
+/* Volta 'disponivel' ao que era com 'marca' registros na pilha */
+static void desfazer_ate(EstadoComuns *e, int marca) {
+    while (e->desfazer.num > (size_t)marca) {
+        Desfazer *d = (Desfazer *)pilha_topo(&e->desfazer);
+        e->disponivel[d->valor] = d->anterior;
+        pilha_desempilhar(&e->desfazer);
+    }
+}
+
+/* ========== Numeração das expressões ========== */
+
+/* O próprio nó pode interromper a execução */
+static int falha_propria(const NoExpr *expr) {
+    if (expr->tipo == EXPR_VAR_ARRAY) {
+        return expr->dado.var->limite != LIMITE_SEGURO;
+    }
+    if (expr->tipo == EXPR_ARITMETICA && expr->dado.aritmetica.op == ARIT_DIV &&
+        expr->tipo_dado != TIPO_REAL) {
+        NoExpr *dir = expr->dado.aritmetica.dir;
+        return !(dir->tipo == EXPR_CONST_INT && dir->dado.const_int != 0 && dir->dado.const_int != -1);
+    }
+    return 0;
+}
+
+static int novo_info(EstadoComuns *e) {
+    if (e->num_info == e->capacidade_info) {
+        e->capacidade_info = e->capacidade_info > 0 ? 2 * e->capacidade_info : 256;
+        e->info = (InfoNo *)realocar(e->info, (size_t)e->capacidade_info * sizeof(InfoNo));
+    }
+    return e->num_info++;
+}
+
+typedef struct {
+    NoExpr *expr;
+    int indice;
+    int etapa;
+} QuadroNumeracao;
+
+/* Número de valor do nó i, com os operandos já numerados */
+static void numerar_no(EstadoComuns *e, NoExpr *expr, int i) {
+    ChaveValor k;
+    int esq = i + 1;
+    int dir = esq < e->num_info ? esq + e->info[esq].tamanho : esq;
+
+    memset(&k, 0, sizeof(k));
+    k.tipo = expr->tipo;
+    k.tipo_dado = expr->tipo_dado;
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+            k.a = expr->dado.const_int;
+            break;
+        case EXPR_CONST_REAL:
+            memcpy(&k.a, &expr->dado.const_real, sizeof(double));
+            break;
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            k.a = indice_simbolo(e, expr->dado.var);
+            k.b = e->versao[k.a];
+            k.c = expr->dado.var->indice != NULL ? e->info[esq].valor : -1;
+            break;
+        case EXPR_ARITMETICA:
+            k.op = expr->dado.aritmetica.op;
+            k.a = e->info[esq].valor;
+            k.b = e->info[dir].valor;
+            if ((k.op == ARIT_SOMA || k.op == ARIT_MULT) && k.a > k.b) {
+                int64_t t = k.a;
+                k.a = k.b;
+                k.b = t;
+            }
+            break;
+        case EXPR_RELACIONAL:
+            k.op = expr->dado.relacional.op;
+            k.a = e->info[esq].valor;
+            k.b = e->info[dir].valor;
+            break;
+        case EXPR_LOGICA:
+            k.op = expr->dado.logica.op;
+            k.a = e->info[esq].valor;
+            k.b = e->info[dir].valor;
+            break;
+        case EXPR_NAO:
+        case EXPR_NEG:
+            k.a = e->info[esq].valor;
+            break;
+    }
+
+    e->info[i].valor = numero_valor(&e->valores, &k);
+}
+
+/* Preenche e->info para 'raiz' (o nó i em pré-ordem fica em e->info[i]); sem recursão */
+static void numerar_expressao(EstadoComuns *e, NoExpr *raiz) {
+    Pilha pilha;
+    QuadroNumeracao *q;
+
+    e->num_info = 0;
+    pilha_iniciar(&pilha, sizeof(QuadroNumeracao));
+    q = (QuadroNumeracao *)pilha_empilhar(&pilha);
+    q->expr = raiz;
+    q->etapa = 0;
+
+    while ((q = (QuadroNumeracao *)pilha_topo(&pilha)) != NULL) {
+        NoExpr *expr = q->expr;
+        int etapa = q->etapa++;
+        if (etapa == 0) {
+            q->indice = novo_info(e);
+        }
+        int i = q->indice;
+
+        NoExpr **operando = lugar_operando(expr, etapa);
+        if (operando != NULL) {
+            QuadroNumeracao *filho = (QuadroNumeracao *)pilha_empilhar(&pilha);
+            filho->expr = *operando;
+            filho->etapa = 0;
+            continue;
+        }
+        pilha_desempilhar(&pilha);
+
+        InfoNo *in = &e->info[i];
+        in->tamanho = e->num_info - i;
+        in->falha = (unsigned char)falha_propria(expr);
+        for (int j = i + 1; j < e->num_info; j += e->info[j].tamanho) {
+            in->falha |= e->info[j].falha;
+        }
+        in->candidata = (expr->tipo == EXPR_ARITMETICA || expr->tipo == EXPR_VAR_ARRAY ||
+                         expr->tipo == EXPR_NEG) &&
+                        (expr->tipo_dado == TIPO_INTEIRO || expr->tipo_dado == TIPO_REAL) &&
+                        !in->falha;
+        numerar_no(e, expr, i);
+    }
+
+    pilha_liberar(&pilha);
+}
+
+/* ========== Temporários ========== */
+
+static NoVar *nova_referencia(ContextoCompilacao *ctx, ChaveId chave, const NoExpr *origem) {
+    NoVar *var = criar_var_simples(ctx, chave);
+    var->linha = origem->linha;
+    var->coluna = origem->coluna;
+    return var;
+}
+
+/* Leitura do temporário 't' no lugar de 'origem' */
+static NoExpr *leitura(EstadoComuns *e, int t, const NoExpr *origem) {
+    ChaveId chave = e->temporarios[t].atrib->dado.atrib.var->chave;
+    NoVar *var = nova_referencia(e->ctx, chave, origem);
+    NoExpr *expr = criar_expr_var(e->ctx, var);
+    expr->tipo_dado = origem->tipo_dado;
+    expr->linha = origem->linha;
+    expr->coluna = origem->coluna;
+
+    if (e->num_referencias == e->capacidade_referencias) {
+        e->capacidade_referencias = e->capacidade_referencias > 0 ? 2 * e->capacidade_referencias : 64;
+        e->referencias = (Referencia *)realocar(e->referencias,
+                                                (size_t)e->capacidade_referencias * sizeof(Referencia));
+    }
+    e->referencias[e->num_referencias].var = var;
+    e->referencias[e->num_referencias].temporario = t;
+    e->num_referencias++;
+    return expr;
+}
+
+/* Passa a primeira ocorrência do comum 'c' para um temporário (o símbolo é ligado no final) */
+static int criar_temporario(EstadoComuns *e, int c) {
+    Comum *m = &e->comuns[c];
+    NoExpr *expr = *m->lugar;
+    char nome[16];          /* "_c" e até 6 dígitos: cabe em ID_MAX_CHARS */
+
+    snprintf(nome, sizeof(nome), "_c%d", e->num_temporarios + 1);
+    ChaveId chave = chave_id(nome, strlen(nome));
+
+    NoCmd *atrib = criar_cmd_atrib(e->ctx, nova_referencia(e->ctx, chave, expr), expr);
+    atrib->linha = expr->linha;
+    atrib->coluna = expr->coluna;
+
+    if (e->num_temporarios == e->capacidade_temporarios) {
+        e->capacidade_temporarios = e->capacidade_temporarios > 0 ? 2 * e->capacidade_temporarios : 16;
+        e->temporarios = (Temporario *)realocar(e->temporarios,
+                                                (size_t)e->capacidade_temporarios * sizeof(Temporario));
+    }
+    int t = e->num_temporarios++;
+    e->temporarios[t].comum = c;
+    e->temporarios[t].atrib = atrib;
+    e->temporarios[t].ocorrencias = 1 + m->repeticoes;
+
+    *m->lugar = leitura(e, t, expr);
+    return t;
+}
+
+/* *lugar repete o comum 'c': a troca só é decidida no final */
+static void anotar_repeticao(EstadoComuns *e, int c, NoExpr **lugar) {
+    if (e->num_ocorrencias == e->capacidade_ocorrencias) {
+        e->capacidade_ocorrencias = e->capacidade_ocorrencias > 0 ? 2 * e->capacidade_ocorrencias : 64;
+        e->ocorrencias = (Ocorrencia *)realocar(e->ocorrencias,
+                                                (size_t)e->capacidade_ocorrencias * sizeof(Ocorrencia));
+    }
+    Comum *m = &e->comuns[c];
+    e->ocorrencias[e->num_ocorrencias].lugar = lugar;
+    e->ocorrencias[e->num_ocorrencias].anterior = m->ultima;
+    m->ultima = e->num_ocorrencias++;
+    m->repeticoes++;
+}
+
+/*
+ * Cria os temporários que compensam: as repetições economizam
+ * tamanho - 1 nós cada, e o temporário custa uma leitura a mais e uma
+ * atribuição (um L[i] repetido só uma vez não compensa)
+ */
+static void criar_temporarios(EstadoComuns *e) {
+    for (int c = 0; c < e->num_comuns && e->num_temporarios < MAX_TEMPORARIOS; c++) {
+        Comum *m = &e->comuns[c];
+        if ((long)m->repeticoes * (m->tamanho - 1) <= 1) {
+            continue;
+        }
+        int t = criar_temporario(e, c);
+        for (int o = m->ultima; o >= 0; o = e->ocorrencias[o].anterior) {
+            NoExpr **lugar = e->ocorrencias[o].lugar;
+            *lugar = leitura(e, t, *lugar);
+            e->trocadas++;
+        }
+    }
+}
+
+/* ========== Percurso ========== */
+
+typedef struct {
+    NoExpr **lugar;
+    int indice;
+    int etapa;
+} QuadroExpressao;
+
+/*
+ * Troca as subexpressões de *lugar já disponíveis (as maiores primeiro)
+ * e registra as novas, depois dos seus operandos
+ */
+static void processar_expressao(EstadoComuns *e, NoExpr **lugar) {
+    Pilha pilha;
+    QuadroExpressao *q;
+
+    numerar_expressao(e, *lugar);
+
+    pilha_iniciar(&pilha, sizeof(QuadroExpressao));
+    q = (QuadroExpressao *)pilha_empilhar(&pilha);
+    q->lugar = lugar;
+    q->indice = 0;
+    q->etapa = 0;
+
+    while ((q = (QuadroExpressao *)pilha_topo(&pilha)) != NULL) {
+        NoExpr **aqui = q->lugar;
+        int indice = q->indice;
+        int etapa = q->etapa++;
+        InfoNo in = e->info[indice];
+
+        if (etapa == 0 && in.candidata) {
+            int c = disponivel(e, in.valor);
+            if (c >= 0) {
+                anotar_repeticao(e, c, aqui);
+                pilha_desempilhar(&pilha);
+                continue;
+            }
+        }
+
+        NoExpr **operando = lugar_operando(*aqui, etapa);
+        if (operando != NULL) {
+            QuadroExpressao *filho = (QuadroExpressao *)pilha_empilhar(&pilha);
+            filho->lugar = operando;
+            filho->indice = indice + 1 + (etapa == 1 ? e->info[indice + 1].tamanho : 0);
+            filho->etapa = 0;
+            continue;
+        }
+        pilha_desempilhar(&pilha);
+
+        if (in.candidata && disponivel(e, in.valor) < 0) {
+            registrar(e, in.valor, aqui, in.tamanho);
+        }
+    }
+
+    pilha_liberar(&pilha);
+}
+
+/* Uma atribuição ou LEIA: os valores que liam 'var' deixam de valer */
+static void definir(EstadoComuns *e, const NoVar *var) {
+    e->versao[indice_simbolo(e, var)]++;
+}
+
+/* Quadro do percurso de comandos: o resto de uma sequência, ou o fim de um bloco */
+typedef struct {
+    NoCmd **lugar;
+    int cabeca;
+    int fechar;             /* Fim de bloco: desfaz até 'marca' e volta à 'barreira' */
+    int marca;
+    int barreira;
+} QuadroComando;
+
+static void empilhar_sequencia(Pilha *pilha, NoCmd **lugar, int cabeca) {
+    QuadroComando *q = (QuadroComando *)pilha_empilhar(pilha);
+    memset(q, 0, sizeof(*q));
+    q->lugar = lugar;
+    q->cabeca = cabeca;
+}
+
+static void empilhar_fim(EstadoComuns *e, Pilha *pilha) {
+    QuadroComando *q = (QuadroComando *)pilha_empilhar(pilha);
+    memset(q, 0, sizeof(*q));
+    q->fechar = 1;
+    q->marca = (int)e->desfazer.num;
+    q->barreira = e->barreira;
+}
+
+static void processar_comandos(EstadoComuns *e, NoPrograma *prog) {
+    Pilha pilha;
+    QuadroComando *q;
+    int posicao = 0;
+
+    pilha_iniciar(&pilha, sizeof(QuadroComando));
+    empilhar_sequencia(&pilha, &prog->algoritmo, 1);
+
+    while ((q = (QuadroComando *)pilha_topo(&pilha)) != NULL) {
+        QuadroComando quadro = *q;
+        pilha_desempilhar(&pilha);
+
+        if (quadro.fechar) {
+            desfazer_ate(e, quadro.marca);
+            e->barreira = quadro.barreira;
+            continue;
+        }
+        NoCmd *cmd = *quadro.lugar;
+        if (cmd == NULL) {
+            continue;
+        }
+
+        empilhar_sequencia(&pilha, &cmd->prox, 0);
+        e->lugar_comando = quadro.lugar;
+        e->cabeca = quadro.cabeca;
+        e->comando = posicao++;
+
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                processar_expressao(e, &cmd->dado.atrib.expr);
+                if (cmd->dado.atrib.var->indice != NULL) {
+                    processar_expressao(e, &cmd->dado.atrib.var->indice);
+                }
+                definir(e, cmd->dado.atrib.var);
+                break;
+
+            case CMD_LEIA:
+                /* Os índices ficam como estão: cada leitura pode mudar o seguinte */
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    definir(e, v->var);
+                }
+                break;
+
+            case CMD_ESCREVA:
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        processar_expressao(e, &item->item.expr);
+                    }
+                }
+                break;
+
+            case CMD_SE:
+                /* A condição vale nos dois ramos; o que cada ramo registra, só nele */
+                processar_expressao(e, &cmd->dado.se.condicao);
+                empilhar_fim(e, &pilha);
+                empilhar_sequencia(&pilha, &cmd->dado.se.senao, 1);
+                empilhar_fim(e, &pilha);
+                empilhar_sequencia(&pilha, &cmd->dado.se.entao, 1);
+                break;
+
+            case CMD_ENQUANTO:
+                empilhar_fim(e, &pilha);
+                empilhar_sequencia(&pilha, &cmd->dado.enquanto.corpo, 1);
+                e->barreira = e->num_comuns;
+                break;
+        }
+    }
+
+    pilha_liberar(&pilha);
+}
+
+/* ========== Inserção e declaração dos temporários ========== */
+
+/* Chave de ordenação de um temporário */
+typedef struct ChaveTemporario {
+    int comando;
+    int comum;
+    int temporario;
+} ChaveTemporario;
+
+/* Por comando e, no mesmo comando, na ordem de registro (operandos antes) */
+static int comparar_temporarios(const void *a, const void *b) {
+    const ChaveTemporario *x = (const ChaveTemporario *)a;
+    const ChaveTemporario *y = (const ChaveTemporario *)b;
+    if (x->comando != y->comando) {
+        return x->comando < y->comando ? -1 : 1;
+    }
+    return (x->comum > y->comum) - (x->comum < y->comum);
+}
+
+/* Põe cada grupo de temporários antes do comando da sua primeira ocorrência */
+static void inserir_temporarios(EstadoComuns *e) {
+    ChaveTemporario *ordem = (ChaveTemporario *)realocar(NULL,
+        (size_t)e->num_temporarios * sizeof(ChaveTemporario));
+
+    for (int i = 0; i < e->num_temporarios; i++) {
+        ordem[i].comum = e->temporarios[i].comum;
+        ordem[i].comando = e->comuns[ordem[i].comum].comando;
+        ordem[i].temporario = i;
+    }
+    qsort(ordem, (size_t)e->num_temporarios, sizeof(ChaveTemporario), comparar_temporarios);
+
+    for (int i = 0; i < e->num_temporarios; ) {
+        const Comum *m = &e->comuns[ordem[i].comum];
+        NoCmd *cmd = *m->lugar_comando;
+        NoCmd *inicio = e->temporarios[ordem[i].temporario].atrib;
+        NoCmd *fim = inicio;
+        int j = i + 1;
+
+        while (j < e->num_temporarios && ordem[j].comando == ordem[i].comando) {
+            fim->prox = e->temporarios[ordem[j].temporario].atrib;
+            fim = fim->prox;
+            j++;
+        }
+        fim->prox = cmd;
+        if (m->cabeca) {
+            inicio->ultimo = cmd->ultimo;
+        }
+        *m->lugar_comando = inicio;
+        i = j;
+    }
+
+    free(ordem);
+}
+
+/* Declara os temporários, já na AST, e liga as leituras aos símbolos */
+static void declarar_temporarios(EstadoComuns *e, NoPrograma *prog) {
+    ContextoCompilacao *ctx = e->ctx;
+
+    EntradaSimbolo *anterior = reservar_simbolos(ctx, e->num_temporarios);
+    if (anterior != NULL) {
+        religar_simbolos(ctx, prog->algoritmo, anterior);
+        free(anterior);
+    }
+
+    for (int t = 0; t < e->num_temporarios; t++) {
+        NoVar *destino = e->temporarios[t].atrib->dado.atrib.var;
+        NoExpr *expr = e->temporarios[t].atrib->dado.atrib.expr;
+        int indice = ctx->tabela.num_simbolos;
+
+        inserir_simbolo(ctx, destino->chave, expr->tipo_dado, 0, expr->linha, expr->coluna);
+        destino->simbolo = &ctx->tabela.simbolos[indice];
+
+        NoDecl *decl = criar_declaracao(ctx, expr->tipo_dado, destino->chave, 0);
+        decl->linha = expr->linha;
+        decl->coluna = expr->coluna;
+        prog->declaracoes = concat_declaracoes(prog->declaracoes, decl);
+    }
+    for (int i = 0; i < e->num_referencias; i++) {
+        Referencia *r = &e->referencias[i];
+        r->var->simbolo = e->temporarios[r->temporario].atrib->dado.atrib.var->simbolo;
+    }
+    prog->tamanho_quadro = ctx->tabela.tamanho_quadro;
+}
+
+long eliminar_subexpressoes(ContextoCompilacao *ctx, NoPrograma *prog, FILE *registro) {
+    EstadoComuns e;
+
+    memset(&e, 0, sizeof(e));
+    e.ctx = ctx;
+    e.versao = (int *)calloc((size_t)ctx->tabela.num_simbolos + 1, sizeof(int));
+    if (e.versao == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a eliminacao de subexpressoes\n");
+        exit(1);
+    }
+    pilha_iniciar(&e.desfazer, sizeof(Desfazer));
+
+    processar_comandos(&e, prog);
+    criar_temporarios(&e);
+
+    if (e.num_temporarios > 0) {
+        inserir_temporarios(&e);
+        declarar_temporarios(&e, prog);
+    }
+
+    if (registro != NULL) {
+        char nome[ID_MAX_CHARS + 1];
+        for (int t = 0; t < e.num_temporarios; t++) {
+            NoCmd *atrib = e.temporarios[t].atrib;
+            fprintf(registro, ">>> Subexpressao comum na linha %d: %s := ", atrib->linha,
+                    texto_id(atrib->dado.atrib.var->chave, nome));
+            imprimir_expressao(atrib->dado.atrib.expr, registro);
+            fprintf(registro, " (%d ocorrencias)\n", e.temporarios[t].ocorrencias);
+        }
+    }
+
+    ctx->subexpressoes_comuns = e.trocadas;
+    ctx->temporarios_comuns = e.num_temporarios;
+
+    free(e.valores.chaves);
+    free(e.valores.baldes);
+    free(e.versao);
+    free(e.disponivel);
+    pilha_liberar(&e.desfazer);
+    free(e.comuns);
+    free(e.ocorrencias);
+    free(e.info);
+    free(e.temporarios);
+    free(e.referencias);
+    return ctx->subexpressoes_comuns;
+}
+
+/* ========== Compartilhamento de nós ========== */
+
+/* A linha do nó aparece num erro de execução (e no bytecode listado) */
+static int leva_linha(const NoExpr *expr) {
+    return (expr->tipo == EXPR_VAR_ARRAY && expr->dado.var->limite != LIMITE_SEGURO) ||
+           (expr->tipo == EXPR_ARITMETICA && expr->dado.aritmetica.op == ARIT_DIV &&
+            expr->tipo_dado != TIPO_REAL);
+}
+
+/* Conteúdo do nó com os operandos já consolidados (comparados por endereço) */
+static unsigned int hash_no(const NoExpr *expr) {
+    uint64_t h = (uint64_t)expr->tipo;
+    h = misturar(h, (uint64_t)expr->tipo_dado);
+
+    switch (expr->tipo) {
+        case EXPR_CONST_INT:
+            h = misturar(h, (uint64_t)(int64_t)expr->dado.const_int);
+            break;
+        case EXPR_CONST_REAL:
+            {
+                uint64_t bits;
+                memcpy(&bits, &expr->dado.const_real, sizeof(bits));
+                h = misturar(h, bits);
+            }
+            break;
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.var->simbolo);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.var->indice);
+            h = misturar(h, (uint64_t)expr->dado.var->limite);
+            break;
+        case EXPR_ARITMETICA:
+            h = misturar(h, (uint64_t)expr->dado.aritmetica.op);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.aritmetica.esq);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.aritmetica.dir);
+            break;
+        case EXPR_RELACIONAL:
+            h = misturar(h, (uint64_t)expr->dado.relacional.op);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.relacional.esq);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.relacional.dir);
+            break;
+        case EXPR_LOGICA:
+            h = misturar(h, (uint64_t)expr->dado.logica.op);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.logica.esq);
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.logica.dir);
+            break;
+        case EXPR_NAO:
+        case EXPR_NEG:
+            h = misturar(h, (uint64_t)(uintptr_t)expr->dado.negacao);
+            break;
+    }
+    if (leva_linha(expr)) {
+        h = misturar(h, (uint64_t)expr->linha);
+    }
+    return finalizar(h);
+}
+
+static int nos_iguais(const NoExpr *x, const NoExpr *y) {
+    if (x->tipo != y->tipo || x->tipo_dado != y->tipo_dado) {
+        return 0;
+    }
+    if (leva_linha(x) && x->linha != y->linha) {
+        return 0;
+    }
+    switch (x->tipo) {
+        case EXPR_CONST_INT:
+            return x->dado.const_int == y->dado.const_int;
+        case EXPR_CONST_REAL:
+            return memcmp(&x->dado.const_real, &y->dado.const_real, sizeof(double)) == 0;
+        case EXPR_VAR:
+        case EXPR_VAR_ARRAY:
+            return x->dado.var->simbolo == y->dado.var->simbolo &&
+                   x->dado.var->indice == y->dado.var->indice &&
+                   x->dado.var->limite == y->dado.var->limite;
+        case EXPR_ARITMETICA:
+            return x->dado.aritmetica.op == y->dado.aritmetica.op &&
+                   x->dado.aritmetica.esq == y->dado.aritmetica.esq &&
+                   x->dado.aritmetica.dir == y->dado.aritmetica.dir;
+        case EXPR_RELACIONAL:
+            return x->dado.relacional.op == y->dado.relacional.op &&
+                   x->dado.relacional.esq == y->dado.relacional.esq &&
+                   x->dado.relacional.dir == y->dado.relacional.dir;
+        case EXPR_LOGICA:
+            return x->dado.logica.op == y->dado.logica.op &&
+                   x->dado.logica.esq == y->dado.logica.esq &&
+                   x->dado.logica.dir == y->dado.logica.dir;
+        case EXPR_NAO:
+        case EXPR_NEG:
+            return x->dado.negacao == y->dado.negacao;
+    }
+    return 0;
+}
+
+/* Nós únicos: endereçamento aberto sobre o conteúdo */
+typedef struct TabelaNos {
+    NoExpr **baldes;
+    int num_baldes;         /* Potência de 2 */
+    int num;
+} TabelaNos;
+
+static void crescer_nos(TabelaNos *t) {
+    int num_baldes = t->num_baldes > 0 ? 2 * t->num_baldes : 1024;
+    NoExpr **baldes = (NoExpr **)calloc((size_t)num_baldes, sizeof(NoExpr *));
+    if (baldes == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a eliminacao de subexpressoes\n");
+        exit(1);
+    }
+    for (int i = 0; i < t->num_baldes; i++) {
+        if (t->baldes[i] != NULL) {
+            unsigned int h = hash_no(t->baldes[i]) & (unsigned int)(num_baldes - 1);
+            while (baldes[h] != NULL) {
+                h = (h + 1) & (unsigned int)(num_baldes - 1);
+            }
+            baldes[h] = t->baldes[i];
+        }
+    }
+    free(t->baldes);
+    t->baldes = baldes;
+    t->num_baldes = num_baldes;
+}
+
+/* O nó único igual a 'expr' (o próprio, se é o primeiro) */
+static NoExpr *consolidar(TabelaNos *t, NoExpr *expr) {
+    if (2 * (t->num + 1) > t->num_baldes) {
+        crescer_nos(t);
+    }
+    unsigned int h = hash_no(expr) & (unsigned int)(t->num_baldes - 1);
+    while (t->baldes[h] != NULL) {
+        if (t->baldes[h] == expr || nos_iguais(t->baldes[h], expr)) {
+            return t->baldes[h];
+        }
+        h = (h + 1) & (unsigned int)(t->num_baldes - 1);
+    }
+    t->baldes[h] = expr;
+    t->num++;
+    return expr;
+}
+
+typedef struct {
+    NoExpr **lugar;
+    int etapa;
+} QuadroConsolidacao;
+
+/* Consolida *lugar de baixo para cima (operandos antes do nó); sem recursão */
+static void compartilhar_expressao(ContextoCompilacao *ctx, TabelaNos *t, NoExpr **lugar, Pilha *pilha) {
+    QuadroConsolidacao *q;
+
+    if (*lugar == NULL) return;
+
+    q = (QuadroConsolidacao *)pilha_empilhar(pilha);
+    q->lugar = lugar;
+    q->etapa = 0;
+
+    while ((q = (QuadroConsolidacao *)pilha_topo(pilha)) != NULL) {
+        NoExpr **aqui = q->lugar;
+        NoExpr **operando = lugar_operando(*aqui, q->etapa++);
+        if (operando != NULL) {
+            QuadroConsolidacao *filho = (QuadroConsolidacao *)pilha_empilhar(pilha);
+            filho->lugar = operando;
+            filho->etapa = 0;
+            continue;
+        }
+        pilha_desempilhar(pilha);
+
+        NoExpr *unico = consolidar(t, *aqui);
+        if (unico != *aqui) {
+            int var = (*aqui)->tipo == EXPR_VAR || (*aqui)->tipo == EXPR_VAR_ARRAY;
+            ctx->nos_compartilhados++;
+            ctx->bytes_compartilhados += (long)(sizeof(NoExpr) + (var ? sizeof(NoVar) : 0));
+            *aqui = unico;
+        }
+    }
+}
+
+long compartilhar_expressoes(ContextoCompilacao *ctx, NoPrograma *prog) {
+    TabelaNos t;
+    PercursoComandos percurso;
+    NoCmd *cmd;
+    Pilha pilha;
+
+    memset(&t, 0, sizeof(t));
+    ctx->nos_compartilhados = 0;
+    ctx->bytes_compartilhados = 0;
+
+    pilha_iniciar(&pilha, sizeof(QuadroConsolidacao));
+    iniciar_percurso(&percurso, prog->algoritmo);
+    while ((cmd = proximo_comando(&percurso)) != NULL) {
+        switch (cmd->tipo) {
+            case CMD_ATRIB:
+                compartilhar_expressao(ctx, &t, &cmd->dado.atrib.var->indice, &pilha);
+                compartilhar_expressao(ctx, &t, &cmd->dado.atrib.expr, &pilha);
+                break;
+            case CMD_LEIA:
+                for (ListaVar *v = cmd->dado.leia; v != NULL; v = v->prox) {
+                    compartilhar_expressao(ctx, &t, &v->var->indice, &pilha);
+                }
+                break;
+            case CMD_ESCREVA:
+                for (ListaEscreva *item = cmd->dado.escreva; item != NULL; item = item->prox) {
+                    if (!item->is_cadeia) {
+                        compartilhar_expressao(ctx, &t, &item->item.expr, &pilha);
+                    }
+                }
+                break;
+            case CMD_SE:
+                compartilhar_expressao(ctx, &t, &cmd->dado.se.condicao, &pilha);
+                break;
+            case CMD_ENQUANTO:
+                compartilhar_expressao(ctx, &t, &cmd->dado.enquanto.condicao, &pilha);
+                break;
+        }
+    }
+    terminar_percurso(&percurso);
+    pilha_liberar(&pilha);
+
+    ctx->nos_unicos = t.num;
+    free(t.baldes);
+    return ctx->nos_compartilhados;
+}
@@ -0,0 +1,45 @@
+/*
+ * Subexpressões comuns e compartilhamento de nós de expressão
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef SUBEXPRESSOES_H
+#define SUBEXPRESSOES_H
+
+#include <stdio.h>
+#include "ast.h"
+
+/*
+ * Eliminação de subexpressões comuns: uma operação aritmética ou um
+ * acesso a lista que se repete com os mesmos valores nos operandos passa
+ * a ser calculado uma vez, num temporário "_c1", "_c2", ... posto antes
+ * do comando da primeira ocorrência, e as seguintes leem o temporário
+ * (quando isso economiza nós: um L[i] que aparece só duas vezes fica).
+ * O valor vale até uma atribuição ou LEIA de algum operando, ao longo da
+ * sequência de comandos e dos blocos de SE nela; o corpo de um ENQUANTO
+ * começa sem valores disponíveis, e a condição do laço não é alterada.
+ * Só entram expressões que não podem interromper a execução (acessos
+ * provados seguros, divisões por constantes).
+ *
+ * Deve ser chamada após uma análise semântica sem erros e antes de
+ * compartilhar_expressoes. Com 'registro' não nulo, escreve ali uma linha
+ * por temporário. Retorna o número de ocorrências trocadas por leituras
+ * de temporários (também em ctx->subexpressoes_comuns).
+ */
+long eliminar_subexpressoes(ContextoCompilacao *ctx, NoPrograma *prog, FILE *registro);
+
+/*
+ * Consolidação por hash (hash-consing): nós de expressão iguais em tipo,
+ * operador, tipo_dado, símbolo e operandos (já consolidados) passam a ser
+ * um só, e as expressões formam um grafo acíclico em vez de árvores. Nós
+ * cuja linha aparece num erro de execução (divisão inteira, acesso não
+ * provado seguro) só se juntam a outros da mesma linha.
+ *
+ * Deve ser o último passo a alterar a AST. Retorna o número de nós de
+ * expressão eliminados (também em ctx->nos_compartilhados; os bytes de
+ * NoExpr e NoVar que deixaram de ser alcançáveis ficam em
+ * ctx->bytes_compartilhados).
+ */
+long compartilhar_expressoes(ContextoCompilacao *ctx, NoPrograma *prog);
+
+#endif /* SUBEXPRESSOES_H */
@@ -0,0 +1,229 @@
+/*
+ * Máquina virtual do bytecode de X25b
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "vm.h"
+#include "runtime.h"
+
+/*
+ * Despacho: com GCC/Clang usa "computed goto" (cada instrução salta
+ * diretamente para a próxima); nos demais compiladores, um switch.
+ */
+#if defined(__GNUC__)
+#define DESPACHO_DIRETO 1
+#endif
+
+#ifdef DESPACHO_DIRETO
+#define CASO(op)        rotulo_##op:
+#define PROXIMA()       do { executadas++; goto *rotulos[codigo[pc++]]; } while (0)
+#define INICIO()        PROXIMA();
+#define FIM()
+#else
+#define CASO(op)        case op:
+#define PROXIMA()       continue
+#define INICIO()        for (;;) { executadas++; switch (codigo[pc++]) {
+#define FIM()           default: goto fim; } }
+#endif
+
+/* Operações binárias sobre o topo da pilha */
+#define BINARIA_I(expr_) do { sp--; int a = pilha[sp - 1].i, b = pilha[sp].i; \
+                              pilha[sp - 1].i = (expr_); } while (0)
+#define BINARIA_R(expr_) do { sp--; double a = pilha[sp - 1].r, b = pilha[sp].r; \
+                              pilha[sp - 1].r = (expr_); } while (0)
+#define COMPARA_R(expr_) do { sp--; double a = pilha[sp - 1].r, b = pilha[sp].r; \
+                              pilha[sp - 1].i = (expr_); } while (0)
+
+/* Verifica o índice de um array (1..tam) e retorna a posição no quadro */
+static int posicao_array(const Bytecode *bc, int slot, int tam, int indice, int linha) {
+    if (indice < 1 || indice > tam) {
+        char nome[ID_MAX_CHARS + 1];
+        erro_execucao(linha, "Indice %d fora dos limites de '%s' (1..%d)",
+                      indice, texto_id(bc->nomes_slot[slot], nome), tam);
+    }
+    return slot + indice - 1;
+}
+
+long executar_bytecode(const Bytecode *bc) {
+    const int32_t *codigo = bc->codigo;
+    long executadas = 0;
+    int pc = 0;
+    int sp = 0;
+
+    /* Pilha de operandos e quadro de variáveis pré-alocados */
+    Valor *pilha = (Valor *)malloc((size_t)(bc->pilha_max + 1) * sizeof(Valor));
+    Valor *quadro = (Valor *)calloc(bc->tamanho_quadro > 0 ? bc->tamanho_quadro : 1,
+                                    sizeof(Valor));
+    if (pilha == NULL || quadro == NULL) {
+        fprintf(stderr, "Erro: memoria insuficiente para a maquina virtual\n");
+        free(pilha);
+        free(quadro);
+        return 0;
+    }
+
+#ifdef DESPACHO_DIRETO
+    static void *rotulos[NUM_OPCODES] = {
+        [OP_CONST_I] = &&rotulo_OP_CONST_I,         [OP_CONST_R] = &&rotulo_OP_CONST_R,
+        [OP_CARREGA] = &&rotulo_OP_CARREGA,         [OP_CARREGA_ARR] = &&rotulo_OP_CARREGA_ARR,
+        [OP_GUARDA] = &&rotulo_OP_GUARDA,           [OP_GUARDA_ARR] = &&rotulo_OP_GUARDA_ARR,
+        [OP_CARREGA_ELEM] = &&rotulo_OP_CARREGA_ELEM, [OP_GUARDA_ELEM] = &&rotulo_OP_GUARDA_ELEM,
+        [OP_I2R] = &&rotulo_OP_I2R,                 [OP_R2I] = &&rotulo_OP_R2I,
+        [OP_SOMA_I] = &&rotulo_OP_SOMA_I,           [OP_SUB_I] = &&rotulo_OP_SUB_I,
+        [OP_MULT_I] = &&rotulo_OP_MULT_I,           [OP_DIV_I] = &&rotulo_OP_DIV_I,
+        [OP_SOMA_R] = &&rotulo_OP_SOMA_R,           [OP_SUB_R] = &&rotulo_OP_SUB_R,
+        [OP_MULT_R] = &&rotulo_OP_MULT_R,           [OP_DIV_R] = &&rotulo_OP_DIV_R,
+        [OP_MAQ_I] = &&rotulo_OP_MAQ_I,             [OP_MAI_I] = &&rotulo_OP_MAI_I,
+        [OP_MEQ_I] = &&rotulo_OP_MEQ_I,             [OP_MEI_I] = &&rotulo_OP_MEI_I,
+        [OP_IGU_I] = &&rotulo_OP_IGU_I,             [OP_DIF_I] = &&rotulo_OP_DIF_I,
+        [OP_MAQ_R] = &&rotulo_OP_MAQ_R,             [OP_MAI_R] = &&rotulo_OP_MAI_R,
+        [OP_MEQ_R] = &&rotulo_OP_MEQ_R,             [OP_MEI_R] = &&rotulo_OP_MEI_R,
+        [OP_IGU_R] = &&rotulo_OP_IGU_R,             [OP_DIF_R] = &&rotulo_OP_DIF_R,
+        [OP_NEG_I] = &&rotulo_OP_NEG_I,             [OP_NEG_R] = &&rotulo_OP_NEG_R,
+        [OP_NAO] = &&rotulo_OP_NAO,                 [OP_DESVIA] = &&rotulo_OP_DESVIA,
+        [OP_DESVIA_F] = &&rotulo_OP_DESVIA_F,       [OP_DESVIA_V] = &&rotulo_OP_DESVIA_V,
+        [OP_LEIA_I] = &&rotulo_OP_LEIA_I,           [OP_LEIA_R] = &&rotulo_OP_LEIA_R,
+        [OP_ESCREVA_I] = &&rotulo_OP_ESCREVA_I,     [OP_ESCREVA_R] = &&rotulo_OP_ESCREVA_R,
+        [OP_ESCREVA_S] = &&rotulo_OP_ESCREVA_S,     [OP_FIM_LINHA] = &&rotulo_OP_FIM_LINHA,
+        [OP_PARA] = &&rotulo_OP_PARA,
+    };
+#endif
+
+    INICIO()
+
+    CASO(OP_CONST_I)
+        pilha[sp++].i = codigo[pc++];
+        PROXIMA();
+
+    CASO(OP_CONST_R)
+        pilha[sp++].r = bc->reais[codigo[pc++]];
+        PROXIMA();
+
+    CASO(OP_CARREGA)
+        pilha[sp++] = quadro[codigo[pc++]];
+        PROXIMA();
+
+    CASO(OP_CARREGA_ARR)
+        pilha[sp - 1] = quadro[posicao_array(bc, codigo[pc], codigo[pc + 1],
+                                             pilha[sp - 1].i, codigo[pc + 2])];
+        pc += 3;
+        PROXIMA();
+
+    CASO(OP_GUARDA)
+        quadro[codigo[pc++]] = pilha[--sp];
+        PROXIMA();
+
+    CASO(OP_GUARDA_ARR)
+        sp -= 2;
+        quadro[posicao_array(bc, codigo[pc], codigo[pc + 1],
+                             pilha[sp].i, codigo[pc + 2])] = pilha[sp + 1];
+        pc += 3;
+        PROXIMA();
+
+    /* Índices provados em 1..tam pela análise de intervalos */
+    CASO(OP_CARREGA_ELEM)
+        pilha[sp - 1] = quadro[codigo[pc++] + pilha[sp - 1].i];
+        PROXIMA();
+
+    CASO(OP_GUARDA_ELEM)
+        sp -= 2;
+        quadro[codigo[pc++] + pilha[sp].i] = pilha[sp + 1];
+        PROXIMA();
+
+    CASO(OP_I2R)
+        pilha[sp - 1].r = (double)pilha[sp - 1].i;
+        PROXIMA();
+
+    CASO(OP_R2I)
+        pilha[sp - 1].i = (int)pilha[sp - 1].r;
+        PROXIMA();
+
+    /* Estouros dão a volta e INT_MIN / -1 é erro, como em --run (runtime.h) */
+    CASO(OP_SOMA_I) BINARIA_I(somar_inteiros(a, b)); PROXIMA();
+    CASO(OP_SUB_I)  BINARIA_I(subtrair_inteiros(a, b)); PROXIMA();
+    CASO(OP_MULT_I) BINARIA_I(multiplicar_inteiros(a, b)); PROXIMA();
+
+    CASO(OP_DIV_I)
+        BINARIA_I(dividir_inteiros(a, b, codigo[pc]));
+        pc++;
+        PROXIMA();
+
+    CASO(OP_SOMA_R) BINARIA_R(a + b); PROXIMA();
+    CASO(OP_SUB_R)  BINARIA_R(a - b); PROXIMA();
+    CASO(OP_MULT_R) BINARIA_R(a * b); PROXIMA();
+    CASO(OP_DIV_R)  BINARIA_R(a / b); PROXIMA();
+
+    CASO(OP_MAQ_I) BINARIA_I(a > b); PROXIMA();
+    CASO(OP_MAI_I) BINARIA_I(a >= b); PROXIMA();
+    CASO(OP_MEQ_I) BINARIA_I(a < b); PROXIMA();
+    CASO(OP_MEI_I) BINARIA_I(a <= b); PROXIMA();
+    CASO(OP_IGU_I) BINARIA_I(a == b); PROXIMA();
+    CASO(OP_DIF_I) BINARIA_I(a != b); PROXIMA();
+
+    CASO(OP_MAQ_R) COMPARA_R(a > b); PROXIMA();
+    CASO(OP_MAI_R) COMPARA_R(a >= b); PROXIMA();
+    CASO(OP_MEQ_R) COMPARA_R(a < b); PROXIMA();
+    CASO(OP_MEI_R) COMPARA_R(a <= b); PROXIMA();
+    CASO(OP_IGU_R) COMPARA_R(a == b); PROXIMA();
+    CASO(OP_DIF_R) COMPARA_R(a != b); PROXIMA();
+
+    CASO(OP_NEG_I)
+        pilha[sp - 1].i = negar_inteiro(pilha[sp - 1].i);
+        PROXIMA();
+
+    CASO(OP_NEG_R)
+        pilha[sp - 1].r = -pilha[sp - 1].r;
+        PROXIMA();
+
+    CASO(OP_NAO)
+        pilha[sp - 1].i = !pilha[sp - 1].i;
+        PROXIMA();
+
+    CASO(OP_DESVIA)
+        pc = codigo[pc];
+        PROXIMA();
+
+    CASO(OP_DESVIA_F)
+        pc = pilha[--sp].i ? pc + 1 : codigo[pc];
+        PROXIMA();
+
+    CASO(OP_DESVIA_V)
+        pc = pilha[--sp].i ? codigo[pc] : pc + 1;
+        PROXIMA();
+
+    CASO(OP_LEIA_I)
+        pilha[sp++].i = ler_inteiro(codigo[pc++]);
+        PROXIMA();
+
+    CASO(OP_LEIA_R)
+        pilha[sp++].r = ler_real(codigo[pc++]);
+        PROXIMA();
+
+    CASO(OP_ESCREVA_I)
+        escrever_inteiro(pilha[--sp].i);
+        PROXIMA();
+
+    CASO(OP_ESCREVA_R)
+        escrever_real(pilha[--sp].r);
+        PROXIMA();
+
+    CASO(OP_ESCREVA_S)
+        escrever_cadeia(bc->cadeias[codigo[pc++]]);
+        PROXIMA();
+
+    CASO(OP_FIM_LINHA)
+        escrever_fim_linha();
+        PROXIMA();
+
+    CASO(OP_PARA)
+        goto fim;
+
+    FIM()
+
+fim:
+    fflush(stdout);
+    free(pilha);
+    free(quadro);
+    return executadas;
+}
@@ -0,0 +1,18 @@
+/*
+ * Máquina virtual para o bytecode de X25b (modo --vm)
+ * Avaliação Parcial 2 - Compiladores
+ */
+
+#ifndef VM_H
+#define VM_H
+
+#include "bytecode.h"
+
+/*
+ * Executa o bytecode. A pilha de operandos e o quadro de variáveis são
+ * alocados uma única vez, com os tamanhos calculados na compilação.
+ * Retorna o número de instruções executadas.
+ */
+long executar_bytecode(const Bytecode *bc);
+
+#endif /* VM_H */